@@ -143,6 +143,8 @@ static inline void ukarch_spinwait(void)
 #define X86_CPUID1_EDX_SSE      (1 << 25)
 /* CPUID feature bits in EBX and ECX when EAX=7, ECX=0 */
 #define X86_CPUID7_EBX_FSGSBASE (1 << 0)
+#define X86_CPUID7_EBX_AVX2     (1 << 5)
+#define X86_CPUID7_EBX_ERMS     (1 << 9)
 #define X86_CPUID7_ECX_PKU	(1 << 3)
 #define X86_CPUID7_ECX_OSPKE	(1 << 4)
 #define X86_CPUID7_ECX_LA57		(1 << 16)
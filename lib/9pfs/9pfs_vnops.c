@@ -572,6 +572,11 @@ out:
 	return -rc;
 }
 
+/*
+ * Called with the vnode locked in shared mode, so reads of the same file can
+ * run concurrently. This is safe since every request carries its own offset
+ * and the fid is not modified; the 9P device serializes the transport.
+ */
 static int uk_9pfs_read(struct vnode *vp, struct vfscore_file *fp,
 			struct uio *uio, int ioflag __unused)
 {
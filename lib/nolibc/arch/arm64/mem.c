@@ -0,0 +1,344 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2023, Unikraft GmbH and The Unikraft Authors.
+ * Licensed under the BSD-3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ */
+
+/*
+ * Word-wide memory functions for arm64.
+ *
+ * These functions are called from interrupt and trap handlers, where the
+ * FP/SIMD register state is not saved. This file is thus built with the
+ * ISR flags (-mgeneral-regs-only) and moves data in pairs of 8-byte
+ * general purpose registers, which the compiler emits as ldp/stp. Short
+ * buffers are handled with overlapping accesses. Long buffers are moved
+ * in 64-byte blocks with 16-byte aligned stores. Long zero fills use
+ * `dc zva` to clear whole cache blocks.
+ */
+
+#include <stddef.h>
+#include <string.h>
+#include <uk/arch/lcpu.h>
+#include <uk/essentials.h>
+
+/* Zero fills from this length on use `dc zva` */
+#define MEM_ZVA_THRESHOLD 256
+
+typedef __u64 __attribute__((__may_alias__, __aligned__(1))) u64_ua;
+typedef __u32 __attribute__((__may_alias__, __aligned__(1))) u32_ua;
+typedef __u16 __attribute__((__may_alias__, __aligned__(1))) u16_ua;
+
+/* DCZID_EL0 */
+#define DCZID_BS_MASK	0xf
+#define DCZID_DZP	(1 << 4)
+
+/* Size of the block cleared by `dc zva`, 0 if prohibited */
+static long arm64_zva_size = -1;
+
+static inline long arm64_zva_block(void)
+{
+	__u64 dczid;
+
+	if (unlikely(arm64_zva_size < 0)) {
+		__asm__ __volatile__("mrs %0, dczid_el0" : "=r"(dczid));
+		if (dczid & DCZID_DZP)
+			arm64_zva_size = 0;
+		else
+			arm64_zva_size = 4L << (dczid & DCZID_BS_MASK);
+	}
+	return arm64_zva_size;
+}
+
+/*
+ * Copies up to 16 bytes. All loads are done before the first store, so
+ * the buffers may overlap.
+ */
+static inline void copy_short(__u8 *d, const __u8 *s, size_t len)
+{
+	__u64 q0, q1;
+	__u32 l0, l1;
+	__u16 w0, w1;
+
+	if (len >= 8) {
+		q0 = *(const u64_ua *)s;
+		q1 = *(const u64_ua *)(s + len - 8);
+		*(u64_ua *)d = q0;
+		*(u64_ua *)(d + len - 8) = q1;
+	} else if (len >= 4) {
+		l0 = *(const u32_ua *)s;
+		l1 = *(const u32_ua *)(s + len - 4);
+		*(u32_ua *)d = l0;
+		*(u32_ua *)(d + len - 4) = l1;
+	} else if (len >= 2) {
+		w0 = *(const u16_ua *)s;
+		w1 = *(const u16_ua *)(s + len - 2);
+		*(u16_ua *)d = w0;
+		*(u16_ua *)(d + len - 2) = w1;
+	} else if (len == 1) {
+		*d = *s;
+	}
+}
+
+/*
+ * Copies 17 to 64 bytes with (overlapping) 16-byte pairs. All loads are
+ * done before the first store, so the buffers may overlap.
+ */
+static inline void copy_medium(__u8 *d, const __u8 *s, size_t len)
+{
+	__u64 a0, a1, b0, b1, c0, c1, e0, e1;
+	__u8 *dend = d + len;
+	const __u8 *send = s + len;
+
+	a0 = *(const u64_ua *)(s + 0);
+	a1 = *(const u64_ua *)(s + 8);
+	e0 = *(const u64_ua *)(send - 16);
+	e1 = *(const u64_ua *)(send - 8);
+	if (len > 32) {
+		b0 = *(const u64_ua *)(s + 16);
+		b1 = *(const u64_ua *)(s + 24);
+		c0 = *(const u64_ua *)(send - 32);
+		c1 = *(const u64_ua *)(send - 24);
+		*(u64_ua *)(d + 16) = b0;
+		*(u64_ua *)(d + 24) = b1;
+		*(u64_ua *)(dend - 32) = c0;
+		*(u64_ua *)(dend - 24) = c1;
+	}
+	*(u64_ua *)(d + 0) = a0;
+	*(u64_ua *)(d + 8) = a1;
+	*(u64_ua *)(dend - 16) = e0;
+	*(u64_ua *)(dend - 8) = e1;
+}
+
+/*
+ * Copies more than 64 bytes in ascending order. Safe for overlapping
+ * buffers as long as `d` is below `s`.
+ */
+static inline void copy_fwd(__u8 *d, const __u8 *s, size_t len)
+{
+	__u64 q0, q1, q2, q3, q4, q5, q6, q7;
+	__u64 h0, h1, t0, t1;
+	__u8 *dstart = d;
+	__u8 *dend = d + len;
+	size_t skew;
+
+	/* Head and tail are loaded first because the loop may overwrite them */
+	h0 = *(const u64_ua *)(s + 0);
+	h1 = *(const u64_ua *)(s + 8);
+	t0 = *(const u64_ua *)(s + len - 16);
+	t1 = *(const u64_ua *)(s + len - 8);
+
+	/* Align the destination to 16 bytes; the head covers the gap */
+	skew = 16 - ((__uptr)d & 15);
+	d += skew;
+	s += skew;
+	len -= skew;
+
+	for (; len > 64; len -= 64, d += 64, s += 64) {
+		q0 = *(const u64_ua *)(s + 0);
+		q1 = *(const u64_ua *)(s + 8);
+		q2 = *(const u64_ua *)(s + 16);
+		q3 = *(const u64_ua *)(s + 24);
+		q4 = *(const u64_ua *)(s + 32);
+		q5 = *(const u64_ua *)(s + 40);
+		q6 = *(const u64_ua *)(s + 48);
+		q7 = *(const u64_ua *)(s + 56);
+		*(u64_ua *)(d + 0) = q0;
+		*(u64_ua *)(d + 8) = q1;
+		*(u64_ua *)(d + 16) = q2;
+		*(u64_ua *)(d + 24) = q3;
+		*(u64_ua *)(d + 32) = q4;
+		*(u64_ua *)(d + 40) = q5;
+		*(u64_ua *)(d + 48) = q6;
+		*(u64_ua *)(d + 56) = q7;
+	}
+	for (; len > 16; len -= 16, d += 16, s += 16) {
+		q0 = *(const u64_ua *)(s + 0);
+		q1 = *(const u64_ua *)(s + 8);
+		*(u64_ua *)(d + 0) = q0;
+		*(u64_ua *)(d + 8) = q1;
+	}
+	*(u64_ua *)(dend - 16) = t0;
+	*(u64_ua *)(dend - 8) = t1;
+	*(u64_ua *)(dstart + 0) = h0;
+	*(u64_ua *)(dstart + 8) = h1;
+}
+
+/*
+ * Copies more than 64 bytes in descending order. Safe for overlapping
+ * buffers as long as `d` is above `s`.
+ */
+static inline void copy_bwd(__u8 *d, const __u8 *s, size_t len)
+{
+	__u64 q0, q1, q2, q3, q4, q5, q6, q7;
+	__u64 h0, h1, t0, t1;
+	__u8 *dstart = d;
+	__u8 *dend = d + len;
+	size_t skew;
+
+	/* Head and tail are loaded first because the loop may overwrite them */
+	h0 = *(const u64_ua *)(s + 0);
+	h1 = *(const u64_ua *)(s + 8);
+	t0 = *(const u64_ua *)(s + len - 16);
+	t1 = *(const u64_ua *)(s + len - 8);
+
+	/* Align the destination end to 16 bytes; the tail covers the gap */
+	skew = ((__uptr)dend & 15) ? ((__uptr)dend & 15) : 16;
+	d = dend - skew;
+	s += len - skew;
+	len -= skew;
+
+	for (; len > 64; len -= 64) {
+		d -= 64;
+		s -= 64;
+		q0 = *(const u64_ua *)(s + 56);
+		q1 = *(const u64_ua *)(s + 48);
+		q2 = *(const u64_ua *)(s + 40);
+		q3 = *(const u64_ua *)(s + 32);
+		q4 = *(const u64_ua *)(s + 24);
+		q5 = *(const u64_ua *)(s + 16);
+		q6 = *(const u64_ua *)(s + 8);
+		q7 = *(const u64_ua *)(s + 0);
+		*(u64_ua *)(d + 56) = q0;
+		*(u64_ua *)(d + 48) = q1;
+		*(u64_ua *)(d + 40) = q2;
+		*(u64_ua *)(d + 32) = q3;
+		*(u64_ua *)(d + 24) = q4;
+		*(u64_ua *)(d + 16) = q5;
+		*(u64_ua *)(d + 8) = q6;
+		*(u64_ua *)(d + 0) = q7;
+	}
+	for (; len > 16; len -= 16) {
+		d -= 16;
+		s -= 16;
+		q0 = *(const u64_ua *)(s + 8);
+		q1 = *(const u64_ua *)(s + 0);
+		*(u64_ua *)(d + 8) = q0;
+		*(u64_ua *)(d + 0) = q1;
+	}
+	*(u64_ua *)(dstart + 0) = h0;
+	*(u64_ua *)(dstart + 8) = h1;
+	*(u64_ua *)(dend - 16) = t0;
+	*(u64_ua *)(dend - 8) = t1;
+}
+
+void *memcpy(void *dst, const void *src, size_t len)
+{
+	if (len <= 16)
+		copy_short(dst, src, len);
+	else if (len <= 64)
+		copy_medium(dst, src, len);
+	else
+		copy_fwd(dst, src, len);
+	return dst;
+}
+
+void *memmove(void *dst, const void *src, size_t len)
+{
+	/* Forward copies are safe unless `dst` lies within `src` */
+	if ((__uptr)dst - (__uptr)src >= len)
+		return memcpy(dst, src, len);
+
+	if (len <= 16)
+		copy_short(dst, src, len);
+	else if (len <= 64)
+		copy_medium(dst, src, len);
+	else
+		copy_bwd(dst, src, len);
+	return dst;
+}
+
+/*
+ * Zeroes whole cache blocks with `dc zva`. Returns the number of bytes
+ * that are left at the end of the buffer.
+ */
+static inline size_t zero_blocks(__u8 *p, size_t len, long bs)
+{
+	__u8 *end = p + len;
+	__u8 *b;
+
+	b = (__u8 *)ALIGN_UP((__uptr)p, (__uptr)bs);
+	for (; p < b; p += 16) {
+		*(u64_ua *)(p + 0) = 0;
+		*(u64_ua *)(p + 8) = 0;
+	}
+	for (p = b; (size_t)(end - p) >= (size_t)bs; p += bs)
+		__asm__ __volatile__("dc zva, %0" : : "r"(p) : "memory");
+	return end - p;
+}
+
+void *memset(void *ptr, int val, size_t len)
+{
+	__u64 q = 0x0101010101010101ULL * (__u8)val;
+	__u8 *p = ptr;
+	__u8 *end = p + len;
+	long bs;
+
+	if (len >= 16) {
+		/* The (unaligned) head and tail cover the edges */
+		*(u64_ua *)(p + 0) = q;
+		*(u64_ua *)(p + 8) = q;
+		*(u64_ua *)(end - 16) = q;
+		*(u64_ua *)(end - 8) = q;
+		if (len <= 32)
+			return ptr;
+
+		/* Continue 16-byte aligned; the head covers the gap */
+		p = (__u8 *)ALIGN_UP((__uptr)p + 1, 16);
+		if (q == 0 && len >= MEM_ZVA_THRESHOLD
+		    && (bs = arm64_zva_block()) > 0
+		    && len >= (size_t)bs * 2)
+			len = zero_blocks(p, end - p, bs);
+		else
+			len = end - p;
+
+		p = end - len;
+		for (; len > 16; len -= 16, p += 16) {
+			*(u64_ua *)(p + 0) = q;
+			*(u64_ua *)(p + 8) = q;
+		}
+	} else if (len >= 8) {
+		*(u64_ua *)p = q;
+		*(u64_ua *)(end - 8) = q;
+	} else if (len >= 4) {
+		*(u32_ua *)p = (__u32)q;
+		*(u32_ua *)(end - 4) = (__u32)q;
+	} else {
+		for (; len > 0; --len)
+			*(p++) = (__u8)val;
+	}
+	return ptr;
+}
+
+int memcmp(const void *ptr1, const void *ptr2, size_t len)
+{
+	const __u8 *c1 = ptr1;
+	const __u8 *c2 = ptr2;
+	__u64 q1, q2;
+
+	if (len >= 8) {
+		for (; len > 8; len -= 8, c1 += 8, c2 += 8) {
+			q1 = *(const u64_ua *)c1;
+			q2 = *(const u64_ua *)c2;
+			if (q1 != q2)
+				goto differ;
+		}
+		/* The last word overlaps with already compared bytes */
+		q1 = *(const u64_ua *)(c1 + len - 8);
+		q2 = *(const u64_ua *)(c2 + len - 8);
+		if (q1 != q2)
+			goto differ;
+		return 0;
+	}
+
+	for (; len > 0; --len, ++c1, ++c2) {
+		if ((*c1) != (*c2))
+			return ((*c1) - (*c2));
+	}
+	return 0;
+
+differ:
+	/* Big-endian order makes the first differing byte most significant */
+	q1 = __builtin_bswap64(q1);
+	q2 = __builtin_bswap64(q2);
+	return (q1 > q2) ? 1 : -1;
+}
@@ -0,0 +1,260 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2023, Unikraft GmbH and The Unikraft Authors.
+ * Licensed under the BSD-3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ */
+
+/*
+ * Word-wide memory functions for x86_64.
+ *
+ * These functions are called from interrupt and trap handlers, where the
+ * extended (SSE/AVX) register state is not saved. This file is thus built
+ * with the ISR flags and only uses general purpose registers: Short
+ * buffers are handled with (overlapping) 8-byte accesses, long buffers
+ * with the string instructions. With ERMS (Enhanced REP MOVSB/STOSB), the
+ * CPU moves whole cache lines for `rep movsb`/`rep stosb`, which makes
+ * them the fastest option for long buffers.
+ */
+
+#include <stddef.h>
+#include <string.h>
+#include <uk/arch/lcpu.h>
+#include <uk/essentials.h>
+
+/* Buffers from this length on are handled with string instructions */
+#define MEM_REP_THRESHOLD 256
+
+typedef __u64 __attribute__((__may_alias__, __aligned__(1))) u64_ua;
+typedef __u32 __attribute__((__may_alias__, __aligned__(1))) u32_ua;
+typedef __u16 __attribute__((__may_alias__, __aligned__(1))) u16_ua;
+
+static int x86_erms = -1;
+
+static inline int x86_has_erms(void)
+{
+	__u32 eax, ebx, ecx, edx;
+
+	if (unlikely(x86_erms < 0)) {
+		ukarch_x86_cpuid(0, 0, &eax, &ebx, &ecx, &edx);
+		if (eax >= 7) {
+			ukarch_x86_cpuid(7, 0, &eax, &ebx, &ecx, &edx);
+			x86_erms = !!(ebx & X86_CPUID7_EBX_ERMS);
+		} else {
+			x86_erms = 0;
+		}
+	}
+	return x86_erms;
+}
+
+static inline void rep_movsb(void *dst, const void *src, size_t len)
+{
+	__asm__ __volatile__("rep movsb"
+			     : "+D"(dst), "+S"(src), "+c"(len)
+			     :
+			     : "memory");
+}
+
+static inline void rep_movsq(void *dst, const void *src, size_t cnt)
+{
+	__asm__ __volatile__("rep movsq"
+			     : "+D"(dst), "+S"(src), "+c"(cnt)
+			     :
+			     : "memory");
+}
+
+static inline void rep_stosb(void *dst, __u8 val, size_t len)
+{
+	__asm__ __volatile__("rep stosb"
+			     : "+D"(dst), "+c"(len)
+			     : "a"(val)
+			     : "memory");
+}
+
+static inline void rep_stosq(void *dst, __u64 val, size_t cnt)
+{
+	__asm__ __volatile__("rep stosq"
+			     : "+D"(dst), "+c"(cnt)
+			     : "a"(val)
+			     : "memory");
+}
+
+/*
+ * Copies up to 16 bytes. All loads are done before the first store, so
+ * the buffers may overlap.
+ */
+static inline void copy_short(__u8 *d, const __u8 *s, size_t len)
+{
+	__u64 q0, q1;
+	__u32 l0, l1;
+	__u16 w0, w1;
+
+	if (len >= 8) {
+		q0 = *(const u64_ua *)s;
+		q1 = *(const u64_ua *)(s + len - 8);
+		*(u64_ua *)d = q0;
+		*(u64_ua *)(d + len - 8) = q1;
+	} else if (len >= 4) {
+		l0 = *(const u32_ua *)s;
+		l1 = *(const u32_ua *)(s + len - 4);
+		*(u32_ua *)d = l0;
+		*(u32_ua *)(d + len - 4) = l1;
+	} else if (len >= 2) {
+		w0 = *(const u16_ua *)s;
+		w1 = *(const u16_ua *)(s + len - 2);
+		*(u16_ua *)d = w0;
+		*(u16_ua *)(d + len - 2) = w1;
+	} else if (len == 1) {
+		*d = *s;
+	}
+}
+
+/*
+ * Copies more than 16 bytes in ascending order. Safe for overlapping
+ * buffers as long as `d` is below `s`.
+ */
+static inline void copy_fwd(__u8 *d, const __u8 *s, size_t len)
+{
+	__u64 q0, q1, q2, q3, tail;
+	__u8 *dend = d + len;
+
+	/* The tail is loaded first because the loop may overwrite it */
+	tail = *(const u64_ua *)(s + len - 8);
+	for (; len > 32; len -= 32, d += 32, s += 32) {
+		q0 = *(const u64_ua *)(s + 0);
+		q1 = *(const u64_ua *)(s + 8);
+		q2 = *(const u64_ua *)(s + 16);
+		q3 = *(const u64_ua *)(s + 24);
+		*(u64_ua *)(d + 0) = q0;
+		*(u64_ua *)(d + 8) = q1;
+		*(u64_ua *)(d + 16) = q2;
+		*(u64_ua *)(d + 24) = q3;
+	}
+	for (; len > 8; len -= 8, d += 8, s += 8)
+		*(u64_ua *)d = *(const u64_ua *)s;
+	*(u64_ua *)(dend - 8) = tail;
+}
+
+/*
+ * Copies more than 16 bytes in descending order. Safe for overlapping
+ * buffers as long as `d` is above `s`.
+ */
+static inline void copy_bwd(__u8 *d, const __u8 *s, size_t len)
+{
+	__u64 q0, q1, q2, q3, head;
+	__u8 *dstart = d;
+
+	/* The head is loaded first because the loop may overwrite it */
+	head = *(const u64_ua *)s;
+	d += len;
+	s += len;
+	for (; len > 32; len -= 32) {
+		d -= 32;
+		s -= 32;
+		q0 = *(const u64_ua *)(s + 24);
+		q1 = *(const u64_ua *)(s + 16);
+		q2 = *(const u64_ua *)(s + 8);
+		q3 = *(const u64_ua *)(s + 0);
+		*(u64_ua *)(d + 24) = q0;
+		*(u64_ua *)(d + 16) = q1;
+		*(u64_ua *)(d + 8) = q2;
+		*(u64_ua *)(d + 0) = q3;
+	}
+	for (; len > 8; len -= 8) {
+		d -= 8;
+		s -= 8;
+		*(u64_ua *)d = *(const u64_ua *)s;
+	}
+	*(u64_ua *)dstart = head;
+}
+
+void *memcpy(void *dst, const void *src, size_t len)
+{
+	if (len <= 16) {
+		copy_short(dst, src, len);
+	} else if (len < MEM_REP_THRESHOLD) {
+		copy_fwd(dst, src, len);
+	} else if (x86_has_erms()) {
+		rep_movsb(dst, src, len);
+	} else {
+		rep_movsq(dst, src, len >> 3);
+		if (len & 7)
+			copy_short((__u8 *)dst + (len & ~7UL),
+				   (const __u8 *)src + (len & ~7UL), len & 7);
+	}
+	return dst;
+}
+
+void *memmove(void *dst, const void *src, size_t len)
+{
+	/* Forward copies are safe unless `dst` lies within `src` */
+	if ((__uptr)dst - (__uptr)src >= len)
+		return memcpy(dst, src, len);
+
+	if (len <= 16)
+		copy_short(dst, src, len);
+	else
+		copy_bwd(dst, src, len);
+	return dst;
+}
+
+void *memset(void *ptr, int val, size_t len)
+{
+	__u64 q = 0x0101010101010101ULL * (__u8)val;
+	__u8 *p = ptr;
+
+	if (len >= MEM_REP_THRESHOLD) {
+		if (x86_has_erms()) {
+			rep_stosb(p, (__u8)val, len);
+		} else {
+			rep_stosq(p, q, len >> 3);
+			p += len & ~7UL;
+			for (len &= 7; len > 0; --len)
+				*(p++) = (__u8)val;
+		}
+	} else if (len >= 8) {
+		*(u64_ua *)(p + len - 8) = q;
+		for (; len >= 8; len -= 8, p += 8)
+			*(u64_ua *)p = q;
+	} else if (len >= 4) {
+		*(u32_ua *)p = (__u32)q;
+		*(u32_ua *)(p + len - 4) = (__u32)q;
+	} else {
+		for (; len > 0; --len)
+			*(p++) = (__u8)val;
+	}
+	return ptr;
+}
+
+int memcmp(const void *ptr1, const void *ptr2, size_t len)
+{
+	const __u8 *c1 = ptr1;
+	const __u8 *c2 = ptr2;
+	__u64 q1, q2;
+
+	if (len >= 8) {
+		for (; len > 8; len -= 8, c1 += 8, c2 += 8) {
+			q1 = *(const u64_ua *)c1;
+			q2 = *(const u64_ua *)c2;
+			if (q1 != q2)
+				goto differ;
+		}
+		/* The last word overlaps with already compared bytes */
+		q1 = *(const u64_ua *)(c1 + len - 8);
+		q2 = *(const u64_ua *)(c2 + len - 8);
+		if (q1 != q2)
+			goto differ;
+		return 0;
+	}
+
+	for (; len > 0; --len, ++c1, ++c2) {
+		if ((*c1) != (*c2))
+			return ((*c1) - (*c2));
+	}
+	return 0;
+
+differ:
+	/* Big-endian order makes the first differing byte most significant */
+	q1 = __builtin_bswap64(q1);
+	q2 = __builtin_bswap64(q2);
+	return (q1 > q2) ? 1 : -1;
+}
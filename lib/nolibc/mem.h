@@ -0,0 +1,24 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2023, Unikraft GmbH and The Unikraft Authors.
+ * Licensed under the BSD-3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ */
+
+#ifndef __NOLIBC_MEM_H__
+#define __NOLIBC_MEM_H__
+
+#include <stddef.h>
+#include <uk/config.h>
+
+/*
+ * Generic implementations of the memory functions (see string.c). They
+ * are exported as memcpy() & co. unless the architecture-optimized
+ * versions in arch/<arch>/mem.c are selected with
+ * CONFIG_LIBNOLIBC_ARCH_MEM.
+ */
+void *__nolibc_memcpy_generic(void *dst, const void *src, size_t len);
+void *__nolibc_memset_generic(void *ptr, int val, size_t len);
+void *__nolibc_memmove_generic(void *dst, const void *src, size_t len);
+int __nolibc_memcmp_generic(const void *ptr1, const void *ptr2, size_t len);
+
+#endif /* __NOLIBC_MEM_H__ */
@@ -62,8 +62,11 @@
 #include <errno.h>
 #include <stdio.h>
 #include <ctype.h>
+#include <uk/essentials.h>
 
-void *memcpy(void *dst, const void *src, size_t len)
+#include "mem.h"
+
+void *__nolibc_memcpy_generic(void *dst, const void *src, size_t len)
 {
 	size_t p;
 
@@ -73,7 +76,7 @@ void *memcpy(void *dst, const void *src, size_t len)
 	return dst;
 }
 
-void *memset(void *ptr, int val, size_t len)
+void *__nolibc_memset_generic(void *ptr, int val, size_t len)
 {
 	__u8 *p = (__u8 *) ptr;
 
@@ -105,7 +108,7 @@ void *memrchr(const void *m, int c, size_t n)
 	return 0;
 }
 
-void *memmove(void *dst, const void *src, size_t len)
+void *__nolibc_memmove_generic(void *dst, const void *src, size_t len)
 {
 	uint8_t *d = dst;
 	const uint8_t *s = src;
@@ -126,7 +129,7 @@ void *memmove(void *dst, const void *src, size_t len)
 	return dst;
 }
 
-int memcmp(const void *ptr1, const void *ptr2, size_t len)
+int __nolibc_memcmp_generic(const void *ptr1, const void *ptr2, size_t len)
 {
 	const unsigned char *c1 = (const unsigned char *)ptr1;
 	const unsigned char *c2 = (const unsigned char *)ptr2;
@@ -139,6 +142,13 @@ int memcmp(const void *ptr1, const void *ptr2, size_t len)
 	return 0;
 }
 
+#if !CONFIG_LIBNOLIBC_ARCH_MEM
+__alias(__nolibc_memcpy_generic, memcpy);
+__alias(__nolibc_memset_generic, memset);
+__alias(__nolibc_memmove_generic, memmove);
+__alias(__nolibc_memcmp_generic, memcmp);
+#endif /* !CONFIG_LIBNOLIBC_ARCH_MEM */
+
 size_t strlen(const char *str)
 {
 	return strnlen(str, SIZE_MAX);
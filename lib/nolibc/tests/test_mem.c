@@ -0,0 +1,230 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2023, Unikraft GmbH and The Unikraft Authors.
+ * Licensed under the BSD-3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ */
+
+#include <string.h>
+#include <uk/test.h>
+#include <uk/essentials.h>
+#include <uk/plat/time.h>
+
+#include "mem.h"
+
+#define BUF_SIZE	(64 * 1024)
+#define BUF_SLACK	64
+#define FILL		0xa5
+
+/* Total number of bytes processed per benchmark measurement */
+#define BENCH_BYTES	(1024 * 1024)
+
+static __u8 src_buf[BUF_SIZE + BUF_SLACK] __align64;
+static __u8 dst_buf[BUF_SIZE + BUF_SLACK] __align64;
+static __u8 ref_buf[BUF_SIZE + BUF_SLACK] __align64;
+
+static const size_t sizes[] = { 8, 64, 256, 1024, 4096, BUF_SIZE };
+static const struct {
+	size_t dst;
+	size_t src;
+} aligns[] = { { 0, 0 }, { 1, 1 }, { 0, 7 }, { 3, 13 } };
+
+/* Called through pointers so that the compiler cannot inline them */
+static const struct {
+	const char *name;
+	void *(*cpy_arch)(void *, const void *, size_t);
+	void *(*cpy_generic)(void *, const void *, size_t);
+} copy_fns[] = {
+	{ "memcpy", memcpy, __nolibc_memcpy_generic },
+	{ "memmove", memmove, __nolibc_memmove_generic },
+};
+
+static void fill_pattern(__u8 *buf, size_t len, unsigned int seed)
+{
+	size_t i;
+
+	for (i = 0; i < len; ++i)
+		buf[i] = (__u8)((i * 7 + seed) ^ (i >> 8));
+}
+
+static inline int sign(int x)
+{
+	return (x > 0) - (x < 0);
+}
+
+UK_TESTCASE(nolibc_mem, memcpy_sizes_aligns)
+{
+	size_t len, sa, da;
+	int fails = 0;
+
+	fill_pattern(src_buf, sizeof(src_buf), 1);
+	for (len = 0; len <= 520; ++len) {
+		for (sa = 0; sa < 16; ++sa) {
+			for (da = 0; da < 16; ++da) {
+				memset(dst_buf, FILL, len + 32);
+				__nolibc_memset_generic(ref_buf, FILL, len + 32);
+				memcpy(dst_buf + da, src_buf + sa, len);
+				__nolibc_memcpy_generic(ref_buf + da,
+							src_buf + sa, len);
+				fails += !!__nolibc_memcmp_generic(dst_buf,
+								   ref_buf,
+								   len + 32);
+			}
+		}
+	}
+	UK_TEST_EXPECT_ZERO(fails);
+}
+
+UK_TESTCASE(nolibc_mem, memset_sizes_aligns)
+{
+	size_t len, da;
+	int fails = 0;
+
+	for (len = 0; len <= 1100; ++len) {
+		for (da = 0; da < 16; ++da) {
+			__nolibc_memset_generic(dst_buf, FILL, len + 32);
+			__nolibc_memset_generic(ref_buf, FILL, len + 32);
+			memset(dst_buf + da, (int)(len & 1 ? da : 0), len);
+			__nolibc_memset_generic(ref_buf + da,
+						(int)(len & 1 ? da : 0), len);
+			fails += !!__nolibc_memcmp_generic(dst_buf, ref_buf,
+							   len + 32);
+		}
+	}
+	UK_TEST_EXPECT_ZERO(fails);
+}
+
+UK_TESTCASE(nolibc_mem, memmove_overlap)
+{
+	size_t len;
+	int off;
+	int fails = 0;
+
+	for (len = 0; len <= 300; ++len) {
+		for (off = -40; off <= 40; ++off) {
+			fill_pattern(dst_buf, 512, (unsigned int)len);
+			fill_pattern(ref_buf, 512, (unsigned int)len);
+			memmove(dst_buf + 64 + off, dst_buf + 64, len);
+			__nolibc_memmove_generic(ref_buf + 64 + off,
+						 ref_buf + 64, len);
+			fails += !!__nolibc_memcmp_generic(dst_buf, ref_buf,
+							   512);
+		}
+	}
+	UK_TEST_EXPECT_ZERO(fails);
+}
+
+UK_TESTCASE(nolibc_mem, memcmp_order)
+{
+	size_t len, pos;
+	int fails = 0;
+
+	fill_pattern(src_buf, 600, 3);
+	for (len = 0; len <= 520; ++len) {
+		memcpy(dst_buf + 1, src_buf, len);
+		fails += !!memcmp(dst_buf + 1, src_buf, len);
+
+		for (pos = 0; pos < len; pos += 1 + pos / 4) {
+			dst_buf[1 + pos] ^= 0x81;
+			fails += sign(memcmp(dst_buf + 1, src_buf, len))
+				 != sign(__nolibc_memcmp_generic(dst_buf + 1,
+								 src_buf,
+								 len));
+			fails += sign(memcmp(src_buf, dst_buf + 1, len))
+				 != sign(__nolibc_memcmp_generic(src_buf,
+								 dst_buf + 1,
+								 len));
+			dst_buf[1 + pos] ^= 0x81;
+		}
+	}
+	UK_TEST_EXPECT_ZERO(fails);
+}
+
+static __nsec bench_copy(void *(*fn)(void *, const void *, size_t),
+			 size_t len, size_t da, size_t sa)
+{
+	size_t rounds = BENCH_BYTES / len;
+	__nsec start;
+
+	start = ukplat_monotonic_clock();
+	while (rounds--)
+		fn(dst_buf + da, src_buf + sa, len);
+	return ukplat_monotonic_clock() - start;
+}
+
+static __nsec bench_set(void *(*fn)(void *, int, size_t),
+			size_t len, size_t da)
+{
+	size_t rounds = BENCH_BYTES / len;
+	__nsec start;
+
+	start = ukplat_monotonic_clock();
+	while (rounds--)
+		fn(dst_buf + da, 0, len);
+	return ukplat_monotonic_clock() - start;
+}
+
+static __nsec bench_cmp(int (*fn)(const void *, const void *, size_t),
+			size_t len, size_t da, size_t sa)
+{
+	size_t rounds = BENCH_BYTES / len;
+	volatile int res;
+	__nsec start;
+
+	start = ukplat_monotonic_clock();
+	while (rounds--)
+		res = fn(dst_buf + da, src_buf + sa, len);
+	(void)res;
+	return ukplat_monotonic_clock() - start;
+}
+
+static void bench_print(const char *name, size_t len, size_t da, size_t sa,
+			__nsec t_generic, __nsec t_arch)
+{
+	uk_test_printf("%-8s %6zu B dst+%zu src+%zu: generic %8"__PRInsec
+		       " ns, arch %8"__PRInsec" ns (%"__PRInsec".%02"
+		       __PRInsec"x)\n", name, len, da, sa, t_generic, t_arch,
+		       t_arch ? t_generic / t_arch : 0,
+		       t_arch ? (t_generic * 100 / t_arch) % 100 : 0);
+}
+
+/* Reports the time to process BENCH_BYTES per size and alignment */
+UK_TESTCASE(nolibc_mem, benchmark)
+{
+	__nsec t_generic, t_arch;
+	size_t i, j, f, da, sa, len;
+
+	fill_pattern(src_buf, sizeof(src_buf), 5);
+	for (i = 0; i < ARRAY_SIZE(sizes); ++i) {
+		len = sizes[i];
+		for (j = 0; j < ARRAY_SIZE(aligns); ++j) {
+			da = aligns[j].dst;
+			sa = aligns[j].src;
+
+			for (f = 0; f < ARRAY_SIZE(copy_fns); ++f) {
+				t_generic = bench_copy(copy_fns[f].cpy_generic,
+						       len, da, sa);
+				t_arch = bench_copy(copy_fns[f].cpy_arch,
+						    len, da, sa);
+				bench_print(copy_fns[f].name, len, da, sa,
+					    t_generic, t_arch);
+			}
+
+			t_generic = bench_set(__nolibc_memset_generic, len, da);
+			t_arch = bench_set(memset, len, da);
+			bench_print("memset", len, da, 0, t_generic, t_arch);
+
+			/* Equal buffers: memcmp has to scan the whole length */
+			memcpy(dst_buf + da, src_buf + sa, len);
+			t_generic = bench_cmp(__nolibc_memcmp_generic,
+					      len, da, sa);
+			t_arch = bench_cmp(memcmp, len, da, sa);
+			bench_print("memcmp", len, da, sa, t_generic, t_arch);
+		}
+	}
+
+	/* The benchmark only reports numbers, the results are checked above */
+	UK_TEST_EXPECT_ZERO(__nolibc_memcmp_generic(dst_buf + da,
+						    src_buf + sa, len));
+}
+
+uk_testsuite_register(nolibc_mem, NULL);
@@ -48,6 +48,7 @@
 #include <uk/init.h>
 
 #include <sys/eventfd.h>
+#include <sys/ioctl.h>
 #include <inttypes.h>
 #include <errno.h>
 #include <string.h>
@@ -101,16 +102,7 @@ static unsigned int eventfd_events(struct eventfd *efd)
 
 static void eventfd_signal_eventpoll(struct eventfd *efd, unsigned int events)
 {
-	struct eventpoll_cb *ecb;
-	struct uk_list_head *itr;
-
-	uk_list_for_each(itr, &efd->ep_list) {
-		ecb = uk_list_entry(itr, struct eventpoll_cb, cb_link);
-
-		UK_ASSERT(ecb->unregister);
-
-		eventpoll_signal(ecb, events);
-	}
+	eventpoll_signal_list(&efd->ep_list, events);
 }
 
 static int eventfd_vfscore_close(struct vnode *vnode,
@@ -268,6 +260,8 @@ static int eventfd_vfscore_poll(struct vnode *vnode, unsigned int *revents,
 	uk_mutex_lock(&efd->lock);
 
 	events = eventfd_events(efd);
+	if (!ecb)
+		goto out;
 
 	uk_mutex_lock(&eventfd_global_lock);
 	if (!ecb->unregister) {
@@ -285,6 +279,7 @@ static int eventfd_vfscore_poll(struct vnode *vnode, unsigned int *revents,
 	}
 	uk_mutex_unlock(&eventfd_global_lock);
 
+out:
 	uk_mutex_unlock(&efd->lock);
 
 	*revents = events;
@@ -292,9 +287,21 @@ static int eventfd_vfscore_poll(struct vnode *vnode, unsigned int *revents,
 	return 0;
 }
 
+static int eventfd_vfscore_ioctl(struct vnode *vnode __unused,
+				 struct vfscore_file *fp __unused,
+				 unsigned long com, void *data __unused)
+{
+	switch (com) {
+	case FIONBIO:
+		/* The caller already sets f_flags, which read and write use */
+		return 0;
+	default:
+		return EINVAL;
+	}
+}
+
 /* vnode operations */
 #define eventfd_vfscore_inactive ((vnop_inactive_t) vfscore_vop_einval)
-#define eventfd_vfscore_ioctl ((vnop_ioctl_t) vfscore_vop_einval)
 
 static struct vnops eventfd_vnops = {
 	.vop_close = eventfd_vfscore_close,
@@ -44,20 +44,82 @@
 #include <errno.h>
 #include <limits.h>
 
+/* Number of fds for which the eventpoll of a blocking poll() is built on the
+ * stack. More fds need a heap allocation on every blocking call. Event loops
+ * that wait on many fds should use epoll, which keeps its interest set.
+ */
+#define POLL_STACK_FDS 8
+
+/* Checks all fds without registering with the drivers.
+ * Returns the number of ready fds or a negative errno value.
+ */
+static int poll_scan(struct pollfd *fds, int num_fds)
+{
+	struct vfscore_file *fp;
+	int i, n = 0;
+
+	for (i = 0; i < num_fds; i++) {
+		fds[i].revents = 0;
+
+		/* A negative fd means we should ignore it */
+		if (fds[i].fd < 0)
+			continue;
+
+		fp = vfscore_get_file(fds[i].fd);
+		if (unlikely(!fp))
+			return -EBADF;
+
+		fds[i].revents = (short)eventpoll_poll_file(fp,
+					(unsigned short)fds[i].events);
+		vfscore_put_file(fp);
+
+		if (fds[i].revents)
+			n++;
+	}
+
+	return n;
+}
+
 static int do_ppoll(struct pollfd *fds, nfds_t nfds, const __nsec *timeout,
 		    const sigset_t *sigmask, size_t sigsetsize __unused)
 {
+	struct eventpoll_fd stack_efds[POLL_STACK_FDS];
+	struct epoll_event stack_events[POLL_STACK_FDS];
+	struct eventpoll_fd *efds = stack_efds;
+	struct epoll_event *events = stack_events;
 	struct epoll_event e;
-	struct epoll_event *events = NULL;
 	struct eventpoll ep;
-	struct eventpoll_fd *efd;
 	struct vfscore_file *fp;
 	int ret, i, fd, num_fds = (int)nfds;
 
 	if (unlikely(nfds > INT_MAX))
 		return -EINVAL;
 
-	eventpoll_init(&ep, uk_alloc_get_default());
+	/* TODO: Implement atomic masking of signals */
+	if (sigmask)
+		uk_pr_warn_once("%s: signal masking not implemented.",
+				__func__);
+
+	/* Fast path: If fds are ready already or the caller does not want to
+	 * wait, we do not need to register with the drivers
+	 */
+	ret = poll_scan(fds, num_fds);
+	if (ret != 0 || (timeout && *timeout == 0))
+		return ret;
+
+	if (num_fds > POLL_STACK_FDS) {
+		efds = uk_malloc(uk_alloc_get_default(),
+				 num_fds * (sizeof(*efds) + sizeof(*events)));
+		if (unlikely(!efds))
+			return -ENOMEM;
+
+		events = (struct epoll_event *)&efds[num_fds];
+	}
+
+	/* The eventpoll fds are not allocated individually, so the eventpoll
+	 * must not free them
+	 */
+	eventpoll_init(&ep, NULL);
 
 	/* Register fds in eventpoll */
 	for (i = 0; i < num_fds; i++) {
@@ -73,11 +135,10 @@ static int do_ppoll(struct pollfd *fds, nfds_t nfds, const __nsec *timeout,
 			goto EXIT;
 		}
 
-		efd = uk_malloc(uk_alloc_get_default(), sizeof(*efd));
-		if (unlikely(!efd)) {
+		/* Files without poll operation never change their state */
+		if (!fp->f_dentry->d_vnode->v_op->vop_poll) {
 			vfscore_put_file(fp);
-			ret = -ENOMEM;
-			goto EXIT;
+			continue;
 		}
 
 		/* We can use the unsafe method of adding the fd to the
@@ -85,44 +146,28 @@ static int do_ppoll(struct pollfd *fds, nfds_t nfds, const __nsec *timeout,
 		 * the eventpoll.
 		 */
 		e.data.ptr = &fds[i].revents;
-		e.events = fds[i].events;
-		eventpoll_fd_init(efd, fp, fd, &e);
-		eventpoll_add_unsafe(&ep, efd);
+		e.events = (unsigned short)fds[i].events;
+		eventpoll_fd_init(&efds[i], fp, fd, &e);
+		eventpoll_add_unsafe(&ep, &efds[i]);
 
 		/* We must add the fd to triggered list so it is
 		 * checked in eventpoll_wait(). This is ok because the
 		 * method will ignore the fd if it has no events
 		 * pending.
 		 */
-		uk_list_add_tail(&efd->tr_link, &ep.tr_list);
+		uk_list_add_tail(&efds[i].tr_link, &ep.tr_list);
 
 		vfscore_put_file(fp);
 	}
 
 	/* We may call poll with no fds to just do a precise wait */
-	if (num_fds > 0) {
-		events = uk_calloc(uk_alloc_get_default(), num_fds,
-				   sizeof(struct epoll_event));
-		if (unlikely(!events)) {
-			ret = -ENOMEM;
-			goto EXIT;
-		}
-	}
-
-	/* TODO: Implement atomic masking of signals */
-	if (sigmask)
-		uk_pr_warn_once("%s: signal masking not implemented.",
-				__func__);
-
 	ret = eventpoll_wait(&ep, events, num_fds, timeout);
 	if (unlikely(ret < 0))
-		goto ERR_FREE_EVENTS;
-
-	for (i = 0; i < num_fds; i++)
-		fds[i].revents = 0;
+		goto EXIT;
 
 	UK_ASSERT(ret <= num_fds);
 
+	/* The scan cleared all revents */
 	for (i = 0; i < ret; i++) {
 		UK_ASSERT(events[i].events);
 		UK_ASSERT(events[i].data.ptr);
@@ -131,11 +176,10 @@ static int do_ppoll(struct pollfd *fds, nfds_t nfds, const __nsec *timeout,
 		*((short *)events[i].data.ptr) = events[i].events;
 	}
 
-ERR_FREE_EVENTS:
-	if (events)
-		uk_free(uk_alloc_get_default(), events);
 EXIT:
 	eventpoll_fini(&ep);
+	if (efds != stack_efds)
+		uk_free(uk_alloc_get_default(), efds);
 	return ret;
 }
 
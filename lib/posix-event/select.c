@@ -51,99 +51,187 @@
 #define POLLOUT_SET (EPOLLWRNORM | EPOLLWRBAND | EPOLLOUT | EPOLLERR)
 #define POLLEX_SET  (EPOLLPRI)
 
+/* Number of fds for which the eventpoll of a blocking select() is built on
+ * the stack. More fds need a heap allocation on every blocking call, see
+ * POLL_STACK_FDS.
+ */
+#define SELECT_STACK_FDS 8
+
+/* Returns the epoll events of interest for an fd */
+static inline unsigned int select_events(int fd, fd_set *readfds,
+					 fd_set *writefds, fd_set *exceptfds)
+{
+	unsigned int events = 0;
+
+	if (readfds && FD_ISSET(fd, readfds))
+		events |= POLLIN_SET;
+
+	if (writefds && FD_ISSET(fd, writefds))
+		events |= POLLOUT_SET;
+
+	if (exceptfds && FD_ISSET(fd, exceptfds))
+		events |= POLLEX_SET;
+
+	return events;
+}
+
+/* Adds the pending events of an fd to the result sets. Returns the number of
+ * bits set.
+ */
+static int select_report(int fd, unsigned int revents, fd_set *readfds,
+			 fd_set *writefds, fd_set *exceptfds)
+{
+	int n = 0;
+
+	if (readfds && (revents & POLLIN_SET)) {
+		FD_SET(fd, readfds);
+		n++;
+	}
+	if (writefds && (revents & POLLOUT_SET)) {
+		FD_SET(fd, writefds);
+		n++;
+	}
+	if (exceptfds && (revents & POLLEX_SET)) {
+		FD_SET(fd, exceptfds);
+		n++;
+	}
+
+	return n;
+}
+
+/* Checks all fds without registering with the drivers. The pending events
+ * are reported in the result sets, which must be cleared by the caller.
+ * Returns the number of bits set or a negative errno value.
+ */
+static int select_scan(int nfds, fd_set *readfds, fd_set *writefds,
+		       fd_set *exceptfds, fd_set *rres, fd_set *wres,
+		       fd_set *xres, int *num_fds)
+{
+	struct vfscore_file *fp;
+	unsigned int events, revents;
+	int i, n = 0;
+
+	*num_fds = 0;
+	for (i = 0; i < nfds; i++) {
+		events = select_events(i, readfds, writefds, exceptfds);
+		if (!events)
+			continue;
+
+		fp = vfscore_get_file(i);
+		if (unlikely(!fp))
+			return -EBADF;
+
+		revents = eventpoll_poll_file(fp, events);
+		vfscore_put_file(fp);
+
+		n += select_report(i, revents, (readfds) ? rres : NULL,
+				   (writefds) ? wres : NULL,
+				   (exceptfds) ? xres : NULL);
+		(*num_fds)++;
+	}
+
+	return n;
+}
+
 static int do_pselect(int nfds, fd_set *readfds, fd_set *writefds,
 		      fd_set *exceptfds, const __nsec *timeout,
 		      const sigset_t *sigmask, size_t sigsetsize __unused)
 {
+	struct eventpoll_fd stack_efds[SELECT_STACK_FDS];
+	struct epoll_event stack_events[SELECT_STACK_FDS];
+	struct eventpoll_fd *efds = stack_efds;
+	struct epoll_event *events = stack_events;
 	struct epoll_event e = {0};
-	struct epoll_event *events = NULL;
+	fd_set rres, wres, xres;
 	struct eventpoll ep;
-	struct eventpoll_fd *efd;
 	struct vfscore_file *fp;
 	int num_fds = 0;
-	int ret, i;
+	int ret, i, j;
 
 	if (unlikely(nfds < 0))
 		return -EINVAL;
 
-	eventpoll_init(&ep, uk_alloc_get_default());
+	/* TODO: Implement atomic masking of signals */
+	if (sigmask)
+		uk_pr_warn_once("%s: signal masking not implemented.",
+				__func__);
 
-	/* Register fds in eventpoll */
-	for (i = 0; i < nfds; i++) {
-		if (readfds && FD_ISSET(i, readfds))
-			e.events |= POLLIN_SET;
-
-		if (writefds && FD_ISSET(i, writefds))
-			e.events |= POLLOUT_SET;
-
-		if (exceptfds && FD_ISSET(i, exceptfds))
-			e.events |= POLLEX_SET;
-
-		if (e.events) {
-			fp = vfscore_get_file(i);
-			if (unlikely(!fp)) {
-				ret = -EBADF;
-				goto EXIT;
-			}
-
-			efd = uk_malloc(uk_alloc_get_default(), sizeof(*efd));
-			if (unlikely(!efd)) {
-				vfscore_put_file(fp);
-				ret = -ENOMEM;
-				goto EXIT;
-			}
-
-			/* We can use the unsafe method of adding the fd to the
-			 * eventpoll because we know that nobody except us
-			 * may access the eventpoll.
-			 */
-			e.data.fd = i;
-			eventpoll_fd_init(efd, fp, i, &e);
-			eventpoll_add_unsafe(&ep, efd);
-
-			/* We must add the fd to triggered list so it is
-			 * checked in eventpoll_wait(). This is ok because the
-			 * method will ignore the fd if it has no events
-			 * pending.
-			 */
-			uk_list_add_tail(&efd->tr_link, &ep.tr_list);
+	/* Fast path: If fds are ready already or the caller does not want to
+	 * wait, we do not need to register with the drivers
+	 */
+	FD_ZERO(&rres);
+	FD_ZERO(&wres);
+	FD_ZERO(&xres);
+	ret = select_scan(nfds, readfds, writefds, exceptfds,
+			  &rres, &wres, &xres, &num_fds);
+	if (ret < 0)
+		return ret;
+
+	if (ret > 0 || (timeout && *timeout == 0)) {
+		if (readfds)
+			*readfds = rres;
+		if (writefds)
+			*writefds = wres;
+		if (exceptfds)
+			*exceptfds = xres;
+		return ret;
+	}
 
-			vfscore_put_file(fp);
+	if (num_fds > SELECT_STACK_FDS) {
+		efds = uk_malloc(uk_alloc_get_default(),
+				 num_fds * (sizeof(*efds) + sizeof(*events)));
+		if (unlikely(!efds))
+			return -ENOMEM;
 
-			num_fds++;
-			e.events = 0;
-		}
+		events = (struct epoll_event *)&efds[num_fds];
 	}
 
-	/* We may call select with no fds to just do a precise wait */
-	if (num_fds > 0) {
-		events = uk_calloc(uk_alloc_get_default(), num_fds,
-				   sizeof(struct epoll_event));
-		if (unlikely(!events)) {
-			ret = -ENOMEM;
+	/* The eventpoll fds are not allocated individually, so the eventpoll
+	 * must not free them
+	 */
+	eventpoll_init(&ep, NULL);
+
+	/* Register fds in eventpoll */
+	for (i = 0, j = 0; i < nfds && j < num_fds; i++) {
+		e.events = select_events(i, readfds, writefds, exceptfds);
+		if (!e.events)
+			continue;
+
+		fp = vfscore_get_file(i);
+		if (unlikely(!fp)) {
+			ret = -EBADF;
 			goto EXIT;
 		}
-	}
 
-	/* TODO: Implement atomic masking of signals */
-	if (sigmask)
-		uk_pr_warn_once("%s: signal masking not implemented.",
-				__func__);
+		/* Files without poll operation never change their state */
+		if (!fp->f_dentry->d_vnode->v_op->vop_poll) {
+			vfscore_put_file(fp);
+			continue;
+		}
+
+		/* We can use the unsafe method of adding the fd to the
+		 * eventpoll because we know that nobody except us
+		 * may access the eventpoll.
+		 */
+		e.data.fd = i;
+		eventpoll_fd_init(&efds[j], fp, i, &e);
+		eventpoll_add_unsafe(&ep, &efds[j]);
+
+		/* We must add the fd to triggered list so it is
+		 * checked in eventpoll_wait(). This is ok because the
+		 * method will ignore the fd if it has no events
+		 * pending.
+		 */
+		uk_list_add_tail(&efds[j].tr_link, &ep.tr_list);
+
+		vfscore_put_file(fp);
+		j++;
+	}
 
+	/* We may call select with no fds to just do a precise wait */
 	ret = eventpoll_wait(&ep, events, num_fds, timeout);
 	if (ret < 0)
-		goto ERR_FREE_EVENTS;
-
-	if (readfds)
-		FD_ZERO(readfds);
-	if (writefds)
-		FD_ZERO(writefds);
-	if (exceptfds)
-		FD_ZERO(exceptfds);
-
-	/* Timeout */
-	if (ret == 0)
-		goto ERR_FREE_EVENTS;
+		goto EXIT;
 
 	UK_ASSERT(ret <= num_fds);
 	num_fds = ret;
@@ -153,25 +241,24 @@ static int do_pselect(int nfds, fd_set *readfds, fd_set *writefds,
 		UK_ASSERT(events[i].events);
 		UK_ASSERT(events[i].data.fd < nfds);
 
-		if (readfds && (events[i].events & POLLIN_SET)) {
-			FD_SET(events[i].data.fd, readfds);
-			ret++;
-		}
-		if (writefds && (events[i].events & POLLOUT_SET)) {
-			FD_SET(events[i].data.fd, writefds);
-			ret++;
-		}
-		if (exceptfds && (events[i].events & POLLEX_SET)) {
-			FD_SET(events[i].data.fd, exceptfds);
-			ret++;
-		}
+		ret += select_report(events[i].data.fd, events[i].events,
+				     (readfds) ? &rres : NULL,
+				     (writefds) ? &wres : NULL,
+				     (exceptfds) ? &xres : NULL);
 	}
 
-ERR_FREE_EVENTS:
-	if (events)
-		uk_free(uk_alloc_get_default(), events);
+	/* The result sets are empty on timeout */
+	if (readfds)
+		*readfds = rres;
+	if (writefds)
+		*writefds = wres;
+	if (exceptfds)
+		*exceptfds = xres;
+
 EXIT:
 	eventpoll_fini(&ep);
+	if (efds != stack_efds)
+		uk_free(uk_alloc_get_default(), efds);
 	return ret;
 }
 
@@ -0,0 +1,299 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2023, Unikraft GmbH and The Unikraft Authors.
+ * Licensed under the BSD-3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ */
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <uk/test.h>
+#include <uk/essentials.h>
+#include <uk/sched.h>
+#include <uk/plat/time.h>
+#include <vfscore/file.h>
+
+/* Number of eventfds for the interest set tests */
+#define TEST_NFDS	(FDTABLE_MAX_FILES >= 1024 ? 512 : FDTABLE_MAX_FILES / 2)
+
+/* Number of waits per benchmark measurement */
+#define BENCH_ROUNDS	1000
+
+/* The benchmark leaves some fds for stdio and the eventpoll itself */
+#define BENCH_MAX_FDS	(FDTABLE_MAX_FILES - 16)
+
+static int efd_open(void)
+{
+	return eventfd(0, EFD_NONBLOCK);
+}
+
+static int efd_post(int fd)
+{
+	uint64_t val = 1;
+
+	return (write(fd, &val, sizeof(val)) == sizeof(val)) ? 0 : -1;
+}
+
+static int ep_add(int epfd, int fd, uint32_t events)
+{
+	struct epoll_event ev = { .events = events, .data.fd = fd };
+
+	return epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev);
+}
+
+static int ep_mod(int epfd, int fd, uint32_t events)
+{
+	struct epoll_event ev = { .events = events, .data.fd = fd };
+
+	return epoll_ctl(epfd, EPOLL_CTL_MOD, fd, &ev);
+}
+
+UK_TESTCASE(posix_event_epoll, interest_set)
+{
+	static int fds[TEST_NFDS];
+	struct epoll_event ev;
+	int epfd, i;
+
+	epfd = epoll_create1(0);
+	UK_TEST_EXPECT(epfd >= 0);
+
+	for (i = 0; i < TEST_NFDS; i++) {
+		fds[i] = efd_open();
+		UK_TEST_EXPECT(fds[i] >= 0);
+		UK_TEST_EXPECT_ZERO(ep_add(epfd, fds[i], EPOLLIN));
+	}
+
+	UK_TEST_EXPECT_SNUM_EQ(ep_add(epfd, fds[0], EPOLLIN), -1);
+	UK_TEST_EXPECT_SNUM_EQ(errno, EEXIST);
+
+	for (i = 0; i < TEST_NFDS; i++)
+		UK_TEST_EXPECT_ZERO(ep_mod(epfd, fds[i], EPOLLIN | EPOLLET));
+
+	/* Remove every other fd from the interest set */
+	for (i = 0; i < TEST_NFDS; i += 2)
+		UK_TEST_EXPECT_ZERO(epoll_ctl(epfd, EPOLL_CTL_DEL, fds[i],
+					      NULL));
+	UK_TEST_EXPECT_SNUM_EQ(ep_mod(epfd, fds[0], EPOLLIN), -1);
+	UK_TEST_EXPECT_SNUM_EQ(errno, ENOENT);
+
+	/* Only fds that are still in the interest set are reported */
+	UK_TEST_EXPECT_ZERO(efd_post(fds[TEST_NFDS - 2]));
+	UK_TEST_EXPECT_ZERO(efd_post(fds[TEST_NFDS - 1]));
+	UK_TEST_EXPECT_SNUM_EQ(epoll_wait(epfd, &ev, 1, 0), 1);
+	UK_TEST_EXPECT_SNUM_EQ(ev.data.fd, fds[TEST_NFDS - 1]);
+
+	/* Closed fds leave the interest set */
+	for (i = 0; i < TEST_NFDS; i++)
+		close(fds[i]);
+	UK_TEST_EXPECT_ZERO(epoll_wait(epfd, &ev, 1, 0));
+
+	close(epfd);
+}
+
+UK_TESTCASE(posix_event_epoll, oneshot)
+{
+	struct epoll_event ev;
+	int epfd, fd;
+
+	epfd = epoll_create1(0);
+	fd = efd_open();
+	UK_TEST_EXPECT(epfd >= 0 && fd >= 0);
+
+	UK_TEST_EXPECT_ZERO(ep_add(epfd, fd, EPOLLIN | EPOLLONESHOT));
+	UK_TEST_EXPECT_ZERO(efd_post(fd));
+	UK_TEST_EXPECT_SNUM_EQ(epoll_wait(epfd, &ev, 1, 0), 1);
+
+	/* The fd is disarmed although it is still readable */
+	UK_TEST_EXPECT_ZERO(epoll_wait(epfd, &ev, 1, 0));
+	UK_TEST_EXPECT_ZERO(efd_post(fd));
+	UK_TEST_EXPECT_ZERO(epoll_wait(epfd, &ev, 1, 0));
+
+	/* Modifying the fd arms it again */
+	UK_TEST_EXPECT_ZERO(ep_mod(epfd, fd, EPOLLIN | EPOLLONESHOT));
+	UK_TEST_EXPECT_SNUM_EQ(epoll_wait(epfd, &ev, 1, 0), 1);
+	UK_TEST_EXPECT_SNUM_EQ(ev.data.fd, fd);
+
+	close(fd);
+	close(epfd);
+}
+
+UK_TESTCASE(posix_event_epoll, level_triggered_rotation)
+{
+	struct epoll_event ev;
+	unsigned int seen = 0;
+	int epfd, fds[4];
+	unsigned int i, j;
+
+	epfd = epoll_create1(0);
+	UK_TEST_EXPECT(epfd >= 0);
+
+	for (i = 0; i < ARRAY_SIZE(fds); i++) {
+		fds[i] = efd_open();
+		UK_TEST_EXPECT_ZERO(ep_add(epfd, fds[i], EPOLLIN));
+		UK_TEST_EXPECT_ZERO(efd_post(fds[i]));
+	}
+
+	/* All ready fds are reported in turn with a single event slot */
+	for (i = 0; i < ARRAY_SIZE(fds); i++) {
+		UK_TEST_EXPECT_SNUM_EQ(epoll_wait(epfd, &ev, 1, 0), 1);
+		for (j = 0; j < ARRAY_SIZE(fds); j++)
+			if (ev.data.fd == fds[j])
+				seen |= 1U << j;
+	}
+	UK_TEST_EXPECT_SNUM_EQ(seen, (1U << ARRAY_SIZE(fds)) - 1);
+
+	for (i = 0; i < ARRAY_SIZE(fds); i++)
+		close(fds[i]);
+	close(epfd);
+}
+
+struct wait_args {
+	int epfd;
+	int ret;
+};
+
+static __noreturn void wait_func(void *arg)
+{
+	struct wait_args *args = (struct wait_args *)arg;
+	struct epoll_event ev;
+
+	args->ret = epoll_wait(args->epfd, &ev, 1, 100);
+	uk_sched_thread_exit();
+}
+
+/* Returns the number of threads that are woken up by a single event if
+ * each thread waits on its own eventpoll
+ */
+static int count_wakeups(uint32_t events)
+{
+	struct uk_thread *threads[2];
+	struct wait_args args[2];
+	int fd, i, n = 0;
+
+	fd = efd_open();
+	UK_ASSERT(fd >= 0);
+
+	for (i = 0; i < 2; i++) {
+		args[i].epfd = epoll_create1(0);
+		UK_ASSERT(args[i].epfd >= 0);
+		ep_add(args[i].epfd, fd, events);
+		threads[i] = uk_sched_thread_create(uk_sched_current(),
+						    wait_func, &args[i],
+						    "epoll-wait");
+		UK_ASSERT(threads[i]);
+	}
+
+	/* Let the threads block in epoll_wait() */
+	uk_sched_yield();
+	efd_post(fd);
+
+	for (i = 0; i < 2; i++) {
+		while (!uk_thread_is_exited(threads[i]))
+			uk_sched_yield();
+		n += args[i].ret;
+		close(args[i].epfd);
+	}
+
+	close(fd);
+	return n;
+}
+
+UK_TESTCASE(posix_event_epoll, exclusive)
+{
+	int epfd, fd;
+
+	epfd = epoll_create1(0);
+	fd = efd_open();
+	UK_TEST_EXPECT(epfd >= 0 && fd >= 0);
+
+	/* Invalid flag combinations */
+	UK_TEST_EXPECT_SNUM_EQ(ep_add(epfd, fd, EPOLLIN | EPOLLEXCLUSIVE |
+					       EPOLLONESHOT), -1);
+	UK_TEST_EXPECT_SNUM_EQ(errno, EINVAL);
+	UK_TEST_EXPECT_ZERO(ep_add(epfd, fd, EPOLLIN | EPOLLEXCLUSIVE));
+	UK_TEST_EXPECT_SNUM_EQ(ep_mod(epfd, fd, EPOLLIN), -1);
+	UK_TEST_EXPECT_SNUM_EQ(errno, EINVAL);
+
+	close(fd);
+	close(epfd);
+
+	UK_TEST_EXPECT_SNUM_EQ(count_wakeups(EPOLLIN), 2);
+	UK_TEST_EXPECT_SNUM_EQ(count_wakeups(EPOLLIN | EPOLLEXCLUSIVE), 1);
+}
+
+static __nsec bench_elapsed(__nsec start, unsigned int ops)
+{
+	return (ukplat_monotonic_clock() - start) / ops;
+}
+
+/* Reports the cost of epoll operations depending on the interest set size */
+UK_TESTCASE(posix_event_epoll, benchmark)
+{
+	static const unsigned int nfds[] = { 1000, 10000, 100000 };
+	__nsec t_add, t_mod, t_wait, t_del, start;
+	struct epoll_event ev;
+	unsigned int i, j, n;
+	int epfd, *fds;
+
+	for (i = 0; i < ARRAY_SIZE(nfds); i++) {
+		n = nfds[i];
+		if (n > BENCH_MAX_FDS) {
+			uk_test_printf("%6u fds: skipped, increase CONFIG_LIBVFSCORE_MAX_FILES\n",
+				       n);
+			continue;
+		}
+
+		fds = malloc(n * sizeof(*fds));
+		UK_TEST_EXPECT_NOT_NULL(fds);
+		if (!fds)
+			break;
+
+		epfd = epoll_create1(0);
+		UK_TEST_EXPECT(epfd >= 0);
+		for (j = 0; j < n; j++) {
+			fds[j] = efd_open();
+			UK_ASSERT(fds[j] >= 0);
+		}
+
+		start = ukplat_monotonic_clock();
+		for (j = 0; j < n; j++)
+			ep_add(epfd, fds[j], EPOLLIN);
+		t_add = bench_elapsed(start, n);
+
+		start = ukplat_monotonic_clock();
+		for (j = 0; j < n; j++)
+			ep_mod(epfd, fds[j], EPOLLIN | EPOLLOUT);
+		t_mod = bench_elapsed(start, n);
+
+		/* A single ready fd among the interest set. The first wait
+		 * drops the fds that were ready for EPOLLOUT.
+		 */
+		for (j = 0; j < n; j++)
+			ep_mod(epfd, fds[j], EPOLLIN);
+		efd_post(fds[n / 2]);
+		epoll_wait(epfd, &ev, 1, 0);
+		start = ukplat_monotonic_clock();
+		for (j = 0; j < BENCH_ROUNDS; j++)
+			UK_TEST_EXPECT_SNUM_EQ(epoll_wait(epfd, &ev, 1, 0), 1);
+		t_wait = bench_elapsed(start, BENCH_ROUNDS);
+
+		start = ukplat_monotonic_clock();
+		for (j = 0; j < n; j++)
+			epoll_ctl(epfd, EPOLL_CTL_DEL, fds[j], NULL);
+		t_del = bench_elapsed(start, n);
+
+		uk_test_printf("%6u fds: add %6"__PRInsec" ns, mod %6"__PRInsec
+			       " ns, wait %6"__PRInsec" ns, del %6"__PRInsec
+			       " ns\n", n, t_add, t_mod, t_wait, t_del);
+
+		for (j = 0; j < n; j++)
+			close(fds[j]);
+		close(epfd);
+		free(fds);
+	}
+}
+
+uk_testsuite_register(posix_event_epoll, NULL);
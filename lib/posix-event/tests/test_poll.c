@@ -0,0 +1,210 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2023, Unikraft GmbH and The Unikraft Authors.
+ * Licensed under the BSD-3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ */
+
+#include <poll.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/select.h>
+#include <uk/test.h>
+#include <uk/essentials.h>
+#include <uk/sched.h>
+#include <vfscore/file.h>
+#include <vfscore/dentry.h>
+#include <vfscore/vnode.h>
+
+/* Numbers of fds of the blocking tests: The eventpoll of poll() and select()
+ * is built on the stack for up to 8 fds and on the heap for more.
+ */
+#define TEST_FEW_FDS	4
+#define TEST_MANY_FDS	12
+
+/* Timeout of blocking calls in ms, the tests fail instead of hanging */
+#define TEST_TIMEOUT	1000
+
+static int efd_open(void)
+{
+	return eventfd(0, EFD_NONBLOCK);
+}
+
+static int efd_post(int fd)
+{
+	uint64_t val = 1;
+
+	return (write(fd, &val, sizeof(val)) == sizeof(val)) ? 0 : -1;
+}
+
+static void efd_open_n(int *fds, unsigned int n)
+{
+	unsigned int i;
+
+	for (i = 0; i < n; i++) {
+		fds[i] = efd_open();
+		UK_ASSERT(fds[i] >= 0 && fds[i] < FD_SETSIZE);
+	}
+}
+
+static void close_n(int *fds, unsigned int n)
+{
+	unsigned int i;
+
+	for (i = 0; i < n; i++)
+		close(fds[i]);
+}
+
+static int select_in(int *fds, unsigned int n, fd_set *rfds,
+		     struct timeval *tv)
+{
+	unsigned int i;
+	int nfds = 0;
+
+	FD_ZERO(rfds);
+	for (i = 0; i < n; i++) {
+		FD_SET(fds[i], rfds);
+		nfds = MAX(nfds, fds[i] + 1);
+	}
+	return select(nfds, rfds, NULL, NULL, tv);
+}
+
+UK_TESTCASE(posix_event_poll, ready_fd)
+{
+	struct pollfd pfds[2];
+	fd_set rfds;
+	int fds[2];
+
+	efd_open_n(fds, 2);
+	UK_TEST_EXPECT_ZERO(efd_post(fds[1]));
+
+	/* Ready fds are reported without waiting for the infinite timeout */
+	pfds[0] = (struct pollfd){ .fd = fds[0], .events = POLLIN };
+	pfds[1] = (struct pollfd){ .fd = fds[1], .events = POLLIN };
+	UK_TEST_EXPECT_SNUM_EQ(poll(pfds, 2, -1), 1);
+	UK_TEST_EXPECT_ZERO(pfds[0].revents);
+	UK_TEST_EXPECT_SNUM_EQ(pfds[1].revents, POLLIN);
+
+	UK_TEST_EXPECT_SNUM_EQ(select_in(fds, 2, &rfds, NULL), 1);
+	UK_TEST_EXPECT(!FD_ISSET(fds[0], &rfds));
+	UK_TEST_EXPECT(FD_ISSET(fds[1], &rfds));
+
+	close_n(fds, 2);
+}
+
+UK_TESTCASE(posix_event_poll, zero_timeout)
+{
+	struct timeval tv = { 0 };
+	struct pollfd pfd;
+	fd_set rfds;
+	int fd;
+
+	efd_open_n(&fd, 1);
+
+	pfd = (struct pollfd){ .fd = fd, .events = POLLIN };
+	UK_TEST_EXPECT_ZERO(poll(&pfd, 1, 0));
+	UK_TEST_EXPECT_ZERO(pfd.revents);
+
+	UK_TEST_EXPECT_ZERO(select_in(&fd, 1, &rfds, &tv));
+	UK_TEST_EXPECT(!FD_ISSET(fd, &rfds));
+
+	close(fd);
+}
+
+static __noreturn void post_func(void *arg)
+{
+	efd_post(*(int *)arg);
+	uk_sched_thread_exit();
+}
+
+/* Blocks in poll() or select() on `n` fds until another thread posts the
+ * last one. Returns the number of ready fds, `posted` tells if the last fd
+ * is reported.
+ */
+static int wait_posted(unsigned int n, int use_select, int *posted)
+{
+	struct pollfd pfds[TEST_MANY_FDS];
+	struct timeval tv = { .tv_sec = TEST_TIMEOUT / 1000 };
+	int fds[TEST_MANY_FDS];
+	struct uk_thread *thread;
+	unsigned int i;
+	fd_set rfds;
+	int ret;
+
+	UK_ASSERT(n <= TEST_MANY_FDS);
+	efd_open_n(fds, n);
+
+	/* The thread runs once we block */
+	thread = uk_sched_thread_create(uk_sched_current(), post_func,
+					&fds[n - 1], "poll-post");
+	UK_ASSERT(thread);
+
+	if (use_select) {
+		ret = select_in(fds, n, &rfds, &tv);
+		*posted = FD_ISSET(fds[n - 1], &rfds);
+	} else {
+		for (i = 0; i < n; i++)
+			pfds[i] = (struct pollfd){ .fd = fds[i],
+						   .events = POLLIN };
+		ret = poll(pfds, n, TEST_TIMEOUT);
+		*posted = (pfds[n - 1].revents == POLLIN);
+	}
+
+	while (!uk_thread_is_exited(thread))
+		uk_sched_yield();
+	close_n(fds, n);
+	return ret;
+}
+
+UK_TESTCASE(posix_event_poll, blocking_wakeup)
+{
+	static const unsigned int nfds[] = { TEST_FEW_FDS, TEST_MANY_FDS };
+	unsigned int i;
+	int posted;
+
+	for (i = 0; i < ARRAY_SIZE(nfds); i++) {
+		posted = 0;
+		UK_TEST_EXPECT_SNUM_EQ(wait_posted(nfds[i], 0, &posted), 1);
+		UK_TEST_EXPECT(posted);
+
+		posted = 0;
+		UK_TEST_EXPECT_SNUM_EQ(wait_posted(nfds[i], 1, &posted), 1);
+		UK_TEST_EXPECT(posted);
+	}
+}
+
+UK_TESTCASE(posix_event_poll, no_poll_op)
+{
+	static struct vnops vops;
+	struct vfscore_file *fp;
+	struct vnops *orig_vops;
+	struct vnode *vnode;
+	struct pollfd pfd;
+	fd_set rfds;
+	int fd;
+
+	/* Turn an eventfd that is not readable into a file without poll
+	 * operation, which is always ready
+	 */
+	efd_open_n(&fd, 1);
+	fp = vfscore_get_file(fd);
+	UK_ASSERT(fp);
+	vnode = fp->f_dentry->d_vnode;
+	orig_vops = vnode->v_op;
+	vops = *orig_vops;
+	vops.vop_poll = NULL;
+	vnode->v_op = &vops;
+
+	pfd = (struct pollfd){ .fd = fd, .events = POLLIN };
+	UK_TEST_EXPECT_SNUM_EQ(poll(&pfd, 1, -1), 1);
+	UK_TEST_EXPECT_SNUM_EQ(pfd.revents, POLLIN);
+
+	UK_TEST_EXPECT_SNUM_EQ(select_in(&fd, 1, &rfds, NULL), 1);
+	UK_TEST_EXPECT(FD_ISSET(fd, &rfds));
+
+	vnode->v_op = orig_vops;
+	vfscore_put_file(fp);
+	close(fd);
+}
+
+uk_testsuite_register(posix_event_poll, NULL);
@@ -47,7 +47,8 @@
 #include <linux/futex.h>
 #include <uk/syscall.h>
 #include <uk/arch/atomic.h>
-#include <uk/thread.h>
+#include <uk/essentials.h>
+#include <uk/init.h>
 #include <uk/thread.h>
 #include <uk/list.h>
 #if CONFIG_LIBPOSIX_PROCESS_CLONE
@@ -61,134 +62,257 @@
 #include <uk/plat/lcpu.h>
 #include <uk/plat/time.h>
 
+#define FUTEX_HASH_ORDER	CONFIG_LIBPOSIX_FUTEX_HASH_ORDER
+#define FUTEX_HASH_SIZE		(1UL << FUTEX_HASH_ORDER)
+
 /** @struct uk_futex
  *  @brief Futex structure.
  */
 struct uk_futex {
 	uint32_t *uaddr; /** The futex address. */
+	uint32_t bitset; /** Waiter mask of FUTEX_WAIT_BITSET. */
+	pid_t tid; /** TID of the waiter, PI futexes only. */
+	int pi; /** The waiter waits on a PI futex. */
 	struct uk_thread *thread; /** The thread waiting on the futex. */
-	struct uk_list_head list_node; /** The list containing all the futexes
-					 * on which the threads are waiting.
-					 */
+	struct futex_bucket *bucket; /** The bucket the waiter is queued in,
+				       * NULL once it is dequeued.
+				       */
+	struct uk_list_head list_node; /** The waiter list of the bucket. */
+};
+
+/** @struct futex_bucket
+ *  @brief Waiters of all futexes whose address hashes to the bucket.
+ */
+struct futex_bucket {
+	uk_spinlock lock;
+	struct uk_list_head waiters;
 };
 
-static UK_LIST_HEAD(futex_list);
-static uk_spinlock futex_list_lock = UK_SPINLOCK_INITIALIZER();
+static struct futex_bucket futex_table[FUTEX_HASH_SIZE];
+
+static int futex_table_init(void)
+{
+	unsigned long i;
+
+	for (i = 0; i < FUTEX_HASH_SIZE; i++) {
+		uk_spin_init(&futex_table[i].lock);
+		UK_INIT_LIST_HEAD(&futex_table[i].waiters);
+	}
+	return 0;
+}
+uk_early_initcall(futex_table_init);
+
+static inline struct futex_bucket *futex_hash(uint32_t *uaddr)
+{
+	/* Multiplicative hashing of the word index */
+	uint32_t h = (uint32_t)((__uptr)uaddr >> 2) * 0x9e3779b9U;
+
+	return &futex_table[h >> (32 - FUTEX_HASH_ORDER)];
+}
+
+/* Locks two buckets in address order, or one if both are the same */
+static inline void futex_lock2(struct futex_bucket *b1,
+			       struct futex_bucket *b2)
+{
+	if (b1 > b2) {
+		uk_spin_lock(&b2->lock);
+		uk_spin_lock(&b1->lock);
+	} else {
+		uk_spin_lock(&b1->lock);
+		if (b1 != b2)
+			uk_spin_lock(&b2->lock);
+	}
+}
+
+static inline void futex_unlock2(struct futex_bucket *b1,
+				 struct futex_bucket *b2)
+{
+	uk_spin_unlock(&b1->lock);
+	if (b1 != b2)
+		uk_spin_unlock(&b2->lock);
+}
+
+/**
+ * Dequeue a waiter and wake up its thread. The bucket lock must be held.
+ *
+ * The waiter lives on the stack of the waiting thread, which may return as
+ * soon as it sees that it was dequeued. The waiter must thus not be
+ * accessed after clearing its bucket.
+ */
+static void futex_wake_waiter(struct uk_futex *f)
+{
+	uk_list_del(&f->list_node);
+
+	/* TODO: Replace with uk_thread_wakeup when the new
+	 * scheduler API is ready
+	 */
+	uk_thread_wake(f->thread);
+	ukarch_store_n(&f->bucket, NULL);
+}
+
+/**
+ * Dequeue a waiter after its thread resumed.
+ *
+ * @return
+ *	1: the waiter was still queued, i.e., nobody woke it up;
+ *	0: the waiter was dequeued by a waker
+ */
+static int futex_unqueue(struct uk_futex *f)
+{
+	struct futex_bucket *b;
+	unsigned long irqf;
+	int queued = 0;
+
+	irqf = ukplat_lcpu_save_irqf();
+
+	/* A requeue may move the waiter to another bucket while we are
+	 * waiting for the lock, so check the bucket again once locked
+	 */
+	while (!queued && (b = ukarch_load_n(&f->bucket))) {
+		uk_spin_lock(&b->lock);
+		if (f->bucket == b) {
+			uk_list_del(&f->list_node);
+			f->bucket = NULL;
+			queued = 1;
+		}
+		uk_spin_unlock(&b->lock);
+	}
+
+	ukplat_lcpu_restore_irqf(irqf);
+
+	return queued;
+}
+
+/**
+ * Enqueue a waiter and block the current thread. The bucket lock must be
+ * held; it is released before the thread yields.
+ */
+static void futex_queue_block(struct uk_futex *f, struct futex_bucket *b,
+			      const __nsec *timeout)
+{
+	f->bucket = b;
+	uk_list_add_tail(&f->list_node, &b->waiters);
+
+	/* The thread is blocked before the bucket is unlocked, so a waker
+	 * cannot find the waiter before it can be woken up
+	 */
+	if (timeout)
+		/* Block at most until `timeout` nanosecs */
+		uk_thread_block_until(f->thread, (__snsec)*timeout);
+	else
+		/* Block indefinitely */
+		uk_thread_block(f->thread);
+
+	uk_spin_unlock(&b->lock);
+}
 
 /**
  * Prepare to wait on a futex.
  *
  * Get the futex value atomically and compare it with the expected value. Add
  * the thread to the wait list and then block it if the value is equal to the
- * expected one. If the futex was not removed from the list when the thread was
- * unblocked, then it means that it timed out.
+ * expected one. The comparison is done with the bucket locked so that a wake
+ * up between the comparison and the enqueue is not lost. If the futex was not
+ * removed from the list when the thread was unblocked, then it means that it
+ * timed out.
  *
  * @param uaddr		The futex userspace address
  * @param val		The expected value
  * @param timeout	The deadline until the function will block at most.
  * 			If it is NULL, the thread will wait indefinitely.
+ * @param bitset	The waiter mask that is matched by wakers
  *
  * @return
  *	0: uaddr contains val and the thread finished waiting;
- *	<1: -EAGAIN (uaddr does not contain val) or -ETIMEDOUT (the futex timed
- *       out)
+ *	<1: -EAGAIN (uaddr does not contain val), -ETIMEDOUT (the futex timed
+ *       out), or -EINVAL (bitset is 0)
  */
-static int futex_wait(uint32_t *uaddr, uint32_t val, const __nsec *timeout)
+static int futex_wait(uint32_t *uaddr, uint32_t val, const __nsec *timeout,
+		      uint32_t bitset)
 {
 	unsigned long irqf;
-	struct uk_list_head *itr, *tmp;
-	struct uk_futex *f_tmp;
+	struct futex_bucket *b = futex_hash(uaddr);
 	struct uk_thread *current = uk_thread_current();
-	struct uk_futex f = {.uaddr = uaddr, .thread = current};
+	struct uk_futex f = {.uaddr = uaddr, .bitset = bitset,
+			     .thread = current};
 
-	if (ukarch_load_n(uaddr) == val) {
-		irqf = ukplat_lcpu_save_irqf();
-		uk_spin_lock(&futex_list_lock);
+	if (unlikely(!bitset))
+		return -EINVAL;
 
-		/* Enqueue thread to wait list */
-		uk_list_add_tail(&f.list_node, &futex_list);
+	irqf = ukplat_lcpu_save_irqf();
+	uk_spin_lock(&b->lock);
 
-		uk_spin_unlock(&futex_list_lock);
+	if (ukarch_load_n(uaddr) != val) {
+		/* Futex word does not contain expected val */
+		uk_spin_unlock(&b->lock);
 		ukplat_lcpu_restore_irqf(irqf);
+		return -EAGAIN;
+	}
 
-		if (timeout)
-			/* Block at most until `timeout` nanosecs */
-			uk_thread_block_until(current, (__snsec)*timeout);
-		else
-			/* Block indefinitely */
-			uk_thread_block(current);
+	/* Enqueue thread to wait list */
+	futex_queue_block(&f, b, timeout);
+	ukplat_lcpu_restore_irqf(irqf);
 
-		uk_sched_yield();
+	uk_sched_yield();
 
-		irqf = ukplat_lcpu_save_irqf();
-		uk_spin_lock(&futex_list_lock);
+	/* If the futex is still in the wait list, then it timed out */
+	if (futex_unqueue(&f))
+		return -ETIMEDOUT;
 
-		/* If the futex is still in the wait list, then it timed out */
-		uk_list_for_each_safe(itr, tmp, &futex_list) {
-			f_tmp = uk_list_entry(itr, struct uk_futex, list_node);
+	return 0;
+}
 
-			if (f_tmp->uaddr == uaddr && f_tmp->thread == current) {
-				/* Remove the thread from the futex list */
-				uk_list_del(&f_tmp->list_node);
-				uk_spin_unlock(&futex_list_lock);
-				ukplat_lcpu_restore_irqf(irqf);
+/* Wakes at most val waiters of uaddr. The bucket lock must be held. */
+static uint32_t futex_wake_locked(struct futex_bucket *b, uint32_t *uaddr,
+				  uint32_t val, uint32_t bitset)
+{
+	struct uk_futex *f, *tmp;
+	uint32_t count = 0;
 
-				return -ETIMEDOUT;
-			}
-		}
+	uk_list_for_each_entry_safe(f, tmp, &b->waiters, list_node) {
+		if (f->uaddr != uaddr || f->pi || !(f->bitset & bitset))
+			continue;
 
-		uk_spin_unlock(&futex_list_lock);
-		ukplat_lcpu_restore_irqf(irqf);
+		futex_wake_waiter(f);
 
-		return 0;
+		/* Wake at most val threads */
+		if (++count >= val)
+			break;
 	}
-
-	/* Futex word does not contain expected val */
-	return -EAGAIN;
+	return count;
 }
 
 /**
  * Wake up threads waiting on a futex.
  *
- * Find val threads in the wait list for the futex, remove the futexes from the
- * list and wake up the threads.
+ * Find val threads in the wait list for the futex whose bitset intersects
+ * with the given one, remove the futexes from the list and wake up the
+ * threads.
  *
- * @param uaddr	The futex userspace address
- * @param val	The number of threads waiting on the futex to be woken up
+ * @param uaddr		The futex userspace address
+ * @param val		The number of threads waiting on the futex to be woken up
+ * @param bitset	The mask of waiters to wake up
  *
  * @return
  *	0: no threads were woken up;
- *	>0: the number of threads woken up
+ *	>0: the number of threads woken up;
+ *	-EINVAL: bitset is 0
  */
-static int futex_wake(uint32_t *uaddr, uint32_t val)
+static int futex_wake(uint32_t *uaddr, uint32_t val, uint32_t bitset)
 {
 	unsigned long irqf;
-	struct uk_list_head *itr, *tmp;
-	struct uk_futex *f;
-	uint32_t count = 0;
+	struct futex_bucket *b = futex_hash(uaddr);
+	uint32_t count;
 
-	irqf = ukplat_lcpu_save_irqf();
-	uk_spin_lock(&futex_list_lock);
-
-	uk_list_for_each_safe(itr, tmp, &futex_list) {
-		f = uk_list_entry(itr, struct uk_futex, list_node);
+	if (unlikely(!bitset))
+		return -EINVAL;
 
-		if (f->uaddr == uaddr) {
-			/* Remove the thread from the futex list */
-			uk_list_del(&f->list_node);
+	irqf = ukplat_lcpu_save_irqf();
+	uk_spin_lock(&b->lock);
 
-			/* TODO: Replace with uk_thread_wakeup when the new
-			 * scheduler API is ready
-			 */
-			uk_thread_wake(f->thread);
+	count = futex_wake_locked(b, uaddr, val, bitset);
 
-			/* Wake at most val threads */
-			if (++count >= val)
-				break;
-		}
-	}
-
-	uk_spin_unlock(&futex_list_lock);
+	uk_spin_unlock(&b->lock);
 	ukplat_lcpu_restore_irqf(irqf);
 
 	return (int) count;
@@ -208,54 +332,309 @@ static int futex_wake(uint32_t *uaddr, uint32_t val)
  * @param val		Number of waiters to wake
  * @param val2		Number of waiters to requeue (0-INT_MAX)
  * @param uaddr2	Target futex user address
- * @param val3		uaddr expected value
+ * @param val3		uaddr expected value, NULL for FUTEX_REQUEUE
  *
  * @return
  *	>=0: on success, the number of tasks requeued or woken;
  *	<0: on error
  */
-static int futex_cmp_requeue(uint32_t *uaddr, uint32_t val, uint32_t val2,
-			     uint32_t *uaddr2, uint32_t val3)
+static int futex_requeue(uint32_t *uaddr, uint32_t val, uint32_t val2,
+			 uint32_t *uaddr2, const uint32_t *val3)
 {
 	unsigned long irqf;
-	struct uk_list_head *itr, *tmp;
-	struct uk_futex *f;
-	int woken_uaddr1;
+	struct futex_bucket *b1 = futex_hash(uaddr);
+	struct futex_bucket *b2 = futex_hash(uaddr2);
+	struct uk_futex *f, *tmp;
+	uint32_t woken_uaddr1 = 0;
 	uint32_t waiters_uaddr2 = 0;
 
-	if (!((uint32_t)val3 == ukarch_load_n(uaddr)))
+	irqf = ukplat_lcpu_save_irqf();
+	futex_lock2(b1, b2);
+
+	if (val3 && *val3 != ukarch_load_n(uaddr)) {
+		futex_unlock2(b1, b2);
+		ukplat_lcpu_restore_irqf(irqf);
 		return -EAGAIN;
+	}
+
+	uk_list_for_each_entry_safe(f, tmp, &b1->waiters, list_node) {
+		if (f->uaddr != uaddr || f->pi)
+			continue;
+
+		/* Wake up val waiters on uaddr */
+		if (woken_uaddr1 < val) {
+			futex_wake_waiter(f);
+			woken_uaddr1++;
+			continue;
+		}
+
+		/* Requeue at most val2 threads */
+		if (waiters_uaddr2 >= val2)
+			break;
+
+		/* Requeue thread to uaddr2 */
+		f->uaddr = uaddr2;
+		if (b1 != b2) {
+			uk_list_del(&f->list_node);
+			uk_list_add_tail(&f->list_node, &b2->waiters);
+			ukarch_store_n(&f->bucket, b2);
+		}
+		waiters_uaddr2++;
+	}
 
-	/* Wake up val waiters on uaddr */
-	woken_uaddr1 = futex_wake(uaddr, val);
+	futex_unlock2(b1, b2);
+	ukplat_lcpu_restore_irqf(irqf);
 
-	if (!val2)
-		return woken_uaddr1;
+	return (int) (woken_uaddr1 + waiters_uaddr2);
+}
+
+/**
+ * Atomically modify uaddr2 and wake up waiters on uaddr and, depending on the
+ * previous value of uaddr2, on uaddr2.
+ *
+ * This is used by condition variables to release the internal lock and wake
+ * up a waiter with a single call.
+ *
+ * @param uaddr		First futex user address
+ * @param val		Number of waiters to wake on uaddr
+ * @param val2		Number of waiters to wake on uaddr2
+ * @param uaddr2	Second futex user address
+ * @param val3		Encoded operation and comparison (see FUTEX_OP())
+ *
+ * @return
+ *	>=0: on success, the total number of woken waiters;
+ *	<0: on error
+ */
+static int futex_wake_op(uint32_t *uaddr, uint32_t val, uint32_t val2,
+			 uint32_t *uaddr2, uint32_t val3)
+{
+	unsigned long irqf;
+	struct futex_bucket *b1 = futex_hash(uaddr);
+	struct futex_bucket *b2 = futex_hash(uaddr2);
+	unsigned int op = (val3 >> 28) & 0xf;
+	unsigned int cmp = (val3 >> 24) & 0xf;
+	int32_t oparg = (int32_t)(val3 << 8) >> 20;
+	int32_t cmparg = (int32_t)(val3 << 20) >> 20;
+	uint32_t oldval, newval;
+	int count, wake2;
+
+	if (op & FUTEX_OP_OPARG_SHIFT) {
+		if (unlikely(oparg < 0 || oparg > 31))
+			return -EINVAL;
+		oparg = (int32_t)(1U << oparg);
+		op &= ~FUTEX_OP_OPARG_SHIFT;
+	}
+	if (unlikely(op > FUTEX_OP_XOR || cmp > FUTEX_OP_CMP_GE))
+		return -ENOSYS;
 
 	irqf = ukplat_lcpu_save_irqf();
-	uk_spin_lock(&futex_list_lock);
+	futex_lock2(b1, b2);
+
+	oldval = ukarch_load_n(uaddr2);
+	do {
+		switch (op) {
+		case FUTEX_OP_SET:
+			newval = (uint32_t) oparg;
+			break;
+		case FUTEX_OP_ADD:
+			newval = oldval + (uint32_t) oparg;
+			break;
+		case FUTEX_OP_OR:
+			newval = oldval | (uint32_t) oparg;
+			break;
+		case FUTEX_OP_ANDN:
+			newval = oldval & ~(uint32_t) oparg;
+			break;
+		default: /* FUTEX_OP_XOR */
+			newval = oldval ^ (uint32_t) oparg;
+			break;
+		}
+	} while (!__atomic_compare_exchange_n(uaddr2, &oldval, newval, 0,
+					      __ATOMIC_SEQ_CST,
+					      __ATOMIC_SEQ_CST));
+
+	switch (cmp) {
+	case FUTEX_OP_CMP_EQ:
+		wake2 = ((int32_t) oldval == cmparg);
+		break;
+	case FUTEX_OP_CMP_NE:
+		wake2 = ((int32_t) oldval != cmparg);
+		break;
+	case FUTEX_OP_CMP_LT:
+		wake2 = ((int32_t) oldval < cmparg);
+		break;
+	case FUTEX_OP_CMP_LE:
+		wake2 = ((int32_t) oldval <= cmparg);
+		break;
+	case FUTEX_OP_CMP_GT:
+		wake2 = ((int32_t) oldval > cmparg);
+		break;
+	default: /* FUTEX_OP_CMP_GE */
+		wake2 = ((int32_t) oldval >= cmparg);
+		break;
+	}
 
-	/* Requeue val2 waiters on uaddr2 */
-	uk_list_for_each_safe(itr, tmp, &futex_list) {
-		f = uk_list_entry(itr, struct uk_futex, list_node);
+	count = (int) futex_wake_locked(b1, uaddr, val,
+					FUTEX_BITSET_MATCH_ANY);
+	if (wake2)
+		count += (int) futex_wake_locked(b2, uaddr2, val2,
+						 FUTEX_BITSET_MATCH_ANY);
 
-		if (f->uaddr == uaddr) {
-			/* Requeue thread to uaddr2 */
-			uk_list_del(&f->list_node);
-			f->uaddr = uaddr2;
-			uk_list_add_tail(&f->list_node, &futex_list);
+	futex_unlock2(b1, b2);
+	ukplat_lcpu_restore_irqf(irqf);
 
-			/* Requeue at most val2 threads */
-			if (++waiters_uaddr2 >= val2)
-				break;
+	return count;
+}
+
+#if CONFIG_LIBPOSIX_PROCESS
+/*
+ * PI futexes hold the TID of the owner in the futex word. User space takes
+ * an uncontended lock by setting the word from 0 to its TID, and releases it
+ * by setting it back to 0 unless FUTEX_WAITERS is set. The kernel is entered
+ * only for contended locks: ownership is then handed over to the first
+ * waiter on unlock.
+ *
+ * N.B. The Unikraft schedulers do not have thread priorities, so there is no
+ * priority to inherit. The PI operations thus implement the handover
+ * protocol only.
+ */
+
+/**
+ * Try to take a PI futex for the current thread. The bucket lock must be
+ * held.
+ *
+ * @return
+ *	1: the lock was taken;
+ *	0: the lock is owned by another thread, FUTEX_WAITERS is set;
+ *	<0: on error
+ */
+static int futex_trylock_pi_locked(uint32_t *uaddr, pid_t tid)
+{
+	uint32_t oldval, newval;
+
+	oldval = ukarch_load_n(uaddr);
+	do {
+		if ((oldval & FUTEX_TID_MASK) == (uint32_t) tid)
+			return -EDEADLK;
+
+		if (oldval & FUTEX_TID_MASK)
+			newval = oldval | FUTEX_WAITERS;
+		else
+			newval = (oldval & FUTEX_OWNER_DIED) | (uint32_t) tid;
+	} while (!__atomic_compare_exchange_n(uaddr, &oldval, newval, 0,
+					      __ATOMIC_SEQ_CST,
+					      __ATOMIC_SEQ_CST));
+
+	return !(oldval & FUTEX_TID_MASK);
+}
+
+/**
+ * Take a PI futex, block until it is handed over if it is owned by another
+ * thread.
+ *
+ * @param uaddr		The futex userspace address
+ * @param timeout	The deadline until the function will block at most.
+ *			If it is NULL, the thread will wait indefinitely.
+ * @param trylock	Do not block (FUTEX_TRYLOCK_PI)
+ *
+ * @return
+ *	0: the current thread owns the futex;
+ *	<0: -EDEADLK (already owned by the caller), -EAGAIN (trylock failed),
+ *	    -ETIMEDOUT (the futex timed out)
+ */
+static int futex_lock_pi(uint32_t *uaddr, const __nsec *timeout, int trylock)
+{
+	unsigned long irqf;
+	struct futex_bucket *b = futex_hash(uaddr);
+	struct uk_thread *current = uk_thread_current();
+	struct uk_futex f = {.uaddr = uaddr, .bitset = FUTEX_BITSET_MATCH_ANY,
+			     .pi = 1, .thread = current};
+	int rc;
+
+	f.tid = uk_syscall_r_gettid();
+	if (unlikely(f.tid <= 0))
+		return f.tid ? f.tid : -ESRCH;
+
+	irqf = ukplat_lcpu_save_irqf();
+	uk_spin_lock(&b->lock);
+
+	rc = futex_trylock_pi_locked(uaddr, f.tid);
+	if (rc != 0 || trylock) {
+		uk_spin_unlock(&b->lock);
+		ukplat_lcpu_restore_irqf(irqf);
+		return (rc < 0) ? rc : (rc ? 0 : -EAGAIN);
+	}
+
+	/* Wait until the owner hands the lock over */
+	futex_queue_block(&f, b, timeout);
+	ukplat_lcpu_restore_irqf(irqf);
+
+	uk_sched_yield();
+
+	if (futex_unqueue(&f))
+		return -ETIMEDOUT;
+
+	/* futex_unlock_pi() wrote our TID to the futex word */
+	return 0;
+}
+
+/**
+ * Release a PI futex that is owned by the current thread and hand it over to
+ * the first waiter.
+ *
+ * @return
+ *	0: on success;
+ *	-EPERM: the current thread does not own the futex
+ */
+static int futex_unlock_pi(uint32_t *uaddr)
+{
+	unsigned long irqf;
+	struct futex_bucket *b = futex_hash(uaddr);
+	struct uk_futex *f, *next = NULL;
+	uint32_t oldval, newval;
+	int more = 0;
+	pid_t tid;
+
+	tid = uk_syscall_r_gettid();
+	if (unlikely(tid <= 0))
+		return tid ? tid : -ESRCH;
+
+	irqf = ukplat_lcpu_save_irqf();
+	uk_spin_lock(&b->lock);
+
+	uk_list_for_each_entry(f, &b->waiters, list_node) {
+		if (f->uaddr != uaddr || !f->pi)
+			continue;
+		if (next) {
+			more = 1;
+			break;
 		}
+		next = f;
 	}
 
-	uk_spin_unlock(&futex_list_lock);
+	/* The new owner inherits FUTEX_WAITERS if others are still waiting */
+	newval = next ? ((uint32_t) next->tid | (more ? FUTEX_WAITERS : 0)) : 0;
+
+	oldval = ukarch_load_n(uaddr);
+	do {
+		if ((oldval & FUTEX_TID_MASK) != (uint32_t) tid) {
+			uk_spin_unlock(&b->lock);
+			ukplat_lcpu_restore_irqf(irqf);
+			return -EPERM;
+		}
+	} while (!__atomic_compare_exchange_n(uaddr, &oldval, newval, 0,
+					      __ATOMIC_SEQ_CST,
+					      __ATOMIC_SEQ_CST));
+
+	if (next)
+		futex_wake_waiter(next);
+
+	uk_spin_unlock(&b->lock);
 	ukplat_lcpu_restore_irqf(irqf);
 
-	return woken_uaddr1 + waiters_uaddr2;
+	return 0;
 }
+#endif /* CONFIG_LIBPOSIX_PROCESS */
 
 /**
  * According to man pages, there exists no libc wrapper for futex
@@ -303,34 +682,54 @@ UK_LLSYSCALL_R_DEFINE(int, futex, uint32_t *, uaddr, int, futex_op,
 			timeout_ns = ukplat_monotonic_clock() +
 				     ukarch_time_sec_to_nsec(timeout->tv_sec) +
 				     timeout->tv_nsec;
-		return futex_wait(uaddr, val, timeout ? &timeout_ns : NULL);
+		return futex_wait(uaddr, val, timeout ? &timeout_ns : NULL,
+				  FUTEX_BITSET_MATCH_ANY);
 
 	case FUTEX_WAIT_BITSET:
-		/*
-		 * Special case implementation for cases where the val3/mask has
-		 * all bits set. Some applications do this to use the absolute
-		 * timeout mode. We return ENOSYS for all non-supported calls.
-		 */
-		if (val3 != UINT32_MAX)
-			return -ENOSYS;
-
+		/* `timeout` is absolute */
 		if (timeout)
 			timeout_ns = ukarch_time_sec_to_nsec(timeout->tv_sec)
 				     + timeout->tv_nsec;
 
-		return futex_wait(uaddr, val, timeout ? &timeout_ns : NULL);
+		return futex_wait(uaddr, val, timeout ? &timeout_ns : NULL,
+				  val3);
 
 	case FUTEX_WAKE:
-		return futex_wake(uaddr, val);
+		return futex_wake(uaddr, val, FUTEX_BITSET_MATCH_ANY);
+
+	case FUTEX_WAKE_BITSET:
+		return futex_wake(uaddr, val, val3);
 
-	case FUTEX_FD:
 	case FUTEX_REQUEUE:
-		return -ENOSYS;
+		return futex_requeue(uaddr, val, (unsigned long)timeout,
+				     uaddr2, NULL);
 
 	case FUTEX_CMP_REQUEUE:
-		return futex_cmp_requeue(uaddr, val, (unsigned long)timeout,
-					 uaddr2, val3);
+		return futex_requeue(uaddr, val, (unsigned long)timeout,
+				     uaddr2, &val3);
+
+	case FUTEX_WAKE_OP:
+		return futex_wake_op(uaddr, val, (unsigned long)timeout,
+				     uaddr2, val3);
 
+#if CONFIG_LIBPOSIX_PROCESS
+	case FUTEX_LOCK_PI:
+	case FUTEX_LOCK_PI2:
+		/* `timeout` is absolute */
+		if (timeout)
+			timeout_ns = ukarch_time_sec_to_nsec(timeout->tv_sec)
+				     + timeout->tv_nsec;
+
+		return futex_lock_pi(uaddr, timeout ? &timeout_ns : NULL, 0);
+
+	case FUTEX_TRYLOCK_PI:
+		return futex_lock_pi(uaddr, NULL, 1);
+
+	case FUTEX_UNLOCK_PI:
+		return futex_unlock_pi(uaddr);
+#endif /* CONFIG_LIBPOSIX_PROCESS */
+
+	case FUTEX_FD:
 	default:
 		return -ENOSYS;
 		/* TODO: other operations? */
@@ -379,7 +778,8 @@ static void pfutex_child_cleartid_term(struct uk_thread *child __unused)
 {
 	if (child_tid_clear_ref != NULL) {
 		*((pid_t *) child_tid_clear_ref) = 0;
-		futex_wake((uint32_t *) child_tid_clear_ref, 0);
+		futex_wake((uint32_t *) child_tid_clear_ref, 1,
+			   FUTEX_BITSET_MATCH_ANY);
 	}
 }
 UK_THREAD_INIT_PRIO(0x0, pfutex_child_cleartid_term, UK_PRIO_EARLIEST);
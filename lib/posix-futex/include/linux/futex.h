@@ -40,4 +40,33 @@
 #define FUTEX_CMP_REQUEUE_PI_PRIVATE	(FUTEX_CMP_REQUEUE_PI | \
 					 FUTEX_PRIVATE_FLAG)
 
+/* Bits of the futex word of PI futexes */
+#define FUTEX_WAITERS		0x80000000
+#define FUTEX_OWNER_DIED	0x40000000
+#define FUTEX_TID_MASK		0x3fffffff
+
+/* Bitset that matches all waiters of FUTEX_WAIT_BITSET/FUTEX_WAKE_BITSET */
+#define FUTEX_BITSET_MATCH_ANY	0xffffffff
+
+/* Operations of FUTEX_WAKE_OP */
+#define FUTEX_OP_SET		0	/* uaddr2 = oparg */
+#define FUTEX_OP_ADD		1	/* uaddr2 += oparg */
+#define FUTEX_OP_OR		2	/* uaddr2 |= oparg */
+#define FUTEX_OP_ANDN		3	/* uaddr2 &= ~oparg */
+#define FUTEX_OP_XOR		4	/* uaddr2 ^= oparg */
+
+#define FUTEX_OP_OPARG_SHIFT	8	/* Use (1 << oparg) as operand */
+
+/* Comparisons of FUTEX_WAKE_OP */
+#define FUTEX_OP_CMP_EQ		0	/* if (oldval == cmparg) wake */
+#define FUTEX_OP_CMP_NE		1	/* if (oldval != cmparg) wake */
+#define FUTEX_OP_CMP_LT		2	/* if (oldval < cmparg) wake */
+#define FUTEX_OP_CMP_LE		3	/* if (oldval <= cmparg) wake */
+#define FUTEX_OP_CMP_GT		4	/* if (oldval > cmparg) wake */
+#define FUTEX_OP_CMP_GE		5	/* if (oldval >= cmparg) wake */
+
+#define FUTEX_OP(op, oparg, cmp, cmparg)				\
+	((((op) & 0xf) << 28) | (((cmp) & 0xf) << 24)			\
+	 | (((oparg) & 0xfff) << 12) | ((cmparg) & 0xfff))
+
 #endif /* __LINUX_FUTEX_H__ */
@@ -40,6 +40,7 @@
 #include <linux/futex.h>
 #include <uk/syscall.h>
 #include <uk/sched.h>
+#include <uk/essentials.h>
 
 #if defined(__X86_32__) || defined(__x86_64__)
 #define NR_FUTEX	202
@@ -442,4 +443,273 @@ UK_TESTCASE(posix_futex_testsuite, test_cmp_requeue_two_waiters_one_waker)
 	UK_TEST_EXPECT_SNUM_EQ(var_to_change, 3);
 }
 
+UK_TESTCASE(posix_futex_testsuite, test_wake_op_no_waiters)
+{
+	uint32_t futex_val = 0;
+	uint32_t futex_val2 = 5;
+	int ret;
+
+	/* *uaddr2 += 3, wake uaddr2 if the old value was 5 */
+	ret = futex(&futex_val, FUTEX_WAKE_OP, 1, (struct timespec *)1,
+		    &futex_val2,
+		    FUTEX_OP(FUTEX_OP_ADD, 3, FUTEX_OP_CMP_EQ, 5));
+	UK_TEST_EXPECT_ZERO(ret);
+	UK_TEST_EXPECT_SNUM_EQ(futex_val2, 8);
+
+	/* *uaddr2 = 1 << 4 */
+	ret = futex(&futex_val, FUTEX_WAKE_OP, 1, (struct timespec *)1,
+		    &futex_val2,
+		    FUTEX_OP(FUTEX_OP_SET | FUTEX_OP_OPARG_SHIFT, 4,
+			     FUTEX_OP_CMP_LT, 0));
+	UK_TEST_EXPECT_ZERO(ret);
+	UK_TEST_EXPECT_SNUM_EQ(futex_val2, 16);
+}
+
+UK_TESTCASE(posix_futex_testsuite, test_wake_op_two_waiters)
+{
+	uint32_t futex_val = 0;
+	uint32_t futex_val2 = 0;
+	uint32_t var_to_change = 0;
+	uint32_t var_to_change_vals[2][1];
+	struct uk_thread *threads[2];
+	struct test_args args[2];
+	int rets[2][1] = { { -2 }, { -2 } };
+	int i, ret;
+
+	for (i = 0; i < 2; ++i)
+		args[i] = (struct test_args){
+			.futex_val = (i == 0) ? &futex_val : &futex_val2,
+			.var_to_change = &var_to_change,
+			.var_to_change_vals = var_to_change_vals[i],
+			.rets = rets[i],
+			.num_iterations = 1,
+			.timeout = NULL,
+		};
+
+	threads[0] = uk_sched_thread_create(uk_sched_current(),
+			waiter_func, args + 0, "Waiter 1");
+	threads[1] = uk_sched_thread_create(uk_sched_current(),
+			waiter_func, args + 1, "Waiter 2");
+	uk_sched_yield();
+
+	/* *uaddr2 += 1, wake uaddr2 if the old value was 0 */
+	ret = futex(&futex_val, FUTEX_WAKE_OP, 1, (struct timespec *)1,
+		    &futex_val2,
+		    FUTEX_OP(FUTEX_OP_ADD, 1, FUTEX_OP_CMP_EQ, 0));
+	UK_TEST_EXPECT_SNUM_EQ(ret, 2);
+	UK_TEST_EXPECT_SNUM_EQ(futex_val2, 1);
+
+	for (i = 0; i < 2; ++i)
+		wait_thread(threads[i]);
+
+	UK_TEST_EXPECT_ZERO(rets[0][0]);
+	UK_TEST_EXPECT_ZERO(rets[1][0]);
+	UK_TEST_EXPECT_SNUM_EQ(var_to_change, 2);
+}
+
+/**
+ * Returns the wait table bucket of a futex. This mirrors the hash function
+ * of the futex implementation.
+ */
+static unsigned long futex_bucket(uint32_t *uaddr)
+{
+	uint32_t h = (uint32_t)((__uptr)uaddr >> 2) * 0x9e3779b9U;
+
+	return h >> (32 - CONFIG_LIBPOSIX_FUTEX_HASH_ORDER);
+}
+
+UK_TESTCASE(posix_futex_testsuite, test_requeue_other_bucket)
+{
+	uint32_t futex_vals[16] = { 0 };
+	uint32_t *futex_val = &futex_vals[0];
+	uint32_t *requeue_futex_val = NULL;
+	uint32_t var_to_change = 0;
+	uint32_t var_to_change_vals[1];
+	struct uk_thread *thread;
+	struct test_args args;
+	int rets[1] = { -2 };
+	unsigned int i;
+	int ret;
+
+	/* Find a futex that hashes to another bucket */
+	for (i = 1; i < ARRAY_SIZE(futex_vals); ++i) {
+		if (futex_bucket(&futex_vals[i]) != futex_bucket(futex_val)) {
+			requeue_futex_val = &futex_vals[i];
+			break;
+		}
+	}
+	UK_TEST_EXPECT_NOT_NULL(requeue_futex_val);
+	if (!requeue_futex_val)
+		return;
+
+	args = (struct test_args){
+		.futex_val = futex_val,
+		.var_to_change = &var_to_change,
+		.var_to_change_vals = var_to_change_vals,
+		.rets = rets,
+		.num_iterations = 1,
+		.timeout = NULL,
+	};
+
+	thread = uk_sched_thread_create(uk_sched_current(),
+			waiter_func, &args, "Waiter");
+	uk_sched_yield();
+
+	/* Requeue the waiter without waking it */
+	ret = futex(futex_val, FUTEX_REQUEUE, 0, (struct timespec *)1,
+		    requeue_futex_val, 0);
+	UK_TEST_EXPECT_SNUM_EQ(ret, 1);
+
+	/* The waiter is found on the new futex only */
+	ret = futex(futex_val, FUTEX_WAKE, 1, NULL, NULL, 0);
+	UK_TEST_EXPECT_ZERO(ret);
+	ret = futex(requeue_futex_val, FUTEX_WAKE, 1, NULL, NULL, 0);
+	UK_TEST_EXPECT_SNUM_EQ(ret, 1);
+
+	wait_thread(thread);
+	UK_TEST_EXPECT_ZERO(rets[0]);
+	UK_TEST_EXPECT_SNUM_EQ(var_to_change, 1);
+}
+
+/**
+ * Wait on the futex with the bitset given in val.
+ */
+static __noreturn void bitset_waiter_func(void *arg)
+{
+	struct test_args *args = (struct test_args *)arg;
+
+	args->rets[0] = futex(args->futex_val, FUTEX_WAIT_BITSET,
+			      *args->futex_val, NULL, NULL, args->val);
+	uk_sched_thread_exit();
+}
+
+UK_TESTCASE(posix_futex_testsuite, test_wait_bitset_zero)
+{
+	uint32_t futex_val = 10;
+
+	int ret = futex(&futex_val, FUTEX_WAIT_BITSET, 10, NULL, NULL, 0);
+
+	UK_TEST_EXPECT_SNUM_EQ(ret, -1);
+	UK_TEST_EXPECT_SNUM_EQ(errno, EINVAL);
+}
+
+UK_TESTCASE(posix_futex_testsuite, test_wake_bitset)
+{
+	uint32_t futex_val = 0;
+	struct uk_thread *thread;
+	int rets[1] = { -2 };
+	struct test_args args = {
+		.futex_val = &futex_val,
+		.val = 0x1,
+		.rets = rets,
+	};
+	int ret;
+
+	thread = uk_sched_thread_create(uk_sched_current(),
+			bitset_waiter_func, &args, "Bitset waiter");
+	uk_sched_yield();
+
+	/* The bitsets do not intersect */
+	ret = futex(&futex_val, FUTEX_WAKE_BITSET, 1, NULL, NULL, 0x2);
+	UK_TEST_EXPECT_ZERO(ret);
+
+	ret = futex(&futex_val, FUTEX_WAKE_BITSET, 1, NULL, NULL, 0x3);
+	UK_TEST_EXPECT_SNUM_EQ(ret, 1);
+
+	wait_thread(thread);
+	UK_TEST_EXPECT_ZERO(rets[0]);
+}
+
+#if CONFIG_LIBPOSIX_PROCESS
+UK_TESTCASE(posix_futex_testsuite, test_pi_lock_unlock)
+{
+	uint32_t futex_val = 0;
+	int ret;
+
+	ret = futex(&futex_val, FUTEX_TRYLOCK_PI, 0, NULL, NULL, 0);
+	UK_TEST_EXPECT_ZERO(ret);
+	UK_TEST_EXPECT_NOT_ZERO(futex_val & FUTEX_TID_MASK);
+
+	/* The lock is not recursive */
+	ret = futex(&futex_val, FUTEX_LOCK_PI, 0, NULL, NULL, 0);
+	UK_TEST_EXPECT_SNUM_EQ(ret, -1);
+	UK_TEST_EXPECT_SNUM_EQ(errno, EDEADLK);
+
+	/* No waiters: the futex word is cleared */
+	ret = futex(&futex_val, FUTEX_UNLOCK_PI, 0, NULL, NULL, 0);
+	UK_TEST_EXPECT_ZERO(ret);
+	UK_TEST_EXPECT_ZERO(futex_val);
+
+	ret = futex(&futex_val, FUTEX_UNLOCK_PI, 0, NULL, NULL, 0);
+	UK_TEST_EXPECT_SNUM_EQ(ret, -1);
+	UK_TEST_EXPECT_SNUM_EQ(errno, EPERM);
+}
+
+/**
+ * Take the PI futex, record the futex word and the own TID, and release it.
+ */
+static __noreturn void pi_locker_func(void *arg)
+{
+	struct test_args *args = (struct test_args *)arg;
+
+	args->rets[0] = futex(args->futex_val, FUTEX_LOCK_PI, 0, NULL, NULL,
+			      0);
+	args->var_to_change_vals[0] = *args->futex_val;
+	args->var_to_change_vals[1] = (uint32_t) uk_syscall_r_gettid();
+	args->rets[1] = futex(args->futex_val, FUTEX_UNLOCK_PI, 0, NULL, NULL,
+			      0);
+	uk_sched_thread_exit();
+}
+
+UK_TESTCASE(posix_futex_testsuite, test_pi_contended)
+{
+	uint32_t futex_val = 0;
+	uint32_t var_to_change_vals[2][2];
+	struct uk_thread *threads[2];
+	struct test_args args[2];
+	int rets[2][2];
+	uint32_t tid;
+	int i, ret;
+
+	ret = futex(&futex_val, FUTEX_TRYLOCK_PI, 0, NULL, NULL, 0);
+	UK_TEST_EXPECT_ZERO(ret);
+	tid = futex_val;
+	UK_TEST_EXPECT_SNUM_EQ(tid, uk_syscall_r_gettid());
+
+	/* Two threads block on the lock in turn */
+	for (i = 0; i < 2; ++i) {
+		args[i] = (struct test_args){
+			.futex_val = &futex_val,
+			.var_to_change_vals = var_to_change_vals[i],
+			.rets = rets[i],
+		};
+		threads[i] = uk_sched_thread_create(uk_sched_current(),
+				pi_locker_func, args + i, "PI locker");
+		uk_sched_yield();
+	}
+	UK_TEST_EXPECT_SNUM_EQ(futex_val, tid | FUTEX_WAITERS);
+
+	/* The lock is handed over to the first waiter. It inherits
+	 * FUTEX_WAITERS because the second one still waits.
+	 */
+	ret = futex(&futex_val, FUTEX_UNLOCK_PI, 0, NULL, NULL, 0);
+	UK_TEST_EXPECT_ZERO(ret);
+
+	for (i = 0; i < 2; ++i)
+		wait_thread(threads[i]);
+
+	UK_TEST_EXPECT_ZERO(rets[0][0]);
+	UK_TEST_EXPECT_ZERO(rets[0][1]);
+	UK_TEST_EXPECT_SNUM_EQ(var_to_change_vals[0][0],
+			       var_to_change_vals[0][1] | FUTEX_WAITERS);
+
+	/* The last waiter gets the lock without FUTEX_WAITERS */
+	UK_TEST_EXPECT_ZERO(rets[1][0]);
+	UK_TEST_EXPECT_ZERO(rets[1][1]);
+	UK_TEST_EXPECT_SNUM_EQ(var_to_change_vals[1][0],
+			       var_to_change_vals[1][1]);
+	UK_TEST_EXPECT_ZERO(futex_val);
+}
+#endif /* CONFIG_LIBPOSIX_PROCESS */
+
 uk_testsuite_register(posix_futex_testsuite, NULL);
@@ -344,6 +344,9 @@ typedef int (*posix_socket_ioctl_func_t)(struct posix_socket_file *sock,
 /**
  * Poll the socket. The driver is expected to register with the eventpoll and
  * signal new incoming events via eventpoll_signal as soon as they occur.
+ * Drivers that keep the registered control blocks in a list should use
+ * eventpoll_signal_list, which implements EPOLLEXCLUSIVE. The control block
+ * is never NULL: queries without registration are handled by posix-socket.
  *
  * @param sock Reference to the socket
  * @param revents Pointer to an unsigned integer which receives the mask of
@@ -42,6 +42,7 @@
 #include <vfscore/vnode.h>
 #include <vfscore/mount.h>
 #include <vfscore/fs.h>
+#include <vfscore/eventpoll.h>
 #include <uk/errptr.h>
 #include <uk/init.h>
 #include <inttypes.h>
@@ -302,6 +303,9 @@ static int posix_socket_vfscore_poll(struct vnode *vnode, unsigned int *revents,
 				     struct eventpoll_cb *ecb)
 {
 	struct posix_socket_file *sock;
+	struct epoll_event tmp_event = { .events = 0 };
+	struct eventpoll_fd tmp_efd;
+	struct eventpoll tmp_ep;
 	int ret;
 
 	UK_ASSERT(vnode->v_data);
@@ -309,7 +313,22 @@ static int posix_socket_vfscore_poll(struct vnode *vnode, unsigned int *revents,
 
 	sock = (struct posix_socket_file *)vnode->v_data;
 
-	ret = posix_socket_poll(sock, revents, ecb);
+	/* Socket drivers always register the context block. If the caller
+	 * only queries the events, we register a temporary one and remove it
+	 * right away. The driver may signal it until then, so it belongs to a
+	 * private eventpoll that is not interested in any event.
+	 */
+	if (!ecb) {
+		eventpoll_init(&tmp_ep, NULL);
+		eventpoll_fd_init(&tmp_efd, sock->vfs_file, sock->vfs_file->fd,
+				  &tmp_event);
+		tmp_efd.ep = &tmp_ep;
+		ret = posix_socket_poll(sock, revents, &tmp_efd.cb);
+		if (tmp_efd.cb.unregister)
+			tmp_efd.cb.unregister(&tmp_efd.cb);
+	} else {
+		ret = posix_socket_poll(sock, revents, ecb);
+	}
 	if (unlikely(ret < 0)) {
 		PSOCKET_ERR("poll on socket %d failed: %d\n",
 			    sock->vfs_file->fd, (int)ret);
@@ -34,6 +34,8 @@
 #define _RAMFS_H
 
 #include <vfscore/prex.h>
+#include <vfscore/uio.h>
+#include <uk/spinlock.h>
 #include <stdbool.h>
 
 /**
@@ -58,14 +60,24 @@ struct ramfs_node {
 	size_t rn_namelen;
 	/* Size of the file */
 	size_t rn_size;
-	/* Buffer to the file data */
+	/*
+	 * Link target of a symbolic link, or external data of a regular
+	 * file (see ramfs_set_file_data()) until it is first modified
+	 */
 	char *rn_buf;
-	/* Size of the allocated buffer */
-	size_t rn_bufsize;
+	/* Radix tree of data pages of a regular file */
+	void *rn_pages;
+	/* Height of the radix tree (0: single data page at most) */
+	unsigned int rn_height;
 	/* Last change time */
 	struct timespec rn_ctime;
 	/* Last access time */
 	struct timespec rn_atime;
+	/*
+	 * Protects rn_atime, which is also updated by readers that hold
+	 * the vnode lock in shared mode only
+	 */
+	struct uk_spinlock rn_atime_lock;
 	/* Last modification time */
 	struct timespec rn_mtime;
 	/* Node access mode */
@@ -95,6 +107,71 @@ struct ramfs_node *ramfs_allocate_node(const char *name, int type);
  */
 void ramfs_free_node(struct ramfs_node *node);
 
+/**
+ * Looks up a data page of a regular file.
+ *
+ * @param np
+ *   Regular file node
+ * @param idx
+ *   Page index in the file
+ * @return
+ *   Pointer to the page or NULL if the page is a hole
+ */
+void *ramfs_page_get(struct ramfs_node *np, size_t idx);
+
+/**
+ * Looks up a data page of a regular file. Missing pages are allocated
+ * and zeroed.
+ *
+ * @param np
+ *   Regular file node
+ * @param idx
+ *   Page index in the file
+ * @return
+ *   Pointer to the page or NULL if the allocation failed
+ */
+void *ramfs_page_get_alloc(struct ramfs_node *np, size_t idx);
+
+/**
+ * Releases the data pages of a regular file from a page index on.
+ *
+ * @param np
+ *   Regular file node
+ * @param first
+ *   Index of the first page to release (0 releases all pages)
+ */
+void ramfs_pages_free_from(struct ramfs_node *np, size_t first);
+
+/**
+ * Moves data between the pages of a regular file and an uio, starting at
+ * the file position `uio->uio_offset`. Reading holes returns zeros;
+ * writing allocates the missing pages.
+ *
+ * @param np
+ *   Regular file node
+ * @param len
+ *   Maximum number of bytes to move
+ * @param uio
+ *   Source or destination of the data, depending on `uio->uio_rw`
+ * @return
+ *   0 on success, or a positive errno value
+ */
+int ramfs_pages_uiomove(struct ramfs_node *np, size_t len, struct uio *uio);
+
+/**
+ * Copies a buffer into the pages of a regular file, from offset 0 on.
+ *
+ * @param np
+ *   Regular file node
+ * @param data
+ *   Data to copy
+ * @param len
+ *   Number of bytes to copy
+ * @return
+ *   0 on success, or ENOMEM
+ */
+int ramfs_pages_import(struct ramfs_node *np, const void *data, size_t len);
+
 /**
  * Transforms a vnode into a ramfs_node.
  *
@@ -0,0 +1,203 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2023, Unikraft GmbH and The Unikraft Authors.
+ * Licensed under the BSD-3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ */
+
+/*
+ * ramfs_pages.c - page storage for regular files of the RAM file system.
+ *
+ * The data of a regular file is kept in pages of the default allocator
+ * that are indexed by a radix tree. Every interior node of the tree is a
+ * page of pointers. A tree of height 0 consists of a single data page
+ * (file index 0), so small files do not need interior nodes. Missing
+ * pages are holes and read as zeros.
+ */
+
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <uk/alloc.h>
+#include <uk/assert.h>
+#include <uk/essentials.h>
+#include <uk/page.h>
+#include <vfscore/uio.h>
+
+#include "ramfs.h"
+
+#define RAMFS_SLOT_SHIFT	(__PAGE_SHIFT - (sizeof(void *) == 8 ? 3 : 2))
+#define RAMFS_SLOTS		(1UL << RAMFS_SLOT_SHIFT)
+#define RAMFS_SLOT_MASK		(RAMFS_SLOTS - 1)
+
+/* Read source for holes */
+static char ramfs_zero_page[__PAGE_SIZE] __align(__PAGE_SIZE);
+
+static inline unsigned int ramfs_slot(size_t idx, unsigned int level)
+{
+	return (idx >> (level * RAMFS_SLOT_SHIFT)) & RAMFS_SLOT_MASK;
+}
+
+/* Whether a tree of the given height can address page `idx` */
+static inline bool ramfs_height_fits(size_t idx, unsigned int height)
+{
+	if (height * RAMFS_SLOT_SHIFT >= sizeof(size_t) * 8)
+		return true;
+	return (idx >> (height * RAMFS_SLOT_SHIFT)) == 0;
+}
+
+static void *ramfs_page_zalloc(void)
+{
+	void *page;
+
+	page = uk_palloc(uk_alloc_get_default(), 1);
+	if (page)
+		memset(page, 0, __PAGE_SIZE);
+	return page;
+}
+
+static inline void ramfs_page_free(void *page)
+{
+	uk_pfree(uk_alloc_get_default(), page, 1);
+}
+
+void *ramfs_page_get(struct ramfs_node *np, size_t idx)
+{
+	unsigned int level = np->rn_height;
+	void *node = np->rn_pages;
+
+	if (!ramfs_height_fits(idx, level))
+		return NULL;
+
+	while (node && level > 0) {
+		level--;
+		node = ((void **)node)[ramfs_slot(idx, level)];
+	}
+	return node;
+}
+
+void *ramfs_page_get_alloc(struct ramfs_node *np, size_t idx)
+{
+	unsigned int level;
+	void **slotp;
+	void **node;
+
+	/* Grow the tree at the root until it covers `idx` */
+	while (!ramfs_height_fits(idx, np->rn_height)) {
+		if (np->rn_pages) {
+			node = ramfs_page_zalloc();
+			if (!node)
+				return NULL;
+			node[0] = np->rn_pages;
+			np->rn_pages = node;
+		}
+		np->rn_height++;
+	}
+
+	slotp = &np->rn_pages;
+	level = np->rn_height;
+	for (;;) {
+		if (!*slotp) {
+			*slotp = ramfs_page_zalloc();
+			if (!*slotp)
+				return NULL;
+		}
+		if (level == 0)
+			return *slotp;
+		level--;
+		slotp = &((void **)*slotp)[ramfs_slot(idx, level)];
+	}
+}
+
+static void ramfs_subtree_free(void *node, unsigned int level)
+{
+	unsigned int i;
+
+	if (level > 0) {
+		for (i = 0; i < RAMFS_SLOTS; ++i) {
+			if (((void **)node)[i])
+				ramfs_subtree_free(((void **)node)[i],
+						   level - 1);
+		}
+	}
+	ramfs_page_free(node);
+}
+
+/* Frees pages from index `first` on in the subtree that starts at `base` */
+static void ramfs_subtree_free_from(void **slotp, unsigned int level,
+				    size_t base, size_t first)
+{
+	void **node = *slotp;
+	size_t span;
+	unsigned int i;
+
+	if (!node)
+		return;
+
+	if (base >= first) {
+		ramfs_subtree_free(node, level);
+		*slotp = NULL;
+		return;
+	}
+	if (level == 0)
+		return;
+
+	span = 1UL << ((level - 1) * RAMFS_SLOT_SHIFT);
+	for (i = 0; i < RAMFS_SLOTS; ++i, base += span) {
+		if (base + span <= first)
+			continue;
+		ramfs_subtree_free_from(&node[i], level - 1, base, first);
+	}
+}
+
+void ramfs_pages_free_from(struct ramfs_node *np, size_t first)
+{
+	ramfs_subtree_free_from(&np->rn_pages, np->rn_height, 0, first);
+	if (!np->rn_pages)
+		np->rn_height = 0;
+}
+
+int ramfs_pages_uiomove(struct ramfs_node *np, size_t len, struct uio *uio)
+{
+	size_t idx, pgoff, chunk;
+	char *page;
+	int error;
+
+	UK_ASSERT(uio->uio_offset >= 0);
+
+	while (len > 0 && uio->uio_resid > 0) {
+		idx = (size_t)uio->uio_offset >> __PAGE_SHIFT;
+		pgoff = (size_t)uio->uio_offset & (__PAGE_SIZE - 1);
+		chunk = MIN(len, __PAGE_SIZE - pgoff);
+
+		if (uio->uio_rw == UIO_WRITE) {
+			page = ramfs_page_get_alloc(np, idx);
+			if (!page)
+				return EIO;
+		} else {
+			page = ramfs_page_get(np, idx);
+			if (!page)
+				page = ramfs_zero_page;
+		}
+
+		error = vfscore_uiomove(page + pgoff, (int)chunk, uio);
+		if (error)
+			return error;
+		len -= chunk;
+	}
+	return 0;
+}
+
+int ramfs_pages_import(struct ramfs_node *np, const void *data, size_t len)
+{
+	size_t idx, chunk;
+	char *page;
+
+	for (idx = 0; len > 0; ++idx, len -= chunk) {
+		chunk = MIN(len, __PAGE_SIZE);
+		page = ramfs_page_get_alloc(np, idx);
+		if (!page)
+			return ENOMEM;
+		memcpy(page, (const char *)data + (idx << __PAGE_SHIFT), chunk);
+	}
+	return 0;
+}
@@ -74,6 +74,14 @@ set_times_to_now(struct timespec *time1, struct timespec *time2,
 		memcpy(time3, &now, sizeof(struct timespec));
 }
 
+static void
+ramfs_touch_atime(struct ramfs_node *np)
+{
+	uk_spin_lock(&np->rn_atime_lock);
+	set_times_to_now(&(np->rn_atime), NULL, NULL);
+	uk_spin_unlock(&np->rn_atime_lock);
+}
+
 struct ramfs_node *
 ramfs_allocate_node(const char *name, int type)
 {
@@ -100,6 +108,7 @@ ramfs_allocate_node(const char *name, int type)
 	else
 		np->rn_mode = S_IFREG|0777;
 
+	uk_spin_init(&np->rn_atime_lock);
 	set_times_to_now(&(np->rn_ctime), &(np->rn_atime), &(np->rn_mtime));
 	np->rn_owns_buf = true;
 
@@ -111,6 +120,7 @@ ramfs_free_node(struct ramfs_node *np)
 {
 	if (np->rn_buf != NULL && np->rn_owns_buf)
 		free(np->rn_buf);
+	ramfs_pages_free_from(np, 0);
 
 	free(np->rn_name);
 	free(np);
@@ -289,7 +299,7 @@ ramfs_symlink(struct vnode *dvp, const char *name, const char *link)
 	len = strlen(link);
 
 	np->rn_buf = strndup(link, len);
-	np->rn_bufsize = np->rn_size = len;
+	np->rn_size = len;
 
 	return 0;
 }
@@ -313,7 +323,7 @@ ramfs_readlink(struct vnode *vp, struct uio *uio)
 	else
 		len = uio->uio_resid;
 
-	set_times_to_now(&(np->rn_atime), NULL, NULL);
+	ramfs_touch_atime(np);
 	return vfscore_uiomove(np->rn_buf + uio->uio_offset, len, uio);
 }
 
@@ -334,40 +344,60 @@ ramfs_remove(struct vnode *dvp, struct vnode *vp,
 	return ramfs_remove_node(dvp->v_data, vp->v_data);
 }
 
+/*
+ * Moves external file data (see ramfs_set_file_data()) into pages before
+ * the file is modified.
+ */
+static int
+ramfs_unshare_file_data(struct ramfs_node *np)
+{
+	int error;
+
+	if (!np->rn_buf)
+		return 0;
+
+	error = ramfs_pages_import(np, np->rn_buf, np->rn_size);
+	if (error) {
+		ramfs_pages_free_from(np, 0);
+		return EIO;
+	}
+	if (np->rn_owns_buf)
+		free(np->rn_buf);
+	np->rn_buf = NULL;
+	np->rn_owns_buf = true;
+	return 0;
+}
+
 /* Truncate file */
 static int
 ramfs_truncate(struct vnode *vp, off_t length)
 {
 	struct ramfs_node *np;
-	void *new_buf;
-	size_t new_size;
+	size_t pgoff;
+	char *page;
+	int error;
 
 	uk_pr_debug("truncate %s length=%lld\n", RAMFS_NODE(vp)->rn_name,
 		 (long long) length);
 	np = vp->v_data;
 
-	if (length == 0) {
-		if (np->rn_buf != NULL) {
-			if (np->rn_owns_buf)
-				free(np->rn_buf);
-			np->rn_buf = NULL;
-			np->rn_bufsize = 0;
-		}
-	} else if ((size_t) length > np->rn_bufsize) {
-		/* TODO: this could use a page level allocator */
-		new_size = round_pgup(length);
-		new_buf = malloc(new_size);
-		if (!new_buf)
-			return EIO;
-		if (np->rn_size != 0) {
-			memcpy(new_buf, np->rn_buf, vp->v_size);
-			if (np->rn_owns_buf)
-				free(np->rn_buf);
+	error = ramfs_unshare_file_data(np);
+	if (error)
+		return error;
+
+	if ((size_t) length < np->rn_size) {
+		/* Release whole pages, clear the tail of the last page so
+		 * that extending the file again reads zeros
+		 */
+		ramfs_pages_free_from(np, round_pgup(length) >> __PAGE_SHIFT);
+		pgoff = (size_t) length & (__PAGE_SIZE - 1);
+		if (pgoff) {
+			page = ramfs_page_get(np, length >> __PAGE_SHIFT);
+			if (page)
+				memset(page + pgoff, 0, __PAGE_SIZE - pgoff);
 		}
-		np->rn_buf = (char *) new_buf;
-		np->rn_bufsize = new_size;
-		np->rn_owns_buf = true;
 	}
+	/* Growing the file leaves a hole that is allocated on write */
 	np->rn_size = length;
 	vp->v_size = length;
 	set_times_to_now(&(np->rn_mtime), &(np->rn_ctime), NULL);
@@ -419,9 +449,11 @@ ramfs_read(struct vnode *vp, struct vfscore_file *fp __unused,
 	else
 		len = uio->uio_resid;
 
-	set_times_to_now(&(np->rn_atime), NULL, NULL);
+	ramfs_touch_atime(np);
 
-	return vfscore_uiomove(np->rn_buf + uio->uio_offset, len, uio);
+	if (np->rn_buf)
+		return vfscore_uiomove(np->rn_buf + uio->uio_offset, len, uio);
+	return ramfs_pages_uiomove(np, len, uio);
 }
 
 int
@@ -433,11 +465,10 @@ ramfs_set_file_data(struct vnode *vp, const void *data, size_t size)
 		return EISDIR;
 	if (vp->v_type != VREG)
 		return EINVAL;
-	if (np->rn_buf)
+	if (np->rn_buf || np->rn_pages)
 		return EINVAL;
 
 	np->rn_buf = (char *) data;
-	np->rn_bufsize = size;
 	np->rn_size = size;
 	vp->v_size = size;
 	np->rn_owns_buf = false;
@@ -449,6 +480,7 @@ static int
 ramfs_write(struct vnode *vp, struct uio *uio, int ioflag)
 {
 	struct ramfs_node *np =  vp->v_data;
+	int error;
 
 	if (vp->v_type == VDIR)
 		return EISDIR;
@@ -464,33 +496,23 @@ ramfs_write(struct vnode *vp, struct uio *uio, int ioflag)
 	if (ioflag & IO_APPEND)
 		uio->uio_offset = np->rn_size;
 
-	if ((size_t) uio->uio_offset + uio->uio_resid > (size_t) vp->v_size) {
-		/* Expand the file size before writing to it */
-		off_t end_pos = uio->uio_offset + uio->uio_resid;
-
-		if (end_pos > (off_t) np->rn_bufsize) {
-			// XXX: this could use a page level allocator
-			size_t new_size = round_pgup(end_pos);
-			void *new_buf = calloc(1, new_size);
-
-			if (!new_buf)
-				return EIO;
-			if (np->rn_size != 0) {
-				memcpy(new_buf, np->rn_buf, vp->v_size);
-				if (np->rn_owns_buf)
-					free(np->rn_buf);
-			}
-			np->rn_buf = (char *) new_buf;
-			np->rn_bufsize = new_size;
-		}
-		np->rn_size = end_pos;
-		vp->v_size = end_pos;
-		np->rn_owns_buf = true;
+	error = ramfs_unshare_file_data(np);
+	if (error)
+		return error;
+
+	/* Pages are allocated on demand: Appending does not copy the
+	 * existing file contents
+	 */
+	error = ramfs_pages_uiomove(np, uio->uio_resid, uio);
+
+	/* Account for partially written data, too */
+	if ((size_t) uio->uio_offset > np->rn_size) {
+		np->rn_size = uio->uio_offset;
+		vp->v_size = uio->uio_offset;
 	}
 
 	set_times_to_now(&(np->rn_mtime), &(np->rn_ctime), NULL);
-	return vfscore_uiomove(np->rn_buf + uio->uio_offset, uio->uio_resid,
-			       uio);
+	return error;
 }
 
 static int
@@ -520,13 +542,15 @@ ramfs_rename(struct vnode *dvp1, struct vnode *vp1, const char *name1 __unused,
 		if (np == NULL)
 			return ENOMEM;
 
-		if (old_np->rn_buf) {
-			/* Copy file data */
-			np->rn_buf = old_np->rn_buf;
-			np->rn_size = old_np->rn_size;
-			np->rn_bufsize = old_np->rn_bufsize;
-			old_np->rn_buf = NULL;
-		}
+		/* Move file data */
+		np->rn_buf = old_np->rn_buf;
+		np->rn_owns_buf = old_np->rn_owns_buf;
+		np->rn_pages = old_np->rn_pages;
+		np->rn_height = old_np->rn_height;
+		np->rn_size = old_np->rn_size;
+		old_np->rn_buf = NULL;
+		old_np->rn_pages = NULL;
+		old_np->rn_height = 0;
 		/* Remove source file */
 		ramfs_remove_node(dvp1->v_data, vp1->v_data);
 	}
@@ -544,8 +568,7 @@ ramfs_readdir(struct vnode *vp, struct vfscore_file *fp, struct dirent *dir)
 
 	uk_mutex_lock(&ramfs_lock);
 
-	set_times_to_now(&(((struct ramfs_node *) vp->v_data)->rn_atime),
-			 NULL, NULL);
+	ramfs_touch_atime(vp->v_data);
 
 	if (fp->f_offset == 0) {
 		dir->d_type = DT_DIR;
@@ -602,7 +625,9 @@ ramfs_getattr(struct vnode *vnode, struct vattr *attr)
 
 	attr->va_type = np->rn_type;
 
+	uk_spin_lock(&np->rn_atime_lock);
 	memcpy(&(attr->va_atime), &(np->rn_atime), sizeof(struct timespec));
+	uk_spin_unlock(&np->rn_atime_lock);
 	memcpy(&(attr->va_ctime), &(np->rn_ctime), sizeof(struct timespec));
 	memcpy(&(attr->va_mtime), &(np->rn_mtime), sizeof(struct timespec));
 
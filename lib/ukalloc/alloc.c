@@ -70,6 +70,27 @@ int uk_alloc_register(struct uk_alloc *a)
 	return 0;
 }
 
+int uk_alloc_set_default(struct uk_alloc *a)
+{
+	struct uk_alloc *this = _uk_alloc_head;
+
+	UK_ASSERT(a);
+
+	if (this == a)
+		return 0;
+
+	/* Unlink `a` from the list and insert it as new head */
+	while (this && this->next != a)
+		this = this->next;
+	if (!this)
+		return -ENOENT;
+
+	this->next = a->next;
+	a->next = _uk_alloc_head;
+	_uk_alloc_head = a;
+	return 0;
+}
+
 #ifdef CONFIG_HAVE_MEMTAG
 #define __align_metadata_ifpages __align(MEMTAG_GRANULE)
 #else
@@ -39,6 +39,9 @@
 #include <uk/assert.h>
 #include <uk/essentials.h>
 #include <errno.h>
+#if CONFIG_LIBUKALLOC_IFSTATS
+#include <uk/counter.h>
+#endif /* CONFIG_LIBUKALLOC_IFSTATS */
 
 #ifdef __cplusplus
 extern "C" {
@@ -85,6 +88,20 @@ struct uk_alloc_stats {
 
 	__u64 nb_enomem; /* number of times failing allocation requests */
 };
+
+/* Statistics are counted per lcpu and aggregated by uk_alloc_stats_get() */
+UK_COUNTERS_DECLARE(uk_alloc_stats_lcpus, struct uk_alloc_stats);
+
+struct uk_alloc_lcpu_stats {
+	struct uk_alloc_stats_lcpus lcpus;
+#if CONFIG_UKPLAT_LCPU_MAXCOUNT > 1
+	/* High water marks of the aggregated current values. The maxima of
+	 * the replicas are meaningless if memory is freed on another lcpu.
+	 */
+	__s64 max_nb_allocs;
+	__ssz max_mem_use;
+#endif /* CONFIG_UKPLAT_LCPU_MAXCOUNT > 1 */
+};
 #endif /* CONFIG_LIBUKALLOC_IFSTATS */
 
 struct uk_alloc {
@@ -113,7 +130,7 @@ struct uk_alloc {
 	uk_alloc_addmem_func_t addmem;
 
 #if CONFIG_LIBUKALLOC_IFSTATS
-	struct uk_alloc_stats _stats;
+	struct uk_alloc_lcpu_stats _stats;
 #endif
 
 	/* internal */
@@ -47,6 +47,16 @@ extern "C" {
 
 int uk_alloc_register(struct uk_alloc *a);
 
+/**
+ * Makes a registered allocator the default allocator, i.e., the one
+ * returned by `uk_alloc_get_default()`. This is used by allocators that
+ * are stacked on top of the allocator that manages the heap.
+ *
+ * @param a Registered allocator
+ * @return 0 on success, -ENOENT if `a` is not registered
+ */
+int uk_alloc_set_default(struct uk_alloc *a);
+
 /**
  * Compatibility functions that can be used by allocator implementations to
  * fill out callback functions in `struct uk_alloc` when just a subset of the
@@ -86,7 +96,7 @@ long uk_alloc_pmaxalloc_compat(struct uk_alloc *a);
 #include <uk/preempt.h>
 
 #if CONFIG_LIBUKALLOC_IFSTATS_GLOBAL
-extern struct uk_alloc_stats _uk_alloc_stats_global;
+extern struct uk_alloc_lcpu_stats _uk_alloc_stats_global;
 #endif /* CONFIG_LIBUKALLOC_IFSTATS_GLOBAL */
 
 /* NOTE: Please do not use this function directly */
@@ -110,12 +120,43 @@ static inline void _uk_alloc_stats_refresh_minmax(struct uk_alloc_stats *stats)
 	}
 }
 
+#if CONFIG_UKPLAT_LCPU_MAXCOUNT > 1
+/* NOTE: Please do not use this macro directly */
+#define _uk_alloc_stats_max_update(max, val)				\
+	do {								\
+		__typeof__(*(max)) __old = __atomic_load_n((max),	\
+							   __ATOMIC_RELAXED); \
+		__typeof__(*(max)) __val = (val);			\
+									\
+		while (__val > __old &&					\
+		       !__atomic_compare_exchange_n((max), &__old, __val, \
+						    0, __ATOMIC_RELAXED, \
+						    __ATOMIC_RELAXED))	\
+			;						\
+	} while (0)
+
+/* NOTE: Please do not use this function directly */
+static inline void _uk_alloc_stats_refresh_max(struct uk_alloc_lcpu_stats *s)
+{
+	_uk_alloc_stats_max_update(&s->max_nb_allocs,
+				   uk_counter_sum(&s->lcpus, cur_nb_allocs));
+	_uk_alloc_stats_max_update(&s->max_mem_use,
+				   uk_counter_sum(&s->lcpus, cur_mem_use));
+}
+#else /* CONFIG_UKPLAT_LCPU_MAXCOUNT <= 1 */
+/* The maxima of the only replica are exact */
+#define _uk_alloc_stats_refresh_max(s) do {} while (0)
+#endif /* CONFIG_UKPLAT_LCPU_MAXCOUNT <= 1 */
+
 /* NOTE: Please do not use this function directly */
-static inline void _uk_alloc_stats_count_alloc(struct uk_alloc_stats *stats,
+static inline void _uk_alloc_stats_count_alloc(struct uk_alloc_lcpu_stats *s,
 					       void *ptr, __sz size)
 {
-	/* TODO: SMP safety */
+	struct uk_alloc_stats *stats;
+
+	/* Disabling preemption keeps us on the lcpu of the replica */
 	uk_preempt_disable();
+	stats = uk_counters_this(&s->lcpus);
 	if (likely(ptr)) {
 		stats->tot_nb_allocs++;
 
@@ -123,6 +164,7 @@ static inline void _uk_alloc_stats_count_alloc(struct uk_alloc_stats *stats,
 		stats->cur_mem_use += size;
 		stats->last_alloc_size = size;
 		_uk_alloc_stats_refresh_minmax(stats);
+		_uk_alloc_stats_refresh_max(s);
 	} else {
 		stats->nb_enomem++;
 	}
@@ -130,11 +172,13 @@ static inline void _uk_alloc_stats_count_alloc(struct uk_alloc_stats *stats,
 }
 
 /* NOTE: Please do not use this function directly */
-static inline void _uk_alloc_stats_count_free(struct uk_alloc_stats *stats,
+static inline void _uk_alloc_stats_count_free(struct uk_alloc_lcpu_stats *s,
 					      void *ptr, __sz size)
 {
-	/* TODO: SMP safety */
+	struct uk_alloc_stats *stats;
+
 	uk_preempt_disable();
+	stats = uk_counters_this(&s->lcpus);
 	if (likely(ptr)) {
 		stats->tot_nb_frees++;
 
@@ -53,21 +53,26 @@ static inline struct uk_alloc *_uk_alloc_get_actual_default(void)
 	return _uk_alloc_head;
 }
 
+/* NOTE: Preemption is disabled while the statistics are watched, so the
+ * allocator counts the request on the replica of our lcpu
+ */
 #define WATCH_STATS_START(p)						\
+	struct uk_alloc_stats *_ps;					\
 	__ssz _before_mem_use;						\
 	__sz _before_nb_allocs;						\
 	__sz _before_tot_nb_allocs;					\
 	__sz _before_nb_enomem;						\
 									\
 	uk_preempt_disable();						\
-	_before_mem_use       = (p)->_stats.cur_mem_use;		\
-	_before_nb_allocs     = (p)->_stats.cur_nb_allocs;		\
-	_before_tot_nb_allocs = (p)->_stats.tot_nb_allocs;		\
-	_before_nb_enomem     = (p)->_stats.nb_enomem;
+	_ps = uk_counters_this(&(p)->_stats.lcpus);			\
+	_before_mem_use       = _ps->cur_mem_use;			\
+	_before_nb_allocs     = _ps->cur_nb_allocs;			\
+	_before_tot_nb_allocs = _ps->tot_nb_allocs;			\
+	_before_nb_enomem     = _ps->nb_enomem;
 
 #define WATCH_STATS_END(p, nb_allocs_diff, nb_enomem_diff,		\
 			mem_use_diff, alloc_size)			\
-	__sz _nb_allocs = (p)->_stats.tot_nb_allocs			\
+	__sz _nb_allocs = _ps->tot_nb_allocs				\
 			  - _before_tot_nb_allocs;			\
 									\
 	/* NOTE: We assume that an allocator call does at
@@ -76,25 +81,28 @@ static inline struct uk_alloc *_uk_alloc_get_actual_default(void)
 	 */								\
 	UK_ASSERT(_nb_allocs <= 1);					\
 									\
-	*(mem_use_diff)   = (p)->_stats.cur_mem_use			\
+	*(mem_use_diff)   = _ps->cur_mem_use				\
 			    - _before_mem_use;				\
-	*(nb_allocs_diff) = (__ssz) (p)->_stats.cur_nb_allocs		\
+	*(nb_allocs_diff) = (__ssz) _ps->cur_nb_allocs			\
 			    - _before_nb_allocs;			\
-	*(nb_enomem_diff) = (__ssz) (p)->_stats.nb_enomem		\
+	*(nb_enomem_diff) = (__ssz) _ps->nb_enomem			\
 			    - _before_nb_enomem;			\
 	if (_nb_allocs > 0)						\
-		*(alloc_size) = (p)->_stats.last_alloc_size;		\
+		*(alloc_size) = _ps->last_alloc_size;			\
 	else								\
 		*(alloc_size) = 0; /* there was no new allocation */	\
 	uk_preempt_enable();
 
-static inline void update_stats(struct uk_alloc_stats *stats,
+static inline void update_stats(struct uk_alloc_lcpu_stats *s,
 				__ssz nb_allocs_diff,
 				__ssz nb_enomem_diff,
 				__ssz mem_use_diff,
 				__sz last_alloc_size)
 {
+	struct uk_alloc_stats *stats;
+
 	uk_preempt_disable();
+	stats = uk_counters_this(&s->lcpus);
 	if (nb_allocs_diff >= 0)
 		stats->tot_nb_allocs += nb_allocs_diff;
 	else
@@ -111,6 +119,8 @@ static inline void update_stats(struct uk_alloc_stats *stats,
 	 *       `_uk_alloc_stats_refresh_minmax()` from here.
 	 */
 	_uk_alloc_stats_refresh_minmax(stats);
+	if (mem_use_diff > 0 || nb_allocs_diff > 0)
+		_uk_alloc_stats_refresh_max(s);
 	uk_preempt_enable();
 }
 
@@ -323,7 +333,7 @@ static struct uk_alloc _uk_alloc_lib_default = {
 	.pavailmem      = uk_alloc_pavailmem_compat,
 	.addmem         = wrapper_addmem,
 
-	._stats         = { 0 },
+	._stats         = { { { { { 0 } } } } },
 };
 
 static __used __section(".uk_alloc_libstats") __align(8)
@@ -31,22 +31,68 @@
  * POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <uk/arch/atomic.h>
 #include <uk/store.h>
 #include <uk/alloc_impl.h>
 
 #if CONFIG_LIBUKALLOC_IFSTATS_GLOBAL
-struct uk_alloc_stats _uk_alloc_stats_global = { 0 };
+struct uk_alloc_lcpu_stats _uk_alloc_stats_global __align(CACHE_LINE_SIZE);
 #endif
 
+/*
+ * Aggregates the per-lcpu statistics. Counters are summed up. With more than
+ * one lcpu, the high water marks are kept in shared words because the ones
+ * of the replicas only grow if memory is allocated on one lcpu and freed on
+ * another. The last allocation size is the one of the current lcpu.
+ */
+static void stats_aggregate(const struct uk_alloc_lcpu_stats *s,
+			    struct uk_alloc_stats *dst)
+{
+	const struct uk_alloc_stats *c;
+	__sz idx;
+
+	memset(dst, 0, sizeof(*dst));
+
+	uk_preempt_disable();
+	uk_counters_foreach(&s->lcpus, idx) {
+		c = uk_counters_lcpu(&s->lcpus, idx);
+
+		dst->tot_nb_allocs += c->tot_nb_allocs;
+		dst->tot_nb_frees  += c->tot_nb_frees;
+		dst->cur_nb_allocs += c->cur_nb_allocs;
+		dst->cur_mem_use   += c->cur_mem_use;
+		dst->nb_enomem     += c->nb_enomem;
+
+		if (c->max_alloc_size > dst->max_alloc_size)
+			dst->max_alloc_size = c->max_alloc_size;
+		if (c->min_alloc_size && (!dst->min_alloc_size ||
+					  c->min_alloc_size
+					  < dst->min_alloc_size))
+			dst->min_alloc_size = c->min_alloc_size;
+	}
+#if CONFIG_UKPLAT_LCPU_MAXCOUNT > 1
+	dst->max_nb_allocs = ukarch_load_n(&s->max_nb_allocs);
+	dst->max_mem_use   = ukarch_load_n(&s->max_mem_use);
+#else /* CONFIG_UKPLAT_LCPU_MAXCOUNT <= 1 */
+	c = uk_counters_lcpu(&s->lcpus, 0);
+	dst->max_nb_allocs = c->max_nb_allocs;
+	dst->max_mem_use   = c->max_mem_use;
+#endif /* CONFIG_UKPLAT_LCPU_MAXCOUNT <= 1 */
+	dst->last_alloc_size = uk_counters_this(&s->lcpus)->last_alloc_size;
+	uk_preempt_enable();
+
+	/* The sum of concurrently updated replicas may exceed the maximum */
+	dst->max_nb_allocs = MAX(dst->max_nb_allocs, dst->cur_nb_allocs);
+	dst->max_mem_use   = MAX(dst->max_mem_use, dst->cur_mem_use);
+}
+
 void uk_alloc_stats_get(struct uk_alloc *a,
 			struct uk_alloc_stats *dst)
 {
 	UK_ASSERT(a);
 	UK_ASSERT(dst);
 
-	uk_preempt_disable();
-	memcpy(dst, &a->_stats, sizeof(*dst));
-	uk_preempt_enable();
+	stats_aggregate(&a->_stats, dst);
 }
 
 static int get_cur_mem_free(void *cookie __unused, __u64 *out)
@@ -61,79 +107,29 @@ void uk_alloc_stats_get_global(struct uk_alloc_stats *dst)
 {
 	UK_ASSERT(dst);
 
-	uk_preempt_disable();
-	memcpy(dst, &_uk_alloc_stats_global, sizeof(*dst));
-	uk_preempt_enable();
+	stats_aggregate(&_uk_alloc_stats_global, dst);
 }
 
-static int get_last_alloc_size(void *cookie __unused, __u64 *out)
-{
-	*out = (__u64) _uk_alloc_stats_global.last_alloc_size;
-	return 0;
-}
-UK_STORE_STATIC_ENTRY(last_alloc_size, u64, get_last_alloc_size, NULL, NULL);
-
-static int get_max_alloc_size(void *cookie __unused, __u64 *out)
-{
-	*out = (__u64) _uk_alloc_stats_global.max_alloc_size;
-	return 0;
-}
-UK_STORE_STATIC_ENTRY(max_alloc_size, u64, get_max_alloc_size, NULL, NULL);
-
-static int get_min_alloc_size(void *cookie __unused, __u64 *out)
-{
-	*out = (__u64) _uk_alloc_stats_global.min_alloc_size;
-	return 0;
-}
-UK_STORE_STATIC_ENTRY(min_alloc_size, u64, get_min_alloc_size, NULL, NULL);
-
-static int get_tot_nb_allocs(void *cookie __unused, __u64 *out)
-{
-	*out = (__u64) _uk_alloc_stats_global.tot_nb_allocs;
-	return 0;
-}
-UK_STORE_STATIC_ENTRY(tot_nb_allocs, u64, get_tot_nb_allocs, NULL, NULL);
-
-static int get_tot_nb_frees(void *cookie __unused, __u64 *out)
-{
-	*out = (__u64) _uk_alloc_stats_global.tot_nb_frees;
-	return 0;
-}
-UK_STORE_STATIC_ENTRY(tot_nb_frees, u64, get_tot_nb_frees, NULL, NULL);
-
-static int get_cur_nb_allocs(void *cookie __unused, __s64 *out)
-{
-	*out = (__s64) _uk_alloc_stats_global.cur_nb_allocs;
-	return 0;
-}
-UK_STORE_STATIC_ENTRY(cur_nb_allocs, s64, get_cur_nb_allocs, NULL, NULL);
-
-static int get_max_nb_allocs(void *cookie __unused, __s64 *out)
-{
-	*out = (__s64) _uk_alloc_stats_global.max_nb_allocs;
-	return 0;
-}
-UK_STORE_STATIC_ENTRY(max_nb_allocs, s64, get_max_nb_allocs, NULL, NULL);
-
-static int get_cur_mem_use(void *cookie __unused, __s64 *out)
-{
-	*out = (__s64) _uk_alloc_stats_global.cur_mem_use;
-	return 0;
-}
-UK_STORE_STATIC_ENTRY(cur_mem_use, s64, get_cur_mem_use, NULL, NULL);
-
-static int get_max_mem_use(void *cookie __unused, __s64 *out)
-{
-	*out = (__s64) _uk_alloc_stats_global.max_mem_use;
-	return 0;
-}
-UK_STORE_STATIC_ENTRY(max_mem_use, s64, get_max_mem_use, NULL, NULL);
-
-static int get_nb_enomem(void *cookie __unused, __u64 *out)
-{
-	*out = (__u64) _uk_alloc_stats_global.nb_enomem;
-	return 0;
-}
-UK_STORE_STATIC_ENTRY(nb_enomem, u64, get_nb_enomem, NULL, NULL);
+#define STATS_GLOBAL_GETTER(field, type)				\
+	static int get_##field(void *cookie __unused, __##type *out)	\
+	{								\
+		struct uk_alloc_stats stats;				\
+									\
+		uk_alloc_stats_get_global(&stats);			\
+		*out = (__##type) stats.field;				\
+		return 0;						\
+	}								\
+	UK_STORE_STATIC_ENTRY(field, type, get_##field, NULL, NULL)
+
+STATS_GLOBAL_GETTER(last_alloc_size, u64);
+STATS_GLOBAL_GETTER(max_alloc_size, u64);
+STATS_GLOBAL_GETTER(min_alloc_size, u64);
+STATS_GLOBAL_GETTER(tot_nb_allocs, u64);
+STATS_GLOBAL_GETTER(tot_nb_frees, u64);
+STATS_GLOBAL_GETTER(cur_nb_allocs, s64);
+STATS_GLOBAL_GETTER(max_nb_allocs, s64);
+STATS_GLOBAL_GETTER(cur_mem_use, s64);
+STATS_GLOBAL_GETTER(max_mem_use, s64);
+STATS_GLOBAL_GETTER(nb_enomem, u64);
 
 #endif
@@ -0,0 +1,34 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2023, Unikraft GmbH and The Unikraft Authors.
+ * Licensed under the BSD-3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ */
+
+#ifndef __LIBUKALLOCSLAB_H__
+#define __LIBUKALLOCSLAB_H__
+
+#include <uk/alloc.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Initializes a slab allocator on top of a page allocator. Small
+ * allocations are served from per-size-class slabs, larger ones from
+ * whole pages of the parent. The metadata of the slab allocator is
+ * allocated from the parent as well.
+ *
+ * @param parent
+ *  Allocator that provides the pages (must implement palloc() and pfree()).
+ * @return
+ *  - (NULL): If the allocation of the metadata failed.
+ *  - pointer to the initialized allocator.
+ */
+struct uk_alloc *uk_allocslab_init(struct uk_alloc *parent);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __LIBUKALLOCSLAB_H__ */
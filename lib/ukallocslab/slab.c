@@ -0,0 +1,573 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2023, Unikraft GmbH and The Unikraft Authors.
+ * Licensed under the BSD-3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ */
+
+/*
+ * SLAB: MEMORY LAYOUT
+ *
+ * Every allocation is found through a header at the start of a page:
+ *
+ * Slab (one page, objects of a single size class):
+ *  +--------+--------+--------+--------+- ... -+--------+---------+
+ *  | header | object | object | object |       | object | (unused)|
+ *  +--------+--------+--------+--------+- ... -+--------+---------+
+ *  ^ page boundary
+ *  ^- SLAB_HDR_SIZE -^
+ *
+ * Free objects of a slab are linked through their first word (in-object
+ * free list). Since objects never start at a page boundary, the header of
+ * the slab is found by aligning the object address down to the page.
+ *
+ * Large allocation (whole pages of the parent allocator):
+ *  +--------+-------------------------------- ... ---+
+ *  | header | object                                 |
+ *  +--------+-------------------------------- ... ---+
+ *  ^ page boundary
+ *
+ * For page-aligned large objects, the header is stored at the start of
+ * the page preceding the object (like uk_malloc_ifpages()).
+ */
+
+#include <string.h>
+#include <errno.h>
+#include <uk/essentials.h>
+#include <uk/alloc_impl.h>
+#include <uk/allocslab.h>
+#include <uk/plat/spinlock.h>
+#include <uk/arch/paging.h>
+#include <uk/plat/lcpu.h>
+#include <uk/list.h>
+#include <uk/print.h>
+
+#define SLAB_MAGIC		0x534c4142 /* "SLAB" */
+#define SLAB_LARGE_MAGIC	0x4c524745 /* "LRGE" */
+
+/* Room for the page header; also the alignment of the first object */
+#define SLAB_HDR_SIZE		64
+
+/* Size granularity of the class lookup table */
+#define SLAB_GRAN_SHIFT		4
+#define SLAB_GRAN		(1UL << SLAB_GRAN_SHIFT)
+
+static const __sz slab_class_size[] = {
+	16, 32, 48, 64, 96, 128, 192, 256, 384, 512, 768, 1024
+};
+
+#define SLAB_NR_CLASSES		ARRAY_SIZE(slab_class_size)
+#define SLAB_MAX_SIZE		1024
+#define SLAB_NR_GRANS		((SLAB_MAX_SIZE >> SLAB_GRAN_SHIFT) + 1)
+
+struct slab_hdr {
+	__u32 magic;
+	__u16 cidx;		/* size class */
+	__u16 inuse;		/* number of allocated objects */
+	void *free;		/* in-object free list */
+	struct uk_list_head list; /* entry in the partial list of the class */
+};
+
+UK_CTASSERT(sizeof(struct slab_hdr) <= SLAB_HDR_SIZE);
+
+struct slab_large_hdr {
+	__u32 magic;
+	unsigned long num_pages;
+	void *base;
+};
+
+UK_CTASSERT(sizeof(struct slab_large_hdr) <= SLAB_HDR_SIZE);
+
+struct slab_class {
+	__sz obj_size;
+	__sz obj_align;
+	__u16 objs_per_slab;
+	/* Slabs with free objects, partially used slabs first */
+	struct uk_list_head partial;
+	unsigned int nr_empty;
+	__spinlock lock;
+};
+
+#if CONFIG_LIBUKALLOCSLAB_MAGAZINES
+struct slab_magazine {
+	unsigned int count;
+	void *objs[CONFIG_LIBUKALLOCSLAB_MAGAZINE_SIZE];
+};
+#endif /* CONFIG_LIBUKALLOCSLAB_MAGAZINES */
+
+struct uk_allocslab {
+	struct uk_alloc *parent;
+	unsigned long meta_pages;
+	__u8 class_idx[SLAB_NR_GRANS];
+	struct slab_class classes[SLAB_NR_CLASSES];
+#if CONFIG_LIBUKALLOCSLAB_MAGAZINES
+	struct slab_magazine mags[CONFIG_UKPLAT_LCPU_MAXCOUNT][SLAB_NR_CLASSES];
+#endif /* CONFIG_LIBUKALLOCSLAB_MAGAZINES */
+};
+
+#define to_allocslab(a)	((struct uk_allocslab *)&(a)->priv)
+
+static inline int slab_class_of(struct uk_allocslab *s, __sz size)
+{
+	UK_ASSERT(size && size <= SLAB_MAX_SIZE);
+	return s->class_idx[(size + SLAB_GRAN - 1) >> SLAB_GRAN_SHIFT];
+}
+
+/*
+ * Slab management; the caller holds the lock of the size class
+ */
+static struct slab_hdr *slab_create(struct uk_allocslab *s, int cidx)
+{
+	struct slab_class *c = &s->classes[cidx];
+	struct slab_hdr *slab;
+	__u8 *obj;
+	void **prev;
+	__u16 i;
+
+	slab = uk_palloc(s->parent, 1);
+	if (unlikely(!slab))
+		return NULL;
+
+	slab->magic = SLAB_MAGIC;
+	slab->cidx = cidx;
+	slab->inuse = 0;
+
+	prev = &slab->free;
+	obj = (__u8 *)slab + SLAB_HDR_SIZE;
+	for (i = 0; i < c->objs_per_slab; i++, obj += c->obj_size) {
+		*prev = obj;
+		prev = (void **)obj;
+	}
+	*prev = NULL;
+
+	uk_list_add(&slab->list, &c->partial);
+	c->nr_empty++;
+	return slab;
+}
+
+static void *slab_obj_take(struct uk_allocslab *s, int cidx)
+{
+	struct slab_class *c = &s->classes[cidx];
+	struct slab_hdr *slab;
+	void *obj;
+
+	slab = uk_list_first_entry_or_null(&c->partial, struct slab_hdr, list);
+	if (!slab) {
+		slab = slab_create(s, cidx);
+		if (unlikely(!slab))
+			return NULL;
+	}
+
+	UK_ASSERT(slab->free);
+	obj = slab->free;
+	slab->free = *(void **)obj;
+	if (slab->inuse++ == 0)
+		c->nr_empty--;
+
+	/* Full slabs are not tracked; they return with the next free */
+	if (!slab->free)
+		uk_list_del(&slab->list);
+	return obj;
+}
+
+static void slab_obj_put(struct uk_allocslab *s, struct slab_hdr *slab,
+			 void *obj)
+{
+	struct slab_class *c = &s->classes[slab->cidx];
+
+	UK_ASSERT(slab->inuse > 0);
+
+	if (!slab->free) {
+		/* The slab was full: prefer it for the next allocations */
+		uk_list_add(&slab->list, &c->partial);
+	}
+
+	*(void **)obj = slab->free;
+	slab->free = obj;
+	if (--slab->inuse > 0)
+		return;
+
+	/* The slab is empty now: keep a few for reuse */
+	if (c->nr_empty < CONFIG_LIBUKALLOCSLAB_EMPTY_SLABS) {
+		c->nr_empty++;
+		uk_list_del(&slab->list);
+		uk_list_add_tail(&slab->list, &c->partial);
+		return;
+	}
+
+	uk_list_del(&slab->list);
+	slab->magic = 0;
+	uk_pfree(s->parent, slab, 1);
+}
+
+#if CONFIG_LIBUKALLOCSLAB_MAGAZINES
+#define SLAB_MAG_BATCH	((CONFIG_LIBUKALLOCSLAB_MAGAZINE_SIZE + 1) / 2)
+
+static void *slab_obj_alloc(struct uk_allocslab *s, int cidx)
+{
+	struct slab_class *c = &s->classes[cidx];
+	struct slab_magazine *mag;
+	unsigned long flags;
+	void *obj = NULL;
+
+	flags = ukplat_lcpu_save_irqf();
+	mag = &s->mags[ukplat_lcpu_idx()][cidx];
+	if (unlikely(!mag->count)) {
+		/* Refill half of the magazine from the slabs */
+		ukarch_spin_lock(&c->lock);
+		while (mag->count < SLAB_MAG_BATCH) {
+			obj = slab_obj_take(s, cidx);
+			if (unlikely(!obj))
+				break;
+			mag->objs[mag->count++] = obj;
+		}
+		ukarch_spin_unlock(&c->lock);
+	}
+	if (likely(mag->count))
+		obj = mag->objs[--mag->count];
+	ukplat_lcpu_restore_irqf(flags);
+	return obj;
+}
+
+static void slab_obj_free(struct uk_allocslab *s, struct slab_hdr *slab,
+			  void *obj)
+{
+	struct slab_class *c = &s->classes[slab->cidx];
+	struct slab_magazine *mag;
+	unsigned long flags;
+	void *flush;
+
+	flags = ukplat_lcpu_save_irqf();
+	mag = &s->mags[ukplat_lcpu_idx()][slab->cidx];
+	if (unlikely(mag->count == CONFIG_LIBUKALLOCSLAB_MAGAZINE_SIZE)) {
+		/* Flush half of the magazine to the slabs */
+		ukarch_spin_lock(&c->lock);
+		while (mag->count > CONFIG_LIBUKALLOCSLAB_MAGAZINE_SIZE
+				    - SLAB_MAG_BATCH) {
+			flush = mag->objs[--mag->count];
+			slab_obj_put(s, (struct slab_hdr *)
+				     PAGE_ALIGN_DOWN((__uptr)flush), flush);
+		}
+		ukarch_spin_unlock(&c->lock);
+	}
+	mag->objs[mag->count++] = obj;
+	ukplat_lcpu_restore_irqf(flags);
+}
+#else /* !CONFIG_LIBUKALLOCSLAB_MAGAZINES */
+static void *slab_obj_alloc(struct uk_allocslab *s, int cidx)
+{
+	struct slab_class *c = &s->classes[cidx];
+	unsigned long flags;
+	void *obj;
+
+	ukplat_spin_lock_irqsave(&c->lock, flags);
+	obj = slab_obj_take(s, cidx);
+	ukplat_spin_unlock_irqrestore(&c->lock, flags);
+	return obj;
+}
+
+static void slab_obj_free(struct uk_allocslab *s, struct slab_hdr *slab,
+			  void *obj)
+{
+	struct slab_class *c = &s->classes[slab->cidx];
+	unsigned long flags;
+
+	ukplat_spin_lock_irqsave(&c->lock, flags);
+	slab_obj_put(s, slab, obj);
+	ukplat_spin_unlock_irqrestore(&c->lock, flags);
+}
+#endif /* !CONFIG_LIBUKALLOCSLAB_MAGAZINES */
+
+/*
+ * Large allocations
+ */
+static void *slab_large_alloc(struct uk_allocslab *s, __sz size, __sz align)
+{
+	struct slab_large_hdr *hdr;
+	unsigned long num_pages;
+	__sz offset;
+	__uptr base, ptr;
+
+	/* Worst-case offset of the object from the first page */
+	if (align < __PAGE_SIZE)
+		offset = MAX((__sz)SLAB_HDR_SIZE, align);
+	else if (align == __PAGE_SIZE)
+		offset = __PAGE_SIZE;
+	else
+		offset = align;
+
+	if (unlikely(size > (~(__sz)0) - offset - __PAGE_SIZE))
+		return NULL;
+
+	num_pages = PAGE_ALIGN_UP(offset + size) >> __PAGE_SHIFT;
+	base = (__uptr)uk_palloc(s->parent, num_pages);
+	if (unlikely(!base))
+		return NULL;
+
+	if (align <= SLAB_HDR_SIZE)
+		ptr = base + SLAB_HDR_SIZE;
+	else if (align < __PAGE_SIZE)
+		ptr = ALIGN_UP(base + SLAB_HDR_SIZE, (__uptr)align);
+	else
+		ptr = ALIGN_UP(base + __PAGE_SIZE, (__uptr)align);
+
+	if (PAGE_ALIGNED(ptr))
+		hdr = (struct slab_large_hdr *)(ptr - __PAGE_SIZE);
+	else
+		hdr = (struct slab_large_hdr *)PAGE_ALIGN_DOWN(ptr);
+	UK_ASSERT((__uptr)hdr >= base);
+
+	hdr->magic = SLAB_LARGE_MAGIC;
+	hdr->num_pages = num_pages;
+	hdr->base = (void *)base;
+	return (void *)ptr;
+}
+
+/* Returns the header of the page that describes `ptr` */
+static inline void *slab_hdr_of(const void *ptr)
+{
+	/* Slab objects are never page-aligned */
+	if (PAGE_ALIGNED((__uptr)ptr))
+		return (void *)((__uptr)ptr - __PAGE_SIZE);
+	return (void *)PAGE_ALIGN_DOWN((__uptr)ptr);
+}
+
+/* Number of bytes usable at `ptr` */
+static __sz slab_usable_size(struct uk_allocslab *s, const void *ptr)
+{
+	struct slab_large_hdr *lhdr;
+	struct slab_hdr *slab;
+
+	slab = slab_hdr_of(ptr);
+	if (slab->magic == SLAB_MAGIC)
+		return s->classes[slab->cidx].obj_size;
+
+	lhdr = (struct slab_large_hdr *)slab;
+	UK_ASSERT(lhdr->magic == SLAB_LARGE_MAGIC);
+	return (__uptr)lhdr->base + (lhdr->num_pages << __PAGE_SHIFT)
+	       - (__uptr)ptr;
+}
+
+/*
+ * uk_alloc interface
+ */
+static void *uk_allocslab_malloc(struct uk_alloc *a, __sz size)
+{
+	struct uk_allocslab *s;
+	void *ptr;
+
+	UK_ASSERT(a);
+	s = to_allocslab(a);
+
+	if (unlikely(!size))
+		return NULL;
+
+	if (size <= SLAB_MAX_SIZE)
+		ptr = slab_obj_alloc(s, slab_class_of(s, size));
+	else
+		ptr = slab_large_alloc(s, size, SLAB_HDR_SIZE);
+
+	if (unlikely(!ptr)) {
+		uk_alloc_stats_count_enomem(a, size);
+		errno = ENOMEM;
+		return NULL;
+	}
+	uk_alloc_stats_count_alloc(a, ptr, slab_usable_size(s, ptr));
+	return ptr;
+}
+
+static int uk_allocslab_posix_memalign(struct uk_alloc *a, void **memptr,
+				       __sz align, __sz size)
+{
+	struct uk_allocslab *s;
+	int cidx;
+	void *ptr = NULL;
+
+	UK_ASSERT(a);
+	UK_ASSERT(memptr);
+	s = to_allocslab(a);
+
+	if (((align - 1) & align) != 0
+	    || (align % sizeof(void *)) != 0)
+		return EINVAL;
+	if (!size)
+		return EINVAL;
+
+	if (size <= SLAB_MAX_SIZE && align <= SLAB_HDR_SIZE) {
+		/* Find the first class whose objects are aligned enough */
+		for (cidx = slab_class_of(s, size);
+		     cidx < (int)SLAB_NR_CLASSES; cidx++) {
+			if (s->classes[cidx].obj_align >= align)
+				break;
+		}
+		if (cidx < (int)SLAB_NR_CLASSES)
+			ptr = slab_obj_alloc(s, cidx);
+		else
+			ptr = slab_large_alloc(s, size, align);
+	} else {
+		ptr = slab_large_alloc(s, size, align);
+	}
+
+	if (unlikely(!ptr)) {
+		uk_alloc_stats_count_enomem(a, size);
+		return ENOMEM;
+	}
+	uk_alloc_stats_count_alloc(a, ptr, slab_usable_size(s, ptr));
+	*memptr = ptr;
+	return 0;
+}
+
+static void uk_allocslab_free(struct uk_alloc *a, void *ptr)
+{
+	struct slab_large_hdr *lhdr;
+	struct uk_allocslab *s;
+	struct slab_hdr *slab;
+
+	UK_ASSERT(a);
+	s = to_allocslab(a);
+
+	if (!ptr)
+		return;
+
+	uk_alloc_stats_count_free(a, ptr, slab_usable_size(s, ptr));
+
+	slab = slab_hdr_of(ptr);
+	if (slab->magic == SLAB_MAGIC) {
+		UK_ASSERT(((__uptr)ptr - (__uptr)slab - SLAB_HDR_SIZE)
+			  % s->classes[slab->cidx].obj_size == 0);
+		slab_obj_free(s, slab, ptr);
+		return;
+	}
+
+	lhdr = (struct slab_large_hdr *)slab;
+	UK_ASSERT(lhdr->magic == SLAB_LARGE_MAGIC);
+	lhdr->magic = 0;
+	uk_pfree(s->parent, lhdr->base, lhdr->num_pages);
+}
+
+static void *uk_allocslab_realloc(struct uk_alloc *a, void *ptr, __sz size)
+{
+	struct uk_allocslab *s;
+	__sz usable;
+	void *retptr;
+
+	UK_ASSERT(a);
+	s = to_allocslab(a);
+
+	if (!ptr)
+		return uk_allocslab_malloc(a, size);
+
+	if (!size) {
+		uk_allocslab_free(a, ptr);
+		return NULL;
+	}
+
+	/* The object has room for the new size already */
+	usable = slab_usable_size(s, ptr);
+	if (size <= usable)
+		return ptr;
+
+	retptr = uk_allocslab_malloc(a, size);
+	if (!retptr)
+		return NULL;
+
+	memcpy(retptr, ptr, usable);
+	uk_allocslab_free(a, ptr);
+	return retptr;
+}
+
+static void *uk_allocslab_palloc(struct uk_alloc *a, unsigned long num_pages)
+{
+	UK_ASSERT(a);
+	return uk_palloc(to_allocslab(a)->parent, num_pages);
+}
+
+static void uk_allocslab_pfree(struct uk_alloc *a, void *ptr,
+			       unsigned long num_pages)
+{
+	UK_ASSERT(a);
+	uk_pfree(to_allocslab(a)->parent, ptr, num_pages);
+}
+
+static long uk_allocslab_pmaxalloc(struct uk_alloc *a)
+{
+	UK_ASSERT(a);
+	return uk_alloc_pmaxalloc(to_allocslab(a)->parent);
+}
+
+static __ssz uk_allocslab_maxalloc(struct uk_alloc *a)
+{
+	UK_ASSERT(a);
+	return uk_alloc_maxalloc(to_allocslab(a)->parent);
+}
+
+static int uk_allocslab_addmem(struct uk_alloc *a, void *base, __sz len)
+{
+	UK_ASSERT(a);
+	return uk_alloc_addmem(to_allocslab(a)->parent, base, len);
+}
+
+struct uk_alloc *uk_allocslab_init(struct uk_alloc *parent)
+{
+	struct uk_allocslab *s;
+	struct uk_alloc *a;
+	unsigned long meta_pages;
+	struct slab_class *c;
+	__sz gran;
+	int cidx;
+
+	UK_ASSERT(parent);
+	UK_ASSERT(parent->palloc && parent->pfree);
+
+	meta_pages = PAGE_ALIGN_UP(sizeof(*a) + sizeof(*s)) >> __PAGE_SHIFT;
+	a = uk_palloc(parent, meta_pages);
+	if (unlikely(!a)) {
+		uk_pr_err("Failed to allocate slab allocator metadata\n");
+		return NULL;
+	}
+	memset(a, 0, meta_pages << __PAGE_SHIFT);
+
+	s = to_allocslab(a);
+	s->parent = parent;
+	s->meta_pages = meta_pages;
+
+	for (cidx = 0; cidx < (int)SLAB_NR_CLASSES; cidx++) {
+		c = &s->classes[cidx];
+		c->obj_size = slab_class_size[cidx];
+		/* Objects start at SLAB_HDR_SIZE: cap the natural alignment */
+		c->obj_align = MIN(c->obj_size & -c->obj_size,
+				   (__sz)SLAB_HDR_SIZE);
+		c->objs_per_slab = (__PAGE_SIZE - SLAB_HDR_SIZE) / c->obj_size;
+		UK_INIT_LIST_HEAD(&c->partial);
+		ukarch_spin_init(&c->lock);
+	}
+
+	/* Lookup table: smallest class that fits each granule */
+	for (gran = 0, cidx = 0; gran < SLAB_NR_GRANS; gran++) {
+		while (slab_class_size[cidx] < (gran << SLAB_GRAN_SHIFT))
+			cidx++;
+		s->class_idx[gran] = cidx;
+	}
+
+	a->malloc         = uk_allocslab_malloc;
+	a->calloc         = uk_calloc_compat;
+	a->realloc        = uk_allocslab_realloc;
+	a->posix_memalign = uk_allocslab_posix_memalign;
+	a->memalign       = uk_memalign_compat;
+	a->free           = uk_allocslab_free;
+	a->palloc         = uk_allocslab_palloc;
+	a->pfree          = uk_allocslab_pfree;
+	/* Free memory is accounted by the parent: Leaving availmem() and
+	 * pavailmem() unset avoids counting it twice in the totals.
+	 */
+	a->availmem       = NULL;
+	a->pavailmem      = NULL;
+	a->maxalloc       = uk_allocslab_maxalloc;
+	a->pmaxalloc      = uk_allocslab_pmaxalloc;
+	a->addmem         = uk_allocslab_addmem;
+
+	uk_alloc_stats_reset(a);
+	uk_alloc_register(a);
+
+	uk_pr_info("Initialize slab allocator @ %p on %p\n", a, parent);
+	return a;
+}
@@ -43,6 +43,9 @@
 #include <uk/ctors.h>
 #include <uk/arch/atomic.h>
 #include <uk/blkdev.h>
+#if CONFIG_LIBUKBLKDEV_STATS
+#include <uk/plat/time.h>
+#endif
 
 struct uk_blkdev_list uk_blkdev_list =
 UK_TAILQ_HEAD_INITIALIZER(uk_blkdev_list);
@@ -55,9 +58,17 @@ static struct uk_blkdev_data *_alloc_data(struct uk_alloc *a,
 {
 	struct uk_blkdev_data *data;
 
+#if CONFIG_LIBUKBLKDEV_STATS
+	/* Keep the per-queue counters on their own cache lines */
+	data = uk_memalign(a, __alignof__(*data), sizeof(*data));
+	if (!data)
+		return NULL;
+	memset(data, 0, sizeof(*data));
+#else
 	data = uk_calloc(a, 1, sizeof(*data));
 	if (!data)
 		return NULL;
+#endif
 
 	data->drv_name = drv_name;
 	data->state    = UK_BLKDEV_UNCONFIGURED;
@@ -384,6 +395,14 @@ int uk_blkdev_queue_submit_one(struct uk_blkdev *dev,
 		uint16_t queue_id,
 		struct uk_blkreq *req)
 {
+#if CONFIG_LIBUKBLKDEV_STATS
+	struct uk_blkdev_queue_stats *stats;
+	enum uk_blkreq_op op;
+	__sector nb_sectors;
+	__u32 inflight;
+	int rc;
+#endif
+
 	UK_ASSERT(dev);
 	UK_ASSERT(dev->_data);
 	UK_ASSERT(dev->submit_one);
@@ -392,7 +411,39 @@ int uk_blkdev_queue_submit_one(struct uk_blkdev *dev,
 	UK_ASSERT(!PTRISERR(dev->_queue[queue_id]));
 	UK_ASSERT(req != NULL);
 
+#if CONFIG_LIBUKBLKDEV_STATS
+	/* The request may complete and be released before submit_one()
+	 * returns, so everything we need afterwards is read beforehand
+	 */
+	stats = &dev->_data->queue_stats[queue_id];
+	op = req->operation;
+	nb_sectors = req->nb_sectors;
+	req->_stats = stats;
+	inflight = ukarch_inc(&stats->inflight) + 1;
+	if (inflight > stats->inflight_max)
+		stats->inflight_max = inflight;
+	req->_submit_ts = ukplat_monotonic_clock();
+
+	rc = dev->submit_one(dev, dev->_queue[queue_id], req);
+	if (uk_blkdev_status_successful(rc)) {
+		stats->reqs++;
+		if (op == UK_BLKREQ_READ)
+			stats->rd_sectors += nb_sectors;
+		else if (op == UK_BLKREQ_WRITE)
+			stats->wr_sectors += nb_sectors;
+		if (!(rc & UK_BLKDEV_STATUS_MORE))
+			stats->full++;
+	} else {
+		ukarch_dec(&stats->inflight);
+		if (rc < 0)
+			stats->errors++;
+		else
+			stats->full++;
+	}
+	return rc;
+#else /* !CONFIG_LIBUKBLKDEV_STATS */
 	return dev->submit_one(dev, dev->_queue[queue_id], req);
+#endif /* !CONFIG_LIBUKBLKDEV_STATS */
 }
 
 int uk_blkdev_queue_finish_reqs(struct uk_blkdev *dev,
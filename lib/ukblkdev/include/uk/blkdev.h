@@ -424,6 +424,33 @@ int uk_blkdev_queue_submit_one(struct uk_blkdev *dev, uint16_t queue_id,
  */
 int uk_blkdev_queue_finish_reqs(struct uk_blkdev *dev, uint16_t queue_id);
 
+#if CONFIG_LIBUKBLKDEV_STATS
+/**
+ * Reads the data path counters of a queue. The counters are updated
+ * without synchronization, so the result is a snapshot.
+ *
+ * @param dev
+ *	The Unikraft Block Device
+ * @param queue_id
+ *	queue id
+ * @param stats
+ *	Reference to the structure that is filled with the counters
+ * @return
+ *	- 0: Success
+ */
+int uk_blkdev_queue_stats_get(struct uk_blkdev *dev, uint16_t queue_id,
+		struct uk_blkdev_queue_stats *stats);
+
+/**
+ * Resets the data path counters of all queues of a block device, except
+ * for the number of requests in flight.
+ *
+ * @param dev
+ *	The Unikraft Block Device
+ */
+void uk_blkdev_stats_reset(struct uk_blkdev *dev);
+#endif /* CONFIG_LIBUKBLKDEV_STATS */
+
 #if CONFIG_LIBUKBLKDEV_SYNC_IO_BLOCKED_WAITING
 /**
  * Make a sync io request on a specific queue.
@@ -43,6 +43,9 @@
 #include <uk/sched.h>
 #include <uk/semaphore.h>
 #endif
+#if CONFIG_LIBUKBLKDEV_STATS
+#include <uk/arch/lcpu.h>
+#endif
 
 /**
  * Unikraft block API common declarations.
@@ -240,6 +243,38 @@ struct uk_blkdev_cap {
 	uint16_t ioalign;
 };
 
+#if CONFIG_LIBUKBLKDEV_STATS
+/* Number of buckets of the completion latency histogram */
+#define UK_BLKDEV_STATS_LAT_BUCKETS 16
+
+/**
+ * Data path counters of a queue (see: `uk_blkdev_queue_stats_get()`).
+ * Each queue has its counters on separate cache lines.
+ */
+struct uk_blkdev_queue_stats {
+	/* Submitted requests */
+	__u64 reqs;
+	/* Completed requests */
+	__u64 completed;
+	/* Sectors of submitted read and write requests */
+	__u64 rd_sectors;
+	__u64 wr_sectors;
+	/* Failed submissions and completions */
+	__u64 errors;
+	/* Submissions that found or left the queue full */
+	__u64 full;
+	/* Submitted requests that are not completed yet */
+	__u32 inflight;
+	/* Highest number of requests in flight */
+	__u32 inflight_max;
+	/* Completion latencies: Bucket 0 counts requests that completed
+	 * within 1us, bucket i (i > 0) the ones that completed within
+	 * [2^(i-1), 2^i) us. The last bucket counts all slower requests.
+	 */
+	__u64 lat_hist[UK_BLKDEV_STATS_LAT_BUCKETS];
+} __align(CACHE_LINE_SIZE);
+#endif /* CONFIG_LIBUKBLKDEV_STATS */
+
 /**
  * @internal
  * Event handler configuration (internal to libukblkdev)
@@ -278,6 +313,11 @@ struct uk_blkdev_data {
 	/* Event handler for each queue */
 	struct uk_blkdev_event_handler
 		queue_handler[CONFIG_LIBUKBLKDEV_MAXNBQUEUES];
+#if CONFIG_LIBUKBLKDEV_STATS
+	/* Data path counters for each queue */
+	struct uk_blkdev_queue_stats
+		queue_stats[CONFIG_LIBUKBLKDEV_MAXNBQUEUES];
+#endif
 	/* Name of device*/
 	const char *drv_name;
 	/* Allocator */
@@ -36,6 +36,10 @@
 
 #include <uk/blkdev_core.h>
 #include <uk/assert.h>
+#if CONFIG_LIBUKBLKDEV_STATS
+#include <uk/essentials.h>
+#include <uk/plat/time.h>
+#endif
 
 /**
  * Unikraft block driver API.
@@ -95,6 +99,37 @@ static inline void uk_blkdev_drv_queue_event(struct uk_blkdev *dev,
 #endif
 }
 
+#if CONFIG_LIBUKBLKDEV_STATS
+/* Accounts the completion of a request to the queue it was submitted to */
+static inline void _uk_blkdev_stats_req_finished(struct uk_blkreq *req)
+{
+	struct uk_blkdev_queue_stats *stats = req->_stats;
+	__nsec lat;
+	unsigned int bucket;
+
+	UK_ASSERT(stats);
+
+	lat = ukarch_time_nsec_to_usec(ukplat_monotonic_clock()
+				       - req->_submit_ts);
+	bucket = lat ? MIN(ukarch_flsl(lat) + 1,
+			   (unsigned int) UK_BLKDEV_STATS_LAT_BUCKETS - 1) : 0;
+	stats->lat_hist[bucket]++;
+	stats->completed++;
+	if (unlikely(req->result < 0))
+		stats->errors++;
+	ukarch_dec(&stats->inflight);
+}
+
+/**
+ * Sets a request as finished.
+ *
+ * @param req
+ *	uk_blkreq structure
+ */
+#define uk_blkreq_finished(req)						\
+	(_uk_blkdev_stats_req_finished(req),				\
+	 ukarch_store_n(&(req)->state.counter, UK_BLKREQ_FINISHED))
+#else /* !CONFIG_LIBUKBLKDEV_STATS */
 /**
  * Sets a request as finished.
  *
@@ -103,6 +138,7 @@ static inline void uk_blkdev_drv_queue_event(struct uk_blkdev *dev,
  */
 #define uk_blkreq_finished(req) \
 	(ukarch_store_n(&(req)->state.counter, UK_BLKREQ_FINISHED))
+#endif /* !CONFIG_LIBUKBLKDEV_STATS */
 
 /**
  * Frees the data allocated for the Unikraft Block Device.
@@ -33,7 +33,11 @@
 #ifndef UK_BLKREQ_H_
 #define UK_BLKREQ_H_
 
+#include <uk/config.h>
 #include <uk/arch/types.h>
+#if CONFIG_LIBUKBLKDEV_STATS
+#include <uk/arch/time.h>
+#endif
 
 /**
  * Unikraft block API request declaration.
@@ -51,6 +55,9 @@ typedef __sz __sector;
 #define __PRIsctr __PRIsz
 
 struct uk_blkreq;
+#if CONFIG_LIBUKBLKDEV_STATS
+struct uk_blkdev_queue_stats;
+#endif
 
 /**
  *	Operation status
@@ -105,6 +112,14 @@ struct uk_blkreq {
 	/* Result status of operation (< 0 on errors)*/
 	int					result;
 
+#if CONFIG_LIBUKBLKDEV_STATS
+	/* Internal members */
+	/* Time of submission */
+	__nsec					_submit_ts;
+	/* Counters of the queue the request was submitted to */
+	struct uk_blkdev_queue_stats		*_stats;
+#endif
+
 };
 
 /**
@@ -0,0 +1,174 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2023, Unikraft GmbH and The Unikraft Authors.
+ * Licensed under the BSD-3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ */
+
+/*
+ * Per-queue data path statistics
+ *
+ * The counters are updated on request submission and completion. With
+ * libukstore, they are additionally exported as static entries. The entries
+ * `stats_dev` and `stats_queue` select the device and queue that the counter
+ * entries report. With the default selection (`STATS_ALL`), the counters of
+ * all queues of all devices are summed up (`inflight_max` reports the
+ * maximum instead). The completion latency histogram is exported as the
+ * entries `lat_hist_00` to `lat_hist_15`.
+ */
+
+#include <string.h>
+#include <errno.h>
+#include <uk/blkdev.h>
+#include <uk/store.h>
+#include <uk/essentials.h>
+
+#define STATS_ALL	UINT16_MAX
+
+int uk_blkdev_queue_stats_get(struct uk_blkdev *dev, uint16_t queue_id,
+		struct uk_blkdev_queue_stats *stats)
+{
+	UK_ASSERT(dev);
+	UK_ASSERT(dev->_data);
+	UK_ASSERT(queue_id < CONFIG_LIBUKBLKDEV_MAXNBQUEUES);
+	UK_ASSERT(stats);
+
+	*stats = dev->_data->queue_stats[queue_id];
+	return 0;
+}
+
+void uk_blkdev_stats_reset(struct uk_blkdev *dev)
+{
+	struct uk_blkdev_queue_stats *stats;
+	uint16_t q;
+
+	UK_ASSERT(dev);
+	UK_ASSERT(dev->_data);
+
+	for (q = 0; q < CONFIG_LIBUKBLKDEV_MAXNBQUEUES; ++q) {
+		stats = &dev->_data->queue_stats[q];
+		/* `inflight` is still needed to account pending completions */
+		memset(stats, 0, __offsetof(struct uk_blkdev_queue_stats,
+					    inflight));
+		stats->inflight_max = stats->inflight;
+		memset(stats->lat_hist, 0, sizeof(stats->lat_hist));
+	}
+}
+
+static __u16 stats_dev = STATS_ALL;
+static __u16 stats_queue = STATS_ALL;
+
+static int get_stats_sel(void *cookie, __u16 *out)
+{
+	*out = *((__u16 *) cookie);
+	return 0;
+}
+
+static int set_stats_sel(void *cookie, __u16 val)
+{
+	*((__u16 *) cookie) = val;
+	return 0;
+}
+
+UK_STORE_STATIC_ENTRY(stats_dev, u16, get_stats_sel, set_stats_sel,
+		      &stats_dev);
+UK_STORE_STATIC_ENTRY(stats_queue, u16, get_stats_sel, set_stats_sel,
+		      &stats_queue);
+
+/* Calls `fn` for the counters of every selected queue */
+static int stats_foreach(void (*fn)(struct uk_blkdev_queue_stats *stats,
+				    __sz off, __u64 *out),
+			 __sz off, __u64 *out)
+{
+	struct uk_blkdev *dev;
+	unsigned int i, q;
+	int found = 0;
+
+	*out = 0;
+	for (i = 0; i < uk_blkdev_count(); ++i) {
+		if (stats_dev != STATS_ALL && stats_dev != i)
+			continue;
+		dev = uk_blkdev_get(i);
+		if (!dev)
+			continue;
+
+		found = 1;
+		for (q = 0; q < CONFIG_LIBUKBLKDEV_MAXNBQUEUES; ++q) {
+			if (stats_queue != STATS_ALL && stats_queue != q)
+				continue;
+			fn(&dev->_data->queue_stats[q], off, out);
+		}
+	}
+	return found ? 0 : -ENODEV;
+}
+
+static void stats_add_u64(struct uk_blkdev_queue_stats *stats, __sz off,
+			  __u64 *out)
+{
+	*out += *((__u64 *)((__uptr) stats + off));
+}
+
+static void stats_add_u32(struct uk_blkdev_queue_stats *stats, __sz off,
+			  __u64 *out)
+{
+	*out += *((__u32 *)((__uptr) stats + off));
+}
+
+static void stats_max_u32(struct uk_blkdev_queue_stats *stats, __sz off,
+			  __u64 *out)
+{
+	*out = MAX(*out, (__u64) *((__u32 *)((__uptr) stats + off)));
+}
+
+static int get_stat_u64(void *cookie, __u64 *out)
+{
+	return stats_foreach(stats_add_u64, (__sz)(__uptr) cookie, out);
+}
+
+static int get_stat_u32(void *cookie, __u64 *out)
+{
+	return stats_foreach(stats_add_u32, (__sz)(__uptr) cookie, out);
+}
+
+static int get_stat_max_u32(void *cookie, __u64 *out)
+{
+	return stats_foreach(stats_max_u32, (__sz)(__uptr) cookie, out);
+}
+
+#define STATS_OFF(field) \
+	((void *) __offsetof(struct uk_blkdev_queue_stats, field))
+
+UK_STORE_STATIC_ENTRY(reqs, u64, get_stat_u64, NULL, STATS_OFF(reqs));
+UK_STORE_STATIC_ENTRY(completed, u64, get_stat_u64, NULL,
+		      STATS_OFF(completed));
+UK_STORE_STATIC_ENTRY(rd_sectors, u64, get_stat_u64, NULL,
+		      STATS_OFF(rd_sectors));
+UK_STORE_STATIC_ENTRY(wr_sectors, u64, get_stat_u64, NULL,
+		      STATS_OFF(wr_sectors));
+UK_STORE_STATIC_ENTRY(errors, u64, get_stat_u64, NULL, STATS_OFF(errors));
+UK_STORE_STATIC_ENTRY(full, u64, get_stat_u64, NULL, STATS_OFF(full));
+UK_STORE_STATIC_ENTRY(inflight, u64, get_stat_u32, NULL,
+		      STATS_OFF(inflight));
+UK_STORE_STATIC_ENTRY(inflight_max, u64, get_stat_max_u32, NULL,
+		      STATS_OFF(inflight_max));
+
+#define STATS_LAT_ENTRY(suffix, bucket)					\
+	UK_STORE_STATIC_ENTRY(lat_hist_ ## suffix, u64, get_stat_u64, NULL, \
+			      STATS_OFF(lat_hist[bucket]))
+
+UK_CTASSERT(UK_BLKDEV_STATS_LAT_BUCKETS == 16);
+STATS_LAT_ENTRY(00, 0);
+STATS_LAT_ENTRY(01, 1);
+STATS_LAT_ENTRY(02, 2);
+STATS_LAT_ENTRY(03, 3);
+STATS_LAT_ENTRY(04, 4);
+STATS_LAT_ENTRY(05, 5);
+STATS_LAT_ENTRY(06, 6);
+STATS_LAT_ENTRY(07, 7);
+STATS_LAT_ENTRY(08, 8);
+STATS_LAT_ENTRY(09, 9);
+STATS_LAT_ENTRY(10, 10);
+STATS_LAT_ENTRY(11, 11);
+STATS_LAT_ENTRY(12, 12);
+STATS_LAT_ENTRY(13, 13);
+STATS_LAT_ENTRY(14, 14);
+STATS_LAT_ENTRY(15, 15);
@@ -50,6 +50,11 @@
 #if CONFIG_LIBUKBOOT_INITBBUDDY
 #include <uk/allocbbuddy.h>
 #define uk_alloc_init uk_allocbbuddy_init
+#elif CONFIG_LIBUKBOOT_INITSLAB
+#include <uk/allocbbuddy.h>
+#include <uk/allocslab.h>
+#include <uk/alloc_impl.h>
+#define uk_alloc_init uk_allocbbuddy_init
 #elif CONFIG_LIBUKBOOT_INITREGION
 #include <uk/allocregion.h>
 #define uk_alloc_init uk_allocregion_init
@@ -288,6 +293,14 @@ void ukplat_entry(int argc, char *argv[])
 	uk_pr_info("Initialize memory allocator...\n");
 
 	a = heap_init();
+#if CONFIG_LIBUKBOOT_INITSLAB
+	if (likely(a)) {
+		/* Stack the slab allocator on the heap and make it default */
+		a = uk_allocslab_init(a);
+		if (likely(a))
+			uk_alloc_set_default(a);
+	}
+#endif /* CONFIG_LIBUKBOOT_INITSLAB */
 	if (unlikely(!a))
 		UK_CRASH("Failed to initialize memory allocator\n");
 	else {
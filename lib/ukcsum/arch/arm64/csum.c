@@ -0,0 +1,58 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2023, Unikraft GmbH and The Unikraft Authors.
+ * Licensed under the BSD-3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ */
+
+/*
+ * NEON checksum for arm64.
+ *
+ * The 32-bit words of each vector are added pairwise to the 64-bit lanes
+ * of two accumulators (UADALP). The file can only be built with FPSIMD,
+ * since the kernel is compiled with general purpose registers otherwise.
+ *
+ * The vectors are written with GCC vector extensions and inline assembly
+ * because the compiler's intrinsics headers are not available with
+ * -nostdinc.
+ */
+
+#include <uk/csum.h>
+#include <uk/essentials.h>
+#include "csum_impl.h"
+
+/* Unaligned vector of 64-bit lanes */
+typedef __u64 __attribute__((__vector_size__(16), __may_alias__,
+			     __aligned__(1))) csum_v2u64;
+
+/* Adds the 32-bit words of the vector at `p` pairwise to `acc` */
+static inline csum_v2u64 csum_uadalp(csum_v2u64 acc, const __u8 *p)
+{
+	csum_v2u64 v = *(const csum_v2u64 *) p;
+
+	__asm__ ("uadalp %0.2d, %1.4s" : "+w"(acc) : "w"(v));
+	return acc;
+}
+
+__u32 uk_csum_partial(const void *buf, __sz len, __u32 sum)
+{
+	const __u8 *p = buf;
+	csum_v2u64 acc0 = { 0 }, acc1 = { 0 };
+	__u64 acc = sum;
+
+	if (len < CSUM_VEC_THRESHOLD)
+		return uk_csum_partial_generic(buf, len, sum);
+
+	while (len >= 64) {
+		acc0 = csum_uadalp(acc0, p);
+		acc1 = csum_uadalp(acc1, p + 16);
+		acc0 = csum_uadalp(acc0, p + 32);
+		acc1 = csum_uadalp(acc1, p + 48);
+		p += 64;
+		len -= 64;
+	}
+	acc0 += acc1;
+	acc += acc0[0] + acc0[1];
+
+	/* The remaining bytes start at an even offset */
+	return uk_csum_partial_generic(p, len, csum_fold64(acc));
+}
@@ -0,0 +1,123 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2023, Unikraft GmbH and The Unikraft Authors.
+ * Licensed under the BSD-3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ */
+
+/*
+ * SSE2 and AVX2 checksum for x86_64.
+ *
+ * Each vector is split into the low and high 32-bit words of its 64-bit
+ * lanes, which are added to the 64-bit lanes of two accumulators. SSE2 is
+ * part of the x86_64 base architecture; AVX2 is used if the CPU supports
+ * it and the YMM state is enabled in XCR0.
+ *
+ * The vectors are written with GCC vector extensions because the
+ * compiler's intrinsics headers are not available with -nostdinc.
+ */
+
+#include <uk/arch/lcpu.h>
+#include <uk/csum.h>
+#include <uk/essentials.h>
+#include "csum_impl.h"
+
+#define X86_XCR0_SSE_AVX	((1 << 1) | (1 << 2))
+
+/* Unaligned vectors of 64-bit lanes */
+typedef __u64 __attribute__((__vector_size__(16), __may_alias__,
+			     __aligned__(1))) csum_v2u64;
+typedef __u64 __attribute__((__vector_size__(32), __may_alias__,
+			     __aligned__(1))) csum_v4u64;
+
+static int x86_avx2 = -1;
+
+static inline __u64 x86_xgetbv(__u32 idx)
+{
+	__u32 lo, hi;
+
+	__asm__ __volatile__("xgetbv" : "=a"(lo), "=d"(hi) : "c"(idx));
+	return ((__u64) hi << 32) | lo;
+}
+
+static inline int x86_has_avx2(void)
+{
+	__u32 eax, ebx, ecx, edx;
+
+	if (unlikely(x86_avx2 < 0)) {
+		x86_avx2 = 0;
+		ukarch_x86_cpuid(1, 0, &eax, &ebx, &ecx, &edx);
+		if (!(ecx & X86_CPUID1_ECX_OSXSAVE)
+		    || !(ecx & X86_CPUID1_ECX_AVX))
+			return 0;
+		if ((x86_xgetbv(0) & X86_XCR0_SSE_AVX) != X86_XCR0_SSE_AVX)
+			return 0;
+		ukarch_x86_cpuid(0, 0, &eax, &ebx, &ecx, &edx);
+		if (eax < 7)
+			return 0;
+		ukarch_x86_cpuid(7, 0, &eax, &ebx, &ecx, &edx);
+		x86_avx2 = !!(ebx & X86_CPUID7_EBX_AVX2);
+	}
+	return x86_avx2;
+}
+
+/* Sums whole 64-byte blocks, returns the number of summed bytes */
+static __sz csum_sse2(const __u8 *p, __sz len, __u64 *acc)
+{
+	const csum_v2u64 lo = { 0xffffffff, 0xffffffff };
+	csum_v2u64 acc0 = { 0 }, acc1 = { 0 }, v;
+	__sz i, j;
+
+	for (i = 0; i + 64 <= len; i += 64) {
+		for (j = 0; j < 64; j += sizeof(v)) {
+			v = *(const csum_v2u64 *) (p + i + j);
+			acc0 += v & lo;
+			acc1 += v >> 32;
+		}
+	}
+
+	acc0 += acc1;
+	*acc += acc0[0] + acc0[1];
+	return i;
+}
+
+/* Sums whole 128-byte blocks, returns the number of summed bytes */
+static __attribute__((target("avx2")))
+__sz csum_avx2(const __u8 *p, __sz len, __u64 *acc)
+{
+	const csum_v4u64 lo = { 0xffffffff, 0xffffffff,
+				0xffffffff, 0xffffffff };
+	csum_v4u64 acc0 = { 0 }, acc1 = { 0 }, v;
+	__sz i, j;
+
+	for (i = 0; i + 128 <= len; i += 128) {
+		for (j = 0; j < 128; j += sizeof(v)) {
+			v = *(const csum_v4u64 *) (p + i + j);
+			acc0 += v & lo;
+			acc1 += v >> 32;
+		}
+	}
+
+	acc0 += acc1;
+	*acc += acc0[0] + acc0[1] + acc0[2] + acc0[3];
+	return i;
+}
+
+__u32 uk_csum_partial(const void *buf, __sz len, __u32 sum)
+{
+	const __u8 *p = buf;
+	__u64 acc = sum;
+	__sz done;
+
+	if (len < CSUM_VEC_THRESHOLD)
+		return uk_csum_partial_generic(buf, len, sum);
+
+	if (x86_has_avx2())
+		done = csum_avx2(p, len, &acc);
+	else
+		done = 0;
+	/* Blocks that are too short for AVX2 are done with SSE2 */
+	done += csum_sse2(p + done, len - done, &acc);
+
+	/* The remaining bytes start at an even offset */
+	return uk_csum_partial_generic(p + done, len - done, csum_fold64(acc));
+}
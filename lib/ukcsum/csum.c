@@ -0,0 +1,180 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2023, Unikraft GmbH and The Unikraft Authors.
+ * Licensed under the BSD-3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ */
+
+#include <errno.h>
+#include <string.h>
+#include <uk/assert.h>
+#include <uk/csum.h>
+#include <uk/essentials.h>
+#if CONFIG_LIBUKNETDEV
+#include <uk/netbuf.h>
+#endif /* CONFIG_LIBUKNETDEV */
+#if CONFIG_LIBUKSGLIST
+#include <uk/sglist.h>
+#endif /* CONFIG_LIBUKSGLIST */
+#include "csum_impl.h"
+
+/*
+ * The data is summed as 32-bit words into a 64-bit accumulator, which
+ * postpones the end-around carry to the final fold: the ones' complement
+ * sum of the 32-bit words folds to the same value as the one of the 16-bit
+ * words.
+ */
+__u32 uk_csum_partial_generic(const void *buf, __sz len, __u32 sum)
+{
+	const __u8 *p = buf;
+	__u64 acc0 = sum, acc1 = 0;
+
+	while (len >= 16) {
+		acc0 += *(const csum_u32_ua *) (p + 0);
+		acc1 += *(const csum_u32_ua *) (p + 4);
+		acc0 += *(const csum_u32_ua *) (p + 8);
+		acc1 += *(const csum_u32_ua *) (p + 12);
+		p += 16;
+		len -= 16;
+	}
+	while (len >= 4) {
+		acc0 += *(const csum_u32_ua *) p;
+		p += 4;
+		len -= 4;
+	}
+	if (len >= 2) {
+		acc0 += *(const csum_u16_ua *) p;
+		p += 2;
+		len -= 2;
+	}
+	if (len) {
+		/* The last byte is padded with zero to a 16-bit word */
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+		acc0 += *p;
+#else
+		acc0 += (__u16) *p << 8;
+#endif
+	}
+
+	return csum_fold64(acc0 + acc1);
+}
+
+#if !CONFIG_LIBUKCSUM_ARCH
+__u32 uk_csum_partial(const void *buf, __sz len, __u32 sum)
+{
+	return uk_csum_partial_generic(buf, len, sum);
+}
+#endif /* !CONFIG_LIBUKCSUM_ARCH */
+
+#if CONFIG_LIBUKNETDEV
+__u32 uk_csum_netbuf(const struct uk_netbuf *pkt, __sz off, __sz len,
+		     __u32 sum)
+{
+	const struct uk_netbuf *seg;
+	__sz pos = 0, n;
+
+	UK_ASSERT(pkt);
+
+	UK_NETBUF_CHAIN_FOREACH(seg, pkt) {
+		if (!len)
+			break;
+		if (off >= seg->len) {
+			off -= seg->len;
+			continue;
+		}
+
+		n = MIN(seg->len - off, len);
+		if (pos & 1)
+			sum = uk_csum_add(sum, uk_csum_shift(
+				uk_csum_partial((__u8 *) seg->data + off, n, 0),
+				pos));
+		else
+			sum = uk_csum_partial((__u8 *) seg->data + off, n, sum);
+		pos += n;
+		len -= n;
+		off = 0;
+	}
+	return sum;
+}
+
+/* Stores the checksum at an offset of the chain; the two bytes may be in
+ * different segments
+ */
+static int csum_netbuf_store(struct uk_netbuf *pkt, __sz off, __u16 csum)
+{
+	struct uk_netbuf *seg;
+	__u8 *src = (__u8 *) &csum;
+	__sz left = sizeof(csum), n;
+
+	UK_NETBUF_CHAIN_FOREACH(seg, pkt) {
+		if (off >= seg->len) {
+			off -= seg->len;
+			continue;
+		}
+
+		n = MIN(seg->len - off, left);
+		memcpy((__u8 *) seg->data + off, src, n);
+		src += n;
+		left -= n;
+		off = 0;
+		if (!left)
+			return 0;
+	}
+	return -EINVAL;
+}
+
+int uk_csum_netbuf_complete(struct uk_netbuf *pkt)
+{
+	__u32 sum;
+	int rc;
+
+	UK_ASSERT(pkt);
+
+	if (!(pkt->flags & UK_NETBUF_F_PARTIAL_CSUM))
+		return 0;
+
+	/* The checksum field is covered by the sum: it holds the pseudo
+	 * header sum that has to be included
+	 */
+	sum = uk_csum_netbuf(pkt, pkt->csum_start, __SZ_MAX, 0);
+	rc = csum_netbuf_store(pkt, (__sz) pkt->csum_start + pkt->csum_offset,
+			       uk_csum_fold(sum));
+	if (unlikely(rc < 0))
+		return rc;
+
+	pkt->flags &= ~UK_NETBUF_F_PARTIAL_CSUM;
+	return 0;
+}
+#endif /* CONFIG_LIBUKNETDEV */
+
+#if CONFIG_LIBUKSGLIST
+__u32 uk_csum_sglist(const struct uk_sglist *sg, __sz off, __sz len,
+		     __u32 sum)
+{
+	const struct uk_sglist_seg *ss;
+	const __u8 *data;
+	__sz pos = 0, n;
+	__u16 i;
+
+	UK_ASSERT(sg);
+
+	for (i = 0; i < sg->sg_nseg && len; i++) {
+		ss = &sg->sg_segs[i];
+		if (off >= ss->ss_len) {
+			off -= ss->ss_len;
+			continue;
+		}
+
+		data = (const __u8 *) ss->ss_paddr + off;
+		n = MIN(ss->ss_len - off, len);
+		if (pos & 1)
+			sum = uk_csum_add(sum, uk_csum_shift(
+				uk_csum_partial(data, n, 0), pos));
+		else
+			sum = uk_csum_partial(data, n, sum);
+		pos += n;
+		len -= n;
+		off = 0;
+	}
+	return sum;
+}
+#endif /* CONFIG_LIBUKSGLIST */
@@ -0,0 +1,26 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2023, Unikraft GmbH and The Unikraft Authors.
+ * Licensed under the BSD-3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ */
+
+#ifndef __UKCSUM_IMPL_H__
+#define __UKCSUM_IMPL_H__
+
+#include <uk/arch/types.h>
+
+/* Buffers shorter than this are not worth setting up vector registers */
+#define CSUM_VEC_THRESHOLD	128
+
+typedef __u32 __attribute__((__may_alias__, __aligned__(1))) csum_u32_ua;
+typedef __u16 __attribute__((__may_alias__, __aligned__(1))) csum_u16_ua;
+
+/* Folds a 64-bit accumulator of 32-bit words into a partial sum */
+static inline __u32 csum_fold64(__u64 acc)
+{
+	acc = (acc & 0xffffffff) + (acc >> 32);
+	acc = (acc & 0xffffffff) + (acc >> 32);
+	return (__u32) acc;
+}
+
+#endif /* __UKCSUM_IMPL_H__ */
@@ -0,0 +1,163 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2023, Unikraft GmbH and The Unikraft Authors.
+ * Licensed under the BSD-3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ */
+
+#ifndef __UK_CSUM__
+#define __UK_CSUM__
+
+#include <uk/config.h>
+#include <uk/arch/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Internet checksum (RFC 1071)
+ *
+ * The functions compute the 16-bit ones' complement sum over the data in
+ * host byte order and return it as a partial (unfolded) 32-bit sum. Partial
+ * sums can be continued by passing them as `sum` argument, combined with
+ * uk_csum_add(), and finally turned into a checksum with uk_csum_fold(). The
+ * checksum is in host byte order as well, so it can be stored into a packet
+ * without conversion.
+ *
+ * With CONFIG_LIBUKCSUM_ARCH, vector registers are used. The functions must
+ * thus not be called from code that is built with the ISR flags.
+ */
+
+/**
+ * Adds two partial sums with end-around carry.
+ */
+static inline __u32 uk_csum_add(__u32 a, __u32 b)
+{
+	__u32 r = a + b;
+
+	return r + (r < a);
+}
+
+/**
+ * Folds a partial sum to 16 bits without complementing it.
+ */
+static inline __u16 uk_csum_reduce(__u32 sum)
+{
+	sum = (sum & 0xffff) + (sum >> 16);
+	sum = (sum & 0xffff) + (sum >> 16);
+	return (__u16) sum;
+}
+
+/**
+ * Folds a partial sum to the final 16-bit checksum.
+ */
+static inline __u16 uk_csum_fold(__u32 sum)
+{
+	return (__u16) ~uk_csum_reduce(sum);
+}
+
+/**
+ * Adjusts the partial sum of a block to the position of the block within
+ * the checksummed data: a block that starts at an odd offset contributes
+ * with swapped bytes.
+ *
+ * @param part
+ *   Partial sum of the block, computed from its own start.
+ * @param off
+ *   Offset of the block within the checksummed data.
+ */
+static inline __u32 uk_csum_shift(__u32 part, __sz off)
+{
+	__u16 r;
+
+	if (!(off & 1))
+		return part;
+	r = uk_csum_reduce(part);
+	return (__u32) (__u16) ((r << 8) | (r >> 8));
+}
+
+/**
+ * Computes the partial sum of a buffer with the fastest implementation that
+ * is available.
+ *
+ * @param buf
+ *   Start of the buffer, no alignment is required.
+ * @param len
+ *   Length of the buffer in bytes.
+ * @param sum
+ *   Partial sum to continue (0 to start a new sum).
+ * @return
+ *   Partial sum
+ */
+__u32 uk_csum_partial(const void *buf, __sz len, __u32 sum);
+
+/**
+ * Portable implementation of uk_csum_partial() that uses general purpose
+ * registers only.
+ */
+__u32 uk_csum_partial_generic(const void *buf, __sz len, __u32 sum);
+
+#if CONFIG_LIBUKNETDEV
+struct uk_netbuf;
+
+/**
+ * Computes the partial sum of a range of the data of a netbuf chain.
+ *
+ * @param pkt
+ *   Head of the netbuf chain.
+ * @param off
+ *   Offset of the range from the data start of `pkt`.
+ * @param len
+ *   Length of the range. The sum ends with the chain if it is shorter.
+ * @param sum
+ *   Partial sum to continue (0 to start a new sum).
+ * @return
+ *   Partial sum
+ */
+__u32 uk_csum_netbuf(const struct uk_netbuf *pkt, __sz off, __sz len,
+		     __u32 sum);
+
+/**
+ * Completes the checksum of a netbuf chain with UK_NETBUF_F_PARTIAL_CSUM
+ * set: sums the data from `csum_start` to the end of the chain and stores
+ * the checksum at `csum_start + csum_offset`. The checksum field must
+ * already contain the (non-complemented) pseudo header sum. The flag is
+ * cleared on success.
+ *
+ * @param pkt
+ *   Head of the netbuf chain.
+ * @return
+ *   - (0): Success, or the flag was not set
+ *   - (-EINVAL): The checksum field lies outside of the chain
+ */
+int uk_csum_netbuf_complete(struct uk_netbuf *pkt);
+#endif /* CONFIG_LIBUKNETDEV */
+
+#if CONFIG_LIBUKSGLIST
+struct uk_sglist;
+
+/**
+ * Computes the partial sum of a range of a scatter gather list. The
+ * segments are accessed through their `ss_paddr` address, which requires
+ * that physical memory is identity-mapped.
+ *
+ * @param sg
+ *   Scatter gather list.
+ * @param off
+ *   Offset of the range from the start of the first segment.
+ * @param len
+ *   Length of the range. The sum ends with the list if it is shorter.
+ * @param sum
+ *   Partial sum to continue (0 to start a new sum).
+ * @return
+ *   Partial sum
+ */
+__u32 uk_csum_sglist(const struct uk_sglist *sg, __sz off, __sz len,
+		     __u32 sum);
+#endif /* CONFIG_LIBUKSGLIST */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __UK_CSUM__ */
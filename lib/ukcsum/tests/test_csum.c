@@ -0,0 +1,238 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2023, Unikraft GmbH and The Unikraft Authors.
+ * Licensed under the BSD-3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ */
+
+#include <errno.h>
+#include <string.h>
+#include <uk/test.h>
+#include <uk/csum.h>
+#include <uk/essentials.h>
+#include <uk/plat/time.h>
+#if CONFIG_LIBUKNETDEV
+#include <uk/netbuf.h>
+#endif /* CONFIG_LIBUKNETDEV */
+
+#define BUF_SIZE	(64 * 1024)
+#define BUF_SLACK	64
+
+/* Total number of bytes processed per benchmark measurement */
+#define BENCH_BYTES	(4 * 1024 * 1024)
+
+static __u8 buf[BUF_SIZE + BUF_SLACK] __align64;
+
+static const size_t sizes[] = { 20, 64, 576, 1500, 9000, BUF_SIZE };
+
+static void fill_pattern(__u8 *p, size_t len, unsigned int seed)
+{
+	size_t i;
+
+	for (i = 0; i < len; ++i)
+		p[i] = (__u8)((i * 13 + seed) ^ (i >> 7));
+}
+
+/* Byte-serial reference: sums 16-bit words as a network stack would */
+static __u32 csum_ref(const void *data, size_t len, __u32 sum)
+{
+	const __u8 *p = data;
+	__u16 word;
+	size_t i;
+
+	for (i = 0; i + 1 < len; i += 2) {
+		memcpy(&word, p + i, sizeof(word));
+		sum += word;
+	}
+	if (len & 1)
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+		sum += p[len - 1];
+#else
+		sum += (__u16) p[len - 1] << 8;
+#endif
+	while (sum >> 16)
+		sum = (sum & 0xffff) + (sum >> 16);
+	return sum;
+}
+
+/* 0x0000 and 0xffff are the same value in ones' complement */
+static inline __u16 csum_norm(__u32 sum)
+{
+	__u16 r = uk_csum_reduce(sum);
+
+	return (r == 0xffff) ? 0 : r;
+}
+
+UK_TESTCASE(ukcsum, partial_sizes_aligns)
+{
+	size_t len, off;
+	__u16 ref;
+	int fails = 0;
+
+	fill_pattern(buf, sizeof(buf), 1);
+	for (len = 0; len <= 520; ++len) {
+		for (off = 0; off < 8; ++off) {
+			ref = csum_norm(csum_ref(buf + off, len, 0));
+			if (csum_norm(uk_csum_partial(buf + off, len, 0)) != ref
+			    || csum_norm(uk_csum_partial_generic(buf + off, len,
+								 0)) != ref)
+				fails++;
+		}
+	}
+	UK_TEST_EXPECT_ZERO(fails);
+
+	for (off = 0; off < 8; ++off)
+		UK_TEST_EXPECT_SNUM_EQ(
+			csum_norm(uk_csum_partial(buf + off, BUF_SIZE - 8,
+						  0x1234)),
+			csum_norm(csum_ref(buf + off, BUF_SIZE - 8, 0x1234)));
+}
+
+UK_TESTCASE(ukcsum, all_ones)
+{
+	/* The carries of the largest words have to be folded back */
+	memset(buf, 0xff, BUF_SIZE);
+	UK_TEST_EXPECT_SNUM_EQ(csum_norm(uk_csum_partial(buf, BUF_SIZE,
+							 0xffffffff)), 0);
+	UK_TEST_EXPECT_SNUM_EQ(uk_csum_fold(uk_csum_partial(buf, 1501, 0)),
+			       (__u16) ~csum_ref(buf, 1501, 0));
+}
+
+UK_TESTCASE(ukcsum, combine_odd_blocks)
+{
+	size_t split;
+	__u32 sum;
+	__u16 ref;
+	int fails = 0;
+
+	fill_pattern(buf, sizeof(buf), 3);
+	ref = csum_norm(csum_ref(buf, 1500, 0));
+	for (split = 0; split <= 1500; split += 7) {
+		sum = uk_csum_add(uk_csum_partial(buf, split, 0),
+				  uk_csum_shift(uk_csum_partial(buf + split,
+								1500 - split,
+								0), split));
+		if (csum_norm(sum) != ref)
+			fails++;
+	}
+	UK_TEST_EXPECT_ZERO(fails);
+}
+
+#if CONFIG_LIBUKNETDEV
+#define NB_SEGS		4
+#define SEG_SIZE	512
+
+static __u8 seg_mem[NB_SEGS][SEG_SIZE + 256] __align64;
+
+/* Splits `len` bytes of `buf` into a chain of netbufs with odd lengths */
+static struct uk_netbuf *chain_prepare(size_t len)
+{
+	static const size_t seg_lens[NB_SEGS] = { 33, 255, 1, SEG_SIZE };
+	struct uk_netbuf *head = NULL, *m;
+	size_t i, off = 0;
+
+	for (i = 0; i < NB_SEGS && off < len; ++i) {
+		m = uk_netbuf_prepare_buf(seg_mem[i], sizeof(seg_mem[i]),
+					  0, 0, NULL);
+		UK_ASSERT(m);
+		m->len = MIN(seg_lens[i], len - off);
+		memcpy(m->data, buf + off, m->len);
+		off += m->len;
+		if (head)
+			uk_netbuf_append(head, m);
+		else
+			head = m;
+	}
+	return head;
+}
+
+UK_TESTCASE(ukcsum, netbuf_chain)
+{
+	struct uk_netbuf *pkt;
+	size_t off;
+	int fails = 0;
+
+	fill_pattern(buf, sizeof(buf), 7);
+	pkt = chain_prepare(700);
+	for (off = 0; off < 300; off += 3) {
+		if (csum_norm(uk_csum_netbuf(pkt, off, 700 - off, 0))
+		    != csum_norm(csum_ref(buf + off, 700 - off, 0)))
+			fails++;
+	}
+	UK_TEST_EXPECT_ZERO(fails);
+}
+
+UK_TESTCASE(ukcsum, netbuf_complete)
+{
+	struct uk_netbuf *pkt;
+	__u16 csum, pseudo = 0x1234;
+
+	fill_pattern(buf, sizeof(buf), 9);
+	/* Checksum field crosses the boundary of the first two segments */
+	memcpy(buf + 32, &pseudo, sizeof(pseudo));
+	pkt = chain_prepare(600);
+	pkt->flags |= UK_NETBUF_F_PARTIAL_CSUM;
+	pkt->csum_start = 20;
+	pkt->csum_offset = 12;
+
+	UK_TEST_EXPECT_ZERO(uk_csum_netbuf_complete(pkt));
+	UK_TEST_EXPECT(!(pkt->flags & UK_NETBUF_F_PARTIAL_CSUM));
+
+	/* Summing over the completed checksum and the pseudo header, which
+	 * is no longer in the field, yields all ones
+	 */
+	UK_TEST_EXPECT_SNUM_EQ(csum_norm(uk_csum_netbuf(pkt, 20, 580, pseudo)),
+			       0);
+	csum = uk_csum_fold(csum_ref(buf + 20, 580, 0));
+	UK_TEST_EXPECT_SNUM_EQ(((__u8 *) pkt->data)[32], ((__u8 *) &csum)[0]);
+
+	/* The field must lie within the chain */
+	pkt->flags |= UK_NETBUF_F_PARTIAL_CSUM;
+	pkt->csum_offset = 600;
+	UK_TEST_EXPECT_SNUM_EQ(uk_csum_netbuf_complete(pkt), -EINVAL);
+}
+#endif /* CONFIG_LIBUKNETDEV */
+
+static __nsec bench_csum(__u32 (*fn)(const void *, __sz, __u32), size_t len)
+{
+	size_t rounds = BENCH_BYTES / len;
+	volatile __u32 res;
+	__nsec start;
+
+	start = ukplat_monotonic_clock();
+	while (rounds--)
+		res = fn(buf, len, 0);
+	(void)res;
+	return ukplat_monotonic_clock() - start;
+}
+
+/* Throughput in MB/s */
+static inline __u64 bench_mbps(size_t len, __nsec t)
+{
+	return t ? (BENCH_BYTES / len) * len * 1000 / t : 0;
+}
+
+/* Reports the throughput of the reference, scalar, and vector path */
+UK_TESTCASE(ukcsum, benchmark)
+{
+	__nsec t_ref, t_generic, t_arch;
+	size_t i, len;
+
+	fill_pattern(buf, sizeof(buf), 11);
+	for (i = 0; i < ARRAY_SIZE(sizes); ++i) {
+		len = sizes[i];
+		t_ref = bench_csum(csum_ref, len);
+		t_generic = bench_csum(uk_csum_partial_generic, len);
+		t_arch = bench_csum(uk_csum_partial, len);
+		uk_test_printf("%6zu B: 16-bit %6"__PRIu64" MB/s, generic %6"
+			       __PRIu64" MB/s, arch %6"__PRIu64" MB/s\n",
+			       len, bench_mbps(len, t_ref),
+			       bench_mbps(len, t_generic),
+			       bench_mbps(len, t_arch));
+	}
+
+	/* The benchmark only reports numbers, the results are checked above */
+	UK_TEST_EXPECT_SNUM_EQ(csum_norm(uk_csum_partial(buf, len, 0)),
+			       csum_norm(csum_ref(buf, len, 0)));
+}
+
+uk_testsuite_register(ukcsum, NULL);
@@ -0,0 +1,125 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2023, Unikraft GmbH and The Unikraft Authors.
+ * Licensed under the BSD-3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ */
+
+/*
+ * Per-lcpu counters
+ *
+ * A counter set is a structure of integer counters that is replicated for
+ * every logical CPU. An lcpu updates only its own replica, so counting does
+ * not need a lock and does not move cache lines between lcpus. Readers
+ * aggregate the replicas, typically by summing them up. The value of a
+ * single replica has no meaning on its own: it wraps around or becomes
+ * negative if an event is counted on one lcpu and reverted on another.
+ */
+
+#ifndef __UK_COUNTER_H__
+#define __UK_COUNTER_H__
+
+#include <uk/config.h>
+#include <uk/essentials.h>
+#include <uk/arch/lcpu.h>
+#include <uk/plat/lcpu.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if CONFIG_UKPLAT_LCPU_MAXCOUNT > 1
+/* Replicas are padded to whole cache lines. They do not share cache lines
+ * as long as the counter set is cache-line aligned.
+ */
+#define __UK_COUNTERS_PAD(type)						\
+	char __pad[ALIGN_UP(sizeof(type), CACHE_LINE_SIZE) - sizeof(type)]
+#else /* CONFIG_UKPLAT_LCPU_MAXCOUNT <= 1 */
+#define __UK_COUNTERS_PAD(type)
+#endif /* CONFIG_UKPLAT_LCPU_MAXCOUNT <= 1 */
+
+/**
+ * Declares the per-lcpu counter set `struct name` with the replica type
+ * `type`, a structure of integer counters.
+ */
+#define UK_COUNTERS_DECLARE(name, type)					\
+	struct name {							\
+		struct {						\
+			type c;						\
+			__UK_COUNTERS_PAD(type);			\
+		} lcpu[CONFIG_UKPLAT_LCPU_MAXCOUNT];			\
+	}
+
+/**
+ * Returns the replica of logical CPU `idx`
+ */
+#define uk_counters_lcpu(ctrs, idx)					\
+	(&(ctrs)->lcpu[(idx)].c)
+
+/**
+ * Returns the replica of the current logical CPU. The caller must not
+ * migrate to another lcpu while it is using the replica.
+ */
+#define uk_counters_this(ctrs)						\
+	uk_counters_lcpu(ctrs, ukplat_lcpu_idx())
+
+/**
+ * Iterates `idx` over the replicas of all logical CPUs
+ */
+#define uk_counters_foreach(ctrs, idx)					\
+	for ((idx) = 0; (idx) < ARRAY_SIZE((ctrs)->lcpu); (idx)++)
+
+/**
+ * Adds to a counter of the current logical CPU. This is safe to use from
+ * interrupt context and does not need the caller to disable preemption.
+ */
+#define uk_counter_add(ctrs, field, val)				\
+	((void) __atomic_fetch_add(&uk_counters_this(ctrs)->field,	\
+				   (val), __ATOMIC_RELAXED))
+#define uk_counter_sub(ctrs, field, val)				\
+	((void) __atomic_fetch_sub(&uk_counters_this(ctrs)->field,	\
+				   (val), __ATOMIC_RELAXED))
+#define uk_counter_inc(ctrs, field)					\
+	uk_counter_add(ctrs, field, 1)
+#define uk_counter_dec(ctrs, field)					\
+	uk_counter_sub(ctrs, field, 1)
+
+/**
+ * Returns the sum of a counter over all logical CPUs. The result is not an
+ * atomic snapshot of concurrent updates.
+ */
+#define uk_counter_sum(ctrs, field)					\
+	({								\
+		__typeof__((ctrs)->lcpu[0].c.field) __sum = 0;		\
+		__sz __idx;						\
+									\
+		uk_counters_foreach(ctrs, __idx)			\
+			__sum += __atomic_load_n(			\
+				&uk_counters_lcpu(ctrs, __idx)->field,	\
+				__ATOMIC_RELAXED);			\
+		__sum;							\
+	})
+
+/**
+ * Returns the maximum of a counter over all logical CPUs
+ */
+#define uk_counter_max(ctrs, field)					\
+	({								\
+		__typeof__((ctrs)->lcpu[0].c.field) __max, __val;	\
+		__sz __idx;						\
+									\
+		__max = uk_counters_lcpu(ctrs, 0)->field;		\
+		uk_counters_foreach(ctrs, __idx) {			\
+			__val = __atomic_load_n(			\
+				&uk_counters_lcpu(ctrs, __idx)->field,	\
+				__ATOMIC_RELAXED);			\
+			if (__val > __max)				\
+				__max = __val;				\
+		}							\
+		__max;							\
+	})
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __UK_COUNTER_H__ */
@@ -0,0 +1,105 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2023, Unikraft GmbH and The Unikraft Authors.
+ * Licensed under the BSD-3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ */
+
+#ifndef __UK_LOCKSTAT_H__
+#define __UK_LOCKSTAT_H__
+
+#include <uk/config.h>
+
+#if CONFIG_LIBUKLOCK_LOCKSTAT
+#include <uk/arch/time.h>
+#include <uk/essentials.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Contention statistics of a lock
+ *
+ * A lock gets an entry in the statistics table when it is contended for the
+ * first time. Afterwards, all its acquisitions are recorded. The entry is
+ * updated by the holder of the lock only, so it does not need further
+ * synchronization. Entries are keyed by the address of the lock: a lock
+ * that is initialized at the address of a former lock continues its
+ * statistics.
+ */
+struct uk_lockstat {
+	/** Address of the lock, NULL if the entry is unused */
+	const void *lock;
+	/** Acquisitions since the lock was first contended */
+	__u64 nr_acquired;
+	/** Acquisitions that had to wait for the lock */
+	__u64 nr_contended;
+	/** Total time spent waiting for the lock */
+	__nsec wait_total;
+	/** Longest time spent waiting for the lock */
+	__nsec wait_max;
+	/** Total time the lock was held exclusively */
+	__nsec hold_total;
+	/** Longest time the lock was held exclusively */
+	__nsec hold_max;
+};
+
+/**
+ * Returns the statistics entry of a lock and creates it if necessary
+ *
+ * @param lock
+ *   Address of the lock
+ * @return
+ *   The entry, NULL if the statistics table is full
+ */
+struct uk_lockstat *uk_lockstat_get(const void *lock);
+
+/**
+ * Copies an entry of the statistics table
+ *
+ * @param idx
+ *   Index of the entry
+ * @param dst
+ *   Destination buffer
+ * @return
+ *   0 on success, -ENOENT if the entry is unused, -EINVAL if `idx` is
+ *   beyond the end of the table
+ */
+int uk_lockstat_read(unsigned int idx, struct uk_lockstat *dst);
+
+/**
+ * Prints the most contended locks with the kernel console
+ *
+ * @param n
+ *   Maximum number of locks to print
+ */
+void uk_lockstat_print(unsigned int n);
+
+/* The following functions must be called while holding the lock */
+static inline void uk_lockstat_contended(struct uk_lockstat *s, __nsec wait)
+{
+	s->nr_contended++;
+	s->wait_total += wait;
+	if (wait > s->wait_max)
+		s->wait_max = wait;
+}
+
+static inline void uk_lockstat_acquired(struct uk_lockstat *s)
+{
+	s->nr_acquired++;
+}
+
+static inline void uk_lockstat_released(struct uk_lockstat *s, __nsec hold)
+{
+	s->hold_total += hold;
+	if (hold > s->hold_max)
+		s->hold_max = hold;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CONFIG_LIBUKLOCK_LOCKSTAT */
+
+#endif /* __UK_LOCKSTAT_H__ */
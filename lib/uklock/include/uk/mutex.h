@@ -37,6 +37,7 @@
 #include <uk/config.h>
 
 #if CONFIG_LIBUKLOCK_MUTEX
+#include <uk/arch/atomic.h>
 #include <uk/assert.h>
 #include <uk/plat/lcpu.h>
 #include <uk/thread.h>
@@ -45,25 +46,45 @@
 #include <uk/plat/time.h>
 
 #ifdef CONFIG_LIBUKLOCK_MUTEX_METRICS
-#include <uk/plat/spinlock.h>
-#include <string.h>
+#include <uk/counter.h>
 #endif /* CONFIG_LIBUKLOCK_MUTEX_METRICS */
+#if CONFIG_LIBUKLOCK_LOCKSTAT
+#include <uk/lockstat.h>
+#endif /* CONFIG_LIBUKLOCK_LOCKSTAT */
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 #define UK_MUTEX_CONFIG_RECURSE 0x01 /* Allow recursive locking */
+#define UK_MUTEX_CONFIG_FAIR    0x02 /* Hand over to waiters in FIFO order */
 
 /*
  * Mutex that relies on a scheduler
  * uses wait queues for threads
+ *
+ * An unlock with waiters wakes up the first waiter only. A fair mutex hands
+ * the ownership over to this waiter directly. Otherwise the mutex is
+ * released and the woken waiter competes with running threads for it; if it
+ * loses, it is requeued in front and gets the mutex handed over on the next
+ * unlock. While the owner is running on another lcpu, lockers spin for a
+ * while before going to sleep (see CONFIG_LIBUKLOCK_MUTEX_SPIN).
  */
 struct uk_mutex {
 	int lock_count;
 	unsigned int flags;
 	struct uk_thread *owner;
 	struct uk_waitq wait;
+	/* Threads in the wait path; protected by wait.sl, read locklessly */
+	volatile unsigned int nwaiters;
+	/* The first waiter lost the mutex to a running thread */
+	int handoff;
+#if CONFIG_LIBUKLOCK_LOCKSTAT
+	/* Contention statistics, assigned on the first contended lock */
+	struct uk_lockstat *stat;
+	/* Time of the last acquisition, valid if `stat` is assigned */
+	__nsec acquired;
+#endif /* CONFIG_LIBUKLOCK_LOCKSTAT */
 };
 
 static inline int uk_mutex_is_recursive(const struct uk_mutex *m)
@@ -71,6 +92,11 @@ static inline int uk_mutex_is_recursive(const struct uk_mutex *m)
 	return (m->flags & UK_MUTEX_CONFIG_RECURSE);
 }
 
+static inline int uk_mutex_is_fair(const struct uk_mutex *m)
+{
+	return (m->flags & UK_MUTEX_CONFIG_FAIR);
+}
+
 /*
  * Mutex statistics for ukstore.
  */
@@ -91,19 +117,52 @@ struct uk_mutex_metrics {
 };
 
 #ifdef CONFIG_LIBUKLOCK_MUTEX_METRICS
+UK_COUNTERS_DECLARE(uk_mutex_lcpu_metrics, struct uk_mutex_metrics);
+
 /*
- * Metric storage (see mutex.c).
+ * Metric storage (see mutex.c). The metrics are counted per lcpu and
+ * summed up by uk_mutex_get_metrics().
  */
-extern struct uk_mutex_metrics _uk_mutex_metrics;
-extern __spinlock              _uk_mutex_metrics_lock;
+extern struct uk_mutex_lcpu_metrics _uk_mutex_metrics;
 #endif /* CONFIG_LIBUKLOCK_MUTEX_METRICS */
 
+#if CONFIG_LIBUKLOCK_LOCKSTAT
+#define __UK_MUTEX_STAT_INITIALIZER , NULL, 0
+#else /* !CONFIG_LIBUKLOCK_LOCKSTAT */
+#define __UK_MUTEX_STAT_INITIALIZER
+#endif /* !CONFIG_LIBUKLOCK_LOCKSTAT */
+
 #define	UK_MUTEX_INITIALIZER(name)				\
-	{ 0, 0, NULL, __WAIT_QUEUE_INITIALIZER((name).wait) }
+	{ 0, 0, NULL, __WAIT_QUEUE_INITIALIZER((name).wait), 0, 0	\
+	  __UK_MUTEX_STAT_INITIALIZER }
 
 void uk_mutex_init_config(struct uk_mutex *m, unsigned int flags);
 void uk_mutex_get_metrics(struct uk_mutex_metrics *dst);
 
+/* Contended paths of uk_mutex_lock() and uk_mutex_unlock() (see mutex.c) */
+void _uk_mutex_lock_slow(struct uk_mutex *m);
+void _uk_mutex_unlock_slow(struct uk_mutex *m);
+
+#if CONFIG_LIBUKLOCK_LOCKSTAT
+static inline void _uk_mutex_stat_acquired(struct uk_mutex *m)
+{
+	if (unlikely(m->stat)) {
+		uk_lockstat_acquired(m->stat);
+		m->acquired = ukplat_monotonic_clock();
+	}
+}
+
+static inline void _uk_mutex_stat_released(struct uk_mutex *m)
+{
+	if (unlikely(m->stat))
+		uk_lockstat_released(m->stat,
+				     ukplat_monotonic_clock() - m->acquired);
+}
+#else /* !CONFIG_LIBUKLOCK_LOCKSTAT */
+#define _uk_mutex_stat_acquired(m) do {} while (0)
+#define _uk_mutex_stat_released(m) do {} while (0)
+#endif /* !CONFIG_LIBUKLOCK_LOCKSTAT */
+
 #define uk_mutex_init(m) uk_mutex_init_config(m, 0)
 
 static inline void uk_mutex_lock(struct uk_mutex *m)
@@ -123,23 +182,19 @@ static inline void uk_mutex_lock(struct uk_mutex *m)
 
 	UK_ASSERT(m->owner != cur);
 
-	for (;;) {
-		uk_waitq_wait_event(&m->wait, m->owner == NULL);
-
-		/* If there is no owner, we can acquire the lock */
-		if (ukarch_compare_exchange_sync(&m->owner, NULL, cur) == cur) {
-			UK_ASSERT(m->lock_count == 0);
-			m->lock_count = 1;
-			break;
-		}
+	if (likely(ukarch_compare_exchange_sync(&m->owner, NULL, cur) == cur)) {
+		UK_ASSERT(m->lock_count == 0);
+		m->lock_count = 1;
+	} else {
+		_uk_mutex_lock_slow(m);
+		UK_ASSERT(m->owner == cur && m->lock_count == 1);
 	}
+	_uk_mutex_stat_acquired(m);
 
 #ifdef CONFIG_LIBUKLOCK_MUTEX_METRICS
-	ukarch_spin_lock(&_uk_mutex_metrics_lock);
-	_uk_mutex_metrics.active_locked   += (m->lock_count == 1);
-	_uk_mutex_metrics.active_unlocked -= (m->lock_count == 1);
-	_uk_mutex_metrics.total_locks++;
-	ukarch_spin_unlock(&_uk_mutex_metrics_lock);
+	uk_counter_inc(&_uk_mutex_metrics, active_locked);
+	uk_counter_dec(&_uk_mutex_metrics, active_unlocked);
+	uk_counter_inc(&_uk_mutex_metrics, total_locks);
 #endif /* CONFIG_LIBUKLOCK_MUTEX_METRICS */
 }
 
@@ -157,9 +212,7 @@ static inline int uk_mutex_trylock(struct uk_mutex *m)
 		m->lock_count++;
 
 #ifdef CONFIG_LIBUKLOCK_MUTEX_METRICS
-		ukarch_spin_lock(&_uk_mutex_metrics_lock);
-		_uk_mutex_metrics.total_ok_trylocks++;
-		ukarch_spin_unlock(&_uk_mutex_metrics_lock);
+		uk_counter_inc(&_uk_mutex_metrics, total_ok_trylocks);
 #endif /* CONFIG_LIBUKLOCK_MUTEX_METRICS */
 
 		return 1;
@@ -171,13 +224,12 @@ static inline int uk_mutex_trylock(struct uk_mutex *m)
 		if (ukarch_compare_exchange_sync(&m->owner, NULL, cur) == cur) {
 			UK_ASSERT(m->lock_count == 0);
 			m->lock_count = 1;
+			_uk_mutex_stat_acquired(m);
 
 #ifdef CONFIG_LIBUKLOCK_MUTEX_METRICS
-			ukarch_spin_lock(&_uk_mutex_metrics_lock);
-			_uk_mutex_metrics.active_locked++;
-			_uk_mutex_metrics.active_unlocked--;
-			_uk_mutex_metrics.total_ok_trylocks++;
-			ukarch_spin_unlock(&_uk_mutex_metrics_lock);
+			uk_counter_inc(&_uk_mutex_metrics, active_locked);
+			uk_counter_dec(&_uk_mutex_metrics, active_unlocked);
+			uk_counter_inc(&_uk_mutex_metrics, total_ok_trylocks);
 #endif /* CONFIG_LIBUKLOCK_MUTEX_METRICS */
 
 			return 1;
@@ -185,9 +237,7 @@ static inline int uk_mutex_trylock(struct uk_mutex *m)
 	}
 
 #ifdef CONFIG_LIBUKLOCK_MUTEX_METRICS
-	ukarch_spin_lock(&_uk_mutex_metrics_lock);
-	_uk_mutex_metrics.total_failed_trylocks++;
-	ukarch_spin_unlock(&_uk_mutex_metrics_lock);
+	uk_counter_inc(&_uk_mutex_metrics, total_failed_trylocks);
 #endif /* CONFIG_LIBUKLOCK_MUTEX_METRICS */
 
 	return 0;
@@ -201,26 +251,37 @@ static inline int uk_mutex_is_locked(struct uk_mutex *m)
 
 static inline void uk_mutex_unlock(struct uk_mutex *m)
 {
+	int released = 0;
+
 	UK_ASSERT(m);
 	UK_ASSERT(m->lock_count > 0);
 	UK_ASSERT(m->owner == uk_thread_current());
 
 	if (--m->lock_count == 0) {
-		/* Make sure lock_count is visible before resetting the
-		 * owner. The lock can be acquired afterwards.
+		released = 1;
+		_uk_mutex_stat_released(m);
+
+		/* The release is sequentially consistent with the check for
+		 * waiters: a thread that enqueues itself afterwards sees the
+		 * mutex unlocked. The lock can be acquired afterwards. If
+		 * there are waiters, the mutex may be handed over.
 		 */
-		wmb();
-		m->owner = NULL;
-		uk_waitq_wake_up(&m->wait);
+		if (unlikely(ukarch_load_n(&m->nwaiters))) {
+			_uk_mutex_unlock_slow(m);
+		} else {
+			ukarch_store_n(&m->owner, NULL);
+			if (unlikely(ukarch_load_n(&m->nwaiters)))
+				_uk_mutex_unlock_slow(m);
+		}
 	}
 
 #ifdef CONFIG_LIBUKLOCK_MUTEX_METRICS
-	ukarch_spin_lock(&_uk_mutex_metrics_lock);
-	_uk_mutex_metrics.active_locked   -= (m->lock_count == 0);
-	_uk_mutex_metrics.active_unlocked += (m->lock_count == 0);
-	_uk_mutex_metrics.total_unlocks++;
-	ukarch_spin_unlock(&_uk_mutex_metrics_lock);
-#endif /* CONFIG_LIBUKLOCK_MUTEX_METRICS */
+	uk_counter_sub(&_uk_mutex_metrics, active_locked, released);
+	uk_counter_add(&_uk_mutex_metrics, active_unlocked, released);
+	uk_counter_inc(&_uk_mutex_metrics, total_unlocks);
+#else /* !CONFIG_LIBUKLOCK_MUTEX_METRICS */
+	(void)released;
+#endif /* !CONFIG_LIBUKLOCK_MUTEX_METRICS */
 }
 
 #define uk_waitq_wait_event_mutex(wq, condition, mutex) \
@@ -13,6 +13,9 @@
 #include <uk/essentials.h>
 #include <uk/spinlock.h>
 #include <uk/wait.h>
+#if CONFIG_LIBUKLOCK_LOCKSTAT
+#include <uk/lockstat.h>
+#endif /* CONFIG_LIBUKLOCK_LOCKSTAT */
 
 #ifdef __cplusplus
 extern "C" {
@@ -29,12 +32,18 @@ struct __align(8) uk_rwlock {
 	volatile unsigned int npending_writes;
 	/** Configuration flag for lock (see UK_RWLOCK_CONFIG_*) */
 	unsigned int config_flags;
-	/** Spinlock to synchronize this lock */
+	/** Spinlock to synchronize this lock and its wait queues */
 	struct uk_spinlock sl;
 	/** Wait queue for readers */
 	struct uk_waitq shared;
 	/** Wait queue for writers */
 	struct uk_waitq exclusive;
+#if CONFIG_LIBUKLOCK_LOCKSTAT
+	/** Contention statistics, assigned on the first contended lock */
+	struct uk_lockstat *stat;
+	/** Time of the last write acquisition, valid if `stat` is assigned */
+	__nsec wacquired;
+#endif /* CONFIG_LIBUKLOCK_LOCKSTAT */
 };
 
 static inline int uk_rwlock_is_write_recursive(const struct uk_rwlock *rwl)
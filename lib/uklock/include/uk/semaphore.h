@@ -44,6 +44,10 @@ extern "C" {
 /*
  * Semaphore that relies on a scheduler
  * uses wait queues for threads
+ *
+ * The wait queue is protected by `sl`. An up() with waiters hands the unit
+ * over to the first waiter instead of incrementing the count, so that only
+ * this waiter is woken up.
  */
 struct uk_semaphore {
 	struct uk_spinlock sl;
@@ -53,24 +57,16 @@ struct uk_semaphore {
 
 void uk_semaphore_init(struct uk_semaphore *s, long count);
 
+/* Blocks until a unit is handed over or until `deadline` if it is not 0.
+ * Returns 1 if the semaphore was decreased, 0 on timeout (see semaphore.c)
+ */
+int _uk_semaphore_down(struct uk_semaphore *s, __nsec deadline);
+
 static inline void uk_semaphore_down(struct uk_semaphore *s)
 {
-	unsigned long irqf;
-
 	UK_ASSERT(s);
 
-	for (;;) {
-		uk_waitq_wait_event(&s->wait, s->count > 0);
-		uk_spin_lock_irqsave(&(s->sl), irqf);
-		if (s->count > 0)
-			break;
-		uk_spin_unlock_irqrestore(&(s->sl), irqf);
-	}
-	--s->count;
-#ifdef UK_SEMAPHORE_DEBUG
-	uk_pr_debug("Decreased semaphore %p to %ld\n", s, s->count);
-#endif
-	uk_spin_unlock_irqrestore(&(s->sl), irqf);
+	_uk_semaphore_down(s, 0);
 }
 
 static inline int uk_semaphore_down_try(struct uk_semaphore *s)
@@ -97,33 +93,13 @@ static inline int uk_semaphore_down_try(struct uk_semaphore *s)
 static inline __nsec uk_semaphore_down_to(struct uk_semaphore *s,
 					  __nsec timeout)
 {
-	unsigned long irqf;
 	__nsec then = ukplat_monotonic_clock();
-	__nsec deadline;
 
 	UK_ASSERT(s);
 
-	deadline = then + timeout;
-
-	for (;;) {
-		uk_waitq_wait_event_deadline(&s->wait, s->count > 0, deadline);
-		uk_spin_lock_irqsave(&(s->sl), irqf);
-		if (s->count > 0 || (deadline &&
-				     ukplat_monotonic_clock() >= deadline))
-			break;
-		uk_spin_unlock_irqrestore(&(s->sl), irqf);
-	}
-	if (s->count > 0) {
-		s->count--;
-#ifdef UK_SEMAPHORE_DEBUG
-		uk_pr_debug("Decreased semaphore %p to %ld\n",
-			    s, s->count);
-#endif
-		uk_spin_unlock_irqrestore(&(s->sl), irqf);
+	if (_uk_semaphore_down(s, then + timeout))
 		return ukplat_monotonic_clock() - then;
-	}
 
-	uk_spin_unlock_irqrestore(&(s->sl), irqf);
 #ifdef UK_SEMAPHORE_DEBUG
 	uk_pr_debug("Timed out while waiting for semaphore %p\n", s);
 #endif
@@ -137,12 +113,17 @@ static inline void uk_semaphore_up(struct uk_semaphore *s)
 	UK_ASSERT(s);
 
 	uk_spin_lock_irqsave(&(s->sl), irqf);
-	++s->count;
+	if (uk_waitq_handoff(&s->wait)) {
 #ifdef UK_SEMAPHORE_DEBUG
-	uk_pr_debug("Increased semaphore %p to %ld\n",
-		    s, s->count);
+		uk_pr_debug("Handed semaphore %p over\n", s);
 #endif
-	uk_waitq_wake_up(&s->wait);
+	} else {
+		++s->count;
+#ifdef UK_SEMAPHORE_DEBUG
+		uk_pr_debug("Increased semaphore %p to %ld\n",
+			    s, s->count);
+#endif
+	}
 	uk_spin_unlock_irqrestore(&(s->sl), irqf);
 }
 
@@ -0,0 +1,102 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2023, Unikraft GmbH and The Unikraft Authors.
+ * Licensed under the BSD-3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ */
+
+#include <errno.h>
+#include <string.h>
+#include <uk/arch/atomic.h>
+#include <uk/assert.h>
+#include <uk/essentials.h>
+#include <uk/lockstat.h>
+#include <uk/print.h>
+
+#define LOCKSTAT_SIZE	CONFIG_LIBUKLOCK_LOCKSTAT_SIZE
+#define LONG_BITS	(sizeof(unsigned long) * 8)
+
+/* Open addressing hash table, entries are never removed */
+static struct uk_lockstat lockstat_table[LOCKSTAT_SIZE];
+static int lockstat_full;
+
+static inline unsigned int lockstat_hash(const void *lock)
+{
+	__u64 h = ((__u64)(__uptr) lock >> 3) * 0x9e3779b97f4a7c15ULL;
+
+	return (unsigned int) ((h >> 32) % LOCKSTAT_SIZE);
+}
+
+struct uk_lockstat *uk_lockstat_get(const void *lock)
+{
+	struct uk_lockstat *s;
+	const void *key;
+	unsigned int idx, i;
+
+	UK_ASSERT(lock);
+
+	idx = lockstat_hash(lock);
+	for (i = 0; i < LOCKSTAT_SIZE; i++) {
+		s = &lockstat_table[(idx + i) % LOCKSTAT_SIZE];
+		key = ukarch_load_n(&s->lock);
+		if (key == lock)
+			return s;
+
+		/* An entry is only created by the holder of the lock, so
+		 * another thread can only claim the slot for another lock
+		 */
+		if (!key &&
+		    ukarch_compare_exchange_sync(&s->lock, NULL, lock) == lock)
+			return s;
+	}
+
+	if (!ukarch_exchange_n(&lockstat_full, 1))
+		uk_pr_warn("Lock statistics table full, increase CONFIG_LIBUKLOCK_LOCKSTAT_SIZE\n");
+	return NULL;
+}
+
+int uk_lockstat_read(unsigned int idx, struct uk_lockstat *dst)
+{
+	UK_ASSERT(dst);
+
+	if (unlikely(idx >= LOCKSTAT_SIZE))
+		return -EINVAL;
+	if (!ukarch_load_n(&lockstat_table[idx].lock))
+		return -ENOENT;
+
+	memcpy(dst, &lockstat_table[idx], sizeof(*dst));
+	return 0;
+}
+
+void uk_lockstat_print(unsigned int n)
+{
+	unsigned long printed[DIV_ROUND_UP(LOCKSTAT_SIZE, LONG_BITS)] = { 0 };
+	struct uk_lockstat s, top;
+	unsigned int i, top_idx;
+
+	uk_pr_info("Lock statistics (times in ns):\n");
+	while (n--) {
+		/* Select the most contended lock that is not printed yet */
+		top.nr_contended = 0;
+		top_idx = LOCKSTAT_SIZE;
+		for (i = 0; i < LOCKSTAT_SIZE; i++) {
+			if (printed[i / LONG_BITS] & (1UL << (i % LONG_BITS)))
+				continue;
+			if (uk_lockstat_read(i, &s) < 0)
+				continue;
+			if (top_idx == LOCKSTAT_SIZE ||
+			    s.nr_contended > top.nr_contended) {
+				top = s;
+				top_idx = i;
+			}
+		}
+		if (top_idx == LOCKSTAT_SIZE)
+			break;
+		printed[top_idx / LONG_BITS] |= 1UL << (top_idx % LONG_BITS);
+
+		uk_pr_info("%p: %"__PRIu64"/%"__PRIu64" contended, wait total %"
+			   __PRInsec" max %"__PRInsec", hold total %"__PRInsec
+			   " max %"__PRInsec"\n", top.lock, top.nr_contended,
+			   top.nr_acquired, top.wait_total, top.wait_max,
+			   top.hold_total, top.hold_max);
+	}
+}
@@ -1,11 +1,9 @@
 #include <uk/mutex.h>
 
 #ifdef CONFIG_LIBUKLOCK_MUTEX_METRICS
-#include <uk/init.h>
 #include <uk/assert.h>
 
-struct uk_mutex_metrics _uk_mutex_metrics = { 0 };
-__spinlock              _uk_mutex_metrics_lock;
+struct uk_mutex_lcpu_metrics _uk_mutex_metrics __align(CACHE_LINE_SIZE);
 #endif /* CONFIG_LIBUKLOCK_MUTEX_METRICS */
 
 void uk_mutex_init_config(struct uk_mutex *m, unsigned int flags)
@@ -14,29 +12,163 @@ void uk_mutex_init_config(struct uk_mutex *m, unsigned int flags)
 	m->flags = flags;
 	m->owner = NULL;
 	uk_waitq_init(&m->wait);
+	m->nwaiters = 0;
+	m->handoff = 0;
+#if CONFIG_LIBUKLOCK_LOCKSTAT
+	m->stat = NULL;
+#endif /* CONFIG_LIBUKLOCK_LOCKSTAT */
 
 #ifdef CONFIG_LIBUKLOCK_MUTEX_METRICS
-	ukarch_spin_lock(&_uk_mutex_metrics_lock);
-	_uk_mutex_metrics.active_unlocked++;
-	ukarch_spin_unlock(&_uk_mutex_metrics_lock);
+	uk_counter_inc(&_uk_mutex_metrics, active_unlocked);
 #endif /* CONFIG_LIBUKLOCK_MUTEX_METRICS */
 }
 
-#ifdef CONFIG_LIBUKLOCK_MUTEX_METRICS
+#if CONFIG_LIBUKLOCK_MUTEX_SPIN
 /**
- * Initializes the mutex metric counters and its spinlock.
- * @return 0 on success.
- *
- * NOTE: this function is registered as a CTOR for this library.
+ * Spins while the owner of the mutex is running on another lcpu, so that a
+ * short critical section does not cost the locker a sleep and a wake up.
+ * @return 1 if the mutex was acquired, 0 if the caller has to sleep.
  */
-static int mutex_metrics_ctor(void)
+static int mutex_spin(struct uk_mutex *m, struct uk_thread *cur)
 {
-	ukarch_spin_init(&_uk_mutex_metrics_lock);
+	struct uk_thread *owner;
+	unsigned int i;
 
+	for (i = 0; i < CONFIG_LIBUKLOCK_MUTEX_SPIN; i++) {
+		owner = ukarch_load_n(&m->owner);
+		if (!owner) {
+			/* Do not overtake waiters of a fair mutex */
+			if (uk_mutex_is_fair(m) && ukarch_load_n(&m->nwaiters))
+				return 0;
+			if (ukarch_compare_exchange_sync(&m->owner, NULL,
+							 cur) == cur) {
+				m->lock_count = 1;
+				return 1;
+			}
+		} else if (owner->sched == cur->sched ||
+			   !uk_thread_is_runnable(owner)) {
+			/* The owner cannot make progress while we spin */
+			return 0;
+		}
+		ukarch_spinwait();
+	}
 	return 0;
 }
-uk_lib_initcall_prio(mutex_metrics_ctor, 1);
+#endif /* CONFIG_LIBUKLOCK_MUTEX_SPIN */
+
+static void mutex_wait(struct uk_mutex *m, struct uk_thread *cur)
+{
+	unsigned long flags;
+	int woken = 0;
+	DEFINE_WAIT(wait);
+
+	ukplat_spin_lock_irqsave(&m->wait.sl, flags);
+	ukarch_inc(&m->nwaiters);
+	for (;;) {
+		/* Pairs with the release in uk_mutex_unlock(): either we see
+		 * the mutex unlocked or the unlocker sees us waiting
+		 */
+		if (ukarch_compare_exchange_sync(&m->owner, NULL, cur) == cur) {
+			uk_waitq_remove(&m->wait, &wait);
+			ukarch_dec(&m->nwaiters);
+			m->lock_count = 1;
+			break;
+		}
+
+		if (!wait.waiting) {
+			if (woken) {
+				/* We lost the mutex after we were woken up:
+				 * the next unlock hands it over to us
+				 */
+				uk_waitq_add_head(&m->wait, &wait);
+				m->handoff = 1;
+			} else {
+				uk_waitq_add(&m->wait, &wait);
+			}
+		}
+
+		uk_thread_block(cur);
+		ukplat_spin_unlock_irqrestore(&m->wait.sl, flags);
+		uk_sched_yield();
+		ukplat_spin_lock_irqsave(&m->wait.sl, flags);
+
+		if (!wait.waiting) {
+			/* Dequeued by _uk_mutex_unlock_slow() */
+			if (m->owner == cur)
+				break;
+			woken = 1;
+			ukarch_inc(&m->nwaiters);
+		}
+	}
+	ukplat_spin_unlock_irqrestore(&m->wait.sl, flags);
+}
+
+void _uk_mutex_lock_slow(struct uk_mutex *m)
+{
+	struct uk_thread *cur = uk_thread_current();
+#if CONFIG_LIBUKLOCK_LOCKSTAT
+	__nsec start = ukplat_monotonic_clock();
+#endif /* CONFIG_LIBUKLOCK_LOCKSTAT */
+
+#if CONFIG_LIBUKLOCK_MUTEX_SPIN
+	if (!mutex_spin(m, cur))
+#endif /* CONFIG_LIBUKLOCK_MUTEX_SPIN */
+		mutex_wait(m, cur);
 
+#if CONFIG_LIBUKLOCK_LOCKSTAT
+	/* We own the mutex now, so we can update its statistics */
+	if (!m->stat)
+		m->stat = uk_lockstat_get(m);
+	if (m->stat)
+		uk_lockstat_contended(m->stat,
+				      ukplat_monotonic_clock() - start);
+#endif /* CONFIG_LIBUKLOCK_LOCKSTAT */
+}
+
+void _uk_mutex_unlock_slow(struct uk_mutex *m)
+{
+	struct uk_thread *cur = uk_thread_current();
+	struct uk_waitq_entry *head;
+	unsigned long flags;
+
+	ukplat_spin_lock_irqsave(&m->wait.sl, flags);
+	head = UK_STAILQ_FIRST(&m->wait.wait_list);
+	if (!head) {
+		/* The waiter acquired the mutex in the meantime */
+		if (m->owner == cur)
+			ukarch_store_n(&m->owner, NULL);
+		goto out;
+	}
+
+	if (uk_mutex_is_fair(m) || m->handoff) {
+		/* Hand the mutex over to the first waiter. If we released it
+		 * already, a running thread may have taken it in the meantime
+		 * and hands it over when it unlocks.
+		 */
+		if (m->owner == cur) {
+			m->lock_count = 1;
+			ukarch_store_n(&m->owner, head->thread);
+		} else if (ukarch_compare_exchange_sync(&m->owner, NULL,
+							head->thread)
+			   == head->thread) {
+			m->lock_count = 1;
+		} else {
+			goto out;
+		}
+		m->handoff = 0;
+	} else if (m->owner == cur) {
+		ukarch_store_n(&m->owner, NULL);
+	}
+
+	/* Wake up only the first waiter */
+	ukarch_dec(&m->nwaiters);
+	uk_waitq_handoff(&m->wait);
+
+out:
+	ukplat_spin_unlock_irqrestore(&m->wait.sl, flags);
+}
+
+#ifdef CONFIG_LIBUKLOCK_MUTEX_METRICS
 /**
  * Makes a copy of mutex metrics to avoid direct user access.
  * @dst : destination buffer (must have been already allocated)
@@ -45,8 +177,14 @@ void uk_mutex_get_metrics(struct uk_mutex_metrics *dst)
 {
 	UK_ASSERT(dst);
 
-	ukarch_spin_lock(&_uk_mutex_metrics_lock);
-	memcpy(dst, &_uk_mutex_metrics, sizeof(*dst));
-	ukarch_spin_unlock(&_uk_mutex_metrics_lock);
+	dst->active_locked = uk_counter_sum(&_uk_mutex_metrics, active_locked);
+	dst->active_unlocked = uk_counter_sum(&_uk_mutex_metrics,
+					      active_unlocked);
+	dst->total_locks = uk_counter_sum(&_uk_mutex_metrics, total_locks);
+	dst->total_ok_trylocks = uk_counter_sum(&_uk_mutex_metrics,
+						total_ok_trylocks);
+	dst->total_failed_trylocks = uk_counter_sum(&_uk_mutex_metrics,
+						    total_failed_trylocks);
+	dst->total_unlocks = uk_counter_sum(&_uk_mutex_metrics, total_unlocks);
 }
 #endif /* CONFIG_LIBUKLOCK_MUTEX_METRICS */
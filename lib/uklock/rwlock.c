@@ -7,8 +7,11 @@
 #include <uk/arch/atomic.h>
 #include <uk/assert.h>
 #include <uk/rwlock.h>
-#include <uk/assert.h>
 #include <uk/config.h>
+#include <uk/thread.h>
+#if CONFIG_LIBUKLOCK_LOCKSTAT
+#include <uk/plat/time.h>
+#endif /* CONFIG_LIBUKLOCK_LOCKSTAT */
 
 void uk_rwlock_init_config(struct uk_rwlock *rwl, unsigned int config_flags)
 {
@@ -25,6 +28,87 @@ void uk_rwlock_init_config(struct uk_rwlock *rwl, unsigned int config_flags)
 	uk_spin_init(&rwl->sl);
 	uk_waitq_init(&rwl->shared);
 	uk_waitq_init(&rwl->exclusive);
+#if CONFIG_LIBUKLOCK_LOCKSTAT
+	rwl->stat = NULL;
+#endif /* CONFIG_LIBUKLOCK_LOCKSTAT */
+}
+
+#if CONFIG_LIBUKLOCK_LOCKSTAT
+/* The statistics are updated with the spinlock held. Hold times are
+ * recorded for writers only.
+ */
+static void rwlock_stat_acquired(struct uk_rwlock *rwl, int write)
+{
+	if (!rwl->stat)
+		return;
+	uk_lockstat_acquired(rwl->stat);
+	if (write)
+		rwl->wacquired = ukplat_monotonic_clock();
+}
+
+static void rwlock_stat_wreleased(struct uk_rwlock *rwl)
+{
+	if (rwl->stat)
+		uk_lockstat_released(rwl->stat,
+				     ukplat_monotonic_clock() - rwl->wacquired);
+}
+#else /* !CONFIG_LIBUKLOCK_LOCKSTAT */
+#define rwlock_stat_acquired(rwl, write) do {} while (0)
+#define rwlock_stat_wreleased(rwl) do {} while (0)
+#endif /* !CONFIG_LIBUKLOCK_LOCKSTAT */
+
+/* Grants the lock to all waiting readers */
+static void rwlock_grant_readers(struct uk_rwlock *rwl)
+{
+	while (uk_waitq_handoff(&rwl->shared)) {
+		UK_ASSERT(rwl->npending_reads > 0);
+		rwl->npending_reads--;
+		rwl->nactive++;
+	}
+}
+
+/* Grants the lock to the first waiting writer */
+static void rwlock_grant_writer(struct uk_rwlock *rwl)
+{
+	UK_ASSERT(rwl->nactive == 0);
+
+	if (uk_waitq_handoff(&rwl->exclusive)) {
+		UK_ASSERT(rwl->npending_writes > 0);
+		rwl->npending_writes--;
+		rwl->nactive = -1;
+	}
+}
+
+/* Blocks until a releasing thread granted the lock by dequeuing the current
+ * thread. Called and returns with the spinlock held.
+ */
+static void rwlock_wait(struct uk_rwlock *rwl, struct uk_waitq *wq, int head)
+{
+	struct uk_thread *cur = uk_thread_current();
+#if CONFIG_LIBUKLOCK_LOCKSTAT
+	__nsec start = ukplat_monotonic_clock();
+#endif /* CONFIG_LIBUKLOCK_LOCKSTAT */
+	DEFINE_WAIT(wait);
+
+	if (head)
+		uk_waitq_add_head(wq, &wait);
+	else
+		uk_waitq_add(wq, &wait);
+
+	do {
+		uk_thread_block(cur);
+		uk_spin_unlock(&rwl->sl);
+		uk_sched_yield();
+		uk_spin_lock(&rwl->sl);
+	} while (wait.waiting);
+
+#if CONFIG_LIBUKLOCK_LOCKSTAT
+	if (!rwl->stat)
+		rwl->stat = uk_lockstat_get(rwl);
+	if (rwl->stat)
+		uk_lockstat_contended(rwl->stat,
+				      ukplat_monotonic_clock() - start);
+#endif /* CONFIG_LIBUKLOCK_LOCKSTAT */
 }
 
 void uk_rwlock_rlock(struct uk_rwlock *rwl)
@@ -32,35 +116,22 @@ void uk_rwlock_rlock(struct uk_rwlock *rwl)
 	UK_ASSERT(rwl);
 
 	uk_spin_lock(&rwl->sl);
-	rwl->npending_reads++;
 
 	/* We let readers wait when there are writers pending. This is
 	 * necessary to avoid a situation where new readers continuously enter
 	 * the critical section while other readers are still in - thereby
 	 * starving the writers. However, at the same time we must not starve
-	 * readers when there are writers. Thus we always wake up readers when
-	 * a writer unlocks. The first wait() functions as a queue where we
-	 * enqueue readers that arrive while a writer had the lock (or is going
-	 * to get the lock next). When the writer unblock the readers, they
-	 * fall to the second wait() and eventually can enter. New readers,
-	 * however, block again on the first wait(), thus giving priority to
-	 * waiting writers.
+	 * readers when there are writers. Thus a writer that unlocks grants
+	 * the lock to all waiting readers at once before the next writer.
 	 */
-	if (rwl->npending_writes > 0)
-		uk_waitq_wait_locked(&rwl->shared,
-				     uk_spin_lock,
-				     uk_spin_unlock,
-				     &rwl->sl);
-
-	/* Wait in case a writer acquired the lock (in the meantime) */
-	uk_waitq_wait_event_locked(&rwl->shared,
-				   rwl->nactive >= 0,
-				   uk_spin_lock,
-				   uk_spin_unlock,
-				   &rwl->sl);
-
-	rwl->nactive++;
-	rwl->npending_reads--;
+	if (rwl->nactive >= 0 && rwl->npending_writes == 0) {
+		rwl->nactive++;
+	} else {
+		rwl->npending_reads++;
+		rwlock_wait(rwl, &rwl->shared, 0);
+		UK_ASSERT(rwl->nactive > 0);
+	}
+	rwlock_stat_acquired(rwl, 0);
 	uk_spin_unlock(&rwl->sl);
 }
 
@@ -69,51 +140,42 @@ void uk_rwlock_wlock(struct uk_rwlock *rwl)
 	UK_ASSERT(rwl);
 
 	uk_spin_lock(&rwl->sl);
-	rwl->npending_writes++;
-
-	/* Wait for all readers to have left the lock. New readers will
-	 * block in uk_rwlock_rlock while we are waiting.
-	 */
-	uk_waitq_wait_event_locked(&rwl->exclusive,
-				   rwl->nactive == 0,
-				   uk_spin_lock,
-				   uk_spin_unlock,
-				   &rwl->sl);
-
-	UK_ASSERT(rwl->npending_writes > 0);
-	UK_ASSERT(rwl->nactive == 0);
+	if (rwl->nactive == 0) {
+		rwl->nactive = -1;
+	} else {
+		/* Wait for all readers to have left the lock. New readers will
+		 * block in uk_rwlock_rlock while we are waiting.
+		 */
+		rwl->npending_writes++;
+		rwlock_wait(rwl, &rwl->exclusive, 0);
+	}
 
-	rwl->npending_writes--;
-	rwl->nactive = -1;
+	UK_ASSERT(rwl->nactive == -1);
+	rwlock_stat_acquired(rwl, 1);
 	uk_spin_unlock(&rwl->sl);
 }
 
 void uk_rwlock_runlock(struct uk_rwlock *rwl)
 {
-	int wake_writers;
-
 	UK_ASSERT(rwl);
 
 	uk_spin_lock(&rwl->sl);
 	UK_ASSERT(rwl->nactive > 0);
 
-	/* Remove this thread from the active readers. We wake up a writer if
-	 * this was the last reader and there are writers waiting. If there
-	 * are no writers pending, readers can always enter. We make sure that
-	 * readers are not starving by prioritizing readers on write unlocks.
+	/* Remove this thread from the active readers. If this was the last
+	 * reader, the lock is handed over to the first waiting writer. If
+	 * there are no writers pending, readers can always enter. We make
+	 * sure that readers are not starving by prioritizing readers on
+	 * write unlocks.
 	 */
 	rwl->nactive--;
-	wake_writers = (rwl->nactive == 0 && rwl->npending_writes > 0);
+	if (rwl->nactive == 0 && rwl->npending_writes > 0)
+		rwlock_grant_writer(rwl);
 	uk_spin_unlock(&rwl->sl);
-
-	if (wake_writers)
-		uk_waitq_wake_up_one(&rwl->exclusive);
 }
 
 void uk_rwlock_wunlock(struct uk_rwlock *rwl)
 {
-	int wake_readers;
-
 	UK_ASSERT(rwl);
 
 	uk_spin_lock(&rwl->sl);
@@ -123,14 +185,13 @@ void uk_rwlock_wunlock(struct uk_rwlock *rwl)
 	 * instead of writers so they do not starve. We avoid starvation of
 	 * writers in uk_rwlock_rlock().
 	 */
+	rwlock_stat_wreleased(rwl);
 	rwl->nactive = 0;
-	wake_readers = (rwl->npending_reads > 0);
+	if (rwl->npending_reads > 0)
+		rwlock_grant_readers(rwl);
+	else if (rwl->npending_writes > 0)
+		rwlock_grant_writer(rwl);
 	uk_spin_unlock(&rwl->sl);
-
-	if (wake_readers)
-		uk_waitq_wake_up(&rwl->shared);
-	else
-		uk_waitq_wake_up_one(&rwl->exclusive);
 }
 
 void uk_rwlock_upgrade(struct uk_rwlock *rwl)
@@ -147,46 +208,34 @@ void uk_rwlock_upgrade(struct uk_rwlock *rwl)
 
 		/*
 		 * Indicate that we are waiting for write access and remove
-		 * this thread from the active readers.
+		 * this thread from the active readers. We queue up in front
+		 * of the other writers, so that the last reader hands the
+		 * lock over to us.
 		 */
 		rwl->npending_writes++;
 		rwl->nactive--;
+		rwlock_wait(rwl, &rwl->exclusive, 1);
 
-		uk_waitq_wait_event_locked(&rwl->shared,
-					   rwl->nactive == 0,
-					   uk_spin_lock,
-					   uk_spin_unlock,
-					   &rwl->sl);
-
-		UK_ASSERT(rwl->npending_writes > 0);
-		UK_ASSERT(rwl->nactive == 0);
-
-		/* We are now the writer. Remove the satisfied request and mark
-		 * the lock for write access.
-		 */
-		rwl->npending_writes--;
-		rwl->nactive = -1;
+		/* We are now the writer */
+		UK_ASSERT(rwl->nactive == -1);
 	}
+	rwlock_stat_acquired(rwl, 1);
 	uk_spin_unlock(&rwl->sl);
 }
 
 void uk_rwlock_downgrade(struct uk_rwlock *rwl)
 {
-	int wake_readers;
-
 	UK_ASSERT(rwl);
 
 	uk_spin_lock(&rwl->sl);
 	UK_ASSERT(rwl->nactive == -1);
 
 	/* We are the writer. Downgrade the lock to read access by
-	 * transforming to a reader. If there are other readers waiting, wake
-	 * them up.
+	 * transforming to a reader. If there are other readers waiting, let
+	 * them in.
 	 */
+	rwlock_stat_wreleased(rwl);
 	rwl->nactive = 1;
-	wake_readers = (rwl->npending_reads > 0);
+	rwlock_grant_readers(rwl);
 	uk_spin_unlock(&rwl->sl);
-
-	if (wake_readers)
-		uk_waitq_wake_up(&rwl->shared);
 }
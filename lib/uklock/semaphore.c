@@ -15,6 +15,45 @@ void uk_semaphore_init(struct uk_semaphore *s, long count)
 #endif
 }
 
+int _uk_semaphore_down(struct uk_semaphore *s, __nsec deadline)
+{
+	struct uk_thread *cur = uk_thread_current();
+	unsigned long irqf;
+	int ret = 1;
+	DEFINE_WAIT(wait);
+
+	uk_spin_lock_irqsave(&(s->sl), irqf);
+	if (s->count > 0) {
+		--s->count;
+#ifdef UK_SEMAPHORE_DEBUG
+		uk_pr_debug("Decreased semaphore %p to %ld\n", s, s->count);
+#endif
+		goto out;
+	}
+
+	uk_waitq_add(&s->wait, &wait);
+	for (;;) {
+		uk_thread_block_until(cur, (__snsec) deadline);
+		uk_spin_unlock_irqrestore(&(s->sl), irqf);
+		uk_sched_yield();
+		uk_spin_lock_irqsave(&(s->sl), irqf);
+
+		/* Dequeued by uk_semaphore_up(), which kept the unit for us */
+		if (!wait.waiting)
+			break;
+
+		if (deadline && ukplat_monotonic_clock() >= deadline) {
+			uk_waitq_remove(&s->wait, &wait);
+			ret = 0;
+			break;
+		}
+	}
+
+out:
+	uk_spin_unlock_irqrestore(&(s->sl), irqf);
+	return ret;
+}
+
 #if CONFIG_LIBPOSIX_PROCESS_CLONE
 /* parent and child share System V semaphores */
 static int uk_posix_clone_sysvsem(const struct clone_args *cl_args __unused,
@@ -0,0 +1,326 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2023, Unikraft GmbH and The Unikraft Authors.
+ * Licensed under the BSD-3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ */
+
+#include <uk/test.h>
+#include <uk/essentials.h>
+#include <uk/mutex.h>
+#include <uk/sched.h>
+#include <uk/sched_impl.h>
+#include <uk/plat/time.h>
+#if CONFIG_LIBUKLOCK_SEMAPHORE
+#include <uk/semaphore.h>
+#endif /* CONFIG_LIBUKLOCK_SEMAPHORE */
+#if CONFIG_LIBUKLOCK_RWLOCK
+#include <uk/rwlock.h>
+#endif /* CONFIG_LIBUKLOCK_RWLOCK */
+
+#define MAX_THREADS	8
+
+/* Number of lock operations per thread and benchmark measurement */
+#define BENCH_ROUNDS	2000
+
+/* The owner yields in every n-th critical section to build up waiters */
+#define BENCH_YIELD	4
+
+struct lock_args {
+	struct uk_mutex *m;
+	unsigned int id;
+	unsigned int rounds;
+	__nsec cs_len;
+	unsigned long *counter;
+	unsigned int *order;
+	unsigned int *norder;
+};
+
+/* Waits for the threads to exit and releases them. The idle thread, which
+ * otherwise collects exited threads, does not run while we yield, so
+ * repeated rounds would run out of memory.
+ */
+static void wait_threads(struct uk_thread **t, unsigned int n)
+{
+	unsigned int i;
+
+	for (i = 0; i < n; ++i)
+		while (!uk_thread_is_exited(t[i]))
+			uk_sched_yield();
+	uk_sched_thread_gc(uk_sched_current());
+}
+
+static void wait_thread(struct uk_thread *t)
+{
+	wait_threads(&t, 1);
+}
+
+/* Busy loop for the length of a critical section */
+static void cs_delay(__nsec len)
+{
+	__nsec end;
+
+	if (!len)
+		return;
+	end = ukplat_monotonic_clock() + len;
+	while (ukplat_monotonic_clock() < end)
+		;
+}
+
+static __noreturn void counter_func(void *arg)
+{
+	struct lock_args *args = (struct lock_args *)arg;
+	unsigned long val;
+	unsigned int i;
+
+	for (i = 0; i < args->rounds; ++i) {
+		uk_mutex_lock(args->m);
+		/* Other threads must not enter while the owner is away */
+		val = *args->counter;
+		cs_delay(args->cs_len);
+		if (i % BENCH_YIELD == 0)
+			uk_sched_yield();
+		*args->counter = val + 1;
+		uk_mutex_unlock(args->m);
+	}
+	uk_sched_thread_exit();
+}
+
+static __noreturn void order_func(void *arg)
+{
+	struct lock_args *args = (struct lock_args *)arg;
+
+	uk_mutex_lock(args->m);
+	args->order[(*args->norder)++] = args->id;
+	uk_mutex_unlock(args->m);
+	uk_sched_thread_exit();
+}
+
+/* Runs `n` threads that increment a counter under the mutex */
+static __nsec run_counter(struct uk_mutex *m, unsigned int n,
+			  unsigned int rounds, __nsec cs_len,
+			  unsigned long *counter)
+{
+	struct uk_thread *threads[MAX_THREADS];
+	struct lock_args args[MAX_THREADS];
+	__nsec start;
+	unsigned int i;
+
+	UK_ASSERT(n <= MAX_THREADS);
+
+	*counter = 0;
+	start = ukplat_monotonic_clock();
+	for (i = 0; i < n; ++i) {
+		args[i] = (struct lock_args){
+			.m = m,
+			.id = i,
+			.rounds = rounds,
+			.cs_len = cs_len,
+			.counter = counter,
+		};
+		threads[i] = uk_sched_thread_create(uk_sched_current(),
+						    counter_func, &args[i],
+						    "mutex-counter");
+		UK_ASSERT(threads[i]);
+	}
+	wait_threads(threads, n);
+	return ukplat_monotonic_clock() - start;
+}
+
+UK_TESTCASE(uklock_mutex, mutual_exclusion)
+{
+	struct uk_mutex m = UK_MUTEX_INITIALIZER(m);
+	struct uk_mutex fair;
+	unsigned long counter;
+
+	run_counter(&m, MAX_THREADS, 100, 0, &counter);
+	UK_TEST_EXPECT_SNUM_EQ(counter, MAX_THREADS * 100);
+	UK_TEST_EXPECT(!uk_mutex_is_locked(&m));
+	UK_TEST_EXPECT_ZERO(m.nwaiters);
+
+	uk_mutex_init_config(&fair, UK_MUTEX_CONFIG_FAIR);
+	run_counter(&fair, MAX_THREADS, 100, 0, &counter);
+	UK_TEST_EXPECT_SNUM_EQ(counter, MAX_THREADS * 100);
+	UK_TEST_EXPECT(!uk_mutex_is_locked(&fair));
+	UK_TEST_EXPECT_ZERO(fair.nwaiters);
+}
+
+UK_TESTCASE(uklock_mutex, fair_handoff_order)
+{
+	struct uk_thread *threads[MAX_THREADS];
+	struct lock_args args[MAX_THREADS];
+	unsigned int order[MAX_THREADS];
+	unsigned int norder = 0;
+	struct uk_mutex m;
+	unsigned int i;
+
+	uk_mutex_init_config(&m, UK_MUTEX_CONFIG_FAIR);
+	uk_mutex_lock(&m);
+
+	for (i = 0; i < MAX_THREADS; ++i) {
+		args[i] = (struct lock_args){
+			.m = &m,
+			.id = i,
+			.order = order,
+			.norder = &norder,
+		};
+		threads[i] = uk_sched_thread_create(uk_sched_current(),
+						    order_func, &args[i],
+						    "mutex-order");
+		UK_ASSERT(threads[i]);
+
+		/* Let the thread queue up on the mutex */
+		uk_sched_yield();
+	}
+	UK_TEST_EXPECT_SNUM_EQ(m.nwaiters, MAX_THREADS);
+
+	/* The mutex is handed over along the wait queue */
+	uk_mutex_unlock(&m);
+	wait_threads(threads, MAX_THREADS);
+
+	UK_TEST_EXPECT_SNUM_EQ(norder, MAX_THREADS);
+	for (i = 0; i < MAX_THREADS; ++i)
+		UK_TEST_EXPECT_SNUM_EQ(order[i], i);
+	UK_TEST_EXPECT(!uk_mutex_is_locked(&m));
+}
+
+#if CONFIG_LIBUKLOCK_SEMAPHORE
+static __noreturn void sem_down_func(void *arg)
+{
+	uk_semaphore_down((struct uk_semaphore *)arg);
+	uk_sched_thread_exit();
+}
+
+UK_TESTCASE(uklock_mutex, semaphore_handoff)
+{
+	struct uk_thread *threads[2];
+	struct uk_semaphore s;
+
+	uk_semaphore_init(&s, 0);
+	UK_TEST_EXPECT_SNUM_EQ(uk_semaphore_down_to(&s, 1000), __NSEC_MAX);
+
+	threads[0] = uk_sched_thread_create(uk_sched_current(),
+					    sem_down_func, &s, "sem-down");
+	threads[1] = uk_sched_thread_create(uk_sched_current(),
+					    sem_down_func, &s, "sem-down");
+	uk_sched_yield();
+
+	/* Both ups happen before any waiter runs: each waiter gets a unit */
+	uk_semaphore_up(&s);
+	uk_semaphore_up(&s);
+	UK_TEST_EXPECT_ZERO(s.count);
+	wait_threads(threads, 2);
+
+	uk_semaphore_up(&s);
+	UK_TEST_EXPECT_SNUM_EQ(s.count, 1);
+	UK_TEST_EXPECT(uk_semaphore_down_try(&s));
+}
+#endif /* CONFIG_LIBUKLOCK_SEMAPHORE */
+
+#if CONFIG_LIBUKLOCK_RWLOCK
+static __noreturn void rwlock_writer_func(void *arg)
+{
+	struct uk_rwlock *rwl = (struct uk_rwlock *)arg;
+
+	uk_rwlock_wlock(rwl);
+	uk_rwlock_wunlock(rwl);
+	uk_sched_thread_exit();
+}
+
+UK_TESTCASE(uklock_mutex, rwlock_handoff)
+{
+	struct uk_thread *writer;
+	struct uk_rwlock rwl;
+
+	uk_rwlock_init(&rwl);
+	uk_rwlock_rlock(&rwl);
+
+	writer = uk_sched_thread_create(uk_sched_current(),
+					rwlock_writer_func, &rwl, "rw-writer");
+	uk_sched_yield();
+	UK_TEST_EXPECT_SNUM_EQ(rwl.npending_writes, 1);
+
+	/* The last reader hands the lock over to the writer */
+	uk_rwlock_runlock(&rwl);
+	UK_TEST_EXPECT_SNUM_EQ(rwl.nactive, -1);
+	UK_TEST_EXPECT_ZERO(rwl.npending_writes);
+
+	wait_thread(writer);
+	UK_TEST_EXPECT_ZERO(rwl.nactive);
+}
+#endif /* CONFIG_LIBUKLOCK_RWLOCK */
+
+#if CONFIG_LIBUKLOCK_LOCKSTAT
+UK_TESTCASE(uklock_mutex, lockstat)
+{
+	struct uk_thread *thread;
+	struct lock_args args;
+	unsigned int order[1];
+	unsigned int norder = 0;
+	/* Statistics are keyed by address, a stack slot may be reused */
+	static struct uk_mutex m;
+
+	uk_mutex_init(&m);
+	uk_mutex_lock(&m);
+	uk_mutex_unlock(&m);
+	UK_TEST_EXPECT_NULL(m.stat);
+
+	/* Let a thread wait for the mutex */
+	uk_mutex_lock(&m);
+	args = (struct lock_args){ .m = &m, .order = order, .norder = &norder };
+	thread = uk_sched_thread_create(uk_sched_current(), order_func, &args,
+					"mutex-stat");
+	UK_ASSERT(thread);
+	uk_sched_yield();
+	uk_mutex_unlock(&m);
+	wait_thread(thread);
+
+	/* The statistics table may be full if other tests contended on many
+	 * locks before
+	 */
+	UK_TEST_EXPECT_NOT_NULL(m.stat);
+	if (!m.stat)
+		return;
+	UK_TEST_EXPECT_PTR_EQ(m.stat->lock, &m);
+	UK_TEST_EXPECT_SNUM_EQ(m.stat->nr_contended, 1);
+	UK_TEST_EXPECT_SNUM_EQ(m.stat->nr_acquired, 1);
+	UK_TEST_EXPECT_PTR_EQ(uk_lockstat_get(&m), m.stat);
+
+	/* Uncontended acquisitions are recorded from now on */
+	uk_mutex_lock(&m);
+	uk_mutex_unlock(&m);
+	UK_TEST_EXPECT_SNUM_EQ(m.stat->nr_contended, 1);
+	UK_TEST_EXPECT_SNUM_EQ(m.stat->nr_acquired, 2);
+}
+#endif /* CONFIG_LIBUKLOCK_LOCKSTAT */
+
+/* Reports the time per lock acquisition under contention */
+UK_TESTCASE(uklock_mutex, benchmark)
+{
+	static const unsigned int nthreads[] = { 1, 2, 4, MAX_THREADS };
+	static const __nsec cs_lens[] = { 0, 1000, 10000 };
+	struct uk_mutex m, fair;
+	unsigned long counter, ops;
+	__nsec t, t_fair;
+	unsigned int i, j;
+
+	uk_mutex_init(&m);
+	uk_mutex_init_config(&fair, UK_MUTEX_CONFIG_FAIR);
+	for (i = 0; i < ARRAY_SIZE(nthreads); ++i) {
+		for (j = 0; j < ARRAY_SIZE(cs_lens); ++j) {
+			ops = nthreads[i] * BENCH_ROUNDS;
+			t = run_counter(&m, nthreads[i], BENCH_ROUNDS,
+					cs_lens[j], &counter);
+			UK_TEST_EXPECT_SNUM_EQ(counter, ops);
+			t_fair = run_counter(&fair, nthreads[i], BENCH_ROUNDS,
+					     cs_lens[j], &counter);
+			UK_TEST_EXPECT_SNUM_EQ(counter, ops);
+
+			uk_test_printf("%u threads, cs %5"__PRInsec" ns: %6"
+				       __PRInsec" ns/lock, fair %6"__PRInsec
+				       " ns/lock\n", nthreads[i], cs_lens[j],
+				       t / ops, t_fair / ops);
+		}
+	}
+}
+
+uk_testsuite_register(uklock_mutex, NULL);
@@ -37,6 +37,7 @@
 #include <stddef.h>
 #include <limits.h>
 #include <errno.h>
+#include <uk/config.h>
 #include <uk/assert.h>
 #include <uk/refcount.h>
 #include <uk/alloc.h>
@@ -123,6 +124,23 @@ typedef void (*uk_netbuf_dtor_t)(struct uk_netbuf *);
 #define UK_NETBUF_F_PARTIAL_CSUM_BIT 1
 #define UK_NETBUF_F_PARTIAL_CSUM     (1 << UK_NETBUF_F_PARTIAL_CSUM_BIT)
 
+/* Segmentation offload types (`gso_type`)
+ * On transmit, a packet with a type other than UK_NETBUF_GSO_NONE is a
+ * super-packet that is segmented by the device into frames carrying
+ * `gso_size` bytes of payload each, every frame repeating the first `hdr_len`
+ * bytes of protocol headers (e.g., Ethernet + IP + TCP). On receive, such a
+ * packet was coalesced from multiple segments by the device.
+ * NOTE: Segmentation offload requires a partial checksum
+ *       (UK_NETBUF_F_PARTIAL_CSUM) on the transport protocol.
+ */
+#define UK_NETBUF_GSO_NONE           0x00
+#define UK_NETBUF_GSO_TCPV4          0x01 /* IPv4 TCP (TSO) */
+#define UK_NETBUF_GSO_TCPV6          0x02 /* IPv6 TCP */
+#define UK_NETBUF_GSO_UDP            0x03 /* UDP fragmentation (UFO) */
+#define UK_NETBUF_GSO_TYPE_MASK      0x7f
+/* Modifier: TCP segments carry the ECN CWR flag */
+#define UK_NETBUF_GSO_ECN            0x80
+
 struct uk_netbuf {
 	struct uk_netbuf *next;
 	struct uk_netbuf *prev;
@@ -147,6 +165,17 @@ struct uk_netbuf {
 				 * pointing to the checksum field
 				 */
 
+	uint8_t gso_type;      /**< Segmentation offload type
+				 * (UK_NETBUF_GSO_*), chain head only
+				 */
+	uint16_t gso_size;     /**< Used if `gso_type` is not
+				 * UK_NETBUF_GSO_NONE; Payload bytes per segment
+				 */
+	uint16_t hdr_len;      /**< Used if `gso_type` is not
+				 * UK_NETBUF_GSO_NONE; Length of the protocol
+				 * headers that are repeated in every segment
+				 */
+
 	uk_netbuf_dtor_t dtor; /**< Destructor callback */
 	struct uk_alloc *_a;   /**< @internal Allocator for free'ing */
 	void *_b;              /**< @internal Base address for free'ing */
@@ -564,6 +593,107 @@ static inline int uk_netbuf_header(struct uk_netbuf *head, int16_t len)
 	return 1;
 }
 
+#if CONFIG_LIBUKNETDEV_NETBUF_POOL
+/*
+ * Netbuf pools
+ *
+ * A pool holds a fixed number of netbufs of the same size that are laid out
+ * like uk_netbuf_alloc_buf() netbufs. Netbufs are taken from the pool in
+ * batches and return to it on their last uk_netbuf_free(). Each logical CPU
+ * caches free netbufs, so that the shared pool is only touched for batches.
+ */
+struct uk_netbuf_pool;
+
+/**
+ * Allocates a netbuf pool.
+ * @param a
+ *   Allocator for the pool memory. The memory is allocated at once.
+ * @param count
+ *   Number of netbufs in the pool
+ * @param buflen
+ *   Size of the buffer area of each netbuf
+ * @param bufalign
+ *   Alignment of the buffer area (`m->buf` will be aligned to it)
+ * @param headroom
+ *   Number of bytes reserved as headroom from the buffer area.
+ *   `headroom` has to be smaller or equal to `buflen`.
+ * @param privlen
+ *   Length of the private data area of each netbuf (`m->priv`)
+ * @param dtor
+ *   Destructor that is called when a netbuf's refcount reaches zero,
+ *   before the netbuf returns to the pool (optional)
+ * @returns
+ *   - (NULL): Allocation failed
+ *   - the netbuf pool
+ */
+struct uk_netbuf_pool *uk_netbuf_pool_create(struct uk_alloc *a,
+					     unsigned int count,
+					     size_t buflen, size_t bufalign,
+					     uint16_t headroom, size_t privlen,
+					     uk_netbuf_dtor_t dtor);
+
+/**
+ * Takes multiple netbufs from a pool. The netbufs are initialized as by
+ * uk_netbuf_alloc_buf(): `m->len` is 0 and `m->data` points behind the
+ * headroom.
+ * @param p
+ *   The netbuf pool
+ * @param m
+ *   Array that is filled with the netbufs
+ * @param count
+ *   Maximum number of netbufs to take
+ * @returns
+ *   Number of netbufs placed to m[0]...m[count - 1]
+ */
+unsigned int uk_netbuf_pool_take_batch(struct uk_netbuf_pool *p,
+				       struct uk_netbuf *m[],
+				       unsigned int count);
+
+/**
+ * Takes a single netbuf from a pool.
+ * @param p
+ *   The netbuf pool
+ * @returns
+ *   - (NULL): The pool is exhausted
+ *   - initialized uk_netbuf
+ */
+static inline struct uk_netbuf *uk_netbuf_pool_take(struct uk_netbuf_pool *p)
+{
+	struct uk_netbuf *m;
+
+	return uk_netbuf_pool_take_batch(p, &m, 1) ? m : NULL;
+}
+
+/**
+ * Returns multiple netbufs to their pool without calling the destructor.
+ * This is intended for netbufs that were taken but never handed out (e.g.,
+ * surplus RX buffers on queue teardown). Each netbuf must be unchained and
+ * hold the only reference.
+ * @param p
+ *   The netbuf pool the netbufs were taken from
+ * @param m
+ *   Array of netbufs
+ * @param count
+ *   Number of netbufs in `m`
+ */
+void uk_netbuf_pool_return_batch(struct uk_netbuf_pool *p,
+				 struct uk_netbuf *m[], unsigned int count);
+
+/**
+ * Returns the number of netbufs that can currently be taken from a pool,
+ * including those that are cached by logical CPUs.
+ */
+unsigned int uk_netbuf_pool_availcount(struct uk_netbuf_pool *p);
+
+/**
+ * uk_netdev_alloc_rxpkts callback that refills receive queues from a pool.
+ * Pass the pool as `alloc_rxpkts_argp` of the queue configuration. The
+ * netbufs are returned with `m->len` set to their tailroom.
+ */
+uint16_t uk_netbuf_pool_alloc_rxpkts(void *argp, struct uk_netbuf *pkts[],
+				     uint16_t count);
+#endif /* CONFIG_LIBUKNETDEV_NETBUF_POOL */
+
 #ifdef __cplusplus
 }
 #endif
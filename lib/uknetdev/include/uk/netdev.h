@@ -185,7 +185,9 @@ const void *uk_netdev_einfo_get(struct uk_netdev *dev,
  *   The Unikraft Network Device in unconfigured state.
  * @param conf
  *   The pointer to the configuration data to be used for the Unikraft
- *   network device.
+ *   network device. If the device allocates queues in pairs
+ *   (`in_queue_pairs` of `struct uk_netdev_info`), the number of
+ *   receive and transmit queues must be equal.
  * @return
  *   - (0): Success, device is in configured state.
  *   - (<0): Error code returned by the driver.
@@ -435,6 +437,130 @@ static inline int uk_netdev_rxq_intr_disable(struct uk_netdev *dev,
 	return dev->ops->rxq_intr_disable(dev, dev->_rx_queue[queue_id]);
 }
 
+#ifdef CONFIG_LIBUKNETDEV_BUSYPOLL
+/**
+ * Sets the busy polling parameters of an RX queue that has an event
+ * callback. After a receive event, the dispatcher thread of the queue
+ * disables the queue interrupts and keeps calling the event callback until
+ * either `budget` consecutive calls did not receive any packet or no packet
+ * was received for `window` nanoseconds. Afterwards, the queue returns to
+ * interrupt mode. The defaults are taken from the configuration.
+ *
+ * @param dev
+ *   The Unikraft Network Device.
+ * @param queue_id
+ *   The index of the configured receive queue.
+ * @param budget
+ *   Maximum number of consecutive empty polls; 0 disables busy polling.
+ * @param window
+ *   Maximum idle time in poll mode in nanoseconds; 0 for no time limit.
+ * @return
+ *   - (0): Success
+ *   - (-EINVAL): The queue has no event callback.
+ */
+int uk_netdev_rxq_busypoll_set(struct uk_netdev *dev, uint16_t queue_id,
+			       uint32_t budget, __nsec window);
+
+/**
+ * Reads the busy polling counters of an RX queue. The counters are updated
+ * without synchronization, so the result is a snapshot.
+ *
+ * @param dev
+ *   The Unikraft Network Device.
+ * @param queue_id
+ *   The index of the configured receive queue.
+ * @param stats
+ *   Reference to the structure that is filled with the counters.
+ * @return
+ *   - (0): Success
+ */
+int uk_netdev_rxq_busypoll_stats_get(struct uk_netdev *dev, uint16_t queue_id,
+				     struct uk_netdev_rxq_busypoll_stats *stats);
+#endif /* CONFIG_LIBUKNETDEV_BUSYPOLL */
+
+#ifdef CONFIG_LIBUKNETDEV_STATS
+/**
+ * Reads the data path counters of an RX queue. The counters are updated
+ * without synchronization, so the result is a snapshot.
+ *
+ * @param dev
+ *   The Unikraft Network Device.
+ * @param queue_id
+ *   The index of the configured receive queue.
+ * @param stats
+ *   Reference to the structure that is filled with the counters.
+ * @return
+ *   - (0): Success
+ */
+int uk_netdev_rxq_stats_get(struct uk_netdev *dev, uint16_t queue_id,
+			    struct uk_netdev_queue_stats *stats);
+
+/**
+ * Reads the data path counters of a TX queue. The counters are updated
+ * without synchronization, so the result is a snapshot.
+ *
+ * @param dev
+ *   The Unikraft Network Device.
+ * @param queue_id
+ *   The index of the configured transmit queue.
+ * @param stats
+ *   Reference to the structure that is filled with the counters.
+ * @return
+ *   - (0): Success
+ */
+int uk_netdev_txq_stats_get(struct uk_netdev *dev, uint16_t queue_id,
+			    struct uk_netdev_queue_stats *stats);
+
+/**
+ * Resets the data path counters of all queues of a network device.
+ *
+ * @param dev
+ *   The Unikraft Network Device.
+ */
+void uk_netdev_stats_reset(struct uk_netdev *dev);
+
+/* Total length of a netbuf chain */
+static inline __u64 _uk_netdev_stats_pktlen(struct uk_netbuf *pkt)
+{
+	__u64 len = 0;
+
+	for (; pkt; pkt = pkt->next)
+		len += pkt->len;
+	return len;
+}
+
+static inline void _uk_netdev_stats_rx(struct uk_netdev_queue_stats *stats,
+				       struct uk_netbuf **pkts, uint16_t cnt,
+				       int status)
+{
+	uint16_t i;
+
+	if (unlikely(status < 0)) {
+		stats->errors++;
+		return;
+	}
+	if (unlikely(status & UK_NETDEV_STATUS_UNDERRUN))
+		stats->underruns++;
+	stats->pkts += cnt;
+	for (i = 0; i < cnt; ++i)
+		stats->bytes += _uk_netdev_stats_pktlen(pkts[i]);
+}
+
+static inline void _uk_netdev_stats_tx(struct uk_netdev_queue_stats *stats,
+				       uint16_t cnt, __u64 bytes, int status)
+{
+	if (unlikely(status < 0)) {
+		stats->errors++;
+		return;
+	}
+	if (!(status & UK_NETDEV_STATUS_MORE))
+		stats->full++;
+	stats->pkts += cnt;
+	if (cnt)
+		stats->bytes += bytes;
+}
+#endif /* CONFIG_LIBUKNETDEV_STATS */
+
 /**
  * Receive one packet and re-program used receive descriptors. In order to avoid
  * race conditions, queue interrupts have to be off while executing this
@@ -474,6 +600,8 @@ static inline int uk_netdev_rxq_intr_disable(struct uk_netdev *dev,
 static inline int uk_netdev_rx_one(struct uk_netdev *dev, uint16_t queue_id,
 				   struct uk_netbuf **pkt)
 {
+	int status;
+
 	UK_ASSERT(dev);
 	UK_ASSERT(dev->rx_one);
 	UK_ASSERT(queue_id < CONFIG_LIBUKNETDEV_MAXNBQUEUES);
@@ -481,7 +609,17 @@ static inline int uk_netdev_rx_one(struct uk_netdev *dev, uint16_t queue_id,
 	UK_ASSERT(!PTRISERR(dev->_rx_queue[queue_id]));
 	UK_ASSERT(pkt);
 
-	return dev->rx_one(dev, dev->_rx_queue[queue_id], pkt);
+	status = dev->rx_one(dev, dev->_rx_queue[queue_id], pkt);
+#ifdef CONFIG_LIBUKNETDEV_BUSYPOLL
+	if (status > 0 && (status & UK_NETDEV_STATUS_SUCCESS))
+		dev->_data->rxq_handler[queue_id].poll_stats.rx_pkts++;
+#endif
+#ifdef CONFIG_LIBUKNETDEV_STATS
+	_uk_netdev_stats_rx(&dev->_data->rxq_stats[queue_id], pkt,
+			    (status > 0 && (status & UK_NETDEV_STATUS_SUCCESS))
+			    ? 1 : 0, status);
+#endif
+	return status;
 }
 
 /**
@@ -513,6 +651,11 @@ static inline int uk_netdev_rx_one(struct uk_netdev *dev, uint16_t queue_id,
 static inline int uk_netdev_tx_one(struct uk_netdev *dev, uint16_t queue_id,
 				   struct uk_netbuf *pkt)
 {
+#ifdef CONFIG_LIBUKNETDEV_STATS
+	__u64 bytes;
+#endif
+	int status;
+
 	UK_ASSERT(dev);
 	UK_ASSERT(dev->tx_one);
 	UK_ASSERT(queue_id < CONFIG_LIBUKNETDEV_MAXNBQUEUES);
@@ -520,7 +663,139 @@ static inline int uk_netdev_tx_one(struct uk_netdev *dev, uint16_t queue_id,
 	UK_ASSERT(!PTRISERR(dev->_tx_queue[queue_id]));
 	UK_ASSERT(pkt);
 
-	return dev->tx_one(dev, dev->_tx_queue[queue_id], pkt);
+#ifdef CONFIG_LIBUKNETDEV_STATS
+	/* `pkt` may be free'd as soon as it is handed over to the driver */
+	bytes = _uk_netdev_stats_pktlen(pkt);
+#endif
+	status = dev->tx_one(dev, dev->_tx_queue[queue_id], pkt);
+#ifdef CONFIG_LIBUKNETDEV_STATS
+	_uk_netdev_stats_tx(&dev->_data->txq_stats[queue_id],
+			    (status > 0 && (status & UK_NETDEV_STATUS_SUCCESS))
+			    ? 1 : 0, bytes, status);
+#endif
+	return status;
+}
+
+/**
+ * Receive a burst of packets and re-program used receive descriptors once for
+ * the whole burst. The same rules regarding queue interrupts and the receive
+ * buffer allocator apply as for `uk_netdev_rx_one()`: Interrupts are enabled
+ * again as soon as the last packet was received from the queue.
+ *
+ * @param dev
+ *   The Unikraft Network Device.
+ * @param queue_id
+ *   The index of the receive queue to receive from.
+ *   The value must be in the range [0, nb_rx_queue - 1] previously supplied
+ *   to uk_netdev_configure().
+ * @param pkts
+ *   Array of netbuf pointers that will point to the received packets after
+ *   the function call. `pkts` has never to be `NULL`.
+ * @param cnt
+ *   On input, the number of entries available in `pkts`. On output, the
+ *   number of received packets that were stored to pkts[0]...pkts[*cnt - 1].
+ *   `cnt` has never to be `NULL` and `*cnt` has to be greater than zero.
+ * @return
+ *   - (>=0): Positive value with status flags
+ *     - UK_NETDEV_STATUS_SUCCESS: At least one packet was received.
+ *     - UK_NETDEV_STATUS_MORE: Indicates that more received packets are
+ *        available on the receive queue. When interrupts are used, they are
+ *        disabled until this flag is unset by a subsequent call.
+ *        This flag may only be set together with UK_NETDEV_STATUS_SUCCESS.
+ *     - UK_NETDEV_STATUS_UNDERRUN: Informs that some available slots of the
+ *        receive queue could not be programmed with a receive buffer.
+ *   - (<0): Negative value with error code from driver, no packet is returned.
+ */
+static inline int uk_netdev_rx_burst(struct uk_netdev *dev, uint16_t queue_id,
+				     struct uk_netbuf **pkts, uint16_t *cnt)
+{
+	int status;
+
+	UK_ASSERT(dev);
+	UK_ASSERT(dev->rx_burst);
+	UK_ASSERT(queue_id < CONFIG_LIBUKNETDEV_MAXNBQUEUES);
+	UK_ASSERT(dev->_data->state == UK_NETDEV_RUNNING);
+	UK_ASSERT(!PTRISERR(dev->_rx_queue[queue_id]));
+	UK_ASSERT(pkts);
+	UK_ASSERT(cnt && *cnt > 0);
+
+	status = dev->rx_burst(dev, dev->_rx_queue[queue_id], pkts, cnt);
+#ifdef CONFIG_LIBUKNETDEV_BUSYPOLL
+	if (status > 0)
+		dev->_data->rxq_handler[queue_id].poll_stats.rx_pkts += *cnt;
+#endif
+#ifdef CONFIG_LIBUKNETDEV_STATS
+	_uk_netdev_stats_rx(&dev->_data->rxq_stats[queue_id], pkts,
+			    status > 0 ? *cnt : 0, status);
+#endif
+	return status;
+}
+
+/**
+ * Transmit a burst of packets. Drivers that implement this natively notify
+ * the device only once for the whole burst.
+ *
+ * @param dev
+ *   The Unikraft Network Device.
+ * @param queue_id
+ *   The index of the transmit queue to send to.
+ *   The value must be in the range [0, nb_tx_queue - 1] previously supplied
+ *   to uk_netdev_configure().
+ * @param pkts
+ *   Array of netbufs to send. Packets are free'd by the driver after sending
+ *   was successfully finished by the device. The same headroom requirements
+ *   apply as for `uk_netdev_tx_one()`. `pkts` has never to be `NULL`.
+ * @param cnt
+ *   On input, the number of packets in `pkts`. On output, the number of
+ *   packets that were put to the transmit queue. Those are always the
+ *   packets pkts[0]...pkts[*cnt - 1]; the ownership of the remaining ones
+ *   stays with the caller. `cnt` has never to be `NULL` and `*cnt` has to be
+ *   greater than zero.
+ * @return
+ *   - (>=0): Positive value with status flags
+ *     - UK_NETDEV_STATUS_SUCCESS: At least one packet was put to the transmit
+ *        queue.
+ *     - UK_NETDEV_STATUS_MORE: Indicates there is still at least one
+ *        descriptor available for a subsequent transmission.
+ *        This flag may only be set together with UK_NETDEV_STATUS_SUCCESS.
+ *   - (<0): Negative value with error code from driver, no packet was sent.
+ */
+static inline int uk_netdev_tx_burst(struct uk_netdev *dev, uint16_t queue_id,
+				     struct uk_netbuf **pkts, uint16_t *cnt)
+{
+#ifdef CONFIG_LIBUKNETDEV_STATS
+	uint16_t i, n;
+	__u64 bytes;
+#endif
+	int status;
+
+	UK_ASSERT(dev);
+	UK_ASSERT(dev->tx_burst);
+	UK_ASSERT(queue_id < CONFIG_LIBUKNETDEV_MAXNBQUEUES);
+	UK_ASSERT(dev->_data->state == UK_NETDEV_RUNNING);
+	UK_ASSERT(!PTRISERR(dev->_tx_queue[queue_id]));
+	UK_ASSERT(pkts);
+	UK_ASSERT(cnt && *cnt > 0);
+
+#ifdef CONFIG_LIBUKNETDEV_STATS
+	/* Sent packets may be free'd as soon as they are handed over to the
+	 * driver, so the bytes of the unsent ones are subtracted afterwards
+	 */
+	bytes = 0;
+	n = *cnt;
+	for (i = 0; i < n; ++i)
+		bytes += _uk_netdev_stats_pktlen(pkts[i]);
+#endif
+	status = dev->tx_burst(dev, dev->_tx_queue[queue_id], pkts, cnt);
+#ifdef CONFIG_LIBUKNETDEV_STATS
+	if (status >= 0) {
+		for (i = *cnt; i < n; ++i)
+			bytes -= _uk_netdev_stats_pktlen(pkts[i]);
+	}
+	_uk_netdev_stats_tx(&dev->_data->txq_stats[queue_id],
+			    status > 0 ? *cnt : 0, bytes, status);
+#endif
+	return status;
 }
 
 /**
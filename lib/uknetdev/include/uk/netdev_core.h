@@ -47,6 +47,12 @@
 #include <uk/sched.h>
 #include <uk/semaphore.h>
 #endif
+#ifdef CONFIG_LIBUKNETDEV_BUSYPOLL
+#include <uk/arch/time.h>
+#endif
+#ifdef CONFIG_LIBUKNETDEV_STATS
+#include <uk/arch/lcpu.h>
+#endif
 
 /**
  * Unikraft network API common declarations.
@@ -138,12 +144,28 @@ struct uk_hwaddr {
 #define UK_NETDEV_F_PARTIAL_CSUM_BIT	2
 #define UK_NETDEV_F_PARTIAL_CSUM	(1UL << UK_NETDEV_F_PARTIAL_CSUM_BIT)
 
+/* Indicates that the device segments transmitted netbufs that are marked
+ * with a TCP segmentation offload type (`gso_type`, see netbuf.h)
+ */
+#define UK_NETDEV_F_TSO_BIT		3
+#define UK_NETDEV_F_TSO			(1UL << UK_NETDEV_F_TSO_BIT)
+
+/* Indicates that the device may hand over coalesced TCP segments on receive,
+ * marked with a segmentation offload type (`gso_type`, see netbuf.h)
+ */
+#define UK_NETDEV_F_GRO_BIT		4
+#define UK_NETDEV_F_GRO			(1UL << UK_NETDEV_F_GRO_BIT)
+
 #define uk_netdev_rxintr_supported(feature)	\
 	(feature & (UK_NETDEV_F_RXQ_INTR))
 #define uk_netdev_txintr_supported(feature)	\
 	(feature & (UK_NETDEV_F_TXQ_INTR))
 #define uk_netdev_partial_csum_supported(feature)	\
 	(feature & (UK_NETDEV_F_PARTIAL_CSUM))
+#define uk_netdev_tso_supported(feature)	\
+	(feature & (UK_NETDEV_F_TSO))
+#define uk_netdev_gro_supported(feature)	\
+	(feature & (UK_NETDEV_F_GRO))
 
 /**
  * A structure used to describe network device capabilities.
@@ -156,6 +178,7 @@ struct uk_netdev_info {
 	uint16_t nb_encap_tx;  /**< Number of bytes required as headroom for tx. */
 	uint16_t nb_encap_rx;  /**< Number of bytes required as headroom for rx. */
 	uint16_t ioalign;  /**< Alignment in bytes for packet data buffers */
+	uint32_t max_gso_len; /**< Maximum length of a super-packet (TSO) */
 	uint32_t features; /**< bitmap of the features supported */
 };
 
@@ -279,7 +302,11 @@ struct uk_netdev_rxqueue_conf {
 	uk_netdev_alloc_rxpkts alloc_rxpkts; /**< Allocator for rx netbufs */
 	void *alloc_rxpkts_argp;             /**< Argument for alloc_rxpkts */
 #ifdef CONFIG_LIBUKNETDEV_DISPATCHERTHREADS
-	struct uk_sched *s;               /**< Scheduler for dispatcher. */
+	/** Scheduler for dispatcher. Each queue has its own dispatcher
+	 *   thread, so handing out different schedulers per queue spreads
+	 *   the receive processing of a multiqueue device.
+	 */
+	struct uk_sched *s;
 #endif
 };
 
@@ -385,6 +412,26 @@ typedef int (*uk_netdev_tx_one_t)(struct uk_netdev *dev,
 				  struct uk_netdev_tx_queue *queue,
 				  struct uk_netbuf *pkt);
 
+/**
+ * Driver callback type to retrieve multiple packets from a RX queue.
+ * On entry `*cnt` holds the capacity of `pkts`, on return the number of
+ * packets that were received.
+ */
+typedef int (*uk_netdev_rx_burst_t)(struct uk_netdev *dev,
+				    struct uk_netdev_rx_queue *queue,
+				    struct uk_netbuf **pkts,
+				    uint16_t *cnt);
+
+/**
+ * Driver callback type to submit multiple packets to a TX queue.
+ * On entry `*cnt` holds the number of packets in `pkts`, on return the
+ * number of packets that were put to the queue.
+ */
+typedef int (*uk_netdev_tx_burst_t)(struct uk_netdev *dev,
+				    struct uk_netdev_tx_queue *queue,
+				    struct uk_netbuf **pkts,
+				    uint16_t *cnt);
+
 /**
  * A structure containing the functions exported by a driver.
  */
@@ -419,6 +466,34 @@ struct uk_netdev_ops {
 	uk_netdev_start_t               start;
 };
 
+#ifdef CONFIG_LIBUKNETDEV_STATS
+/**
+ * Data path counters of a receive or transmit queue
+ * (see: `uk_netdev_rxq_stats_get()`, `uk_netdev_txq_stats_get()`).
+ * Each queue has its counters on separate cache lines.
+ */
+struct uk_netdev_queue_stats {
+	__u64 pkts;      /**< Packets received or transmitted */
+	__u64 bytes;     /**< Bytes received or transmitted */
+	__u64 errors;    /**< Calls that returned an error */
+	__u64 underruns; /**< RX: Calls that could not refill all slots */
+	__u64 full;      /**< TX: Calls that left the queue full */
+} __align(CACHE_LINE_SIZE);
+#endif /* CONFIG_LIBUKNETDEV_STATS */
+
+#ifdef CONFIG_LIBUKNETDEV_BUSYPOLL
+/**
+ * Busy polling counters of a receive queue
+ * (see: `uk_netdev_rxq_busypoll_stats_get()`)
+ */
+struct uk_netdev_rxq_busypoll_stats {
+	__u64 irqs;        /**< Receive events signaled by the driver */
+	__u64 polls;       /**< Event callback calls in poll mode */
+	__u64 empty_polls; /**< Polls during which no packet was received */
+	__u64 rx_pkts;     /**< Packets received from the queue */
+};
+#endif /* CONFIG_LIBUKNETDEV_BUSYPOLL */
+
 /**
  * @internal
  * Event handler configuration (internal to libuknetdev)
@@ -435,6 +510,11 @@ struct uk_netdev_event_handler {
 	char                *dispatcher_name; /**< reference to thread name */
 	struct uk_sched     *dispatcher_s;    /**< Scheduler for dispatcher. */
 #endif
+#ifdef CONFIG_LIBUKNETDEV_BUSYPOLL
+	uint32_t            poll_budget; /**< max. consecutive empty polls */
+	__nsec              poll_window; /**< max. idle time in poll mode */
+	struct uk_netdev_rxq_busypoll_stats poll_stats;
+#endif
 };
 
 /**
@@ -446,9 +526,23 @@ struct uk_netdev_data {
 
 	struct uk_netdev_event_handler
 			     rxq_handler[CONFIG_LIBUKNETDEV_MAXNBQUEUES];
+#ifdef CONFIG_LIBUKNETDEV_STATS
+	struct uk_netdev_queue_stats
+			     rxq_stats[CONFIG_LIBUKNETDEV_MAXNBQUEUES];
+	struct uk_netdev_queue_stats
+			     txq_stats[CONFIG_LIBUKNETDEV_MAXNBQUEUES];
+#endif
 
 	const uint16_t       id;    /**< ID is assigned during registration */
 	const char           *drv_name;
+
+#ifdef CONFIG_LIBUKNETDEV_SWCSUM
+	/** Transmit functions of the driver if checksums are completed in
+	 *  software before calling them
+	 */
+	uk_netdev_tx_one_t   drv_tx_one;
+	uk_netdev_tx_burst_t drv_tx_burst;
+#endif /* CONFIG_LIBUKNETDEV_SWCSUM */
 };
 
 struct uk_netdev_einfo {
@@ -465,6 +559,9 @@ struct uk_netdev_einfo {
  * registering the netdev. They change during device life time. Packet RX/TX
  * functions are added directly to this structure for performance reasons.
  * It prevents another indirection to ops.
+ * The burst callbacks (tx_burst, rx_burst) are optional for drivers. When a
+ * driver does not provide them, libuknetdev installs a generic implementation
+ * on registration that loops over tx_one and rx_one.
  */
 struct uk_netdev {
 	/** Packet transmission. */
@@ -473,6 +570,12 @@ struct uk_netdev {
 	/** Packet reception. */
 	uk_netdev_rx_one_t          rx_one; /* by driver */
 
+	/** Burst packet transmission. */
+	uk_netdev_tx_burst_t        tx_burst; /* by driver, optional */
+
+	/** Burst packet reception. */
+	uk_netdev_rx_burst_t        rx_burst; /* by driver, optional */
+
 	/** Pointer to API-internal state data. */
 	struct uk_netdev_data       *_data;
 
@@ -86,6 +86,9 @@ static inline void uk_netdev_drv_rx_event(struct uk_netdev *dev,
 	rxq_handler = &dev->_data->rxq_handler[queue_id];
 
 #ifdef CONFIG_LIBUKNETDEV_DISPATCHERTHREADS
+#ifdef CONFIG_LIBUKNETDEV_BUSYPOLL
+	rxq_handler->poll_stats.irqs++;
+#endif
 	uk_semaphore_up(&rxq_handler->events);
 #else
 	if (rxq_handler->callback)
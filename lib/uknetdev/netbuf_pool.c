@@ -0,0 +1,303 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2023, Unikraft GmbH and The Unikraft Authors.
+ * Licensed under the BSD-3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ */
+
+/*
+ * Netbuf pools
+ *
+ * Each pool object is one netbuf allocation in the layout that
+ * uk_netbuf_prepare_buf() uses: the buffer area comes first (so that the
+ * object alignment is forwarded to `m->buf`), followed by the netbuf, a
+ * back reference to the pool, and the private data area:
+ *
+ *          +-------------------------+ <- object, m->buf
+ *          |    buffer (buflen)      |
+ *          +-------------------------+ <- m
+ *          | struct netbuf_pool_meta |
+ *          +-------------------------+ <- m->priv
+ *          |     priv (privlen)      |
+ *          +-------------------------+
+ *
+ * Free objects are kept in a ukallocpool that is protected by a spinlock.
+ * Every logical CPU additionally caches up to
+ * CONFIG_LIBUKNETDEV_NETBUF_POOL_CACHE free objects, so that netbufs that
+ * are taken and freed on the same CPU do not touch the shared pool, and the
+ * shared pool is only accessed with batches of half a cache.
+ */
+
+#include <string.h>
+#include <uk/netbuf.h>
+#include <uk/allocpool.h>
+#include <uk/plat/spinlock.h>
+#include <uk/plat/lcpu.h>
+#include <uk/essentials.h>
+#include <uk/print.h>
+
+#define NETBUF_POOL_META_ALIGN	(sizeof(long long))
+
+#define NETBUF_POOL_CACHE_SIZE	CONFIG_LIBUKNETDEV_NETBUF_POOL_CACHE
+#define NETBUF_POOL_CACHE_BATCH	((NETBUF_POOL_CACHE_SIZE + 1) / 2)
+
+struct netbuf_pool_meta {
+	struct uk_netbuf nb;
+	struct uk_netbuf_pool *pool;
+};
+
+#if NETBUF_POOL_CACHE_SIZE > 0
+struct netbuf_pool_cache {
+	unsigned int count;
+	void *objs[NETBUF_POOL_CACHE_SIZE];
+};
+#endif /* NETBUF_POOL_CACHE_SIZE > 0 */
+
+struct uk_netbuf_pool {
+	struct uk_allocpool *ap;
+	__spinlock lock;	/* Protects `ap` */
+
+	size_t meta_off;	/* Offset of struct netbuf_pool_meta */
+	size_t buflen;
+	uint16_t headroom;
+	size_t privlen;
+	uk_netbuf_dtor_t dtor;
+
+#if NETBUF_POOL_CACHE_SIZE > 0
+	UKPLAT_PER_LCPU_DEFINE(struct netbuf_pool_cache, caches);
+#endif /* NETBUF_POOL_CACHE_SIZE > 0 */
+};
+
+static void netbuf_pool_dtor(struct uk_netbuf *m);
+
+static inline struct uk_netbuf *netbuf_pool_obj2nb(struct uk_netbuf_pool *p,
+						   void *obj)
+{
+	return &((struct netbuf_pool_meta *)((__uptr) obj
+					     + p->meta_off))->nb;
+}
+
+/* Resets the netbuf of a free object to the state after allocation */
+static inline struct uk_netbuf *netbuf_pool_init_obj(struct uk_netbuf_pool *p,
+						     void *obj)
+{
+	struct netbuf_pool_meta *meta;
+
+	meta = __containerof(netbuf_pool_obj2nb(p, obj),
+			     struct netbuf_pool_meta, nb);
+	uk_netbuf_init_indir(&meta->nb, obj, p->buflen, p->headroom,
+			     p->privlen ? (void *)(meta + 1) : NULL,
+			     netbuf_pool_dtor);
+	/* The memory is owned by the pool, uk_netbuf_free_single() must not
+	 * release it to an allocator
+	 */
+	meta->nb._a = NULL;
+	meta->nb._b = NULL;
+	meta->pool = p;
+	return &meta->nb;
+}
+
+static unsigned int netbuf_pool_get(struct uk_netbuf_pool *p, void *objs[],
+				    unsigned int count)
+{
+	unsigned long flags;
+	unsigned int n = 0;
+#if NETBUF_POOL_CACHE_SIZE > 0
+	struct netbuf_pool_cache *c;
+	unsigned int take;
+
+	flags = ukplat_lcpu_save_irqf();
+	c = &ukplat_per_lcpu_current(p->caches);
+	while (n < count) {
+		if (!c->count) {
+			ukarch_spin_lock(&p->lock);
+			if (count - n >= NETBUF_POOL_CACHE_BATCH) {
+				/* Large requests bypass the cache */
+				n += uk_allocpool_take_batch(p->ap, &objs[n],
+							     count - n);
+				ukarch_spin_unlock(&p->lock);
+				break;
+			}
+			c->count = uk_allocpool_take_batch(p->ap, c->objs,
+						NETBUF_POOL_CACHE_BATCH);
+			ukarch_spin_unlock(&p->lock);
+			if (unlikely(!c->count))
+				break;
+		}
+
+		take = MIN(c->count, count - n);
+		c->count -= take;
+		memcpy(&objs[n], &c->objs[c->count], take * sizeof(void *));
+		n += take;
+	}
+	ukplat_lcpu_restore_irqf(flags);
+#else /* NETBUF_POOL_CACHE_SIZE == 0 */
+	ukplat_spin_lock_irqsave(&p->lock, flags);
+	n = uk_allocpool_take_batch(p->ap, objs, count);
+	ukplat_spin_unlock_irqrestore(&p->lock, flags);
+#endif /* NETBUF_POOL_CACHE_SIZE == 0 */
+	return n;
+}
+
+static void netbuf_pool_put(struct uk_netbuf_pool *p, void *objs[],
+			    unsigned int count)
+{
+	unsigned long flags;
+#if NETBUF_POOL_CACHE_SIZE > 0
+	struct netbuf_pool_cache *c;
+	unsigned int put;
+
+	flags = ukplat_lcpu_save_irqf();
+	c = &ukplat_per_lcpu_current(p->caches);
+	while (count > 0) {
+		if (c->count == NETBUF_POOL_CACHE_SIZE) {
+			/* Flush the older half of the cache */
+			ukarch_spin_lock(&p->lock);
+			uk_allocpool_return_batch(p->ap, c->objs,
+						  NETBUF_POOL_CACHE_BATCH);
+			ukarch_spin_unlock(&p->lock);
+			c->count -= NETBUF_POOL_CACHE_BATCH;
+			memmove(&c->objs[0], &c->objs[NETBUF_POOL_CACHE_BATCH],
+				c->count * sizeof(void *));
+		}
+
+		put = MIN(NETBUF_POOL_CACHE_SIZE - c->count, count);
+		memcpy(&c->objs[c->count], objs, put * sizeof(void *));
+		c->count += put;
+		objs += put;
+		count -= put;
+	}
+	ukplat_lcpu_restore_irqf(flags);
+#else /* NETBUF_POOL_CACHE_SIZE == 0 */
+	ukplat_spin_lock_irqsave(&p->lock, flags);
+	uk_allocpool_return_batch(p->ap, objs, count);
+	ukplat_spin_unlock_irqrestore(&p->lock, flags);
+#endif /* NETBUF_POOL_CACHE_SIZE == 0 */
+}
+
+static void netbuf_pool_dtor(struct uk_netbuf *m)
+{
+	struct netbuf_pool_meta *meta;
+	struct uk_netbuf_pool *p;
+	void *obj;
+
+	meta = __containerof(m, struct netbuf_pool_meta, nb);
+	p = meta->pool;
+	UK_ASSERT(p);
+
+	if (p->dtor)
+		p->dtor(m);
+
+	obj = (void *)((__uptr) meta - p->meta_off);
+	netbuf_pool_put(p, &obj, 1);
+}
+
+struct uk_netbuf_pool *uk_netbuf_pool_create(struct uk_alloc *a,
+					     unsigned int count,
+					     size_t buflen, size_t bufalign,
+					     uint16_t headroom, size_t privlen,
+					     uk_netbuf_dtor_t dtor)
+{
+	struct uk_netbuf_pool *p;
+	size_t obj_len;
+
+	UK_ASSERT(a);
+	UK_ASSERT(buflen > 0);
+	UK_ASSERT(headroom <= buflen);
+	UK_ASSERT(!bufalign || POWER_OF_2(bufalign));
+
+	p = uk_calloc(a, 1, sizeof(*p));
+	if (!p)
+		return NULL;
+
+	p->meta_off = ALIGN_UP(buflen, NETBUF_POOL_META_ALIGN);
+	p->buflen   = p->meta_off;
+	p->headroom = headroom;
+	p->privlen  = privlen;
+	p->dtor     = dtor;
+	ukarch_spin_init(&p->lock);
+
+	obj_len = p->meta_off
+		  + ALIGN_UP(sizeof(struct netbuf_pool_meta) + privlen,
+			     NETBUF_POOL_META_ALIGN);
+	p->ap = uk_allocpool_alloc(a, count, obj_len,
+				   MAX(bufalign, NETBUF_POOL_META_ALIGN));
+	if (!p->ap) {
+		uk_free(a, p);
+		return NULL;
+	}
+
+	uk_pr_debug("%p: Netbuf pool created: %u netbufs of %"__PRIsz" B\n",
+		    p, count, obj_len);
+	return p;
+}
+
+unsigned int uk_netbuf_pool_take_batch(struct uk_netbuf_pool *p,
+				       struct uk_netbuf *m[],
+				       unsigned int count)
+{
+	unsigned int n, i;
+
+	UK_ASSERT(p);
+	UK_ASSERT(m);
+
+	/* Objects are collected in `m` and converted in place */
+	n = netbuf_pool_get(p, (void **) m, count);
+	for (i = 0; i < n; ++i)
+		m[i] = netbuf_pool_init_obj(p, (void *) m[i]);
+	return n;
+}
+
+void uk_netbuf_pool_return_batch(struct uk_netbuf_pool *p,
+				 struct uk_netbuf *m[], unsigned int count)
+{
+	struct netbuf_pool_meta *meta;
+	unsigned int i;
+
+	UK_ASSERT(p);
+	UK_ASSERT(m);
+
+	/* Objects are converted in place */
+	for (i = 0; i < count; ++i) {
+		meta = __containerof(m[i], struct netbuf_pool_meta, nb);
+		UK_ASSERT(meta->pool == p);
+		UK_ASSERT(!m[i]->next && !m[i]->prev);
+		UK_ASSERT(uk_netbuf_refcount_single_get(m[i]) == 1);
+
+		m[i] = (struct uk_netbuf *)((__uptr) meta - p->meta_off);
+	}
+	netbuf_pool_put(p, (void **) m, count);
+}
+
+unsigned int uk_netbuf_pool_availcount(struct uk_netbuf_pool *p)
+{
+	unsigned long flags;
+	unsigned int count;
+#if NETBUF_POOL_CACHE_SIZE > 0
+	unsigned int i;
+#endif /* NETBUF_POOL_CACHE_SIZE > 0 */
+
+	UK_ASSERT(p);
+
+	ukplat_spin_lock_irqsave(&p->lock, flags);
+	count = uk_allocpool_availcount(p->ap);
+	ukplat_spin_unlock_irqrestore(&p->lock, flags);
+
+#if NETBUF_POOL_CACHE_SIZE > 0
+	/* Racy snapshot of the caches of other CPUs */
+	for (i = 0; i < ukplat_lcpu_count(); ++i)
+		count += ukplat_per_lcpu(p->caches, i).count;
+#endif /* NETBUF_POOL_CACHE_SIZE > 0 */
+	return count;
+}
+
+uint16_t uk_netbuf_pool_alloc_rxpkts(void *argp, struct uk_netbuf *pkts[],
+				     uint16_t count)
+{
+	struct uk_netbuf_pool *p = (struct uk_netbuf_pool *) argp;
+	unsigned int n, i;
+
+	n = uk_netbuf_pool_take_batch(p, pkts, count);
+	for (i = 0; i < n; ++i)
+		pkts[i]->len = uk_netbuf_tailroom(pkts[i]);
+	return (uint16_t) n;
+}
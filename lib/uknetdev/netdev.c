@@ -38,6 +38,12 @@
 #include <uk/netdev.h>
 #include <uk/print.h>
 #include <uk/libparam.h>
+#ifdef CONFIG_LIBUKNETDEV_BUSYPOLL
+#include <uk/plat/time.h>
+#endif
+#ifdef CONFIG_LIBUKNETDEV_SWCSUM
+#include <uk/csum.h>
+#endif
 
 struct uk_netdev_list uk_netdev_list =
 	UK_TAILQ_HEAD_INITIALIZER(uk_netdev_list);
@@ -100,9 +106,17 @@ static struct uk_netdev_data *_alloc_data(struct uk_alloc *a,
 {
 	struct uk_netdev_data *data;
 
+#ifdef CONFIG_LIBUKNETDEV_STATS
+	/* Keep the per-queue counters on their own cache lines */
+	data = uk_memalign(a, __alignof__(*data), sizeof(*data));
+	if (!data)
+		return NULL;
+	memset(data, 0, sizeof(*data));
+#else
 	data = uk_calloc(a, 1, sizeof(*data));
 	if (!data)
 		return NULL;
+#endif
 
 	data->drv_name = drv_name;
 	data->state    = UK_NETDEV_UNPROBED;
@@ -132,6 +146,143 @@ static struct uk_netdev_einfo *_alloc_einfo(struct uk_alloc *a)
 	return _einfo;
 }
 
+/*
+ * Generic burst implementations for drivers that provide only rx_one/tx_one.
+ * A failing operation in the middle of a burst terminates the burst without
+ * reporting the error so that the packets handled so far are not lost; the
+ * error is reported by the next call.
+ */
+static int _rx_burst_generic(struct uk_netdev *dev,
+			     struct uk_netdev_rx_queue *queue,
+			     struct uk_netbuf **pkts, uint16_t *cnt)
+{
+	uint16_t i = 0;
+	int status = 0x0;
+	int more = 0x0;
+	int rc;
+
+	while (i < *cnt) {
+		rc = dev->rx_one(dev, queue, &pkts[i]);
+		if (unlikely(rc < 0)) {
+			if (i == 0) {
+				*cnt = 0;
+				return rc;
+			}
+			break;
+		}
+		status |= (rc & UK_NETDEV_STATUS_UNDERRUN);
+		if (!(rc & UK_NETDEV_STATUS_SUCCESS)) {
+			/* Queue is empty, interrupts may be enabled again */
+			more = 0x0;
+			break;
+		}
+		i++;
+		more = (rc & UK_NETDEV_STATUS_MORE);
+		if (!more)
+			break;
+	}
+
+	if (i > 0)
+		status |= UK_NETDEV_STATUS_SUCCESS | more;
+	*cnt = i;
+	return status;
+}
+
+static int _tx_burst_generic(struct uk_netdev *dev,
+			     struct uk_netdev_tx_queue *queue,
+			     struct uk_netbuf **pkts, uint16_t *cnt)
+{
+	uint16_t i = 0;
+	int more = 0x0;
+	int rc;
+
+	while (i < *cnt) {
+		rc = dev->tx_one(dev, queue, pkts[i]);
+		if (unlikely(rc < 0)) {
+			if (i == 0) {
+				*cnt = 0;
+				return rc;
+			}
+			break;
+		}
+		if (!(rc & UK_NETDEV_STATUS_SUCCESS)) {
+			/* Transmit queue is full */
+			more = 0x0;
+			break;
+		}
+		i++;
+		more = (rc & UK_NETDEV_STATUS_MORE);
+		if (!more)
+			break;
+	}
+
+	*cnt = i;
+	return (i > 0) ? (UK_NETDEV_STATUS_SUCCESS | more) : 0x0;
+}
+
+#ifdef CONFIG_LIBUKNETDEV_SWCSUM
+/*
+ * Transmit functions for devices without checksum offload: partial
+ * checksums are completed before the packets are handed over to the driver.
+ * Packets that the driver does not accept keep their completed checksum.
+ */
+static int _tx_one_swcsum(struct uk_netdev *dev,
+			  struct uk_netdev_tx_queue *queue,
+			  struct uk_netbuf *pkt)
+{
+	int rc;
+
+	if (pkt->flags & UK_NETBUF_F_PARTIAL_CSUM) {
+		rc = uk_csum_netbuf_complete(pkt);
+		if (unlikely(rc < 0))
+			return rc;
+	}
+	return dev->_data->drv_tx_one(dev, queue, pkt);
+}
+
+static int _tx_burst_swcsum(struct uk_netdev *dev,
+			    struct uk_netdev_tx_queue *queue,
+			    struct uk_netbuf **pkts, uint16_t *cnt)
+{
+	uint16_t i;
+	int rc;
+
+	for (i = 0; i < *cnt; ++i) {
+		if (!(pkts[i]->flags & UK_NETBUF_F_PARTIAL_CSUM))
+			continue;
+
+		rc = uk_csum_netbuf_complete(pkts[i]);
+		if (unlikely(rc < 0)) {
+			if (i == 0) {
+				*cnt = 0;
+				return rc;
+			}
+			/* Send the packets before the broken one */
+			*cnt = i;
+			break;
+		}
+	}
+	return dev->_data->drv_tx_burst(dev, queue, pkts, cnt);
+}
+
+static void _swcsum_setup(struct uk_netdev *dev)
+{
+	struct uk_netdev_info drv_info;
+
+	memset(&drv_info, 0, sizeof(drv_info));
+	dev->ops->info_get(dev, &drv_info);
+	if (drv_info.features & UK_NETDEV_F_PARTIAL_CSUM)
+		return;
+
+	dev->_data->drv_tx_one = dev->tx_one;
+	dev->_data->drv_tx_burst = dev->tx_burst;
+	dev->tx_one = _tx_one_swcsum;
+	dev->tx_burst = _tx_burst_swcsum;
+	uk_pr_info("netdev%"PRIu16": Checksums are completed in software\n",
+		   dev->_data->id);
+}
+#endif /* CONFIG_LIBUKNETDEV_SWCSUM */
+
 int uk_netdev_drv_register(struct uk_netdev *dev, struct uk_alloc *a,
 			   const char *drv_name)
 {
@@ -155,6 +306,12 @@ int uk_netdev_drv_register(struct uk_netdev *dev, struct uk_alloc *a,
 	UK_ASSERT(dev->rx_one);
 	UK_ASSERT(dev->tx_one);
 
+	/* Fall back to generic burst functions if the driver has none */
+	if (!dev->rx_burst)
+		dev->rx_burst = _rx_burst_generic;
+	if (!dev->tx_burst)
+		dev->tx_burst = _tx_burst_generic;
+
 	dev->_data = _alloc_data(a, netdev_count,  drv_name);
 	if (!dev->_data)
 		return -ENOMEM;
@@ -252,6 +409,10 @@ void uk_netdev_info_get(struct uk_netdev *dev,
 				      dev_info->max_rx_queues);
 	dev_info->max_tx_queues = MIN(CONFIG_LIBUKNETDEV_MAXNBQUEUES,
 				      dev_info->max_tx_queues);
+#ifdef CONFIG_LIBUKNETDEV_SWCSUM
+	/* Checksums that the device cannot compute are done in software */
+	dev_info->features |= UK_NETDEV_F_PARTIAL_CSUM;
+#endif
 }
 
 static const void *_netdev_einfo_get(struct uk_netdev *dev,
@@ -338,11 +499,17 @@ int uk_netdev_configure(struct uk_netdev *dev,
 		return -EINVAL;
 	if (dev_conf->nb_tx_queues > dev_info.max_tx_queues)
 		return -EINVAL;
+	if (dev_info.in_queue_pairs
+	    && dev_conf->nb_rx_queues != dev_conf->nb_tx_queues)
+		return -EINVAL;
 
 	ret = dev->ops->configure(dev, dev_conf);
 	if (ret >= 0) {
 		uk_pr_info("netdev%"PRIu16": Configured interface\n",
 			   dev->_data->id);
+#ifdef CONFIG_LIBUKNETDEV_SWCSUM
+		_swcsum_setup(dev);
+#endif
 		dev->_data->state = UK_NETDEV_CONFIGURED;
 	} else {
 		uk_pr_err("netdev%"PRIu16": Failed to configure interface: %d\n",
@@ -352,6 +519,58 @@ int uk_netdev_configure(struct uk_netdev *dev,
 }
 
 #ifdef CONFIG_LIBUKNETDEV_DISPATCHERTHREADS
+#ifdef CONFIG_LIBUKNETDEV_BUSYPOLL
+/* Calls the event callback with queue interrupts disabled until the queue
+ * becomes idle. Returns with interrupts enabled again.
+ */
+static void _dispatcher_busypoll(struct uk_netdev_event_handler *handler)
+{
+	struct uk_netdev_rxq_busypoll_stats *stats = &handler->poll_stats;
+	__u64 rx_pkts = stats->rx_pkts;
+	uint32_t empty = 0;
+	__nsec idle_since = 0;
+	int rc;
+
+	for (;;) {
+		handler->callback(handler->dev,
+				  handler->queue_id,
+				  handler->cookie);
+		stats->polls++;
+
+		if (stats->rx_pkts != rx_pkts) {
+			rx_pkts = stats->rx_pkts;
+			empty = 0;
+			idle_since = 0;
+		} else {
+			stats->empty_polls++;
+			if (!idle_since)
+				idle_since = ukplat_monotonic_clock();
+
+			if (++empty >= handler->poll_budget ||
+			    (handler->poll_window &&
+			     ukplat_monotonic_clock() - idle_since
+			     >= handler->poll_window)) {
+				rc = uk_netdev_rxq_intr_enable(handler->dev,
+							       handler->queue_id);
+				if (rc != 1)
+					return;
+
+				/* Packets arrived in the meantime: stay in
+				 * poll mode
+				 */
+				uk_netdev_rxq_intr_disable(handler->dev,
+							   handler->queue_id);
+				empty = 0;
+				idle_since = 0;
+			}
+		}
+
+		/* Let other threads run between the polls */
+		uk_sched_yield();
+	}
+}
+#endif /* CONFIG_LIBUKNETDEV_BUSYPOLL */
+
 static __noreturn void _dispatcher(void *arg)
 {
 	struct uk_netdev_event_handler *handler =
@@ -362,6 +581,17 @@ static __noreturn void _dispatcher(void *arg)
 
 	for (;;) {
 		uk_semaphore_down(&handler->events);
+#ifdef CONFIG_LIBUKNETDEV_BUSYPOLL
+		/* Switch to poll mode if the driver can turn off interrupts,
+		 * so that the callback does not enable them again
+		 */
+		if (handler->poll_budget &&
+		    uk_netdev_rxq_intr_disable(handler->dev,
+					       handler->queue_id) == 0) {
+			_dispatcher_busypoll(handler);
+			continue;
+		}
+#endif /* CONFIG_LIBUKNETDEV_BUSYPOLL */
 		handler->callback(handler->dev,
 				  handler->queue_id,
 				  handler->cookie);
@@ -395,6 +625,12 @@ static int _create_event_handler(uk_netdev_queue_event_t callback,
 	h->dev = dev;
 	h->queue_id = queue_id;
 	uk_semaphore_init(&h->events, 0);
+#ifdef CONFIG_LIBUKNETDEV_BUSYPOLL
+	h->poll_budget = CONFIG_LIBUKNETDEV_BUSYPOLL_BUDGET;
+	h->poll_window = ukarch_time_usec_to_nsec(
+				CONFIG_LIBUKNETDEV_BUSYPOLL_WINDOW);
+	memset(&h->poll_stats, 0, sizeof(h->poll_stats));
+#endif
 	h->dispatcher_s = s;
 
 	/* Create a name for the dispatcher thread.
@@ -489,6 +725,43 @@ err_out:
 	return err;
 }
 
+#ifdef CONFIG_LIBUKNETDEV_BUSYPOLL
+int uk_netdev_rxq_busypoll_set(struct uk_netdev *dev, uint16_t queue_id,
+			       uint32_t budget, __nsec window)
+{
+	struct uk_netdev_event_handler *h;
+
+	UK_ASSERT(dev);
+	UK_ASSERT(dev->_data);
+	UK_ASSERT(queue_id < CONFIG_LIBUKNETDEV_MAXNBQUEUES);
+	UK_ASSERT(!PTRISERR(dev->_rx_queue[queue_id]));
+
+	h = &dev->_data->rxq_handler[queue_id];
+	if (!h->dispatcher)
+		return -EINVAL;
+
+	h->poll_budget = budget;
+	h->poll_window = window;
+	uk_pr_debug("netdev%"PRIu16": rxq %"PRIu16": busy poll budget %"PRIu32
+		    ", window %"__PRInsec" ns\n",
+		    dev->_data->id, queue_id, budget, window);
+	return 0;
+}
+
+int uk_netdev_rxq_busypoll_stats_get(struct uk_netdev *dev, uint16_t queue_id,
+				     struct uk_netdev_rxq_busypoll_stats *stats)
+{
+	UK_ASSERT(dev);
+	UK_ASSERT(dev->_data);
+	UK_ASSERT(queue_id < CONFIG_LIBUKNETDEV_MAXNBQUEUES);
+	UK_ASSERT(!PTRISERR(dev->_rx_queue[queue_id]));
+	UK_ASSERT(stats);
+
+	*stats = dev->_data->rxq_handler[queue_id].poll_stats;
+	return 0;
+}
+#endif /* CONFIG_LIBUKNETDEV_BUSYPOLL */
+
 int uk_netdev_txq_configure(struct uk_netdev *dev, uint16_t queue_id,
 			    uint16_t nb_desc,
 			    struct uk_netdev_txqueue_conf *tx_conf)
@@ -0,0 +1,128 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2023, Unikraft GmbH and The Unikraft Authors.
+ * Licensed under the BSD-3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ */
+
+/*
+ * Per-queue data path statistics
+ *
+ * The counters are updated by the data path functions of uk/netdev.h. With
+ * libukstore, they are additionally exported as static entries. Because
+ * static entries cannot be created per device, the entries `stats_dev` and
+ * `stats_queue` select the device and queue that the counter entries report.
+ * With the default selection (`STATS_ALL`), the counters of all queues of all
+ * devices are summed up.
+ */
+
+#include <string.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <uk/netdev.h>
+#include <uk/store.h>
+#include <uk/essentials.h>
+
+#define STATS_ALL	UINT16_MAX
+
+int uk_netdev_rxq_stats_get(struct uk_netdev *dev, uint16_t queue_id,
+			    struct uk_netdev_queue_stats *stats)
+{
+	UK_ASSERT(dev);
+	UK_ASSERT(dev->_data);
+	UK_ASSERT(queue_id < CONFIG_LIBUKNETDEV_MAXNBQUEUES);
+	UK_ASSERT(stats);
+
+	*stats = dev->_data->rxq_stats[queue_id];
+	return 0;
+}
+
+int uk_netdev_txq_stats_get(struct uk_netdev *dev, uint16_t queue_id,
+			    struct uk_netdev_queue_stats *stats)
+{
+	UK_ASSERT(dev);
+	UK_ASSERT(dev->_data);
+	UK_ASSERT(queue_id < CONFIG_LIBUKNETDEV_MAXNBQUEUES);
+	UK_ASSERT(stats);
+
+	*stats = dev->_data->txq_stats[queue_id];
+	return 0;
+}
+
+void uk_netdev_stats_reset(struct uk_netdev *dev)
+{
+	UK_ASSERT(dev);
+	UK_ASSERT(dev->_data);
+
+	memset(dev->_data->rxq_stats, 0, sizeof(dev->_data->rxq_stats));
+	memset(dev->_data->txq_stats, 0, sizeof(dev->_data->txq_stats));
+}
+
+static __u16 stats_dev = STATS_ALL;
+static __u16 stats_queue = STATS_ALL;
+
+static int get_stats_sel(void *cookie, __u16 *out)
+{
+	*out = *((__u16 *) cookie);
+	return 0;
+}
+
+static int set_stats_sel(void *cookie, __u16 val)
+{
+	*((__u16 *) cookie) = val;
+	return 0;
+}
+
+UK_STORE_STATIC_ENTRY(stats_dev, u16, get_stats_sel, set_stats_sel,
+		      &stats_dev);
+UK_STORE_STATIC_ENTRY(stats_queue, u16, get_stats_sel, set_stats_sel,
+		      &stats_queue);
+
+/* Sums up one counter over the selected devices and queues */
+static int stats_sum(bool tx, __sz off, __u64 *out)
+{
+	struct uk_netdev_queue_stats *qstats;
+	struct uk_netdev *dev;
+	unsigned int i, q;
+	int found = 0;
+
+	*out = 0;
+	for (i = 0; i < uk_netdev_count(); ++i) {
+		if (stats_dev != STATS_ALL && stats_dev != i)
+			continue;
+		dev = uk_netdev_get(i);
+		if (!dev)
+			continue;
+
+		found = 1;
+		qstats = tx ? dev->_data->txq_stats : dev->_data->rxq_stats;
+		for (q = 0; q < CONFIG_LIBUKNETDEV_MAXNBQUEUES; ++q) {
+			if (stats_queue != STATS_ALL && stats_queue != q)
+				continue;
+			*out += *((__u64 *)((__uptr) &qstats[q] + off));
+		}
+	}
+	return found ? 0 : -ENODEV;
+}
+
+static int get_rxq_stat(void *cookie, __u64 *out)
+{
+	return stats_sum(false, (__sz)(__uptr) cookie, out);
+}
+
+static int get_txq_stat(void *cookie, __u64 *out)
+{
+	return stats_sum(true, (__sz)(__uptr) cookie, out);
+}
+
+#define STATS_OFF(field) \
+	((void *) __offsetof(struct uk_netdev_queue_stats, field))
+
+UK_STORE_STATIC_ENTRY(rx_pkts, u64, get_rxq_stat, NULL, STATS_OFF(pkts));
+UK_STORE_STATIC_ENTRY(rx_bytes, u64, get_rxq_stat, NULL, STATS_OFF(bytes));
+UK_STORE_STATIC_ENTRY(rx_errors, u64, get_rxq_stat, NULL, STATS_OFF(errors));
+UK_STORE_STATIC_ENTRY(rx_underruns, u64, get_rxq_stat, NULL,
+		      STATS_OFF(underruns));
+UK_STORE_STATIC_ENTRY(tx_pkts, u64, get_txq_stat, NULL, STATS_OFF(pkts));
+UK_STORE_STATIC_ENTRY(tx_bytes, u64, get_txq_stat, NULL, STATS_OFF(bytes));
+UK_STORE_STATIC_ENTRY(tx_errors, u64, get_txq_stat, NULL, STATS_OFF(errors));
+UK_STORE_STATIC_ENTRY(tx_full, u64, get_txq_stat, NULL, STATS_OFF(full));
@@ -0,0 +1,131 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2023, Unikraft GmbH and The Unikraft Authors.
+ * Licensed under the BSD-3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ */
+
+#ifndef __UK_NETPAIR__
+#define __UK_NETPAIR__
+
+#include <uk/config.h>
+#include <uk/arch/types.h>
+#include <uk/arch/time.h>
+#include <uk/netdev.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * In-memory network device pairs and loopback devices
+ *
+ * The number of devices is set with the library parameters `netpair.pairs`
+ * and `netpair.loopbacks`. Packets that are transmitted on one device of a
+ * pair are received by the other one, a loopback device receives its own
+ * packets. The devices do not need a hypervisor or a host network and are
+ * meant for functional tests and for measuring the overhead of the
+ * uknetdev data path.
+ */
+
+/**
+ * Returns the device that receives the packets transmitted by `dev`.
+ *
+ * @param dev
+ *   The Unikraft Network Device.
+ * @return
+ *   - (NULL): `dev` is not a netpair device
+ *   - The peer device (`dev` itself for loopback devices)
+ */
+struct uk_netdev *uk_netpair_peer_get(struct uk_netdev *dev);
+
+#if CONFIG_LIBUKNETPAIR_PKTGEN
+struct uk_netbuf_pool;
+
+/**
+ * Brings a network device to running state for the packet generator:
+ * probes and configures the device if needed, sets up `nb_queues` receive
+ * and transmit queues (receive buffers are taken from `pool`) and starts
+ * the device. Interrupts are left disabled.
+ *
+ * @param dev
+ *   The Unikraft Network Device in unprobed or unconfigured state.
+ * @param nb_queues
+ *   Number of receive and transmit queues.
+ * @param nb_desc
+ *   Number of descriptors per queue, 0 for the driver default.
+ * @param pool
+ *   Netbuf pool for receive buffers.
+ * @return
+ *   - (0): Success
+ *   - (<0): Negative error code of the failed uknetdev call
+ */
+int uk_netpair_pktgen_prepare(struct uk_netdev *dev, __u16 nb_queues,
+			      __u16 nb_desc, struct uk_netbuf_pool *pool);
+
+struct uk_netpair_pktgen_conf {
+	/* Number of packets to send */
+	__u32 count;
+	/* Length of each frame (including Ethernet header) */
+	__u16 pktlen;
+	/* Maximum number of packets per burst call */
+	__u16 burst;
+	/* Transmit and receive queue */
+	__u16 queue_id;
+	/* Abort if no progress was made for this long (0: 1 second) */
+	__nsec timeout;
+};
+
+struct uk_netpair_pktgen_result {
+	__u64 tx_pkts;
+	__u64 rx_pkts;
+	/* Received frames with wrong length, magic, or sequence number */
+	__u64 rx_bad;
+	/* Transmit calls that found the queue full */
+	__u64 tx_full;
+	/* Time from the first transmission to the last reception */
+	__nsec duration;
+	/* Received packets per second */
+	__u64 pps;
+	/* One-way latency in nanoseconds (transmit to reception) */
+	__nsec lat_min;
+	__nsec lat_p50;
+	__nsec lat_p90;
+	__nsec lat_p99;
+	__nsec lat_p999;
+	__nsec lat_max;
+};
+
+/**
+ * Sends `conf->count` frames on `tx` and receives them on `rx` by polling
+ * from the calling thread. Every frame carries a sequence number and its
+ * transmission timestamp, so that the result reports loss, reordering and
+ * the latency distribution. Both devices must be running (see
+ * uk_netpair_pktgen_prepare()) and `rx` must be the peer of `tx`.
+ *
+ * @param tx
+ *   Transmitting device.
+ * @param rx
+ *   Receiving device.
+ * @param pool
+ *   Netbuf pool for transmit buffers.
+ * @param conf
+ *   Generator configuration.
+ * @param res
+ *   Filled with the measurement results.
+ * @return
+ *   - (0): All packets were received
+ *   - (-ETIMEDOUT): No progress within `conf->timeout`, `res` is filled
+ *   - (-ENOMEM): Allocation of the latency buffer failed
+ *   - (-EINVAL): Invalid configuration
+ */
+int uk_netpair_pktgen_run(struct uk_netdev *tx, struct uk_netdev *rx,
+			  struct uk_netbuf_pool *pool,
+			  const struct uk_netpair_pktgen_conf *conf,
+			  struct uk_netpair_pktgen_result *res);
+#endif /* CONFIG_LIBUKNETPAIR_PKTGEN */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __UK_NETPAIR__ */
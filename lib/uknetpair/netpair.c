@@ -0,0 +1,632 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2023, Unikraft GmbH and The Unikraft Authors.
+ * Licensed under the BSD-3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ */
+
+/*
+ * In-memory network device pairs
+ *
+ * Every pair consists of two network devices whose transmit queues feed the
+ * receive queues of the other device (transmit queue `q` of one device is
+ * connected to receive queue `q % nb_rx_queues` of its peer). A loopback
+ * device is its own peer. Transmitted netbufs are handed over through a
+ * lock-free ring (ukring) per receive queue and copied to the receive
+ * buffers of the peer on reception, like a device would do with DMA. A full
+ * receive ring back-pressures the sender (the transmit functions report a
+ * full queue instead of dropping packets).
+ *
+ * Receive interrupts are emulated: when interrupts are enabled on an empty
+ * receive queue, the queue is armed and the next transmission to it raises a
+ * receive event in the context of the sender.
+ */
+
+#include <errno.h>
+#include <string.h>
+#include <uk/alloc.h>
+#include <uk/arch/types.h>
+#include <uk/arch/atomic.h>
+#include <uk/arch/lcpu.h>
+#include <uk/netdev_core.h>
+#include <uk/netdev_driver.h>
+#include <uk/netbuf.h>
+#include <uk/netpair.h>
+#include <uk/ring.h>
+#include <uk/errptr.h>
+#include <uk/libparam.h>
+#include <uk/bus.h>
+#include <uk/print.h>
+
+#define DRIVER_NAME		"netpair"
+
+#define NETPAIR_ETH_HLEN	18 /* Ethernet header with VLAN tag */
+#define NETPAIR_MAX_MTU		9000U
+#define NETPAIR_MAX_GSO_LEN	__U16_MAX
+#define NETPAIR_RING_MAX	32768U
+
+#define to_netpairdev(dev) \
+	__containerof(dev, struct netpair_dev, ndev)
+
+struct uk_netdev_rx_queue {
+	/* Device that this queue belongs to */
+	struct netpair_dev *npdev;
+	/* Queue identifier */
+	__u16 queue_id;
+	/* Netbufs that were transmitted by the peer */
+	struct uk_ring *ring;
+	/* Allocator of the queue and the ring */
+	struct uk_alloc *a;
+	/* Callback for allocating receive buffers */
+	uk_netdev_alloc_rxpkts alloc_rxpkts;
+	void *alloc_rxpkts_argp;
+	/* Interrupts are enabled by the user */
+	__u8 intr_usr_en;
+	/* The next transmission to the queue raises an event */
+	int intr_armed;
+};
+
+struct uk_netdev_tx_queue {
+	/* Device that this queue belongs to */
+	struct netpair_dev *npdev;
+	/* Queue identifier */
+	__u16 queue_id;
+};
+
+struct netpair_dev {
+	/* Net device structure */
+	struct uk_netdev ndev;
+	/* Device that receives the transmitted packets (can be this one) */
+	struct netpair_dev *peer;
+	/* UK Netdevice identifier */
+	__u16 id;
+	/* Configured queues */
+	__u16 nb_rx_queues;
+	__u16 nb_tx_queues;
+	struct uk_netdev_rx_queue *rxqs[CONFIG_LIBUKNETDEV_MAXNBQUEUES];
+	/* Mac address of the device */
+	struct uk_hwaddr hw_addr;
+	/* MTU of the device */
+	__u16 mtu;
+};
+
+/**
+ * Module level variables
+ */
+static struct uk_alloc *netpair_a;
+static const char *drv_name = DRIVER_NAME;
+
+/**
+ * Module Parameters.
+ */
+static __u32 pairs = 1;
+static __u32 loopbacks;
+static __u32 queues = 1;
+static __u32 ringsize = 256;
+static __u32 mtu = 1500;
+static __u32 features;
+
+/**
+ * netpair.pairs=<# of device pairs>
+ */
+UK_LIB_PARAM(pairs, __u32);
+/**
+ * netpair.loopbacks=<# of loopback devices>
+ */
+UK_LIB_PARAM(loopbacks, __u32);
+/**
+ * netpair.queues=<max. # of queues per direction and device>
+ */
+UK_LIB_PARAM(queues, __u32);
+/**
+ * netpair.ringsize=<default # of receive ring slots>
+ */
+UK_LIB_PARAM(ringsize, __u32);
+/**
+ * netpair.mtu=<initial MTU>
+ */
+UK_LIB_PARAM(mtu, __u32);
+/**
+ * netpair.features=<UK_NETDEV_F_* offload flags to announce>
+ */
+UK_LIB_PARAM(features, __u32);
+
+static const struct uk_netdev_ops netpair_netdev_ops;
+
+/* Raises an event if the receive queue is armed */
+static inline void netpair_rxq_notify(struct uk_netdev_rx_queue *rxq)
+{
+	if (ukarch_load_n(&rxq->intr_armed)
+	    && ukarch_exchange_n(&rxq->intr_armed, 0))
+		uk_netdev_drv_rx_event(&rxq->npdev->ndev, rxq->queue_id);
+}
+
+/* Arms an empty receive queue. Returns 1 if packets are pending */
+static int netpair_rxq_arm(struct uk_netdev_rx_queue *rxq)
+{
+	if (!uk_ring_empty(rxq->ring))
+		return 1;
+
+	ukarch_exchange_n(&rxq->intr_armed, 1);
+	/* A transmission between the check above and arming the queue did
+	 * not see the flag: take it back if we can
+	 */
+	mb();
+	if (!uk_ring_empty(rxq->ring)
+	    && ukarch_exchange_n(&rxq->intr_armed, 0))
+		return 1;
+	return 0;
+}
+
+static inline struct uk_netdev_rx_queue *
+netpair_peer_rxq(struct uk_netdev_tx_queue *txq)
+{
+	struct netpair_dev *peer = txq->npdev->peer;
+
+	if (unlikely(!peer->nb_rx_queues))
+		return NULL;
+	return peer->rxqs[txq->queue_id % peer->nb_rx_queues];
+}
+
+/* Whether the peer would have to drop the packet */
+static inline int netpair_pkt_oversized(struct netpair_dev *npdev,
+					struct uk_netbuf *pkt)
+{
+	struct uk_netbuf *seg;
+	size_t len = 0;
+
+	UK_NETBUF_CHAIN_FOREACH(seg, pkt)
+		len += seg->len;
+
+	if (pkt->gso_type != UK_NETBUF_GSO_NONE
+	    && uk_netdev_tso_supported(features))
+		return len > NETPAIR_MAX_GSO_LEN;
+	return len > (size_t) npdev->mtu + NETPAIR_ETH_HLEN;
+}
+
+/* Puts one packet to the receive ring of the peer. Returns 0 if the ring
+ * is full, 1 otherwise (the packet was either queued or dropped)
+ */
+static inline int netpair_xmit_pkt(struct uk_netdev_tx_queue *txq,
+				   struct uk_netdev_rx_queue *rxq,
+				   struct uk_netbuf *pkt)
+{
+	if (unlikely(!rxq || netpair_pkt_oversized(rxq->npdev, pkt))) {
+		/* No link partner or frame too long: the packet is lost */
+		uk_pr_debug(DRIVER_NAME"%"__PRIu16": Dropping packet %p\n",
+			    txq->npdev->id, pkt);
+		uk_netbuf_free(pkt);
+		return 1;
+	}
+	return uk_ring_enqueue(rxq->ring, pkt) == 0;
+}
+
+static int netpair_netdev_xmit(struct uk_netdev *dev __maybe_unused,
+			       struct uk_netdev_tx_queue *txq,
+			       struct uk_netbuf *pkt)
+{
+	struct uk_netdev_rx_queue *rxq;
+
+	UK_ASSERT(dev);
+	UK_ASSERT(txq && pkt);
+
+	rxq = netpair_peer_rxq(txq);
+	if (!netpair_xmit_pkt(txq, rxq, pkt))
+		return 0x0;
+	if (!rxq)
+		return UK_NETDEV_STATUS_SUCCESS | UK_NETDEV_STATUS_MORE;
+
+	netpair_rxq_notify(rxq);
+	return UK_NETDEV_STATUS_SUCCESS
+		| (uk_ring_full(rxq->ring) ? 0x0 : UK_NETDEV_STATUS_MORE);
+}
+
+static int netpair_netdev_xmit_burst(struct uk_netdev *dev __maybe_unused,
+				     struct uk_netdev_tx_queue *txq,
+				     struct uk_netbuf **pkts, __u16 *cnt)
+{
+	struct uk_netdev_rx_queue *rxq;
+	__u16 sent = 0;
+
+	UK_ASSERT(dev);
+	UK_ASSERT(txq && pkts && cnt);
+
+	rxq = netpair_peer_rxq(txq);
+	while (sent < *cnt && netpair_xmit_pkt(txq, rxq, pkts[sent]))
+		sent++;
+
+	*cnt = sent;
+	if (!rxq)
+		return UK_NETDEV_STATUS_SUCCESS | UK_NETDEV_STATUS_MORE;
+	if (sent == 0)
+		return 0x0;
+
+	/* One event for the whole burst */
+	netpair_rxq_notify(rxq);
+	return UK_NETDEV_STATUS_SUCCESS
+		| (uk_ring_full(rxq->ring) ? 0x0 : UK_NETDEV_STATUS_MORE);
+}
+
+/* Copies a transmitted packet to a receive buffer. Returns 0 on success */
+static int netpair_pkt_copy(struct uk_netbuf *dst, struct uk_netbuf *src)
+{
+	struct uk_netbuf *seg;
+	size_t len = 0;
+
+	UK_NETBUF_CHAIN_FOREACH(seg, src) {
+		if (unlikely(len + seg->len > dst->len))
+			return -ENOSPC;
+		memcpy((__u8 *) dst->data + len, seg->data, seg->len);
+		len += seg->len;
+	}
+	dst->len = len;
+
+	/* Checksum and segmentation offload requests travel with the data */
+	dst->flags = src->flags;
+	dst->csum_start = src->csum_start;
+	dst->csum_offset = src->csum_offset;
+	dst->gso_type = src->gso_type;
+	dst->gso_size = src->gso_size;
+	dst->hdr_len = src->hdr_len;
+	return 0;
+}
+
+static int netpair_netdev_recv_burst(struct uk_netdev *dev __maybe_unused,
+				     struct uk_netdev_rx_queue *rxq,
+				     struct uk_netbuf **pkts, __u16 *cnt)
+{
+	struct uk_netbuf *src;
+	__u16 avail, alloced, rcvd = 0, i;
+	int status = 0x0;
+
+	UK_ASSERT(dev);
+	UK_ASSERT(rxq && pkts && cnt);
+
+	/* Only allocate receive buffers for the packets that are there */
+	avail = (__u16) MIN((int) *cnt, uk_ring_count(rxq->ring));
+	if (avail == 0)
+		goto out;
+
+	alloced = rxq->alloc_rxpkts(rxq->alloc_rxpkts_argp, pkts, avail);
+	if (alloced < avail)
+		status |= UK_NETDEV_STATUS_UNDERRUN;
+
+	for (i = 0; i < alloced; ++i) {
+		src = uk_ring_dequeue_sc(rxq->ring);
+		UK_ASSERT(src);
+
+		if (unlikely(netpair_pkt_copy(pkts[rcvd], src) < 0)) {
+			uk_pr_debug(DRIVER_NAME"%"__PRIu16": Receive buffer too small, dropping packet %p\n",
+				    rxq->npdev->id, src);
+		} else {
+			rcvd++;
+		}
+		uk_netbuf_free(src);
+	}
+
+	/* Release the buffers that did not receive a packet */
+	for (i = rcvd; i < alloced; ++i)
+		uk_netbuf_free(pkts[i]);
+
+out:
+	*cnt = rcvd;
+	if (rcvd > 0)
+		status |= UK_NETDEV_STATUS_SUCCESS;
+
+	if (!uk_ring_empty(rxq->ring)) {
+		if (rcvd > 0)
+			status |= UK_NETDEV_STATUS_MORE;
+	} else if (rxq->intr_usr_en && netpair_rxq_arm(rxq)) {
+		/* Packets arrived while arming */
+		if (rcvd > 0)
+			status |= UK_NETDEV_STATUS_MORE;
+		else
+			netpair_rxq_notify(rxq);
+	}
+	return status;
+}
+
+static int netpair_netdev_recv(struct uk_netdev *dev,
+			       struct uk_netdev_rx_queue *rxq,
+			       struct uk_netbuf **pkt)
+{
+	__u16 cnt = 1;
+
+	return netpair_netdev_recv_burst(dev, rxq, pkt, &cnt);
+}
+
+static int netpair_netdev_rxq_intr_enable(struct uk_netdev *dev __unused,
+					  struct uk_netdev_rx_queue *rxq)
+{
+	UK_ASSERT(rxq);
+
+	rxq->intr_usr_en = 1;
+	return netpair_rxq_arm(rxq);
+}
+
+static int netpair_netdev_rxq_intr_disable(struct uk_netdev *dev __unused,
+					   struct uk_netdev_rx_queue *rxq)
+{
+	UK_ASSERT(rxq);
+
+	rxq->intr_usr_en = 0;
+	ukarch_store_n(&rxq->intr_armed, 0);
+	return 0;
+}
+
+static int netpair_netdev_queue_info_get(struct uk_netdev *dev __unused,
+					 __u16 queue_id __unused,
+					 struct uk_netdev_queue_info *qinfo)
+{
+	UK_ASSERT(qinfo);
+
+	qinfo->nb_min = 2;
+	qinfo->nb_max = NETPAIR_RING_MAX;
+	qinfo->nb_align = 1;
+	qinfo->nb_is_power_of_two = 1;
+	return 0;
+}
+
+static struct uk_netdev_rx_queue *
+netpair_netdev_rxq_setup(struct uk_netdev *dev, __u16 queue_id,
+			 __u16 nb_desc, struct uk_netdev_rxqueue_conf *conf)
+{
+	struct netpair_dev *npdev;
+	struct uk_netdev_rx_queue *rxq;
+	int rc;
+
+	UK_ASSERT(dev && conf);
+	npdev = to_netpairdev(dev);
+
+	if (!nb_desc)
+		nb_desc = (__u16) MIN(ringsize, NETPAIR_RING_MAX);
+	if (nb_desc < 2 || nb_desc > NETPAIR_RING_MAX
+	    || !POWER_OF_2(nb_desc)) {
+		uk_pr_err(DRIVER_NAME"%"__PRIu16": Invalid number of descriptors: %"__PRIu16"\n",
+			  npdev->id, nb_desc);
+		rc = -EINVAL;
+		goto err_exit;
+	}
+
+	rxq = uk_zalloc(conf->a, sizeof(*rxq));
+	if (!rxq) {
+		rc = -ENOMEM;
+		goto err_exit;
+	}
+
+	rxq->ring = uk_ring_alloc(nb_desc, conf->a
+#ifdef DEBUG_BUFRING
+				  , NULL
+#endif
+				  );
+	if (!rxq->ring) {
+		rc = -ENOMEM;
+		goto err_free_rxq;
+	}
+
+	rxq->npdev = npdev;
+	rxq->queue_id = queue_id;
+	rxq->a = conf->a;
+	rxq->alloc_rxpkts = conf->alloc_rxpkts;
+	rxq->alloc_rxpkts_argp = conf->alloc_rxpkts_argp;
+
+	/* Publish the queue to the transmit path of the peer */
+	ukarch_store_n(&npdev->rxqs[queue_id], rxq);
+	uk_pr_debug(DRIVER_NAME"%"__PRIu16": rxq %"__PRIu16": %"__PRIu16" slots\n",
+		    npdev->id, queue_id, nb_desc);
+	return rxq;
+
+err_free_rxq:
+	uk_free(conf->a, rxq);
+err_exit:
+	return ERR2PTR(rc);
+}
+
+static struct uk_netdev_tx_queue *
+netpair_netdev_txq_setup(struct uk_netdev *dev, __u16 queue_id,
+			 __u16 nb_desc __unused,
+			 struct uk_netdev_txqueue_conf *conf)
+{
+	struct uk_netdev_tx_queue *txq;
+
+	UK_ASSERT(dev && conf);
+
+	txq = uk_zalloc(conf->a, sizeof(*txq));
+	if (!txq)
+		return ERR2PTR(-ENOMEM);
+
+	txq->npdev = to_netpairdev(dev);
+	txq->queue_id = queue_id;
+	return txq;
+}
+
+static int netpair_netdev_configure(struct uk_netdev *dev,
+				    const struct uk_netdev_conf *conf)
+{
+	struct netpair_dev *npdev;
+
+	UK_ASSERT(dev && conf);
+	npdev = to_netpairdev(dev);
+
+	if (conf->nb_rx_queues > queues || conf->nb_tx_queues > queues) {
+		uk_pr_err(DRIVER_NAME"%"__PRIu16": rx-queue:%"__PRIu16", tx-queue:%"__PRIu16" not supported\n",
+			  npdev->id, conf->nb_rx_queues, conf->nb_tx_queues);
+		return -ENOTSUP;
+	}
+
+	/* The transmit path of the peer maps to the configured queues as
+	 * soon as they are set up
+	 */
+	npdev->nb_tx_queues = conf->nb_tx_queues;
+	ukarch_store_n(&npdev->nb_rx_queues, conf->nb_rx_queues);
+	return 0;
+}
+
+static int netpair_netdev_start(struct uk_netdev *dev __unused)
+{
+	return 0;
+}
+
+static void netpair_netdev_info_get(struct uk_netdev *dev __unused,
+				    struct uk_netdev_info *dev_info)
+{
+	UK_ASSERT(dev_info);
+
+	dev_info->max_rx_queues = (uint16_t) queues;
+	dev_info->max_tx_queues = (uint16_t) queues;
+	dev_info->in_queue_pairs = 0;
+	dev_info->max_mtu = NETPAIR_MAX_MTU;
+	dev_info->nb_encap_tx = 0;
+	dev_info->nb_encap_rx = 0;
+	dev_info->ioalign = 1;
+	dev_info->max_gso_len = uk_netdev_tso_supported(features)
+				? NETPAIR_MAX_GSO_LEN : 0;
+	dev_info->features = features | UK_NETDEV_F_RXQ_INTR;
+}
+
+static unsigned int netpair_netdev_promisc_get(struct uk_netdev *dev __unused)
+{
+	/* Every packet of the peer is received */
+	return 1;
+}
+
+static __u16 netpair_netdev_mtu_get(struct uk_netdev *dev)
+{
+	UK_ASSERT(dev);
+	return to_netpairdev(dev)->mtu;
+}
+
+static int netpair_netdev_mtu_set(struct uk_netdev *dev, __u16 new_mtu)
+{
+	UK_ASSERT(dev);
+
+	if (new_mtu > NETPAIR_MAX_MTU)
+		return -EINVAL;
+	to_netpairdev(dev)->mtu = new_mtu;
+	return 0;
+}
+
+static const struct uk_hwaddr *netpair_netdev_mac_get(struct uk_netdev *dev)
+{
+	UK_ASSERT(dev);
+	return &to_netpairdev(dev)->hw_addr;
+}
+
+static int netpair_netdev_mac_set(struct uk_netdev *dev,
+				  const struct uk_hwaddr *hwaddr)
+{
+	UK_ASSERT(dev && hwaddr);
+
+	memcpy(&to_netpairdev(dev)->hw_addr, hwaddr, sizeof(*hwaddr));
+	return 0;
+}
+
+static const struct uk_netdev_ops netpair_netdev_ops = {
+	.configure = netpair_netdev_configure,
+	.rxq_configure = netpair_netdev_rxq_setup,
+	.txq_configure = netpair_netdev_txq_setup,
+	.start = netpair_netdev_start,
+	.rxq_intr_enable = netpair_netdev_rxq_intr_enable,
+	.rxq_intr_disable = netpair_netdev_rxq_intr_disable,
+	.info_get = netpair_netdev_info_get,
+	.promiscuous_get = netpair_netdev_promisc_get,
+	.hwaddr_get = netpair_netdev_mac_get,
+	.hwaddr_set = netpair_netdev_mac_set,
+	.mtu_get = netpair_netdev_mtu_get,
+	.mtu_set = netpair_netdev_mtu_set,
+	.txq_info_get = netpair_netdev_queue_info_get,
+	.rxq_info_get = netpair_netdev_queue_info_get,
+};
+
+struct uk_netdev *uk_netpair_peer_get(struct uk_netdev *dev)
+{
+	UK_ASSERT(dev);
+
+	if (dev->ops != &netpair_netdev_ops)
+		return NULL;
+	return &to_netpairdev(dev)->peer->ndev;
+}
+
+/**
+ * Registering the network device.
+ */
+static struct netpair_dev *netpair_dev_init(void)
+{
+	struct netpair_dev *npdev;
+	int rc;
+
+	npdev = uk_zalloc(netpair_a, sizeof(*npdev));
+	if (!npdev) {
+		uk_pr_err(DRIVER_NAME": Failed to allocate device\n");
+		return NULL;
+	}
+	npdev->ndev.rx_one = netpair_netdev_recv;
+	npdev->ndev.tx_one = netpair_netdev_xmit;
+	npdev->ndev.rx_burst = netpair_netdev_recv_burst;
+	npdev->ndev.tx_burst = netpair_netdev_xmit_burst;
+	npdev->ndev.ops = &netpair_netdev_ops;
+	npdev->peer = npdev;
+	npdev->mtu = (__u16) MIN(mtu, NETPAIR_MAX_MTU);
+
+	rc = uk_netdev_drv_register(&npdev->ndev, netpair_a, drv_name);
+	if (rc < 0) {
+		uk_pr_err(DRIVER_NAME": Failed to register the network device\n");
+		uk_free(netpair_a, npdev);
+		return NULL;
+	}
+	npdev->id = rc;
+
+	/* Locally administered: 02:6e:70:00:<id> */
+	npdev->hw_addr.addr_bytes[0] = 0x02;
+	npdev->hw_addr.addr_bytes[1] = 0x6e;
+	npdev->hw_addr.addr_bytes[2] = 0x70;
+	npdev->hw_addr.addr_bytes[3] = 0x00;
+	npdev->hw_addr.addr_bytes[4] = (__u8) (npdev->id >> 8);
+	npdev->hw_addr.addr_bytes[5] = (__u8) npdev->id;
+	return npdev;
+}
+
+static int netpair_drv_probe(void)
+{
+	struct netpair_dev *a, *b;
+	__u32 i;
+
+	if (queues < 1 || queues > CONFIG_LIBUKNETDEV_MAXNBQUEUES) {
+		uk_pr_warn(DRIVER_NAME": Limiting queues to %d\n",
+			   CONFIG_LIBUKNETDEV_MAXNBQUEUES);
+		queues = CONFIG_LIBUKNETDEV_MAXNBQUEUES;
+	}
+
+	for (i = 0; i < pairs; ++i) {
+		a = netpair_dev_init();
+		if (!a)
+			return -ENOMEM;
+		b = netpair_dev_init();
+		if (!b)
+			return -ENOMEM;
+		a->peer = b;
+		b->peer = a;
+		uk_pr_info(DRIVER_NAME": Registered pair netdev%"__PRIu16" <-> netdev%"__PRIu16"\n",
+			   a->id, b->id);
+	}
+
+	for (i = 0; i < loopbacks; ++i) {
+		a = netpair_dev_init();
+		if (!a)
+			return -ENOMEM;
+		uk_pr_info(DRIVER_NAME": Registered loopback netdev%"__PRIu16"\n",
+			   a->id);
+	}
+	return 0;
+}
+
+static int netpair_drv_init(struct uk_alloc *a)
+{
+	netpair_a = a;
+	return 0;
+}
+
+static struct uk_bus netpair_bus = {
+	.init = netpair_drv_init,
+	.probe = netpair_drv_probe,
+};
+UK_BUS_REGISTER(&netpair_bus);
@@ -0,0 +1,239 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2023, Unikraft GmbH and The Unikraft Authors.
+ * Licensed under the BSD-3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ */
+
+/*
+ * Minimal packet generator for netpair devices
+ *
+ * Frames are sent and received from a single thread by polling, so the
+ * measurement only covers the uknetdev data path and the driver. Each frame
+ * consists of an Ethernet header with the IEEE local experimental ethertype
+ * and a payload that carries a magic value, a sequence number and the
+ * transmission timestamp. The rest of the frame is left untouched.
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <uk/alloc.h>
+#include <uk/essentials.h>
+#include <uk/netbuf.h>
+#include <uk/netdev.h>
+#include <uk/netpair.h>
+#include <uk/plat/time.h>
+#include <uk/print.h>
+
+#define PKTGEN_ETHERTYPE	0x88b5
+#define PKTGEN_MAGIC		0x756b7067 /* "ukpg" */
+#define PKTGEN_BURST_MAX	64
+#define PKTGEN_TIMEOUT_DEFAULT	UKARCH_NSEC_PER_SEC
+
+struct pktgen_hdr {
+	__u8 dst[UK_NETDEV_HWADDR_LEN];
+	__u8 src[UK_NETDEV_HWADDR_LEN];
+	__u16 type;
+	__u32 magic;
+	__u32 seq;
+	__u64 ts;
+} __packed;
+
+int uk_netpair_pktgen_prepare(struct uk_netdev *dev, __u16 nb_queues,
+			      __u16 nb_desc, struct uk_netbuf_pool *pool)
+{
+	struct uk_netdev_conf dev_conf = {0};
+	struct uk_netdev_rxqueue_conf rxq_conf = {0};
+	struct uk_netdev_txqueue_conf txq_conf = {0};
+	__u16 qid;
+	int rc;
+
+	UK_ASSERT(dev);
+	UK_ASSERT(pool);
+
+	if (uk_netdev_state_get(dev) == UK_NETDEV_UNPROBED) {
+		rc = uk_netdev_probe(dev);
+		if (rc < 0)
+			return rc;
+	}
+	if (uk_netdev_state_get(dev) != UK_NETDEV_UNCONFIGURED)
+		return -EBUSY;
+
+	dev_conf.nb_rx_queues = nb_queues;
+	dev_conf.nb_tx_queues = nb_queues;
+	rc = uk_netdev_configure(dev, &dev_conf);
+	if (rc < 0)
+		return rc;
+
+	rxq_conf.a = uk_alloc_get_default();
+	rxq_conf.alloc_rxpkts = uk_netbuf_pool_alloc_rxpkts;
+	rxq_conf.alloc_rxpkts_argp = pool;
+	txq_conf.a = uk_alloc_get_default();
+	for (qid = 0; qid < nb_queues; ++qid) {
+		rc = uk_netdev_rxq_configure(dev, qid, nb_desc, &rxq_conf);
+		if (rc < 0)
+			return rc;
+		rc = uk_netdev_txq_configure(dev, qid, nb_desc, &txq_conf);
+		if (rc < 0)
+			return rc;
+	}
+
+	return uk_netdev_start(dev);
+}
+
+static int pktgen_lat_cmp(const void *a, const void *b)
+{
+	__nsec la = *(const __nsec *) a;
+	__nsec lb = *(const __nsec *) b;
+
+	return (la > lb) - (la < lb);
+}
+
+/* Value at the given per mille of the sorted samples */
+static inline __nsec pktgen_lat_at(const __nsec *lat, __u64 n,
+				   unsigned int permille)
+{
+	return lat[(n - 1) * permille / 1000];
+}
+
+static void pktgen_fill(struct uk_netbuf *pkt, __u16 pktlen,
+			const struct uk_hwaddr *dst,
+			const struct uk_hwaddr *src, __u32 seq)
+{
+	struct pktgen_hdr *hdr = pkt->data;
+
+	memcpy(hdr->dst, dst->addr_bytes, sizeof(hdr->dst));
+	memcpy(hdr->src, src->addr_bytes, sizeof(hdr->src));
+	hdr->type = (__u16) ((PKTGEN_ETHERTYPE >> 8)
+			     | ((PKTGEN_ETHERTYPE & 0xff) << 8));
+	hdr->magic = PKTGEN_MAGIC;
+	hdr->seq = seq;
+	pkt->len = pktlen;
+}
+
+int uk_netpair_pktgen_run(struct uk_netdev *tx, struct uk_netdev *rx,
+			  struct uk_netbuf_pool *pool,
+			  const struct uk_netpair_pktgen_conf *conf,
+			  struct uk_netpair_pktgen_result *res)
+{
+	struct uk_netbuf *txv[PKTGEN_BURST_MAX];
+	struct uk_netbuf *rxv[PKTGEN_BURST_MAX];
+	const struct uk_hwaddr *src, *dst;
+	struct pktgen_hdr *hdr;
+	__u16 burst, txoff = 0, txpend = 0, cnt, i;
+	__u32 next_seq = 0, exp_seq = 0;
+	__nsec timeout, start, now, progress;
+	__nsec *lat;
+	__u64 nlat = 0;
+	int status, rc = 0;
+
+	UK_ASSERT(tx && rx);
+	UK_ASSERT(pool && conf && res);
+
+	if (!conf->count || conf->pktlen < sizeof(struct pktgen_hdr))
+		return -EINVAL;
+
+	burst = conf->burst ? MIN(conf->burst, PKTGEN_BURST_MAX) : 1;
+	timeout = conf->timeout ? conf->timeout : PKTGEN_TIMEOUT_DEFAULT;
+	src = uk_netdev_hwaddr_get(tx);
+	dst = uk_netdev_hwaddr_get(rx);
+	UK_ASSERT(src && dst);
+
+	lat = uk_malloc(uk_alloc_get_default(), conf->count * sizeof(*lat));
+	if (!lat)
+		return -ENOMEM;
+
+	memset(res, 0, sizeof(*res));
+	start = ukplat_monotonic_clock();
+	progress = start;
+	while (res->rx_pkts < conf->count) {
+		/* Refill the transmit batch */
+		if (!txpend && next_seq < conf->count) {
+			txoff = 0;
+			txpend = (__u16) uk_netbuf_pool_take_batch(pool, txv,
+					MIN(burst, conf->count - next_seq));
+			for (i = 0; i < txpend; ++i) {
+				if (unlikely(uk_netbuf_tailroom(txv[i])
+					     < conf->pktlen)) {
+					uk_netbuf_pool_return_batch(pool, txv,
+								    txpend);
+					txpend = 0;
+					rc = -EINVAL;
+					goto out;
+				}
+				pktgen_fill(txv[i], conf->pktlen, dst, src,
+					    next_seq++);
+			}
+		}
+
+		if (txpend) {
+			now = ukplat_monotonic_clock();
+			for (i = txoff; i < txoff + txpend; ++i)
+				((struct pktgen_hdr *) txv[i]->data)->ts = now;
+
+			cnt = txpend;
+			status = uk_netdev_tx_burst(tx, conf->queue_id,
+						    &txv[txoff], &cnt);
+			if (unlikely(status < 0)) {
+				rc = status;
+				goto out;
+			}
+			if (cnt < txpend)
+				res->tx_full++;
+			if (cnt > 0)
+				progress = now;
+			txoff += cnt;
+			txpend -= cnt;
+			res->tx_pkts += cnt;
+		}
+
+		cnt = burst;
+		status = uk_netdev_rx_burst(rx, conf->queue_id, rxv, &cnt);
+		if (unlikely(status < 0)) {
+			rc = status;
+			goto out;
+		}
+		now = ukplat_monotonic_clock();
+		for (i = 0; i < cnt; ++i) {
+			hdr = rxv[i]->data;
+			if (unlikely(rxv[i]->len != conf->pktlen
+				     || hdr->magic != PKTGEN_MAGIC
+				     || hdr->seq != exp_seq)) {
+				res->rx_bad++;
+			} else {
+				lat[nlat++] = now - hdr->ts;
+			}
+			exp_seq = hdr->seq + 1;
+			uk_netbuf_free(rxv[i]);
+		}
+		res->rx_pkts += cnt;
+
+		if (cnt > 0) {
+			progress = now;
+		} else if (now - progress > timeout) {
+			uk_pr_warn("pktgen: No progress after %"__PRIu64" of %"__PRIu32" packets\n",
+				   res->rx_pkts, conf->count);
+			rc = -ETIMEDOUT;
+			goto out;
+		}
+	}
+
+out:
+	if (txpend)
+		uk_netbuf_pool_return_batch(pool, &txv[txoff], txpend);
+
+	res->duration = (progress > start) ? progress - start : 0;
+	if (res->duration)
+		res->pps = res->rx_pkts * UKARCH_NSEC_PER_SEC / res->duration;
+	if (nlat) {
+		qsort(lat, nlat, sizeof(*lat), pktgen_lat_cmp);
+		res->lat_min = lat[0];
+		res->lat_p50 = pktgen_lat_at(lat, nlat, 500);
+		res->lat_p90 = pktgen_lat_at(lat, nlat, 900);
+		res->lat_p99 = pktgen_lat_at(lat, nlat, 990);
+		res->lat_p999 = pktgen_lat_at(lat, nlat, 999);
+		res->lat_max = lat[nlat - 1];
+	}
+	uk_free(uk_alloc_get_default(), lat);
+	return rc;
+}
@@ -0,0 +1,183 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2023, Unikraft GmbH and The Unikraft Authors.
+ * Licensed under the BSD-3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ */
+
+#include <errno.h>
+#include <uk/test.h>
+#include <uk/alloc.h>
+#include <uk/essentials.h>
+#include <uk/netbuf.h>
+#include <uk/netdev.h>
+#include <uk/netpair.h>
+
+#define POOL_SIZE	1024
+#define BUF_SIZE	2048
+#define BURST		32
+
+/* Number of packets per benchmark measurement */
+#define BENCH_PKTS	(256 * 1024)
+
+static const __u16 bench_pktlens[] = { 64, 512, 1500 };
+
+static struct uk_netdev *dev_tx;
+static struct uk_netdev *dev_rx;
+static struct uk_netbuf_pool *pool;
+
+/* Brings up the first unused device pair */
+static int netpair_setup(void)
+{
+	struct uk_netdev *dev, *peer;
+	unsigned int i;
+	int rc;
+
+	if (dev_tx)
+		return 0;
+
+	pool = uk_netbuf_pool_create(uk_alloc_get_default(), POOL_SIZE,
+				     BUF_SIZE, 0, 0, 0, NULL);
+	if (!pool)
+		return -ENOMEM;
+
+	for (i = 0; i < uk_netdev_count(); ++i) {
+		dev = uk_netdev_get(i);
+		peer = uk_netpair_peer_get(dev);
+		if (!peer || peer == dev
+		    || uk_netdev_state_get(dev) != UK_NETDEV_UNPROBED
+		    || uk_netdev_state_get(peer) != UK_NETDEV_UNPROBED)
+			continue;
+
+		rc = uk_netpair_pktgen_prepare(dev, 1, 0, pool);
+		if (rc < 0)
+			return rc;
+		rc = uk_netpair_pktgen_prepare(peer, 1, 0, pool);
+		if (rc < 0)
+			return rc;
+		dev_tx = dev;
+		dev_rx = peer;
+		return 0;
+	}
+	return -ENODEV;
+}
+
+UK_TESTCASE(uknetpair, pair_delivers_all)
+{
+	struct uk_netpair_pktgen_conf conf = {
+		.count = 10000,
+		.pktlen = 128,
+		.burst = BURST,
+	};
+	struct uk_netpair_pktgen_result res;
+	unsigned int avail;
+
+	UK_TEST_ASSERT(netpair_setup() == 0);
+	avail = uk_netbuf_pool_availcount(pool);
+
+	UK_TEST_EXPECT_ZERO(uk_netpair_pktgen_run(dev_tx, dev_rx, pool,
+						  &conf, &res));
+	UK_TEST_EXPECT_SNUM_EQ(res.tx_pkts, conf.count);
+	UK_TEST_EXPECT_SNUM_EQ(res.rx_pkts, conf.count);
+	UK_TEST_EXPECT_ZERO(res.rx_bad);
+	UK_TEST_EXPECT(res.lat_min <= res.lat_p50);
+	UK_TEST_EXPECT(res.lat_p999 <= res.lat_max);
+
+	/* No netbuf got lost on the way */
+	UK_TEST_EXPECT_SNUM_EQ(uk_netbuf_pool_availcount(pool), avail);
+}
+
+UK_TESTCASE(uknetpair, oversized_frames_dropped)
+{
+	struct uk_netbuf *pkt;
+	__u16 cnt = 1;
+	unsigned int avail;
+	int status;
+
+	UK_TEST_ASSERT(netpair_setup() == 0);
+	avail = uk_netbuf_pool_availcount(pool);
+
+	pkt = uk_netbuf_pool_take(pool);
+	UK_TEST_ASSERT(pkt != NULL);
+	pkt->len = uk_netdev_mtu_get(dev_tx) + 64;
+
+	/* The frame is consumed but never shows up at the peer */
+	status = uk_netdev_tx_burst(dev_tx, 0, &pkt, &cnt);
+	UK_TEST_EXPECT(uk_netdev_status_successful(status));
+	UK_TEST_EXPECT_SNUM_EQ(cnt, 1);
+
+	cnt = 1;
+	status = uk_netdev_rx_burst(dev_rx, 0, &pkt, &cnt);
+	UK_TEST_EXPECT_ZERO(cnt);
+	UK_TEST_EXPECT_SNUM_EQ(uk_netbuf_pool_availcount(pool), avail);
+}
+
+UK_TESTCASE(uknetpair, full_ring_backpressure)
+{
+	struct uk_netbuf *pkts[BURST];
+	__u16 cnt, n;
+	unsigned int sent = 0, rcvd = 0;
+	int status;
+
+	UK_TEST_ASSERT(netpair_setup() == 0);
+
+	/* Fill the receive ring of the peer until the sender is stopped */
+	do {
+		n = (__u16) uk_netbuf_pool_take_batch(pool, pkts, BURST);
+		UK_TEST_ASSERT(n == BURST);
+		for (cnt = 0; cnt < n; ++cnt)
+			pkts[cnt]->len = 64;
+		cnt = n;
+		status = uk_netdev_tx_burst(dev_tx, 0, pkts, &cnt);
+		sent += cnt;
+		if (cnt < n)
+			uk_netbuf_pool_return_batch(pool, &pkts[cnt], n - cnt);
+	} while (cnt == n && sent < POOL_SIZE / 2);
+	UK_TEST_EXPECT(cnt < n);
+	UK_TEST_EXPECT(!uk_netdev_status_more(status));
+
+	/* Everything that was accepted is delivered */
+	do {
+		cnt = BURST;
+		uk_netdev_rx_burst(dev_rx, 0, pkts, &cnt);
+		for (n = 0; n < cnt; ++n)
+			uk_netbuf_free(pkts[n]);
+		rcvd += cnt;
+	} while (cnt > 0);
+	UK_TEST_EXPECT_SNUM_EQ(rcvd, sent);
+}
+
+/* Reports throughput and one-way latency per frame size */
+UK_TESTCASE(uknetpair, benchmark)
+{
+	struct uk_netpair_pktgen_conf conf = {
+		.count = BENCH_PKTS,
+		.burst = BURST,
+	};
+	struct uk_netpair_pktgen_result res;
+	__u64 bad = 0;
+	unsigned int i;
+
+	UK_TEST_ASSERT(netpair_setup() == 0);
+
+	for (i = 0; i < ARRAY_SIZE(bench_pktlens); ++i) {
+		conf.pktlen = bench_pktlens[i];
+		UK_TEST_EXPECT_ZERO(uk_netpair_pktgen_run(dev_tx, dev_rx, pool,
+							  &conf, &res));
+		bad += res.rx_bad;
+
+		uk_test_printf("%5"__PRIu16" B: %"__PRIu64".%03"__PRIu64
+			       " Mpps, latency min %"__PRInsec" p50 %"
+			       __PRInsec" p90 %"__PRInsec" p99 %"__PRInsec
+			       " p99.9 %"__PRInsec" max %"__PRInsec
+			       " ns, %"__PRIu64" full\n",
+			       conf.pktlen, res.pps / 1000000,
+			       (res.pps / 1000) % 1000, res.lat_min,
+			       res.lat_p50, res.lat_p90, res.lat_p99,
+			       res.lat_p999, res.lat_max, res.tx_full);
+	}
+
+	/* The benchmark only reports numbers, delivery is checked above */
+	UK_TEST_EXPECT_ZERO(bad);
+}
+
+uk_testsuite_register(uknetpair, NULL);
@@ -0,0 +1,111 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2023, Unikraft GmbH and The Unikraft Authors.
+ * Licensed under the BSD-3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ */
+
+#include <errno.h>
+#include <uk/test.h>
+#include <uk/alloc.h>
+#include <uk/ring.h>
+#include <uk/essentials.h>
+
+#define RING_SIZE	8
+
+/* Enough rounds to wrap the indices of the ring several times */
+#define RING_ROUNDS	(4 * RING_SIZE)
+
+static struct uk_ring *ring_alloc(void)
+{
+	struct uk_ring *r;
+
+	r = uk_ring_alloc(RING_SIZE, uk_alloc_get_default()
+#ifdef DEBUG_BUFRING
+			  , NULL
+#endif
+			  );
+	UK_ASSERT(r);
+	return r;
+}
+
+static inline void *ring_item(unsigned long i)
+{
+	/* Items must not be NULL, which the dequeue functions return when
+	 * the ring is empty
+	 */
+	return (void *)(i + 1);
+}
+
+/* Fills the ring, which holds one item less than its size, and drains it,
+ * so that the indices wrap around
+ */
+static unsigned int fill_drain(struct uk_ring *r, unsigned long *seq,
+			       void *(*dequeue)(struct uk_ring *))
+{
+	unsigned int i, fails = 0;
+
+	for (i = 0; i < RING_SIZE - 1; i++)
+		if (uk_ring_enqueue(r, ring_item(*seq + i)))
+			fails++;
+	if (uk_ring_enqueue(r, ring_item(*seq + i)) != -ENOBUFS)
+		fails++;
+
+	for (i = 0; i < RING_SIZE - 1; i++)
+		if (dequeue(r) != ring_item((*seq)++))
+			fails++;
+	if (dequeue(r) != NULL)
+		fails++;
+	return fails;
+}
+
+UK_TESTCASE(ukring, wrap_dequeue_mc)
+{
+	struct uk_ring *r = ring_alloc();
+	unsigned long seq = 0;
+	unsigned int i, fails = 0;
+
+	for (i = 0; i < RING_ROUNDS; i++)
+		fails += fill_drain(r, &seq, uk_ring_dequeue_mc);
+	UK_TEST_EXPECT_ZERO(fails);
+	UK_TEST_EXPECT(uk_ring_empty(r));
+
+	uk_ring_free(r, uk_alloc_get_default());
+}
+
+UK_TESTCASE(ukring, wrap_dequeue_sc)
+{
+	struct uk_ring *r = ring_alloc();
+	unsigned long seq = 0;
+	unsigned int i, fails = 0;
+
+	for (i = 0; i < RING_ROUNDS; i++)
+		fails += fill_drain(r, &seq, uk_ring_dequeue_sc);
+	UK_TEST_EXPECT_ZERO(fails);
+	UK_TEST_EXPECT(uk_ring_empty(r));
+
+	uk_ring_free(r, uk_alloc_get_default());
+}
+
+/* One item at a time passes every index of the ring, including the wrap
+ * of the producer index to 0 while the consumer is right behind it
+ */
+UK_TESTCASE(ukring, wrap_single)
+{
+	struct uk_ring *r = ring_alloc();
+	unsigned int i, fails = 0;
+
+	for (i = 0; i < RING_ROUNDS * RING_SIZE; i++) {
+		if (uk_ring_enqueue(r, ring_item(i)))
+			fails++;
+		if (uk_ring_count(r) != 1)
+			fails++;
+		if (uk_ring_dequeue_mc(r) != ring_item(i))
+			fails++;
+	}
+	UK_TEST_EXPECT_ZERO(fails);
+	UK_TEST_EXPECT(uk_ring_empty(r));
+
+	uk_ring_free(r, uk_alloc_get_default());
+}
+
+uk_testsuite_register(ukring, NULL);
@@ -63,6 +63,11 @@ struct uk_thread {
 	UK_TAILQ_ENTRY(struct uk_thread) queue;
 	uint32_t flags;
 	__snsec wakeup_time;
+	struct {
+		struct uk_thread *child;
+		struct uk_thread *next;
+		struct uk_thread *prev;
+	} _sleepq;			/**< Sleep queue node (scheduler internal!) */
 	struct uk_sched *sched;
 
 	struct {
@@ -67,6 +67,17 @@ void uk_waitq_add(struct uk_waitq *wq,
 	}
 }
 
+/* Enqueues an entry in front of the other waiters */
+static inline
+void uk_waitq_add_head(struct uk_waitq *wq,
+		struct uk_waitq_entry *entry)
+{
+	if (!entry->waiting) {
+		UK_STAILQ_INSERT_HEAD(&(wq->wait_list), entry, thread_list);
+		entry->waiting = 1;
+	}
+}
+
 static inline
 void uk_waitq_remove(struct uk_waitq *wq,
 		struct uk_waitq_entry *entry)
@@ -218,6 +229,35 @@ void uk_waitq_wake_up_one(struct uk_waitq *wq)
 	ukplat_spin_unlock_irqrestore(&(wq->sl), flags);
 }
 
+/**
+ * Dequeues the first waiter and wakes it up. In contrast to
+ * uk_waitq_wake_up_one(), the waiter is not found again by subsequent wake
+ * ups, so that a resource can be handed over to exactly one waiter. The
+ * waiter detects the hand-over by its entry no longer `waiting`.
+ * The caller has to serialize the access to the wait queue.
+ *
+ * @param wq
+ *   Wait queue to operate on
+ * @return
+ *   The woken thread, NULL if the wait queue is empty
+ */
+static inline
+struct uk_thread *uk_waitq_handoff(struct uk_waitq *wq)
+{
+	struct uk_waitq_entry *head;
+	struct uk_thread *thread;
+
+	head = UK_STAILQ_FIRST(&wq->wait_list);
+	if (!head)
+		return NULL;
+
+	/* The entry lives on the stack of the waiter */
+	thread = head->thread;
+	uk_waitq_remove(wq, head);
+	uk_thread_wake(thread);
+	return thread;
+}
+
 #ifdef __cplusplus
 }
 #endif
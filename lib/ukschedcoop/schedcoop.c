@@ -28,6 +28,12 @@
 /*
  * The scheduler is non-preemptive (cooperative), and schedules according
  * to Round Robin algorithm.
+ *
+ * Threads that block with a timeout are kept in a pairing heap that is
+ * ordered by their wakeup time: Inserting a sleeper is O(1), removing
+ * the earliest or any other sleeper is O(log n) amortized. A scheduling
+ * decision thus only looks at the expired sleepers instead of walking
+ * all of them.
  */
 #include <uk/plat/config.h>
 #include <uk/plat/lcpu.h>
@@ -40,7 +46,7 @@
 struct schedcoop {
 	struct uk_sched sched;
 	struct uk_thread_list run_queue;
-	struct uk_thread_list sleep_queue;
+	struct uk_thread *sleep_queue; /* root of the sleep heap */
 
 	struct uk_thread idle;
 	__nsec idle_return_time;
@@ -53,11 +59,120 @@ static inline struct schedcoop *uksched2schedcoop(struct uk_sched *s)
 	return __containerof(s, struct schedcoop, sched);
 }
 
+/*
+ * Sleep queue (pairing heap ordered by `wakeup_time`)
+ *
+ * `_sleepq.prev` points to the parent for the first child and to the left
+ * sibling for all other children. It is NULL for the root and for threads
+ * that are not queued.
+ */
+static inline bool sleepq_is_queued(struct schedcoop *c, struct uk_thread *t)
+{
+	return t->_sleepq.prev || c->sleep_queue == t;
+}
+
+/* Links two heaps, `a` and `b` must be roots without siblings */
+static struct uk_thread *sleepq_meld(struct uk_thread *a, struct uk_thread *b)
+{
+	struct uk_thread *tmp;
+
+	if (!a)
+		return b;
+	if (!b)
+		return a;
+
+	if (b->wakeup_time < a->wakeup_time) {
+		tmp = a;
+		a = b;
+		b = tmp;
+	}
+
+	/* `b` becomes the first child of `a` */
+	b->_sleepq.prev = a;
+	b->_sleepq.next = a->_sleepq.child;
+	if (a->_sleepq.child)
+		a->_sleepq.child->_sleepq.prev = b;
+	a->_sleepq.child = b;
+	return a;
+}
+
+/* Combines a list of siblings into one heap (two-pass pairing) */
+static struct uk_thread *sleepq_merge_pairs(struct uk_thread *first)
+{
+	struct uk_thread *a, *b, *rest;
+	struct uk_thread *pairs = NULL;
+	struct uk_thread *root = NULL;
+
+	/* Left to right: meld pairs, collect them in reverse order */
+	while (first) {
+		a = first;
+		b = a->_sleepq.next;
+		rest = b ? b->_sleepq.next : NULL;
+
+		a->_sleepq.next = NULL;
+		a->_sleepq.prev = NULL;
+		if (b) {
+			b->_sleepq.next = NULL;
+			b->_sleepq.prev = NULL;
+			a = sleepq_meld(a, b);
+		}
+		a->_sleepq.next = pairs;
+		pairs = a;
+		first = rest;
+	}
+
+	/* Right to left: meld the pairs into the result */
+	while (pairs) {
+		rest = pairs->_sleepq.next;
+		pairs->_sleepq.next = NULL;
+		root = sleepq_meld(root, pairs);
+		pairs = rest;
+	}
+	return root;
+}
+
+static void sleepq_insert(struct schedcoop *c, struct uk_thread *t)
+{
+	UK_ASSERT(!sleepq_is_queued(c, t));
+
+	t->_sleepq.child = NULL;
+	t->_sleepq.next = NULL;
+	t->_sleepq.prev = NULL;
+	c->sleep_queue = sleepq_meld(c->sleep_queue, t);
+}
+
+static void sleepq_remove(struct schedcoop *c, struct uk_thread *t)
+{
+	struct uk_thread *sub;
+
+	UK_ASSERT(sleepq_is_queued(c, t));
+
+	sub = sleepq_merge_pairs(t->_sleepq.child);
+	t->_sleepq.child = NULL;
+
+	if (c->sleep_queue == t) {
+		c->sleep_queue = sub;
+		return;
+	}
+
+	/* Unlink `t` from its parent or left sibling */
+	if (t->_sleepq.prev->_sleepq.child == t)
+		t->_sleepq.prev->_sleepq.child = t->_sleepq.next;
+	else
+		t->_sleepq.prev->_sleepq.next = t->_sleepq.next;
+	if (t->_sleepq.next)
+		t->_sleepq.next->_sleepq.prev = t->_sleepq.prev;
+	t->_sleepq.next = NULL;
+	t->_sleepq.prev = NULL;
+
+	c->sleep_queue = sleepq_meld(c->sleep_queue, sub);
+}
+
 static void schedcoop_schedule(struct uk_sched *s)
 {
 	struct schedcoop *c = uksched2schedcoop(s);
-	struct uk_thread *prev, *next, *thread, *tmp;
-	__snsec now, min_wakeup_time;
+	struct uk_thread *prev, *next, *thread;
+	__snsec now;
 	unsigned long flags;
 
 	if (unlikely(ukplat_lcpu_irqs_disabled()))
@@ -71,21 +186,13 @@ static void schedcoop_schedule(struct uk_sched *s)
 		UK_CRASH("Must not call %s from a callback\n", __func__);
 #endif
 
-	/* Examine all sleeping threads.
-	 * Wake up expired ones and find the time when the next timeout expires.
+	/* Wake up expired sleepers. They are dequeued before the wake so that
+	 * the loop also terminates for threads that are runnable already.
 	 */
 	now = ukplat_monotonic_clock();
-	min_wakeup_time = 0;
-
-	UK_TAILQ_FOREACH_SAFE(thread, &c->sleep_queue,
-			      queue, tmp) {
-		if (likely(thread->wakeup_time)) {
-			if (thread->wakeup_time <= now)
-				uk_thread_wake(thread);
-			else if (!min_wakeup_time
-				 || thread->wakeup_time < min_wakeup_time)
-				min_wakeup_time = thread->wakeup_time;
-		}
+	while ((thread = c->sleep_queue) && thread->wakeup_time <= now) {
+		sleepq_remove(c, thread);
+		uk_thread_wake(thread);
 	}
 
 	next = UK_TAILQ_FIRST(&c->run_queue);
@@ -111,7 +218,8 @@ static void schedcoop_schedule(struct uk_sched *s)
 		 * We select the idle thread only if we do not have anything
 		 * else to execute
 		 */
-		c->idle_return_time = min_wakeup_time;
+		c->idle_return_time = c->sleep_queue
+				      ? c->sleep_queue->wakeup_time : 0;
 		next = &c->idle;
 	}
 
@@ -156,6 +264,8 @@ static void schedcoop_thread_remove(struct uk_sched *s, struct uk_thread *t)
 	if (t != uk_thread_current()
 	    && uk_thread_is_runnable(t))
 		UK_TAILQ_REMOVE(&c->run_queue, t, queue);
+	else if (sleepq_is_queued(c, t))
+		sleepq_remove(c, t);
 }
 
 static void schedcoop_thread_blocked(struct uk_sched *s, struct uk_thread *t)
@@ -167,7 +277,7 @@ static void schedcoop_thread_blocked(struct uk_sched *s, struct uk_thread *t)
 	if (t != uk_thread_current())
 		UK_TAILQ_REMOVE(&c->run_queue, t, queue);
 	if (t->wakeup_time > 0)
-		UK_TAILQ_INSERT_TAIL(&c->sleep_queue, t, queue);
+		sleepq_insert(c, t);
 }
 
 static void schedcoop_thread_woken(struct uk_sched *s, struct uk_thread *t)
@@ -176,8 +286,8 @@ static void schedcoop_thread_woken(struct uk_sched *s, struct uk_thread *t)
 
 	UK_ASSERT(ukplat_lcpu_irqs_disabled());
 
-	if (t->wakeup_time > 0)
-		UK_TAILQ_REMOVE(&c->sleep_queue, t, queue);
+	if (sleepq_is_queued(c, t))
+		sleepq_remove(c, t);
 	if (uk_thread_is_queueable(t) && uk_thread_is_runnable(t)) {
 		UK_TAILQ_INSERT_TAIL(&c->run_queue, t, queue);
 		uk_thread_clear_queueable(t);
@@ -260,7 +370,7 @@ struct uk_sched *uk_schedcoop_create(struct uk_alloc *a)
 		goto err_out;
 
 	UK_TAILQ_INIT(&c->run_queue);
-	UK_TAILQ_INIT(&c->sleep_queue);
+	c->sleep_queue = NULL;
 
 	/* Create idle thread */
 	rc = uk_thread_init_fn1(&c->idle,
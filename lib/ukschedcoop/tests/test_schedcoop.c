@@ -0,0 +1,225 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2023, Unikraft GmbH and The Unikraft Authors.
+ * Licensed under the BSD-3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ */
+
+#include <uk/test.h>
+#include <uk/essentials.h>
+#include <uk/sched.h>
+#include <uk/thread.h>
+#include <uk/arch/time.h>
+#include <uk/plat/time.h>
+
+/* Thread switches (yield round trips) per measurement */
+#define BENCH_ROUNDS		10000
+#define BENCH_MAX_SLEEPERS	1000
+#define SLEEPER_STACK_SIZE	(16 * 1024)
+
+static const unsigned int nr_sleepers[] = { 0, 10, 100, BENCH_MAX_SLEEPERS };
+
+static struct uk_thread *sleepers[BENCH_MAX_SLEEPERS];
+static volatile unsigned int sleepers_asleep;
+static volatile int stop;
+
+static __noreturn void sleeper_fn(void *argp)
+{
+	/* Distinct wakeup times far in the future */
+	__nsec nsec = ukarch_time_sec_to_nsec(3600) + (__nsec)(__uptr)argp;
+
+	sleepers_asleep++;
+	while (!stop)
+		uk_sched_thread_sleep(nsec);
+	sleepers_asleep--;
+	uk_sched_thread_exit();
+}
+
+static __noreturn void partner_fn(void *argp __unused)
+{
+	while (!stop)
+		uk_sched_yield();
+	uk_sched_thread_exit();
+}
+
+static int sleepers_start(struct uk_sched *s, unsigned int count)
+{
+	unsigned int i;
+
+	for (i = 0; i < count; ++i) {
+		sleepers[i] = uk_sched_thread_create_fn1(s, sleeper_fn,
+							 (void *)(__uptr)i,
+							 SLEEPER_STACK_SIZE,
+							 false, false,
+							 "sleeper", NULL, NULL);
+		if (!sleepers[i])
+			return -1;
+	}
+
+	/* Let all sleepers enter the sleep queue */
+	while (sleepers_asleep < count)
+		uk_sched_yield();
+	return 0;
+}
+
+static void sleepers_stop(unsigned int count)
+{
+	unsigned int i;
+
+	for (i = 0; i < count; ++i) {
+		if (sleepers[i])
+			uk_thread_wake(sleepers[i]);
+		sleepers[i] = NULL;
+	}
+	while (sleepers_asleep > 0)
+		uk_sched_yield();
+}
+
+/* Wake-up order test: Deadlines are spaced by ORDER_STEP, the sleepers are
+ * created in a different order than they expire.
+ */
+#define ORDER_SLEEPERS		8
+#define ORDER_STEP		ukarch_time_msec_to_nsec(2)
+
+struct order_args {
+	__snsec deadline;
+	unsigned int id;
+	unsigned int *order;
+	unsigned int *norder;
+};
+
+static __noreturn void order_fn(void *argp)
+{
+	struct order_args *args = (struct order_args *)argp;
+
+	uk_thread_block_until(uk_thread_current(), args->deadline);
+	uk_sched_yield();
+	args->order[(*args->norder)++] = args->id;
+	uk_sched_thread_exit();
+}
+
+UK_TESTCASE(ukschedcoop, wake_order)
+{
+	/* Position of each sleeper in the expected wake-up order */
+	static const unsigned int pos[ORDER_SLEEPERS] = {
+		5, 2, 7, 0, 3, 6, 1, 4
+	};
+	struct uk_thread *threads[ORDER_SLEEPERS];
+	struct order_args args[ORDER_SLEEPERS];
+	unsigned int order[ORDER_SLEEPERS];
+	unsigned int norder = 0;
+	__snsec base;
+	unsigned int i;
+
+	base = ukplat_monotonic_clock() + ukarch_time_msec_to_nsec(5);
+	for (i = 0; i < ORDER_SLEEPERS; ++i) {
+		args[i] = (struct order_args){
+			.deadline = base + pos[i] * ORDER_STEP,
+			.id = i,
+			.order = order,
+			.norder = &norder,
+		};
+		threads[i] = uk_sched_thread_create(uk_sched_current(),
+						    order_fn, &args[i],
+						    "order-sleeper");
+		UK_ASSERT(threads[i]);
+	}
+
+	for (i = 0; i < ORDER_SLEEPERS; ++i)
+		while (!uk_thread_is_exited(threads[i]))
+			uk_sched_yield();
+
+	UK_TEST_EXPECT_SNUM_EQ(norder, ORDER_SLEEPERS);
+	for (i = 0; i < ORDER_SLEEPERS; ++i)
+		UK_TEST_EXPECT_SNUM_EQ(pos[order[i]], i);
+}
+
+static volatile unsigned int early_wakes;
+
+static __noreturn void early_fn(void *argp __unused)
+{
+	uk_sched_thread_sleep(ukarch_time_msec_to_nsec(10));
+	early_wakes++;
+
+	/* Block without timeout: Only an explicit wake-up may follow */
+	uk_thread_block(uk_thread_current());
+	uk_sched_yield();
+	early_wakes++;
+	uk_sched_thread_exit();
+}
+
+UK_TESTCASE(ukschedcoop, early_wake)
+{
+	struct uk_thread *thread;
+	__nsec end;
+
+	early_wakes = 0;
+	thread = uk_sched_thread_create(uk_sched_current(), early_fn, NULL,
+					"early-sleeper");
+	UK_ASSERT(thread);
+
+	/* Let the thread go to sleep and wake it before its deadline */
+	uk_sched_yield();
+	UK_TEST_EXPECT(!uk_thread_is_runnable(thread));
+	uk_thread_wake(thread);
+	uk_sched_yield();
+	UK_TEST_EXPECT_SNUM_EQ(early_wakes, 1);
+	UK_TEST_EXPECT(!uk_thread_is_runnable(thread));
+
+	/* The expired sleep must not wake the thread again */
+	end = ukplat_monotonic_clock() + ukarch_time_msec_to_nsec(30);
+	while (ukplat_monotonic_clock() < end)
+		uk_sched_yield();
+	UK_TEST_EXPECT_SNUM_EQ(early_wakes, 1);
+	UK_TEST_EXPECT(!uk_thread_is_runnable(thread));
+
+	uk_thread_wake(thread);
+	while (!uk_thread_is_exited(thread))
+		uk_sched_yield();
+	UK_TEST_EXPECT_SNUM_EQ(early_wakes, 2);
+}
+
+/* Reports the average switch latency depending on the number of sleepers */
+UK_TESTCASE(ukschedcoop, switch_latency)
+{
+	struct uk_sched *s = uk_sched_current();
+	struct uk_thread *partner;
+	__nsec start, t;
+	unsigned int i, n;
+	int rc = 0;
+
+	UK_TEST_EXPECT_NOT_NULL(s);
+
+	for (n = 0; n < ARRAY_SIZE(nr_sleepers) && !rc; ++n) {
+		stop = 0;
+		rc = sleepers_start(s, nr_sleepers[n]);
+		if (rc)
+			uk_test_printf("Failed to create %u sleepers\n",
+				       nr_sleepers[n]);
+
+		partner = uk_sched_thread_create(s, partner_fn, NULL,
+						 "partner");
+		UK_TEST_EXPECT_NOT_NULL(partner);
+		if (!partner)
+			rc = -1;
+
+		if (!rc) {
+			/* Each round switches to the partner and back */
+			start = ukplat_monotonic_clock();
+			for (i = 0; i < BENCH_ROUNDS; ++i)
+				uk_sched_yield();
+			t = ukplat_monotonic_clock() - start;
+
+			uk_test_printf("%5u sleepers: %6"__PRInsec
+				       " ns per switch\n", nr_sleepers[n],
+				       t / (2 * BENCH_ROUNDS));
+		}
+
+		stop = 1;
+		sleepers_stop(nr_sleepers[n]);
+		/* The partner exits with its next time slice */
+		uk_sched_yield();
+	}
+	UK_TEST_EXPECT_ZERO(rc);
+}
+
+uk_testsuite_register(ukschedcoop, NULL);
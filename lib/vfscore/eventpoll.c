@@ -45,6 +45,9 @@
 
 #define EPERR_SET (EPOLLERR | EPOLLHUP | EPOLLNVAL)
 
+/* Initial number of buckets of the fd index */
+#define EP_HASH_MIN_SIZE 16
+
 UK_TRACEPOINT(trace_ep_wait, "%p %p", void *, void *);
 UK_TRACEPOINT(trace_ep_wakeup, "%p %p %u", void *, void *, unsigned int);
 
@@ -81,6 +84,21 @@ void eventpoll_fini(struct eventpoll *ep)
 	}
 
 	UK_ASSERT(uk_list_empty(&ep->fd_list));
+	UK_ASSERT(ep->nfds == 0);
+
+	if (ep->fd_hash) {
+		UK_ASSERT(ep->a);
+		uk_free(ep->a, ep->fd_hash);
+		ep->fd_hash = NULL;
+		ep->fd_hash_size = 0;
+	}
+}
+
+/* fds are allocated densely from 0, so the fd itself is a good hash */
+static inline struct uk_hlist_head *efd_bucket(struct uk_hlist_head *hash,
+					       unsigned int size, int fd)
+{
+	return &hash[(unsigned int)fd & (size - 1)];
 }
 
 static struct eventpoll_fd *efd_find(struct eventpoll *ep, int fd)
@@ -90,6 +108,17 @@ static struct eventpoll_fd *efd_find(struct eventpoll *ep, int fd)
 
 	UK_ASSERT(ep);
 
+	if (likely(ep->fd_hash)) {
+		uk_hlist_for_each_entry(efd, efd_bucket(ep->fd_hash,
+							ep->fd_hash_size, fd),
+					fd_hnode) {
+			if (efd->fd == fd)
+				return efd;
+		}
+
+		return NULL;
+	}
+
 	uk_list_for_each(itr, &ep->fd_list) {
 		efd = uk_list_entry(itr, struct eventpoll_fd, fd_link);
 
@@ -100,6 +129,87 @@ static struct eventpoll_fd *efd_find(struct eventpoll *ep, int fd)
 	return NULL;
 }
 
+/* Doubles the size of the fd index and rehashes all monitored fds. If the
+ * allocation fails, the current index is kept with longer chains.
+ */
+static void efd_hash_grow(struct eventpoll *ep)
+{
+	struct uk_hlist_head *hash;
+	struct eventpoll_fd *efd;
+	struct uk_list_head *itr;
+	unsigned int size, i;
+
+	UK_ASSERT(ep->a);
+
+	size = (ep->fd_hash_size) ? ep->fd_hash_size * 2 : EP_HASH_MIN_SIZE;
+	hash = uk_malloc(ep->a, size * sizeof(*hash));
+	if (unlikely(!hash))
+		return;
+
+	for (i = 0; i < size; i++)
+		UK_INIT_HLIST_HEAD(&hash[i]);
+
+	uk_list_for_each(itr, &ep->fd_list) {
+		efd = uk_list_entry(itr, struct eventpoll_fd, fd_link);
+		uk_hlist_add_head(&efd->fd_hnode,
+				  efd_bucket(hash, size, efd->fd));
+	}
+
+	if (ep->fd_hash)
+		uk_free(ep->a, ep->fd_hash);
+
+	ep->fd_hash = hash;
+	ep->fd_hash_size = size;
+}
+
+/* Returns the events of the file description that are reported. A
+ * one-shot file description is disarmed after reporting an event until it
+ * is modified again.
+ */
+static inline unsigned int efd_filter(struct eventpoll_fd *efd)
+{
+	unsigned int events = (unsigned int)efd->event.events;
+
+	if (unlikely(!(events & ~EVENTPOLL_PRIVATE_BITS)))
+		return 0;
+
+	return events | EPERR_SET;
+}
+
+/* Checks the events requested for an fd, see epoll_ctl(2) */
+static int efd_check_events(const struct epoll_event *event)
+{
+	if ((event->events & EPOLLEXCLUSIVE) &&
+	    (event->events & ~EVENTPOLL_EXCLUSIVE_OK_BITS))
+		return -EINVAL;
+
+	return 0;
+}
+
+/* Queues the fd for eventpoll_wait() and wakes up waiting threads. If the fd
+ * is exclusive, only one thread is woken up.
+ *
+ * @return 0 if the fd is exclusive and no thread is waiting, 1 otherwise
+ */
+static int efd_trigger(struct eventpoll_fd *efd)
+{
+	struct eventpoll *ep = efd->ep;
+	int woken;
+
+	if (uk_list_empty(&efd->tr_link))
+		uk_list_add_tail(&efd->tr_link, &ep->tr_list);
+
+	if (efd->event.events & EPOLLEXCLUSIVE) {
+		/* Waiters enqueue themselves while holding fd_lock */
+		woken = !uk_waitq_empty(&ep->wq);
+		uk_waitq_wake_up_one(&ep->wq);
+		return woken;
+	}
+
+	uk_waitq_wake_up(&ep->wq);
+	return 1;
+}
+
 static int efd_poll(struct eventpoll_fd *efd, unsigned int *revents)
 {
 	struct vnode *vnode;
@@ -112,7 +222,7 @@ static int efd_poll(struct eventpoll_fd *efd, unsigned int *revents)
 	UK_ASSERT(efd->vfs_file);
 	vnode = efd->vfs_file->f_dentry->d_vnode;
 
-	filter = (unsigned int)efd->event.events | EPERR_SET;
+	filter = efd_filter(efd);
 
 	UK_ASSERT(vnode->v_op->vop_poll);
 	ret = VOP_POLL(vnode, revents, &efd->cb);
@@ -128,6 +238,24 @@ static int efd_poll(struct eventpoll_fd *efd, unsigned int *revents)
 	return 0;
 }
 
+unsigned int eventpoll_poll_file(struct vfscore_file *fp, unsigned int events)
+{
+	struct vnode *vnode;
+	unsigned int revents = 0;
+
+	UK_ASSERT(fp);
+	UK_ASSERT(fp->f_dentry);
+	vnode = fp->f_dentry->d_vnode;
+
+	if (!vnode->v_op->vop_poll)
+		return events & (EPOLLIN | EPOLLRDNORM | EPOLLOUT | EPOLLWRNORM);
+
+	if (unlikely(VOP_POLL(vnode, &revents, NULL)))
+		return EPOLLERR;
+
+	return revents & (events | EPERR_SET);
+}
+
 void eventpoll_add_unsafe(struct eventpoll *ep, struct eventpoll_fd *efd)
 {
 	UK_ASSERT(ep);
@@ -143,6 +271,16 @@ void eventpoll_add_unsafe(struct eventpoll *ep, struct eventpoll_fd *efd)
 
 	uk_list_add_tail(&efd->f_link, &efd->vfs_file->f_ep);
 	uk_list_add_tail(&efd->fd_link, &ep->fd_list);
+	ep->nfds++;
+
+	if (ep->fd_hash)
+		uk_hlist_add_head(&efd->fd_hnode,
+				  efd_bucket(ep->fd_hash, ep->fd_hash_size,
+					     efd->fd));
+
+	/* Keep the average chain in the fd index shorter than one */
+	if (ep->a && ep->nfds > ep->fd_hash_size)
+		efd_hash_grow(ep);
 
 	trace_efd_add(ep, efd->fd, efd->vfs_file->f_dentry->d_vnode->v_type);
 }
@@ -160,6 +298,10 @@ int eventpoll_add(struct eventpoll *ep, int fd, struct vfscore_file *fp,
 	if (unlikely(!event))
 		return -EINVAL;
 
+	ret = efd_check_events(event);
+	if (unlikely(ret))
+		return ret;
+
 	/* Allocate and initialize a new eventpoll fd
 	 *
 	 * TODO:
@@ -205,10 +347,7 @@ int eventpoll_add(struct eventpoll *ep, int fd, struct vfscore_file *fp,
 		trace_efd_signal(ep, efd->fd, revents,
 				 revents & efd->event.events);
 
-		if (uk_list_empty(&efd->tr_link))
-			uk_list_add_tail(&efd->tr_link, &ep->tr_list);
-
-		uk_waitq_wake_up(&ep->wq);
+		efd_trigger(efd);
 	}
 
 EXIT:
@@ -230,6 +369,10 @@ int eventpoll_mod(struct eventpoll *ep, int fd, const struct epoll_event *event)
 	if (unlikely(!event))
 		return -EINVAL;
 
+	/* The exclusive mode can only be set when adding the fd */
+	if (unlikely(event->events & EPOLLEXCLUSIVE))
+		return -EINVAL;
+
 	uk_mutex_lock(&ep->fd_lock);
 
 	efd = efd_find(ep, fd);
@@ -238,6 +381,11 @@ int eventpoll_mod(struct eventpoll *ep, int fd, const struct epoll_event *event)
 		goto EXIT;
 	}
 
+	if (unlikely(efd->event.events & EPOLLEXCLUSIVE)) {
+		ret = -EINVAL;
+		goto EXIT;
+	}
+
 	efd->event = *event;
 
 	/* We need to poll the fd here to check if the new configuration
@@ -252,10 +400,7 @@ int eventpoll_mod(struct eventpoll *ep, int fd, const struct epoll_event *event)
 		trace_efd_signal(ep, efd->fd, revents,
 				 revents & efd->event.events);
 
-		if (uk_list_empty(&efd->tr_link))
-			uk_list_add_tail(&efd->tr_link, &ep->tr_list);
-
-		uk_waitq_wake_up(&ep->wq);
+		efd_trigger(efd);
 	}
 
 EXIT:
@@ -276,6 +421,11 @@ void eventpoll_del_unsafe(struct eventpoll_fd *efd)
 	uk_list_del(&efd->f_link);
 	uk_list_del(&efd->tr_link);
 	uk_list_del(&efd->fd_link);
+	if (efd->ep->fd_hash)
+		uk_hlist_del(&efd->fd_hnode);
+
+	UK_ASSERT(efd->ep->nfds > 0);
+	efd->ep->nfds--;
 
 	trace_efd_del(efd->ep, efd->fd);
 
@@ -352,6 +502,7 @@ int eventpoll_wait(struct eventpoll *ep, struct epoll_event *events,
 {
 	struct eventpoll_fd *efd;
 	struct uk_list_head *itr, *tmp;
+	UK_LIST_HEAD(reported);
 	unsigned int revents = 0;
 	__nsec deadline;
 	int timedout;
@@ -378,6 +529,10 @@ int eventpoll_wait(struct eventpoll *ep, struct epoll_event *events,
 		 * in two cases:
 		 *   1) the fd is ready during eventpoll_mod
 		 *   2) the driver signals an event
+		 *
+		 * Reported level-triggered fds are moved to the end of the
+		 * list, so that they are not polled again in this scan and
+		 * do not starve other fds if maxevents is reached.
 		 */
 		uk_list_for_each_safe(itr, tmp, &ep->tr_list) {
 			efd = uk_list_entry(itr, struct eventpoll_fd, tr_link);
@@ -396,11 +551,21 @@ int eventpoll_wait(struct eventpoll *ep, struct epoll_event *events,
 				events[n].data = efd->event.data;
 				n++;
 
-				/* If the fd is edge-triggered we remove the fd
-				 * from the triggered list
+				/* A one-shot fd is disarmed until the next
+				 * eventpoll_mod. If the fd is edge-triggered or
+				 * disarmed we remove the fd from the triggered
+				 * list.
 				 */
-				if (efd->event.events & EPOLLET)
+				if (efd->event.events & EPOLLONESHOT)
+					efd->event.events &=
+						EVENTPOLL_PRIVATE_BITS;
+
+				if (efd->event.events &
+				    (EPOLLET | EPOLLONESHOT))
 					uk_list_del_init(&efd->tr_link);
+				else
+					uk_list_move_tail(&efd->tr_link,
+							  &reported);
 			} else {
 				/* The fd is not actually ready so remove it
 				 * from the triggered list
@@ -408,9 +573,16 @@ int eventpoll_wait(struct eventpoll *ep, struct epoll_event *events,
 				uk_list_del_init(&efd->tr_link);
 			}
 		}
-
-		if (n > 0)
+		uk_list_splice_tail_init(&reported, &ep->tr_list);
+
+		if (n > 0) {
+			/* Exclusive fds wake up only one thread. Pass the
+			 * wake up on if we could not report all events.
+			 */
+			if (n == maxevents && !uk_list_empty(&ep->tr_list))
+				uk_waitq_wake_up_one(&ep->wq);
 			break;
+		}
 
 		trace_ep_wait(ep, uk_thread_current());
 
@@ -430,11 +602,12 @@ int eventpoll_wait(struct eventpoll *ep, struct epoll_event *events,
 	return n;
 }
 
-void eventpoll_signal(struct eventpoll_cb *ecb, unsigned int revents)
+int eventpoll_signal(struct eventpoll_cb *ecb, unsigned int revents)
 {
 	struct eventpoll *ep;
 	struct eventpoll_fd *efd;
 	unsigned int filtered;
+	int woken = 0;
 
 	UK_ASSERT(ecb);
 
@@ -442,18 +615,46 @@ void eventpoll_signal(struct eventpoll_cb *ecb, unsigned int revents)
 	UK_ASSERT(efd->ep);
 	ep = efd->ep;
 
-	filtered = revents & ((unsigned int)efd->event.events | EPERR_SET);
-
 	uk_mutex_lock(&ep->fd_lock);
 
+	/* The filter changes with eventpoll_mod() and one-shot reports */
+	filtered = revents & efd_filter(efd);
+
 	trace_efd_signal(ep, efd->fd, revents, filtered);
 
-	if (filtered) {
-		if (uk_list_empty(&efd->tr_link))
-			uk_list_add_tail(&efd->tr_link, &ep->tr_list);
-
-		uk_waitq_wake_up(&ep->wq);
-	}
+	if (!(efd->event.events & EPOLLEXCLUSIVE))
+		woken = 1;
+	if (filtered)
+		woken = efd_trigger(efd);
 
 	uk_mutex_unlock(&ep->fd_lock);
+
+	return woken;
+}
+
+void eventpoll_signal_list(struct uk_list_head *ecb_list,
+			   unsigned int revents)
+{
+	struct eventpoll_fd *efd;
+	struct eventpoll_cb *ecb;
+	struct uk_list_head *itr;
+	int exclusive_woken = 0;
+
+	UK_ASSERT(ecb_list);
+
+	uk_list_for_each(itr, ecb_list) {
+		ecb = uk_list_entry(itr, struct eventpoll_cb, cb_link);
+		efd = __containerof(ecb, struct eventpoll_fd, cb);
+
+		UK_ASSERT(ecb->unregister);
+
+		/* The exclusive flag cannot change after adding the fd */
+		if (efd->event.events & EPOLLEXCLUSIVE) {
+			if (exclusive_woken)
+				continue;
+			exclusive_woken = eventpoll_signal(ecb, revents);
+		} else {
+			eventpoll_signal(ecb, revents);
+		}
+	}
 }
@@ -64,10 +64,23 @@ int vfs_read(struct vfscore_file *fp, struct uio *uio, int flags)
 	int error;
 	size_t count;
 	ssize_t bytes;
+	int shared;
 
 	bytes = uio->uio_resid;
 
-	vn_lock(vp);
+	/* Regular files are read in shared mode so that readers of the same
+	 * file do not serialize. Reads at the file offset still have to be
+	 * serialized on the open file to update the offset atomically.
+	 */
+	shared = (vp->v_type == VREG);
+	if (shared) {
+		if ((flags & FOF_OFFSET) == 0)
+			FD_LOCK(fp);
+		vn_lock_shared(vp);
+	} else {
+		vn_lock(vp);
+	}
+
 	if ((flags & FOF_OFFSET) == 0)
 		uio->uio_offset = fp->f_offset;
 
@@ -80,6 +93,9 @@ int vfs_read(struct vfscore_file *fp, struct uio *uio, int flags)
 	}
 	vn_unlock(vp);
 
+	if (shared && (flags & FOF_OFFSET) == 0)
+		FD_UNLOCK(fp);
+
 	return error;
 }
 
@@ -133,7 +149,7 @@ int vfs_stat(struct vfscore_file *fp, struct stat *st)
 	struct vnode *vp = fp->f_dentry->d_vnode;
 	int error;
 
-	vn_lock(vp);
+	vn_lock_shared(vp);
 	error = vn_stat(vp, st);
 	vn_unlock(vp);
 
@@ -54,6 +54,16 @@ struct vfscore_file;
 #define EPOLLNVAL	0x00000020	/* Invalid request: fd not open */
 #endif
 
+/* Flags that configure the eventpoll behavior rather than select events */
+#define EVENTPOLL_PRIVATE_BITS	(EPOLLWAKEUP | EPOLLONESHOT | EPOLLET | \
+				 EPOLLEXCLUSIVE)
+
+/* Flags that may be combined with EPOLLEXCLUSIVE */
+#define EVENTPOLL_EXCLUSIVE_OK_BITS					\
+	(EPOLLIN | EPOLLOUT | EPOLLRDNORM | EPOLLRDBAND | EPOLLWRNORM |	\
+	 EPOLLWRBAND | EPOLLERR | EPOLLHUP | EPOLLWAKEUP | EPOLLET |	\
+	 EPOLLEXCLUSIVE)
+
 /**
  * Eventpoll context block
  * Representation of an eventpoll file description towards VFS drivers
@@ -75,6 +85,9 @@ struct eventpoll_cb {
 	 * The driver must serialize calls to eventpoll_signal() with the
 	 * unregister operation to avoid races where an eventpoll is destroyed
 	 * while the driver is signaling an event.
+	 *
+	 * VOP_POLL() can be called without a context block (NULL) to only
+	 * query the current events, see eventpoll_poll_file().
 	 */
 	void (*unregister)(struct eventpoll_cb *ecb);
 
@@ -112,6 +125,9 @@ struct eventpoll_fd {
 	/* Used to link into monitored fd list */
 	struct uk_list_head fd_link;
 
+	/* Used to link into the fd index of the eventpoll */
+	struct uk_hlist_node fd_hnode;
+
 	/* Used to link into triggered list which is scanned by
 	 * eventpoll_wait() to find pending events. Being in the list, does not
 	 * guarantee that events are still pending.
@@ -147,6 +163,7 @@ static inline void eventpoll_fd_init(struct eventpoll_fd *efd,
 	UK_INIT_LIST_HEAD(&efd->cb.cb_link);
 
 	UK_INIT_LIST_HEAD(&efd->fd_link);
+	UK_INIT_HLIST_NODE(&efd->fd_hnode);
 	UK_INIT_LIST_HEAD(&efd->tr_link);
 	UK_INIT_LIST_HEAD(&efd->f_link);
 }
@@ -166,6 +183,18 @@ struct eventpoll {
 	/* List of monitored fds */
 	struct uk_list_head fd_list;
 
+	/* Index of the monitored fds by fd number. It is allocated with the
+	 * allocator of the eventpoll when fds are added. Without an index,
+	 * the fd list is searched.
+	 */
+	struct uk_hlist_head *fd_hash;
+
+	/* Number of buckets in the fd index, a power of two */
+	unsigned int fd_hash_size;
+
+	/* Number of monitored fds */
+	unsigned int nfds;
+
 	/* List of triggered fds */
 	struct uk_list_head tr_list;
 
@@ -187,6 +216,9 @@ static inline void eventpoll_init(struct eventpoll *ep, struct uk_alloc *a)
 
 	uk_mutex_init(&ep->fd_lock);
 	UK_INIT_LIST_HEAD(&ep->fd_list);
+	ep->fd_hash = NULL;
+	ep->fd_hash_size = 0;
+	ep->nfds = 0;
 	UK_INIT_LIST_HEAD(&ep->tr_list);
 	uk_waitq_init(&ep->wq);
 }
@@ -225,7 +257,9 @@ int eventpoll_add(struct eventpoll *ep, int fd, struct vfscore_file *fp,
 /**
  * Update the epoll event for a watched file description. This will trigger a
  * poll on the underlying VFS file to check if there are pending events based
- * on the updated epoll event object.
+ * on the updated epoll event object. A file description that has been added
+ * with EPOLLEXCLUSIVE cannot be modified. Modifying a one-shot file
+ * description arms it again.
  *
  * @param ep the eventpoll to which the watched file descriptor belongs
  * @param fd the file descriptor for which to update the epoll event object
@@ -299,8 +333,38 @@ int eventpoll_wait(struct eventpoll *ep, struct epoll_event *events,
  *
  * @param ecb the eventpoll context block supplied in the poll call
  * @param revents a bitmask specifying all the active epoll events for this file
+ *
+ * @return 0 if the file description is registered with EPOLLEXCLUSIVE and no
+ *    thread was woken up, 1 otherwise
+ */
+int eventpoll_signal(struct eventpoll_cb *ecb, unsigned int revents);
+
+/**
+ * Signal events for all eventpoll context blocks in a driver's signal list,
+ * linked with their `cb_link`. Of the file descriptions that are registered
+ * with EPOLLEXCLUSIVE, only the ones up to the first that wakes up a thread
+ * are signaled. The caller must serialize the call with modifications of the
+ * list.
+ *
+ * @param ecb_list the list of eventpoll context blocks to signal
+ * @param revents a bitmask specifying all the active epoll events for the file
+ */
+void eventpoll_signal_list(struct uk_list_head *ecb_list,
+			   unsigned int revents);
+
+/**
+ * Query the pending events of a VFS file without registering for signaling.
+ * This is the fast path for poll() and select() if file descriptors are
+ * ready already. Files without a poll operation are always ready for reading
+ * and writing.
+ *
+ * @param fp the VFS file object to poll
+ * @param events the epoll events of interest. Errors and hang ups are always
+ *    reported
+ *
+ * @return the pending events of interest, EPOLLERR if the poll failed
  */
-void eventpoll_signal(struct eventpoll_cb *ecb, unsigned int revents);
+unsigned int eventpoll_poll_file(struct vfscore_file *fp, unsigned int events);
 
 /**
  * @internal Called by VFS to inform the eventpoll API that a file description
@@ -38,6 +38,7 @@
 #include <sys/types.h>
 #include <vfscore/dentry.h>
 #include <uk/list.h>
+#include <uk/config.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -82,7 +83,7 @@ int fdrop(struct vfscore_file* fp);
 #define FOF_OFFSET  0x0800    /* Use the offset in uio argument */
 
 /* Also used from posix-sysinfo to determine sysconf(_SC_OPEN_MAX). */
-#define FDTABLE_MAX_FILES 1024
+#define FDTABLE_MAX_FILES CONFIG_LIBVFSCORE_MAX_FILES
 
 #ifdef __cplusplus
 }
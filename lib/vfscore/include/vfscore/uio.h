@@ -48,6 +48,9 @@ enum	uio_rw { UIO_READ, UIO_WRITE };
 
 #define UIO_MAXIOV 1024
 
+/* Number of iovecs that sys_read() and sys_write() copy on the stack */
+#define UIO_FASTIOV 8
+
 #define UIO_SYSSPACE 0
 
 struct uio {
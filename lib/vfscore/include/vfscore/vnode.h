@@ -37,6 +37,7 @@
 #include <dirent.h>
 
 #include <uk/mutex.h>
+#include <uk/rwlock.h>
 #include <uk/list.h>
 #include <uk/config.h>
 #include <time.h>
@@ -83,7 +84,7 @@ struct vnode {
 	int		v_flags;	/* vnode flag */
 	mode_t		v_mode;		/* file mode */
 	off_t		v_size;		/* file size */
-	struct uk_mutex	v_lock;		/* lock for this vnode */
+	struct uk_rwlock v_lock;	/* lock for this vnode */
 	struct uk_list_head v_names;	/* directory entries pointing at this */
 	void		*v_data;	/* private data for fs */
 };
@@ -247,6 +248,7 @@ int vfscore_vop_eperm();
 int vfscore_vop_erofs();
 struct vnode *vn_lookup(struct mount *, uint64_t);
 void	 vn_lock(struct vnode *);
+void	 vn_lock_shared(struct vnode *);
 void	 vn_unlock(struct vnode *);
 int	 vn_stat(struct vnode *, struct stat *);
 int	 vn_settimes(struct vnode *, struct timespec[2]);
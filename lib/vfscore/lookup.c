@@ -50,7 +50,7 @@ read_link(struct vnode *vp, char *buf, size_t bufsz, ssize_t *sz)
 	int rc;
 
 	*sz = 0;
-	vn_lock(vp);
+	vn_lock_shared(vp);
 	rc  = VOP_READLINK(vp, &uio);
 	vn_unlock(vp);
 
@@ -181,8 +181,18 @@ namei(const char *path, struct dentry **dpp)
 			strlcat(node, "/", sizeof(node));
 			strlcat(node, name, sizeof(node));
 			dvp = ddp->d_vnode;
-			vn_lock(dvp);
+			vn_lock_shared(dvp);
 			dp = dentry_lookup(mp, node);
+			if (dp == NULL) {
+				/*
+				 * Populating the cache requires the exclusive
+				 * lock. Another thread may have added the entry
+				 * while we were not holding the lock.
+				 */
+				vn_unlock(dvp);
+				vn_lock(dvp);
+				dp = dentry_lookup(mp, node);
+			}
 			if (dp == NULL) {
 				/* Find a vnode in this directory. */
 				error = VOP_LOOKUP(dvp, name, &vp);
@@ -287,8 +297,14 @@ namei_last_nofollow(char *path, struct dentry *ddp, struct dentry **dpp)
 	}
 
 	dvp = ddp->d_vnode;
-	vn_lock(dvp);
+	vn_lock_shared(dvp);
 	dp = dentry_lookup(mp, node);
+	if (dp == NULL) {
+		/* Populating the cache requires the exclusive lock */
+		vn_unlock(dvp);
+		vn_lock(dvp);
+		dp = dentry_lookup(mp, node);
+	}
 	if (dp == NULL) {
 		error = VOP_LOOKUP(dvp, name, &vp);
 		if (error != 0) {
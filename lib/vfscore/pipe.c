@@ -212,7 +212,7 @@ static unsigned long pipe_buf_read(struct pipe_buf *pipe_buf,
 		int second_copy_bytes;
 
 		/* Copy the first part */
-		first_copy_bytes = pipe_buf->capacity - pipe_buf->cons;
+		first_copy_bytes = pipe_buf->capacity - cons_idx;
 		memcpy(iovec_data,
 				pipe_buf->data + cons_idx,
 				first_copy_bytes);
@@ -264,19 +264,10 @@ void pipe_file_free(struct pipe_file *pipe_file)
 static void
 pipe_file_event(struct pipe_file *pipe_file, unsigned int event)
 {
-	struct eventpoll_cb *ecb;
-	struct uk_list_head *itr;
-
 	UK_ASSERT(pipe_file);
 
 	uk_mutex_lock(&pipe_file->evp_lock);
-	uk_list_for_each(itr, &pipe_file->evp_list) {
-		ecb = uk_list_entry(itr, struct eventpoll_cb, cb_link);
-
-		UK_ASSERT(ecb->unregister);
-
-		eventpoll_signal(ecb, event);
-	}
+	eventpoll_signal_list(&pipe_file->evp_list, event);
 	uk_mutex_unlock(&pipe_file->evp_lock);
 }
 
@@ -502,6 +493,8 @@ pipe_poll(struct vnode *vnode, unsigned int *revents,
 	UK_ASSERT(revents);
 
 	*revents = get_pipe_file_events(pipe_file);
+	if (!ecb)
+		return 0;
 
 	uk_mutex_lock(&pipe_file->evp_lock);
 	if (!ecb->unregister) {
@@ -613,7 +606,7 @@ static int pipe_fd_alloc(struct pipe_file *pipe_file, int flags)
 		goto ERR_ALLOC_VNODE;
 	}
 
-	uk_mutex_unlock(&p_vnode->v_lock);
+	vn_unlock(p_vnode);
 
 	p_dentry = dentry_alloc(NULL, p_vnode, "/");
 	if (!p_dentry) {
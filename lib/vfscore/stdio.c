@@ -204,7 +204,6 @@ static struct vnops stdio_vnops = {
 static struct vnode stdio_vnode = {
 	.v_ino = 1,
 	.v_op = &stdio_vnops,
-	.v_lock = UK_MUTEX_INITIALIZER(stdio_vnode.v_lock),
 	.v_refcnt = 1,
 	.v_link = UK_LIST_HEAD_INIT(stdio_vnode.v_link),
 	.v_names = UK_LIST_HEAD_INIT(stdio_vnode.v_names),
@@ -232,6 +231,8 @@ int init_stdio(void)
 {
 	int fd;
 
+	uk_rwlock_init(&stdio_vnode.v_lock);
+
 	fd = vfscore_alloc_fd();
 	if (fd != 0) {
 		uk_pr_crit("failed to allocate fd for stdin (fd=0)\n");
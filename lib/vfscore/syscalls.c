@@ -243,11 +243,38 @@ sys_close(struct vfscore_file *fp __unused)
 	return 0;
 }
 
+/*
+ * The VOP_READ() and VOP_WRITE() implementations advance the iovecs of the
+ * uio in place, so they work on a copy of the caller's array. Short arrays
+ * are copied to `fast_iov` on the stack of the caller.
+ */
+static struct iovec *
+iov_copy(struct iovec *fast_iov, const struct iovec *iov, size_t niov)
+{
+	struct iovec *copy_iov = fast_iov;
+
+	if (unlikely(niov > UIO_FASTIOV)) {
+		copy_iov = malloc(sizeof(struct iovec) * niov);
+		if (!copy_iov)
+			return NULL;
+	}
+	memcpy(copy_iov, iov, sizeof(struct iovec) * niov);
+	return copy_iov;
+}
+
+static inline void
+iov_release(struct iovec *fast_iov, struct iovec *copy_iov)
+{
+	if (unlikely(copy_iov != fast_iov))
+		free(copy_iov);
+}
+
 int
 sys_read(struct vfscore_file *fp, const struct iovec *iov, size_t niov,
 		off_t offset, size_t *count)
 {
 	int error = 0;
+	struct iovec fast_iov[UIO_FASTIOV];
 	struct iovec *copy_iov;
 	if ((fp->f_flags & UK_FREAD) == 0)
 		return EBADF;
@@ -269,17 +296,10 @@ sys_read(struct vfscore_file *fp, const struct iovec *iov, size_t niov,
 	}
 
 	struct uio uio;
-	/* TODO: is it necessary to copy iov within Unikraft?
-	 * OSv did this, mentioning this reason:
-	 *
-	 * "Unfortunately, the current implementation of fp->read
-	 *  zeros the iov_len fields when it reads from disk, so we
-	 *  have to copy iov. "
-	 */
-	copy_iov = calloc(sizeof(struct iovec), niov);
+
+	copy_iov = iov_copy(fast_iov, iov, niov);
 	if (!copy_iov)
 		return ENOMEM;
-	memcpy(copy_iov, iov, sizeof(struct iovec)*niov);
 
 	uio.uio_iov = copy_iov;
 	uio.uio_iovcnt = niov;
@@ -289,7 +309,7 @@ sys_read(struct vfscore_file *fp, const struct iovec *iov, size_t niov,
 	error = vfs_read(fp, &uio, (offset == -1) ? 0 : FOF_OFFSET);
 	*count = bytes - uio.uio_resid;
 
-	free(copy_iov);
+	iov_release(fast_iov, copy_iov);
 	return error;
 }
 
@@ -297,6 +317,7 @@ int
 sys_write(struct vfscore_file *fp, const struct iovec *iov, size_t niov,
 		off_t offset, size_t *count)
 {
+	struct iovec fast_iov[UIO_FASTIOV];
 	struct iovec *copy_iov;
 	int error = 0;
 	if ((fp->f_flags & UK_FWRITE) == 0)
@@ -319,16 +340,9 @@ sys_write(struct vfscore_file *fp, const struct iovec *iov, size_t niov,
 
 	struct uio uio;
 
-	/* TODO: same note as in sys_read. Original comment:
-	 *
-	 * "Unfortunately, the current implementation of fp->write zeros the
-	 *  iov_len fields when it writes to disk, so we have to copy iov.
-	 */
-	/* std::vector<iovec> copy_iov(iov, iov + niov); */
-	copy_iov = calloc(sizeof(struct iovec), niov);
+	copy_iov = iov_copy(fast_iov, iov, niov);
 	if (!copy_iov)
 		return ENOMEM;
-	memcpy(copy_iov, iov, sizeof(struct iovec)*niov);
 
 	uio.uio_iov = copy_iov;
 	uio.uio_iovcnt = niov;
@@ -338,7 +352,7 @@ sys_write(struct vfscore_file *fp, const struct iovec *iov, size_t niov,
 	error = vfs_write(fp, &uio, (offset == -1) ? 0 : FOF_OFFSET);
 	*count = bytes - uio.uio_resid;
 
-	free(copy_iov);
+	iov_release(fast_iov, copy_iov);
 	return error;
 }
 
@@ -1276,7 +1290,7 @@ sys_readlink(char *path, char *buf, size_t bufsize, ssize_t *size)
 	uio.uio_rw	= UIO_READ;
 
 	vp = dp->d_vnode;
-	vn_lock(vp);
+	vn_lock_shared(vp);
 	error = VOP_READLINK(vp, &uio);
 	vn_unlock(vp);
 
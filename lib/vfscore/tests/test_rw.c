@@ -0,0 +1,177 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2023, Unikraft GmbH and The Unikraft Authors.
+ * Licensed under the BSD-3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ */
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mount.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <uk/test.h>
+#include <uk/essentials.h>
+#include <uk/syscall.h>
+#include <uk/plat/time.h>
+#include <vfscore/uio.h>
+
+#define TEST_MNT	"/vfscore_test"
+#define TEST_FILE	TEST_MNT "/rw"
+
+#define BUF_SIZE	(64 * 1024)
+
+/* Number of calls per benchmark measurement */
+#define BENCH_ROUNDS	1000
+
+static char buf[BUF_SIZE];
+static char cmp[BUF_SIZE];
+
+static const size_t sizes[] = { 1, 64, 512, 4096, 16384, BUF_SIZE };
+
+static int test_file_open(void)
+{
+	if (mkdir(TEST_MNT, 0777) && errno != EEXIST)
+		return -1;
+	if (mount("", TEST_MNT, "ramfs", 0, NULL) && errno != EBUSY)
+		return -1;
+	return open(TEST_FILE, O_RDWR | O_CREAT | O_TRUNC, 0666);
+}
+
+static void fill_pattern(char *p, size_t len, unsigned int seed)
+{
+	size_t i;
+
+	for (i = 0; i < len; ++i)
+		p[i] = (char)(i * 7 + seed);
+}
+
+UK_TESTCASE(vfscore_rw, readv_writev_iovs)
+{
+	struct iovec iov[UIO_FASTIOV * 2], saved[UIO_FASTIOV * 2];
+	size_t i, off, total;
+	int fd;
+
+	fd = test_file_open();
+	UK_TEST_EXPECT(fd >= 0);
+
+	/* Stack (UIO_FASTIOV) and heap copies of the iovec array; the
+	 * caller's array must not be modified by either
+	 */
+	for (int niov = 1; niov <= (int)ARRAY_SIZE(iov);
+	     niov += UIO_FASTIOV - 1) {
+		fill_pattern(buf, BUF_SIZE, niov);
+		for (i = 0, off = 0; i < (size_t)niov; ++i) {
+			iov[i].iov_base = buf + off;
+			iov[i].iov_len = 3 + i * 11;
+			off += iov[i].iov_len;
+		}
+		total = off;
+		memcpy(saved, iov, sizeof(iov));
+
+		UK_TEST_EXPECT_SNUM_EQ(pwritev(fd, iov, niov, 0), total);
+		UK_TEST_EXPECT_ZERO(memcmp(saved, iov, niov * sizeof(*iov)));
+
+		for (i = 0, off = 0; i < (size_t)niov; ++i) {
+			iov[i].iov_base = cmp + off;
+			off += iov[i].iov_len;
+		}
+		memcpy(saved, iov, sizeof(iov));
+		memset(cmp, 0, BUF_SIZE);
+
+		UK_TEST_EXPECT_SNUM_EQ(preadv(fd, iov, niov, 0), total);
+		UK_TEST_EXPECT_ZERO(memcmp(saved, iov, niov * sizeof(*iov)));
+		UK_TEST_EXPECT_ZERO(memcmp(buf, cmp, total));
+	}
+
+	close(fd);
+}
+
+/* Returns the average duration of a call in ns */
+static __nsec bench_file(int fd, size_t len, int wr)
+{
+	ssize_t res = 0;
+	__nsec start;
+	int i;
+
+	start = ukplat_monotonic_clock();
+	for (i = 0; i < BENCH_ROUNDS && res >= 0; ++i)
+		res = wr ? pwrite(fd, buf, len, 0) : pread(fd, buf, len, 0);
+	return (ukplat_monotonic_clock() - start) / BENCH_ROUNDS;
+}
+
+/* Moves `len` bytes through the pipe, returns the number of calls */
+static unsigned long pipe_xfer(int fds[2], size_t len)
+{
+	unsigned long calls = 0;
+	ssize_t n;
+
+	while (len) {
+		n = write(fds[1], buf, len);
+		if (n <= 0)
+			break;
+		len -= n;
+		calls++;
+		while (n > 0) {
+			ssize_t r = read(fds[0], cmp, n);
+
+			if (r <= 0)
+				return calls;
+			n -= r;
+			calls++;
+		}
+	}
+	return calls;
+}
+
+/* Returns the average duration of a write or read call in ns */
+static __nsec bench_pipe(int fds[2], size_t len)
+{
+	unsigned long calls = 0;
+	__nsec start;
+	int i;
+
+	start = ukplat_monotonic_clock();
+	for (i = 0; i < BENCH_ROUNDS; ++i)
+		calls += pipe_xfer(fds, len);
+	return calls ? (ukplat_monotonic_clock() - start) / calls : 0;
+}
+
+/* Reports the per-call overhead of read() and write() */
+UK_TESTCASE(vfscore_rw, benchmark)
+{
+	__nsec t_fwr, t_frd, t_pipe;
+	size_t i, len;
+	int fds[2];
+	int fd;
+
+	fd = test_file_open();
+	UK_TEST_EXPECT(fd >= 0);
+	UK_TEST_EXPECT_ZERO(uk_syscall_r_pipe2((long) fds, O_NONBLOCK));
+
+	fill_pattern(buf, BUF_SIZE, 1);
+	UK_TEST_EXPECT_SNUM_EQ(pwrite(fd, buf, BUF_SIZE, 0), BUF_SIZE);
+
+	for (i = 0; i < ARRAY_SIZE(sizes); ++i) {
+		len = sizes[i];
+		t_fwr = bench_file(fd, len, 1);
+		t_frd = bench_file(fd, len, 0);
+		t_pipe = bench_pipe(fds, len);
+		uk_test_printf("%6zu B: ramfs write %8"__PRInsec" ns, read %8"
+			       __PRInsec" ns, pipe %8"__PRInsec" ns/call\n",
+			       len, t_fwr, t_frd, t_pipe);
+	}
+
+	/* The benchmark only reports numbers; check that the data arrived */
+	UK_TEST_EXPECT_SNUM_EQ(pread(fd, cmp, BUF_SIZE, 0), BUF_SIZE);
+	UK_TEST_EXPECT_ZERO(memcmp(buf, cmp, BUF_SIZE));
+
+	close(fds[0]);
+	close(fds[1]);
+	close(fd);
+}
+
+uk_testsuite_register(vfscore_rw, NULL);
@@ -120,7 +120,7 @@ vn_lookup(struct mount *mp, uint64_t ino)
 	uk_list_for_each_entry(vp, &vnode_table[vn_hash(mp, ino)], v_link) {
 		if (vp->v_mount == mp && vp->v_ino == ino) {
 			vp->v_refcnt++;
-			uk_mutex_lock(&vp->v_lock);
+			uk_rwlock_wlock(&vp->v_lock);
 			return vp;
 		}
 	}
@@ -142,7 +142,7 @@ vn_path(struct vnode *vp)
 #endif
 
 /*
- * Lock vnode
+ * Lock vnode exclusively
  */
 void
 vn_lock(struct vnode *vp)
@@ -150,12 +150,27 @@ vn_lock(struct vnode *vp)
 	UK_ASSERT(vp);
 	UK_ASSERT(vp->v_refcnt > 0);
 
-	uk_mutex_lock(&vp->v_lock);
+	uk_rwlock_wlock(&vp->v_lock);
 	DPRINTF(VFSDB_VNODE, ("vn_lock:   %s\n", vn_path(vp)));
 }
 
 /*
- * Unlock vnode
+ * Lock vnode in shared mode. Only operations that do not modify the vnode
+ * or its file system node (read, getattr, readlink, and lookups that hit
+ * the dentry cache) may be done in shared mode.
+ */
+void
+vn_lock_shared(struct vnode *vp)
+{
+	UK_ASSERT(vp);
+	UK_ASSERT(vp->v_refcnt > 0);
+
+	uk_rwlock_rlock(&vp->v_lock);
+	DPRINTF(VFSDB_VNODE, ("vn_lock_shared:   %s\n", vn_path(vp)));
+}
+
+/*
+ * Unlock vnode, either mode
  */
 void
 vn_unlock(struct vnode *vp)
@@ -163,7 +178,11 @@ vn_unlock(struct vnode *vp)
 	UK_ASSERT(vp);
 	UK_ASSERT(vp->v_refcnt >= 0);
 
-	uk_mutex_unlock(&vp->v_lock);
+	/* The lock is held by the caller, so a writer can only be us */
+	if (vp->v_lock.nactive < 0)
+		uk_rwlock_wunlock(&vp->v_lock);
+	else
+		uk_rwlock_runlock(&vp->v_lock);
 	DPRINTF(VFSDB_VNODE, ("vn_lock:   %s\n", vn_path(vp)));
 }
 
@@ -202,7 +221,7 @@ vfscore_vget(struct mount *mp, uint64_t ino, struct vnode **vpp)
 	vp->v_mount = mp;
 	vp->v_refcnt = 1;
 	vp->v_op = mp->m_op->vfs_vnops;
-	uk_mutex_init(&vp->v_lock);
+	uk_rwlock_init(&vp->v_lock);
 	/*
 	 * Request to allocate fs specific data for vnode.
 	 */
@@ -212,7 +231,7 @@ vfscore_vget(struct mount *mp, uint64_t ino, struct vnode **vpp)
 		return 0;
 	}
 	vfs_busy(vp->v_mount);
-	uk_mutex_lock(&vp->v_lock);
+	uk_rwlock_wlock(&vp->v_lock);
 
 	uk_list_add(&vp->v_link, &vnode_table[vn_hash(mp, ino)]);
 	VNODE_UNLOCK();
@@ -248,7 +267,7 @@ vput(struct vnode *vp)
 	if (vp->v_op->vop_inactive)
 		VOP_INACTIVE(vp);
 	vfs_unbusy(vp->v_mount);
-	uk_mutex_unlock(&vp->v_lock);
+	vn_unlock(vp);
 	free(vp);
 }
 
@@ -61,6 +61,35 @@
 #define DEVFN(dev, fn)   ((dev << PCI_FN_BIT_NBR) | fn)
 #define SIZE_PER_PCI_DEV 0x20	/* legacy pci device size, no msi */
 
+int pci_conf_read(struct pci_device *dev, int where, int size, __u32 *val)
+{
+	UK_ASSERT(dev && val);
+
+	*val = 0;
+	if (unlikely(size != 1 && size != 2 && size != 4))
+		return -EINVAL;
+	if (unlikely(pci_generic_config_read(dev->addr.bus,
+					     DEVFN(dev->addr.devid,
+						   dev->addr.function),
+					     where, size, val)))
+		return -EIO;
+	return 0;
+}
+
+int pci_conf_write(struct pci_device *dev, int where, int size, __u32 val)
+{
+	UK_ASSERT(dev);
+
+	if (unlikely(size != 1 && size != 2 && size != 4))
+		return -EINVAL;
+	if (unlikely(pci_generic_config_write(dev->addr.bus,
+					      DEVFN(dev->addr.devid,
+						    dev->addr.function),
+					      where, size, val)))
+		return -EIO;
+	return 0;
+}
+
 static int arch_pci_driver_add_device(struct pci_driver *drv,
 					struct pci_address *addr,
 					struct pci_device_id *devid,
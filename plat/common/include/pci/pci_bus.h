@@ -69,6 +69,9 @@
 #include <uk/bus.h>
 #include <uk/alloc.h>
 #include <uk/ctors.h>
+#include <uk/arch/types.h>
+#include <uk/plat/lcpu.h>
+#include <uk/plat/irq.h>
 
 /**
  * A structure describing an ID for a PCI driver. Each driver provides a
@@ -295,6 +298,146 @@ static struct pci_bus_handler ph __unused;
 #define PCI_MIN_GNT		0x3e	/* 8 bits */
 #define PCI_MAX_LAT		0x3f	/* 8 bits */
 
+#define PCI_STATUS		0x06	/* 16 bits */
+#define  PCI_STATUS_CAP_LIST	0x10	/* Support Capability List */
+
+#define  PCI_BASE_ADDRESS_SPACE_IO	0x01
+#define  PCI_BASE_ADDRESS_MEM_TYPE_MASK	0x06
+#define  PCI_BASE_ADDRESS_MEM_TYPE_64	0x04	/* 64 bit address */
+#define  PCI_BASE_ADDRESS_MEM_MASK	(~0x0fU)
+
+/* Capability lists */
+#define PCI_CAP_LIST_ID		0	/* Capability ID */
+#define  PCI_CAP_ID_VNDR	0x09	/* Vendor-Specific */
+#define  PCI_CAP_ID_MSIX	0x11	/* MSI-X */
+#define PCI_CAP_LIST_NEXT	1	/* Next capability in the list */
+
+/* MSI-X capability */
+#define PCI_MSIX_FLAGS		2	/* Message Control, 16 bits */
+#define  PCI_MSIX_FLAGS_QSIZE	0x07ff	/* Table size - 1 */
+#define  PCI_MSIX_FLAGS_MASKALL	0x4000	/* Mask all vectors */
+#define  PCI_MSIX_FLAGS_ENABLE	0x8000	/* MSI-X enable */
+#define PCI_MSIX_TABLE		4	/* Table offset and BAR, 32 bits */
+#define  PCI_MSIX_TABLE_BIR	0x00000007
+#define  PCI_MSIX_TABLE_OFFSET	0xfffffff8
+
+/* MSI-X table entry */
+#define PCI_MSIX_ENTRY_SIZE		16
+#define PCI_MSIX_ENTRY_LOWER_ADDR	0
+#define PCI_MSIX_ENTRY_UPPER_ADDR	4
+#define PCI_MSIX_ENTRY_DATA		8
+#define PCI_MSIX_ENTRY_VECTOR_CTRL	12
+#define  PCI_MSIX_ENTRY_CTRL_MASKBIT	0x1
+
 struct pci_driver *pci_find_driver(struct pci_device_id *id);
 
+/**
+ * Reads from the configuration space of a PCI device. Implemented by the
+ * architecture-specific bus code.
+ *
+ * @param dev the PCI device
+ * @param where byte offset into the configuration space
+ * @param size access width in bytes (1, 2, or 4)
+ * @param[out] val the value read, zero-extended
+ * @return 0 on success, a negative errno value on errors
+ */
+int pci_conf_read(struct pci_device *dev, int where, int size, __u32 *val);
+
+/**
+ * Writes to the configuration space of a PCI device. Implemented by the
+ * architecture-specific bus code.
+ *
+ * @param dev the PCI device
+ * @param where byte offset into the configuration space
+ * @param size access width in bytes (1, 2, or 4)
+ * @param val the value to write
+ * @return 0 on success, a negative errno value on errors
+ */
+int pci_conf_write(struct pci_device *dev, int where, int size, __u32 val);
+
+/**
+ * Searches the capability list of a PCI device.
+ *
+ * @param dev the PCI device
+ * @param pos offset of the capability after which the search starts, or 0
+ *    to start at the head of the list
+ * @param cap_id the capability ID to look for (PCI_CAP_ID_*)
+ * @return the configuration space offset of the capability, or 0 if there
+ *    is no (further) capability with the given ID
+ */
+__u8 pci_find_next_cap(struct pci_device *dev, __u8 pos, __u8 cap_id);
+
+static inline __u8 pci_find_cap(struct pci_device *dev, __u8 cap_id)
+{
+	return pci_find_next_cap(dev, 0, cap_id);
+}
+
+/**
+ * Sizes a memory BAR of a PCI device, enables memory decoding, and maps the
+ * region into the address space.
+ *
+ * @param dev the PCI device
+ * @param bar the BAR index (0-5). A 64-bit BAR occupies two indices and is
+ *    referred to by the lower one
+ * @param[out] addr the virtual address of the region
+ * @param[out] len the length of the region
+ * @return 0 on success, -ENODEV if the BAR is not implemented or has no
+ *    address assigned, -ENOTSUP for I/O BARs, other negative errno values on
+ *    errors
+ */
+int pci_bar_map(struct pci_device *dev, int bar, void **addr, __sz *len);
+
+/**
+ * MSI-X state of a PCI device
+ */
+struct pci_msix {
+	struct pci_device *dev;
+	/** Configuration space offset of the MSI-X capability */
+	__u8 cap;
+	/** Number of table entries */
+	__u16 nvec;
+	/** The mapped MSI-X table */
+	volatile __u8 *table;
+};
+
+/**
+ * Locates and maps the MSI-X table of a PCI device and masks all its
+ * vectors. MSI-X stays disabled until pci_msix_enable() is called.
+ *
+ * @return 0 on success, -ENOTSUP if the device has no MSI-X capability,
+ *    other negative errno values on errors
+ */
+int pci_msix_init(struct pci_device *dev, struct pci_msix *msix);
+
+/**
+ * Sets up an MSI-X vector: Allocates an MSI IRQ, registers the handler for
+ * it, and routes the vector to the given logical CPU. The vector is unmasked
+ * on success.
+ *
+ * @param msix the MSI-X state initialized with pci_msix_init()
+ * @param vec the table entry
+ * @param lcpuidx index of the logical CPU that handles the interrupt
+ * @param func the interrupt handler
+ * @param arg the argument passed to `func`
+ * @return 0 on success, a negative errno value on errors
+ */
+int pci_msix_vector_setup(struct pci_msix *msix, __u16 vec,
+			  __lcpuidx lcpuidx, irq_handler_func_t func,
+			  void *arg);
+
+/**
+ * Masks or unmasks a single MSI-X vector.
+ */
+void pci_msix_vector_mask(struct pci_msix *msix, __u16 vec, int mask);
+
+/**
+ * Enables MSI-X for the device. This also disables INTx delivery.
+ */
+void pci_msix_enable(struct pci_msix *msix);
+
+/**
+ * Disables MSI-X for the device and re-enables INTx delivery.
+ */
+void pci_msix_disable(struct pci_msix *msix);
+
 #endif /* __UKPLAT_COMMON_PCI_BUS_H__ */
@@ -34,6 +34,7 @@
 #define __PLAT_CMN_IRQ_H__
 
 #include <uk/plat/irq.h>
+#include <uk/plat/lcpu.h>
 
 #if defined(__X86_64__)
 #include <x86/irq.h>
@@ -68,4 +69,28 @@ enum uk_irq_polarity {
  */
 void _ukplat_irq_handle(struct __regs *regs, unsigned long irq);
 
+/**
+ * Allocates an IRQ that is raised by message signaled interrupts (MSI/MSI-X)
+ * instead of an interrupt line. Handlers are registered for it with
+ * ukplat_irq_register() as usual.
+ *
+ * @param[out] irq the allocated IRQ
+ * @return 0 on success, -ENOSPC if all MSI IRQs are in use, -ENOTSUP if the
+ *    platform cannot deliver MSIs
+ */
+int ukplat_irq_msi_alloc(unsigned long *irq);
+
+/**
+ * Composes the message that a device has to write to raise an MSI IRQ on the
+ * given logical CPU.
+ *
+ * @param irq IRQ returned by ukplat_irq_msi_alloc()
+ * @param lcpuidx index of the logical CPU that handles the interrupt
+ * @param[out] addr the message address
+ * @param[out] data the message data
+ * @return 0 on success, a negative errno value on errors
+ */
+int ukplat_irq_msi_compose(unsigned long irq, __lcpuidx lcpuidx,
+			   __u64 *addr, __u32 *data);
+
 #endif /* __PLAT_CMN_IRQ_H__ */
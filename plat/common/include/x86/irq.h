@@ -90,6 +90,14 @@ static inline int irqs_disabled(void)
 #define local_irq_enable()       __sti()
 #define local_irq_enable_halt()  __sti_hlt()
 
-#define __MAX_IRQ	16
+/* IRQs 0-15 are routed through the legacy 8259 PIC */
+#define X86_PIC_IRQS		16
+/* IRQs from X86_MSI_IRQ_BASE on are message signaled interrupts (MSIs)
+ * that are delivered through the local APIC
+ */
+#define X86_MSI_IRQ_BASE	X86_PIC_IRQS
+#define X86_MSI_IRQS		32
+
+#define __MAX_IRQ	(X86_MSI_IRQ_BASE + X86_MSI_IRQS)
 
 #endif /* __PLAT_CMN_X86_IRQ_H__ */
@@ -52,8 +52,13 @@
  */
 
 #include <string.h>
+#include <errno.h>
 #include <uk/print.h>
 #include <uk/plat/common/cpu.h>
+#include <uk/plat/common/irq.h>
+#ifdef CONFIG_PAGING
+#include <uk/plat/paging.h>
+#endif /* CONFIG_PAGING */
 #include <pci/pci_bus.h>
 
 extern int arch_pci_probe(struct uk_alloc *pha);
@@ -123,6 +128,265 @@ struct pci_driver *pci_find_driver(struct pci_device_id *id)
 	return NULL; /* no driver found */
 }
 
+/* Bounds the capability list walk in case of a malformed (cyclic) list */
+#define PCI_CAP_MAX_ENTRIES	48
+#define PCI_CAP_MIN_OFFSET	0x40
+
+__u8 pci_find_next_cap(struct pci_device *dev, __u8 pos, __u8 cap_id)
+{
+	int ttl = PCI_CAP_MAX_ENTRIES;
+	__u32 val;
+
+	UK_ASSERT(dev);
+
+	if (pos == 0) {
+		pci_conf_read(dev, PCI_STATUS, 2, &val);
+		if (!(val & PCI_STATUS_CAP_LIST))
+			return 0;
+		pci_conf_read(dev, PCI_CAPABILITIES_PTR, 1, &val);
+	} else {
+		pci_conf_read(dev, pos + PCI_CAP_LIST_NEXT, 1, &val);
+	}
+
+	pos = val & ~3;
+	while (pos >= PCI_CAP_MIN_OFFSET && ttl--) {
+		pci_conf_read(dev, pos + PCI_CAP_LIST_ID, 1, &val);
+		if (val == cap_id)
+			return pos;
+		pci_conf_read(dev, pos + PCI_CAP_LIST_NEXT, 1, &val);
+		pos = val & ~3;
+	}
+	return 0;
+}
+
+static int pci_mmio_map(__paddr_t paddr, __sz len)
+{
+#ifdef CONFIG_PAGING
+	__vaddr_t vaddr = PAGE_ALIGN_DOWN(paddr);
+	unsigned long attr = PAGE_ATTR_PROT_RW;
+	int rc;
+
+	len = PAGE_ALIGN_UP(len + (paddr - vaddr));
+
+#ifdef CONFIG_ARCH_ARM_64
+	/* Device registers must not be cached or accessed speculatively */
+	attr |= PAGE_ATTR_TYPE_DEVICE_nGnRE;
+#endif /* CONFIG_ARCH_ARM_64 */
+
+	/* Device memory is mapped 1:1 */
+	rc = ukplat_page_map(ukplat_pt_get_active(), vaddr, vaddr,
+			     len >> PAGE_SHIFT, attr, 0);
+	if (unlikely(rc && rc != -EEXIST))
+		return rc;
+#elif defined(CONFIG_ARCH_X86_64)
+	/* The boot page tables map only the first 4 GiB 1:1 */
+	if (unlikely(paddr + len > 0x100000000UL))
+		return -ENOTSUP;
+#endif /* CONFIG_ARCH_X86_64 */
+	return 0;
+}
+
+int pci_bar_map(struct pci_device *dev, int bar, void **addr, __sz *len)
+{
+	__u32 lo, hi = 0, size_lo, size_hi = 0, cmd;
+	__paddr_t base;
+	__u64 size;
+	int reg, is64;
+	int rc;
+
+	UK_ASSERT(dev && addr && len);
+
+	if (unlikely(bar < 0 || bar > 5))
+		return -EINVAL;
+
+	reg = PCI_BASE_ADDRESS_0 + bar * 4;
+	pci_conf_read(dev, reg, 4, &lo);
+	if (lo & PCI_BASE_ADDRESS_SPACE_IO)
+		return -ENOTSUP;
+
+	is64 = ((lo & PCI_BASE_ADDRESS_MEM_TYPE_MASK)
+		== PCI_BASE_ADDRESS_MEM_TYPE_64);
+	if (is64) {
+		if (unlikely(bar == 5))
+			return -EINVAL;
+		pci_conf_read(dev, reg + 4, 4, &hi);
+	}
+
+	/* Size the BAR with memory decoding turned off, so that the device
+	 * does not respond to the temporary all-ones address
+	 */
+	pci_conf_read(dev, PCI_COMMAND, 2, &cmd);
+	pci_conf_write(dev, PCI_COMMAND, 2, cmd & ~PCI_COMMAND_MEMORY);
+
+	pci_conf_write(dev, reg, 4, ~0U);
+	pci_conf_read(dev, reg, 4, &size_lo);
+	pci_conf_write(dev, reg, 4, lo);
+	if (is64) {
+		pci_conf_write(dev, reg + 4, 4, ~0U);
+		pci_conf_read(dev, reg + 4, 4, &size_hi);
+		pci_conf_write(dev, reg + 4, 4, hi);
+	} else {
+		size_hi = ~0U;
+	}
+
+	size = ((__u64)size_hi << 32) | (size_lo & PCI_BASE_ADDRESS_MEM_MASK);
+	size = ~size + 1;
+	base = ((__u64)hi << 32) | (lo & PCI_BASE_ADDRESS_MEM_MASK);
+	if (unlikely(!base || !(size_lo & PCI_BASE_ADDRESS_MEM_MASK))) {
+		pci_conf_write(dev, PCI_COMMAND, 2, cmd);
+		return -ENODEV;
+	}
+
+	pci_conf_write(dev, PCI_COMMAND, 2, cmd | PCI_COMMAND_MEMORY);
+
+	rc = pci_mmio_map(base, size);
+	if (unlikely(rc)) {
+		uk_pr_err("PCI %02x:%02x.%02x: Failed to map BAR%d: %d\n",
+			  (int) dev->addr.bus, (int) dev->addr.devid,
+			  (int) dev->addr.function, bar, rc);
+		return rc;
+	}
+
+	*addr = (void *) base;
+	*len = size;
+	return 0;
+}
+
+static inline volatile __u8 *pci_msix_entry(struct pci_msix *msix, __u16 vec)
+{
+	UK_ASSERT(vec < msix->nvec);
+	return msix->table + vec * PCI_MSIX_ENTRY_SIZE;
+}
+
+static inline void pci_msix_ctrl_update(struct pci_msix *msix, __u16 clear,
+					__u16 set)
+{
+	__u32 ctrl;
+
+	pci_conf_read(msix->dev, msix->cap + PCI_MSIX_FLAGS, 2, &ctrl);
+	ctrl = (ctrl & ~clear) | set;
+	pci_conf_write(msix->dev, msix->cap + PCI_MSIX_FLAGS, 2, ctrl);
+}
+
+int pci_msix_init(struct pci_device *dev, struct pci_msix *msix)
+{
+	__u32 ctrl, table;
+	void *bar_addr;
+	__sz bar_len;
+	__u32 offset;
+	__u16 i;
+	int rc;
+
+	UK_ASSERT(dev && msix);
+
+	msix->dev = dev;
+	msix->cap = pci_find_cap(dev, PCI_CAP_ID_MSIX);
+	if (!msix->cap)
+		return -ENOTSUP;
+
+	pci_conf_read(dev, msix->cap + PCI_MSIX_FLAGS, 2, &ctrl);
+	pci_conf_read(dev, msix->cap + PCI_MSIX_TABLE, 4, &table);
+	msix->nvec = (ctrl & PCI_MSIX_FLAGS_QSIZE) + 1;
+
+	rc = pci_bar_map(dev, table & PCI_MSIX_TABLE_BIR, &bar_addr, &bar_len);
+	if (unlikely(rc))
+		return rc;
+
+	offset = table & PCI_MSIX_TABLE_OFFSET;
+	if (unlikely(offset + (__sz) msix->nvec * PCI_MSIX_ENTRY_SIZE
+		     > bar_len))
+		return -EINVAL;
+	msix->table = (volatile __u8 *) bar_addr + offset;
+
+	/* Start with all vectors masked */
+	for (i = 0; i < msix->nvec; i++)
+		pci_msix_vector_mask(msix, i, 1);
+
+	return 0;
+}
+
+void pci_msix_vector_mask(struct pci_msix *msix, __u16 vec, int mask)
+{
+	volatile __u32 *ctrl;
+
+	UK_ASSERT(msix && msix->table);
+
+	ctrl = (volatile __u32 *)(pci_msix_entry(msix, vec)
+				  + PCI_MSIX_ENTRY_VECTOR_CTRL);
+	if (mask)
+		*ctrl |= PCI_MSIX_ENTRY_CTRL_MASKBIT;
+	else
+		*ctrl &= ~PCI_MSIX_ENTRY_CTRL_MASKBIT;
+}
+
+int pci_msix_vector_setup(struct pci_msix *msix, __u16 vec,
+			  __lcpuidx lcpuidx, irq_handler_func_t func,
+			  void *arg)
+{
+	volatile __u8 *entry;
+	unsigned long irq;
+	__u64 addr;
+	__u32 data;
+	int rc;
+
+	UK_ASSERT(msix && msix->table);
+	UK_ASSERT(func);
+
+	if (unlikely(vec >= msix->nvec))
+		return -EINVAL;
+
+	rc = ukplat_irq_msi_alloc(&irq);
+	if (unlikely(rc))
+		return rc;
+
+	rc = ukplat_irq_msi_compose(irq, lcpuidx, &addr, &data);
+	if (unlikely(rc))
+		return rc;
+
+	rc = ukplat_irq_register(irq, func, arg);
+	if (unlikely(rc))
+		return rc;
+
+	entry = pci_msix_entry(msix, vec);
+	pci_msix_vector_mask(msix, vec, 1);
+	*(volatile __u32 *)(entry + PCI_MSIX_ENTRY_LOWER_ADDR) = (__u32) addr;
+	*(volatile __u32 *)(entry + PCI_MSIX_ENTRY_UPPER_ADDR) =
+		(__u32)(addr >> 32);
+	*(volatile __u32 *)(entry + PCI_MSIX_ENTRY_DATA) = data;
+	pci_msix_vector_mask(msix, vec, 0);
+
+	uk_pr_debug("PCI %02x:%02x.%02x: MSI-X vector %u: irq %lu on lcpu %u\n",
+		    (int) msix->dev->addr.bus, (int) msix->dev->addr.devid,
+		    (int) msix->dev->addr.function, vec, irq,
+		    (unsigned int) lcpuidx);
+	return 0;
+}
+
+void pci_msix_enable(struct pci_msix *msix)
+{
+	__u32 cmd;
+
+	UK_ASSERT(msix && msix->cap);
+
+	pci_conf_read(msix->dev, PCI_COMMAND, 2, &cmd);
+	pci_conf_write(msix->dev, PCI_COMMAND, 2,
+		       cmd | PCI_COMMAND_INTX_DISABLE | PCI_COMMAND_MASTER);
+	pci_msix_ctrl_update(msix, PCI_MSIX_FLAGS_MASKALL,
+			     PCI_MSIX_FLAGS_ENABLE);
+}
+
+void pci_msix_disable(struct pci_msix *msix)
+{
+	__u32 cmd;
+
+	UK_ASSERT(msix && msix->cap);
+
+	pci_msix_ctrl_update(msix, PCI_MSIX_FLAGS_ENABLE, 0);
+	pci_conf_read(msix->dev, PCI_COMMAND, 2, &cmd);
+	pci_conf_write(msix->dev, PCI_COMMAND, 2,
+		       cmd & ~PCI_COMMAND_INTX_DISABLE);
+}
+
 static int pci_probe(void)
 {
 	return arch_pci_probe(ph.a);
@@ -52,6 +52,7 @@
  */
 
 #include <string.h>
+#include <errno.h>
 #include <uk/print.h>
 #include <uk/plat/common/cpu.h>
 #include <pci/pci_bus.h>
@@ -65,6 +66,61 @@
 		*(ret) = (type) _conf_data;				\
 	} while (0)
 
+static inline __u32 pci_conf_addr(struct pci_device *dev, int where)
+{
+	return (PCI_ENABLE_BIT)
+		| (dev->addr.bus << PCI_BUS_SHIFT)
+		| (dev->addr.devid << PCI_DEVICE_SHIFT)
+		| (dev->addr.function << PCI_FUNCTION_SHIFT)
+		| (where & ~3);
+}
+
+int pci_conf_read(struct pci_device *dev, int where, int size, __u32 *val)
+{
+	__u16 port = PCI_CONFIG_DATA + (where & 3);
+
+	UK_ASSERT(dev && val);
+
+	outl(PCI_CONFIG_ADDR, pci_conf_addr(dev, where));
+	switch (size) {
+	case 1:
+		*val = inb(port);
+		break;
+	case 2:
+		*val = inw(port);
+		break;
+	case 4:
+		*val = inl(port);
+		break;
+	default:
+		return -EINVAL;
+	}
+	return 0;
+}
+
+int pci_conf_write(struct pci_device *dev, int where, int size, __u32 val)
+{
+	__u16 port = PCI_CONFIG_DATA + (where & 3);
+
+	UK_ASSERT(dev);
+
+	outl(PCI_CONFIG_ADDR, pci_conf_addr(dev, where));
+	switch (size) {
+	case 1:
+		outb(port, (__u8) val);
+		break;
+	case 2:
+		outw(port, (__u16) val);
+		break;
+	case 4:
+		outl(port, val);
+		break;
+	default:
+		return -EINVAL;
+	}
+	return 0;
+}
+
 static inline int pci_driver_add_device(struct pci_driver *drv,
 					struct pci_address *addr,
 					struct pci_device_id *devid)
@@ -0,0 +1,776 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2023, Unikraft GmbH and The Unikraft Authors.
+ * Licensed under the BSD-3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ */
+
+/*
+ * Packet socket (AF_PACKET) network driver
+ *
+ * Every device is bound to a host interface (e.g., one end of a veth pair)
+ * with one packet socket per queue. Each socket shares a TPACKET_V3 receive
+ * ring and a transmit ring with the host kernel:
+ *
+ *  - The receive ring consists of blocks that the host fills with frames and
+ *    hands over as a whole. Received frames are not copied: they are wrapped
+ *    into indirect netbufs that point into the ring. A block is returned to
+ *    the host when all of its frames were walked and every netbuf that
+ *    points into it was freed, so netbufs should not be held for long.
+ *  - The transmit ring consists of fixed-size frames that are filled by
+ *    copying the netbuf chain. One system call per burst makes the host send
+ *    the marked frames.
+ *
+ * Receiving is free of system calls as long as the host keeps up filling
+ * blocks. With multiple queues, the sockets form a fanout group so that the
+ * host distributes the received flows among them.
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <uk/alloc.h>
+#include <uk/arch/types.h>
+#include <uk/arch/atomic.h>
+#include <uk/arch/lcpu.h>
+#include <uk/netdev_core.h>
+#include <uk/netdev_driver.h>
+#include <uk/netbuf.h>
+#include <uk/errptr.h>
+#include <uk/libparam.h>
+#include <uk/bus.h>
+#include <afpacket/afpacket.h>
+
+/**
+ * The driver is supported only on the linuxu platform.
+ */
+#ifdef CONFIG_PLAT_LINUXU
+#include <linuxu/afpacket.h>
+#else
+#error "The driver is supported on linuxu platform"
+#endif /* CONFIG_PLAT_LINUXU */
+
+#define DRIVER_NAME		"afpacket-net"
+
+#define AFPACKET_IFNAMSIZ	16
+#define AFPACKET_ETH_HLEN	18 /* Ethernet header with VLAN tag */
+#define AFPACKET_PAGE_SIZE	4096UL
+#define AFPACKET_RX_BLOCK_SIZE	(1UL << 16)
+#define AFPACKET_RX_FRAME_SIZE	2048UL
+#define AFPACKET_RX_BLOCKS_MAX	1024
+#define AFPACKET_TX_FRAMES_MAX	32768
+
+#define to_afpacketdev(dev) \
+	__containerof(dev, struct afpacket_dev, ndev)
+
+struct uk_netdev_rx_queue {
+	/* Device that this queue belongs to */
+	struct afpacket_dev *adev;
+	/* Queue identifier */
+	__u16 queue_id;
+	/* Allocator for the queue and the netbufs of received frames */
+	struct uk_alloc *a;
+	/* Packet socket of the queue */
+	int fd;
+	/* Receive ring */
+	__u8 *ring;
+	__u32 blk_nr;
+	/* Block that is currently walked */
+	__u32 blk_idx;
+	/* Next frame and number of remaining frames in the current block */
+	struct uk_tpacket3_hdr *frame;
+	__u32 frames_left;
+	/* References to each block (walker and netbufs) */
+	int *blk_refs;
+};
+
+struct uk_netdev_tx_queue {
+	/* Queue identifier */
+	__u16 queue_id;
+	/* Allocator for the queue */
+	struct uk_alloc *a;
+	/* Packet socket of the queue */
+	int fd;
+	/* Transmit ring */
+	__u8 *ring;
+	__u32 frame_size;
+	__u32 frame_nr;
+	/* Frames do not cross block boundaries */
+	__u32 blk_size;
+	__u32 frames_per_blk;
+	/* Next frame to fill */
+	__u32 head;
+};
+
+/* Private data of a received netbuf */
+struct afpacket_rx_ref {
+	struct uk_netdev_rx_queue *rxq;
+	__u32 blk_idx;
+};
+
+struct afpacket_dev {
+	/* Net device structure */
+	struct uk_netdev ndev;
+	/* UK Netdevice identifier */
+	__u16 id;
+	/* Host interface */
+	char ifname[AFPACKET_IFNAMSIZ];
+	int ifindex;
+	/* Max number of queues */
+	__u16 max_qpairs;
+	/* One packet socket per queue */
+	int socks[CONFIG_LIBUKNETDEV_MAXNBQUEUES];
+	__u16 nb_socks;
+	__u16 nb_rx_queues;
+	__u16 nb_tx_queues;
+	struct uk_netdev_rx_queue *rxqs[CONFIG_LIBUKNETDEV_MAXNBQUEUES];
+	struct uk_netdev_tx_queue *txqs[CONFIG_LIBUKNETDEV_MAXNBQUEUES];
+	/* Mapped rings of each socket */
+	void *rings[CONFIG_LIBUKNETDEV_MAXNBQUEUES];
+	__sz rings_len[CONFIG_LIBUKNETDEV_MAXNBQUEUES];
+	/* Mac address of the device */
+	struct uk_hwaddr hw_addr;
+	/* MTU of the host interface */
+	__u16 mtu;
+};
+
+/**
+ * Module level variables
+ */
+static struct uk_alloc *afpacket_a;
+static const char *drv_name = DRIVER_NAME;
+static char *ifnames;
+static __u32 queues = 1;
+
+/**
+ * Module Parameters.
+ */
+/**
+ * afpacket.ifnames="veth0 veth1 ... vethn"
+ */
+UK_LIB_PARAM_STR(ifnames);
+/**
+ * afpacket.queues=<max # of queues per device>
+ */
+UK_LIB_PARAM(queues, __u32);
+
+static inline struct uk_tpacket_block_desc *
+afpacket_rx_block(struct uk_netdev_rx_queue *rxq, __u32 idx)
+{
+	return (struct uk_tpacket_block_desc *)
+		(rxq->ring + (__sz) idx * AFPACKET_RX_BLOCK_SIZE);
+}
+
+/* Drops a reference to a receive block and hands it back to the host with
+ * the last one
+ */
+static void afpacket_rx_block_put(struct uk_netdev_rx_queue *rxq, __u32 idx)
+{
+	struct uk_tpacket_block_desc *blk;
+
+	if (ukarch_dec(&rxq->blk_refs[idx]) != 1)
+		return;
+
+	/* All accesses to the frames of the block are done */
+	blk = afpacket_rx_block(rxq, idx);
+	mb();
+	ukarch_store_n(&blk->bh1.block_status, UK_TP_STATUS_KERNEL);
+}
+
+static void afpacket_rx_dtor(struct uk_netbuf *m)
+{
+	struct afpacket_rx_ref *ref = m->priv;
+
+	afpacket_rx_block_put(ref->rxq, ref->blk_idx);
+}
+
+/* Makes the next block the current one if the host handed it over */
+static int afpacket_rx_block_open(struct uk_netdev_rx_queue *rxq)
+{
+	struct uk_tpacket_block_desc *blk;
+
+	blk = afpacket_rx_block(rxq, rxq->blk_idx);
+	if (!(ukarch_load_n(&blk->bh1.block_status) & UK_TP_STATUS_USER))
+		return 0;
+	/* Read the frames only after the block status */
+	rmb();
+
+	/* Reference of the walker */
+	ukarch_store_n(&rxq->blk_refs[rxq->blk_idx], 1);
+	rxq->frames_left = blk->bh1.num_pkts;
+	rxq->frame = (struct uk_tpacket3_hdr *)
+		((__u8 *) blk + blk->bh1.offset_to_first_pkt);
+	return 1;
+}
+
+/* Advances to the next frame of the current block */
+static void afpacket_rx_frame_next(struct uk_netdev_rx_queue *rxq)
+{
+	UK_ASSERT(rxq->frames_left > 0);
+
+	rxq->frames_left--;
+	if (rxq->frames_left == 0) {
+		/* Block walked, drop the reference of the walker */
+		afpacket_rx_block_put(rxq, rxq->blk_idx);
+		rxq->blk_idx = (rxq->blk_idx + 1) % rxq->blk_nr;
+		rxq->frame = NULL;
+		return;
+	}
+	rxq->frame = (struct uk_tpacket3_hdr *)
+		((__u8 *) rxq->frame + rxq->frame->tp_next_offset);
+}
+
+static int afpacket_netdev_recv_burst(struct uk_netdev *dev __maybe_unused,
+				      struct uk_netdev_rx_queue *rxq,
+				      struct uk_netbuf **pkts, __u16 *cnt)
+{
+	struct uk_tpacket3_hdr *frame;
+	struct afpacket_rx_ref *ref;
+	struct uk_netbuf *m;
+	__u16 rcvd = 0;
+	int status = 0x0;
+
+	UK_ASSERT(dev);
+	UK_ASSERT(rxq && pkts && cnt);
+
+	while (rcvd < *cnt) {
+		if (!rxq->frame) {
+			if (!afpacket_rx_block_open(rxq))
+				break;
+			if (unlikely(!rxq->frames_left)) {
+				/* Empty block retired by timeout */
+				rxq->frames_left = 1;
+				afpacket_rx_frame_next(rxq);
+				continue;
+			}
+		}
+		frame = rxq->frame;
+
+		/* Frames that the host sent on the interface */
+		if (UK_TPACKET3_SLL(frame)->sll_pkttype == UK_PACKET_OUTGOING) {
+			afpacket_rx_frame_next(rxq);
+			continue;
+		}
+
+		m = uk_netbuf_alloc_indir(rxq->a, (__u8 *) frame + frame->tp_mac,
+					  frame->tp_snaplen, 0,
+					  sizeof(*ref), afpacket_rx_dtor);
+		if (unlikely(!m)) {
+			/* The frame stays in the ring for the next call */
+			status |= UK_NETDEV_STATUS_UNDERRUN;
+			break;
+		}
+		m->len = frame->tp_snaplen;
+		/* Frames of the host stack may not have a checksum yet, but
+		 * they never crossed a wire
+		 */
+		if (frame->tp_status
+		    & (UK_TP_STATUS_CSUM_VALID | UK_TP_STATUS_CSUMNOTREADY))
+			m->flags |= UK_NETBUF_F_DATA_VALID;
+
+		ref = m->priv;
+		ref->rxq = rxq;
+		ref->blk_idx = rxq->blk_idx;
+		ukarch_inc(&rxq->blk_refs[rxq->blk_idx]);
+
+		pkts[rcvd++] = m;
+		afpacket_rx_frame_next(rxq);
+	}
+
+	*cnt = rcvd;
+	if (rcvd > 0)
+		status |= UK_NETDEV_STATUS_SUCCESS;
+	if (rxq->frame
+	    || (ukarch_load_n(&afpacket_rx_block(rxq, rxq->blk_idx)
+			      ->bh1.block_status) & UK_TP_STATUS_USER))
+		status |= UK_NETDEV_STATUS_MORE;
+	return status;
+}
+
+static int afpacket_netdev_recv(struct uk_netdev *dev,
+				struct uk_netdev_rx_queue *rxq,
+				struct uk_netbuf **pkt)
+{
+	__u16 cnt = 1;
+
+	return afpacket_netdev_recv_burst(dev, rxq, pkt, &cnt);
+}
+
+static inline struct uk_tpacket3_hdr *
+afpacket_tx_frame(struct uk_netdev_tx_queue *txq, __u32 idx)
+{
+	return (struct uk_tpacket3_hdr *)
+		(txq->ring + (__sz) (idx / txq->frames_per_blk) * txq->blk_size
+		 + (__sz) (idx % txq->frames_per_blk) * txq->frame_size);
+}
+
+/* Copies a packet into the next transmit frame. Returns 0 if the ring is
+ * full, 1 if the frame was filled, or a negative error code
+ */
+static int afpacket_tx_fill(struct uk_netdev_tx_queue *txq,
+			    struct uk_netbuf *pkt)
+{
+	struct uk_tpacket3_hdr *frame;
+	struct uk_netbuf *seg;
+	__u8 *data;
+	__u32 len = 0;
+
+	frame = afpacket_tx_frame(txq, txq->head);
+	if (ukarch_load_n(&frame->tp_status) != UK_TP_STATUS_AVAILABLE)
+		return 0;
+
+	data = (__u8 *) frame + UK_TPACKET3_TX_DATA_OFF;
+	UK_NETBUF_CHAIN_FOREACH(seg, pkt) {
+		if (unlikely(len + seg->len
+			     > txq->frame_size - UK_TPACKET3_TX_DATA_OFF)) {
+			uk_pr_err(DRIVER_NAME": Packet %p too long for a transmit frame\n",
+				  pkt);
+			return -EMSGSIZE;
+		}
+		memcpy(data + len, seg->data, seg->len);
+		len += seg->len;
+	}
+	frame->tp_len = len;
+
+	/* The frame content is complete before the host can see it */
+	wmb();
+	ukarch_store_n(&frame->tp_status, UK_TP_STATUS_SEND_REQUEST);
+	txq->head = (txq->head + 1) % txq->frame_nr;
+	return 1;
+}
+
+static int afpacket_netdev_xmit_burst(struct uk_netdev *dev __maybe_unused,
+				      struct uk_netdev_tx_queue *txq,
+				      struct uk_netbuf **pkts, __u16 *cnt)
+{
+	__u16 sent = 0;
+	int rc = 0;
+
+	UK_ASSERT(dev);
+	UK_ASSERT(txq && pkts && cnt);
+
+	while (sent < *cnt) {
+		rc = afpacket_tx_fill(txq, pkts[sent]);
+		if (rc <= 0)
+			break;
+		uk_netbuf_free(pkts[sent]);
+		sent++;
+	}
+
+	/* One system call for the whole burst */
+	if (sent > 0)
+		afpacket_tx_kick(txq->fd);
+
+	if (sent == 0 && rc < 0) {
+		*cnt = 0;
+		return rc;
+	}
+
+	*cnt = sent;
+	if (sent == 0)
+		return UK_NETDEV_STATUS_UNDERRUN;
+	return UK_NETDEV_STATUS_SUCCESS
+		| ((rc > 0) ? UK_NETDEV_STATUS_MORE : 0x0);
+}
+
+static int afpacket_netdev_xmit(struct uk_netdev *dev,
+				struct uk_netdev_tx_queue *txq,
+				struct uk_netbuf *pkt)
+{
+	__u16 cnt = 1;
+
+	return afpacket_netdev_xmit_burst(dev, txq, &pkt, &cnt);
+}
+
+static int afpacket_netdev_rxq_info_get(struct uk_netdev *dev __unused,
+					__u16 queue_id __unused,
+					struct uk_netdev_queue_info *qinfo)
+{
+	UK_ASSERT(qinfo);
+
+	/* Descriptors are receive blocks */
+	qinfo->nb_min = 2;
+	qinfo->nb_max = AFPACKET_RX_BLOCKS_MAX;
+	qinfo->nb_align = 1;
+	qinfo->nb_is_power_of_two = 0;
+	return 0;
+}
+
+static int afpacket_netdev_txq_info_get(struct uk_netdev *dev __unused,
+					__u16 queue_id __unused,
+					struct uk_netdev_queue_info *qinfo)
+{
+	UK_ASSERT(qinfo);
+
+	/* Descriptors are transmit frames */
+	qinfo->nb_min = 1;
+	qinfo->nb_max = AFPACKET_TX_FRAMES_MAX;
+	qinfo->nb_align = 1;
+	qinfo->nb_is_power_of_two = 0;
+	return 0;
+}
+
+static struct uk_netdev_rx_queue *
+afpacket_netdev_rxq_setup(struct uk_netdev *dev, __u16 queue_id,
+			  __u16 nb_desc, struct uk_netdev_rxqueue_conf *conf)
+{
+	struct afpacket_dev *adev;
+	struct uk_netdev_rx_queue *rxq;
+
+	UK_ASSERT(dev && conf);
+	adev = to_afpacketdev(dev);
+	UK_ASSERT(queue_id < adev->nb_socks);
+
+	if (nb_desc == 0)
+		nb_desc = CONFIG_AFPACKET_NET_RX_BLOCKS;
+	if (nb_desc < 2 || nb_desc > AFPACKET_RX_BLOCKS_MAX)
+		return ERR2PTR(-EINVAL);
+
+	rxq = uk_zalloc(conf->a, sizeof(*rxq));
+	if (!rxq)
+		return ERR2PTR(-ENOMEM);
+	rxq->blk_refs = uk_calloc(conf->a, nb_desc, sizeof(*rxq->blk_refs));
+	if (!rxq->blk_refs) {
+		uk_free(conf->a, rxq);
+		return ERR2PTR(-ENOMEM);
+	}
+
+	rxq->adev = adev;
+	rxq->queue_id = queue_id;
+	rxq->a = conf->a;
+	rxq->fd = adev->socks[queue_id];
+	rxq->blk_nr = nb_desc;
+	adev->rxqs[queue_id] = rxq;
+	return rxq;
+}
+
+static struct uk_netdev_tx_queue *
+afpacket_netdev_txq_setup(struct uk_netdev *dev, __u16 queue_id,
+			  __u16 nb_desc, struct uk_netdev_txqueue_conf *conf)
+{
+	struct afpacket_dev *adev;
+	struct uk_netdev_tx_queue *txq;
+
+	UK_ASSERT(dev && conf);
+	adev = to_afpacketdev(dev);
+	UK_ASSERT(queue_id < adev->nb_socks);
+
+	if (nb_desc == 0)
+		nb_desc = CONFIG_AFPACKET_NET_TX_FRAMES;
+
+	txq = uk_zalloc(conf->a, sizeof(*txq));
+	if (!txq)
+		return ERR2PTR(-ENOMEM);
+
+	txq->queue_id = queue_id;
+	txq->a = conf->a;
+	txq->fd = adev->socks[queue_id];
+	txq->frame_nr = nb_desc;
+	txq->frame_size = UK_TPACKET_ALIGN(UK_TPACKET3_TX_DATA_OFF
+					   + adev->mtu + AFPACKET_ETH_HLEN);
+	adev->txqs[queue_id] = txq;
+	return txq;
+}
+
+/* Sets up the rings of one socket, maps them, and binds the socket */
+static int afpacket_sock_start(struct afpacket_dev *adev, __u16 idx)
+{
+	struct uk_netdev_rx_queue *rxq = adev->rxqs[idx];
+	struct uk_netdev_tx_queue *txq = adev->txqs[idx];
+	struct uk_tpacket_req3 req;
+	int fd = adev->socks[idx];
+	__sz rx_len = 0, tx_len = 0;
+	__u32 frames_per_blk;
+	int val, rc;
+	__u8 *ring;
+
+	val = UK_TPACKET_V3;
+	rc = afpacket_sockopt_set(fd, UK_PACKET_VERSION, &val, sizeof(val));
+	if (rc < 0)
+		return rc;
+	/* Skip malformed transmit frames instead of stopping the ring */
+	val = 1;
+	rc = afpacket_sockopt_set(fd, UK_PACKET_LOSS, &val, sizeof(val));
+	if (rc < 0)
+		return rc;
+	/* Transmitted frames bypass the queueing discipline of the host */
+	afpacket_sockopt_set(fd, UK_PACKET_QDISC_BYPASS, &val, sizeof(val));
+
+	if (rxq) {
+		memset(&req, 0, sizeof(req));
+		req.tp_block_size = AFPACKET_RX_BLOCK_SIZE;
+		req.tp_block_nr = rxq->blk_nr;
+		req.tp_frame_size = AFPACKET_RX_FRAME_SIZE;
+		req.tp_frame_nr = (AFPACKET_RX_BLOCK_SIZE
+				   / AFPACKET_RX_FRAME_SIZE) * rxq->blk_nr;
+		req.tp_retire_blk_tov = CONFIG_AFPACKET_NET_RX_BLOCK_TIMEOUT;
+		rc = afpacket_sockopt_set(fd, UK_PACKET_RX_RING, &req,
+					  sizeof(req));
+		if (rc < 0)
+			return rc;
+		rx_len = (__sz) req.tp_block_size * req.tp_block_nr;
+	}
+
+	if (txq) {
+		memset(&req, 0, sizeof(req));
+		req.tp_block_size = ALIGN_UP((__sz) txq->frame_size,
+					     AFPACKET_PAGE_SIZE);
+		frames_per_blk = req.tp_block_size / txq->frame_size;
+		req.tp_block_nr = DIV_ROUND_UP(txq->frame_nr, frames_per_blk);
+		req.tp_frame_size = txq->frame_size;
+		req.tp_frame_nr = frames_per_blk * req.tp_block_nr;
+		rc = afpacket_sockopt_set(fd, UK_PACKET_TX_RING, &req,
+					  sizeof(req));
+		if (rc < 0)
+			return rc;
+		/* Use every frame of the last block as well */
+		txq->frame_nr = req.tp_frame_nr;
+		txq->blk_size = req.tp_block_size;
+		txq->frames_per_blk = frames_per_blk;
+		tx_len = (__sz) req.tp_block_size * req.tp_block_nr;
+	}
+
+	ring = afpacket_ring_map(fd, rx_len + tx_len);
+	if (!ring)
+		return -ENOMEM;
+	adev->rings[idx] = ring;
+	adev->rings_len[idx] = rx_len + tx_len;
+	if (rxq)
+		rxq->ring = ring;
+	if (txq)
+		txq->ring = ring + rx_len;
+
+	/* Sockets without a receive queue must not receive anything */
+	rc = afpacket_bind(fd, adev->ifindex, rxq ? UK_ETH_P_ALL : 0);
+	if (rc < 0)
+		goto err_unmap;
+
+	if (rxq && adev->nb_rx_queues > 1) {
+		val = (adev->ifindex & 0xffff) | (UK_PACKET_FANOUT_HASH << 16);
+		rc = afpacket_sockopt_set(fd, UK_PACKET_FANOUT, &val,
+					  sizeof(val));
+		if (rc < 0)
+			goto err_unmap;
+	}
+	return 0;
+
+err_unmap:
+	afpacket_ring_unmap(ring, rx_len + tx_len);
+	adev->rings[idx] = NULL;
+	return rc;
+}
+
+static int afpacket_netdev_start(struct uk_netdev *dev)
+{
+	struct afpacket_dev *adev;
+	struct uk_packet_mreq mreq = {0};
+	__u16 i;
+	int rc;
+
+	UK_ASSERT(dev);
+	adev = to_afpacketdev(dev);
+
+	/* Rings can only be set up once all queues are known */
+	for (i = 0; i < adev->nb_socks; i++) {
+		rc = afpacket_sock_start(adev, i);
+		if (rc < 0) {
+			uk_pr_err(DRIVER_NAME": Failed(%d) to start queue %"__PRIu16" on %s\n",
+				  rc, i, adev->ifname);
+			return rc;
+		}
+	}
+
+	/* Frames to our own hardware address are received as well */
+	mreq.mr_ifindex = adev->ifindex;
+	mreq.mr_type = UK_PACKET_MR_PROMISC;
+	rc = afpacket_sockopt_set(adev->socks[0], UK_PACKET_ADD_MEMBERSHIP,
+				  &mreq, sizeof(mreq));
+	if (rc < 0)
+		return rc;
+
+	uk_pr_info(DRIVER_NAME": Started %s with %"__PRIu16" queue(s)\n",
+		   adev->ifname, adev->nb_socks);
+	return 0;
+}
+
+static int afpacket_netdev_configure(struct uk_netdev *dev,
+				     const struct uk_netdev_conf *conf)
+{
+	struct afpacket_dev *adev;
+	__u16 nb_socks;
+	int rc;
+
+	UK_ASSERT(dev && conf);
+	adev = to_afpacketdev(dev);
+
+	if (conf->nb_rx_queues > adev->max_qpairs
+	    || conf->nb_tx_queues > adev->max_qpairs) {
+		uk_pr_err(DRIVER_NAME": rx-queue:%d, tx-queue:%d not supported\n",
+			  conf->nb_rx_queues, conf->nb_tx_queues);
+		return -ENOTSUP;
+	}
+
+	/* Receive queue `i` and transmit queue `i` share socket `i` */
+	nb_socks = MAX(MAX(conf->nb_rx_queues, conf->nb_tx_queues), 1);
+	for (adev->nb_socks = 0; adev->nb_socks < nb_socks; adev->nb_socks++) {
+		rc = afpacket_open();
+		if (rc < 0)
+			goto err_close;
+		adev->socks[adev->nb_socks] = rc;
+	}
+	adev->nb_rx_queues = conf->nb_rx_queues;
+	adev->nb_tx_queues = conf->nb_tx_queues;
+	return 0;
+
+err_close:
+	while (adev->nb_socks > 0)
+		afpacket_close(adev->socks[--adev->nb_socks]);
+	return rc;
+}
+
+static void afpacket_netdev_info_get(struct uk_netdev *dev,
+				     struct uk_netdev_info *dev_info)
+{
+	struct afpacket_dev *adev;
+
+	UK_ASSERT(dev && dev_info);
+	adev = to_afpacketdev(dev);
+
+	dev_info->max_rx_queues = adev->max_qpairs;
+	dev_info->max_tx_queues = adev->max_qpairs;
+	dev_info->in_queue_pairs = 0;
+	dev_info->max_mtu = adev->mtu;
+	dev_info->nb_encap_tx = 0;
+	dev_info->nb_encap_rx = 0;
+	dev_info->ioalign = 1;
+	dev_info->features = 0;
+}
+
+static unsigned int afpacket_netdev_promisc_get(struct uk_netdev *dev __unused)
+{
+	return 1;
+}
+
+static __u16 afpacket_netdev_mtu_get(struct uk_netdev *dev)
+{
+	UK_ASSERT(dev);
+	return to_afpacketdev(dev)->mtu;
+}
+
+static const struct uk_hwaddr *afpacket_netdev_mac_get(struct uk_netdev *dev)
+{
+	UK_ASSERT(dev);
+	return &to_afpacketdev(dev)->hw_addr;
+}
+
+static int afpacket_netdev_mac_set(struct uk_netdev *dev,
+				   const struct uk_hwaddr *hwaddr)
+{
+	UK_ASSERT(dev && hwaddr);
+
+	/* The interface is promiscuous: any address can be used */
+	memcpy(&to_afpacketdev(dev)->hw_addr, hwaddr, sizeof(*hwaddr));
+	return 0;
+}
+
+static const struct uk_netdev_ops afpacket_netdev_ops = {
+	.configure = afpacket_netdev_configure,
+	.rxq_configure = afpacket_netdev_rxq_setup,
+	.txq_configure = afpacket_netdev_txq_setup,
+	.start = afpacket_netdev_start,
+	.info_get = afpacket_netdev_info_get,
+	.promiscuous_get = afpacket_netdev_promisc_get,
+	.hwaddr_get = afpacket_netdev_mac_get,
+	.hwaddr_set = afpacket_netdev_mac_set,
+	.mtu_get = afpacket_netdev_mtu_get,
+	.txq_info_get = afpacket_netdev_txq_info_get,
+	.rxq_info_get = afpacket_netdev_rxq_info_get,
+};
+
+/**
+ * Registering the network device.
+ */
+static int afpacket_dev_init(const char *ifname)
+{
+	struct afpacket_dev *adev;
+	int fd, mtu, rc;
+
+	adev = uk_zalloc(afpacket_a, sizeof(*adev));
+	if (!adev) {
+		uk_pr_err(DRIVER_NAME": Failed to allocate the device\n");
+		return -ENOMEM;
+	}
+	snprintf(adev->ifname, sizeof(adev->ifname), "%s", ifname);
+
+	/* The device takes over index, address, and MTU of the interface */
+	fd = afpacket_open();
+	if (fd < 0) {
+		rc = fd;
+		goto free_adev;
+	}
+	rc = afpacket_ifinfo_get(fd, adev->ifname, &adev->ifindex,
+				 adev->hw_addr.addr_bytes, &mtu);
+	afpacket_close(fd);
+	if (rc < 0)
+		goto free_adev;
+	adev->mtu = (__u16) mtu;
+	adev->max_qpairs = MIN(MAX(queues, 1U),
+			       (__u32) CONFIG_LIBUKNETDEV_MAXNBQUEUES);
+
+	adev->ndev.rx_one = afpacket_netdev_recv;
+	adev->ndev.tx_one = afpacket_netdev_xmit;
+	adev->ndev.rx_burst = afpacket_netdev_recv_burst;
+	adev->ndev.tx_burst = afpacket_netdev_xmit_burst;
+	adev->ndev.ops = &afpacket_netdev_ops;
+
+	rc = uk_netdev_drv_register(&adev->ndev, afpacket_a, drv_name);
+	if (rc < 0) {
+		uk_pr_err(DRIVER_NAME": Failed to register the network device\n");
+		goto free_adev;
+	}
+	adev->id = rc;
+	uk_pr_info(DRIVER_NAME": device(%"__PRIu16") bound to %s (index %d, MTU %"__PRIu16")\n",
+		   adev->id, adev->ifname, adev->ifindex, adev->mtu);
+	return 0;
+
+free_adev:
+	uk_free(afpacket_a, adev);
+	return rc;
+}
+
+static int afpacket_drv_probe(void)
+{
+	char *idx, *ifname;
+	int rc;
+
+	idx = ifnames;
+	while (idx && *idx) {
+		ifname = idx;
+		idx = strchr(idx, ' ');
+		if (idx) {
+			*idx = '\0';
+			idx++;
+		}
+		if (!*ifname)
+			continue;
+
+		rc = afpacket_dev_init(ifname);
+		if (rc < 0) {
+			uk_pr_err(DRIVER_NAME": Failed to initialize the device for %s\n",
+				  ifname);
+			return rc;
+		}
+	}
+	return 0;
+}
+
+static int afpacket_drv_init(struct uk_alloc *a)
+{
+	afpacket_a = a;
+	return 0;
+}
+
+static struct uk_bus afpacket_bus = {
+	.init = afpacket_drv_init,
+	.probe = afpacket_drv_probe,
+};
+UK_BUS_REGISTER(&afpacket_bus);
@@ -0,0 +1,33 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2023, Unikraft GmbH and The Unikraft Authors.
+ * Licensed under the BSD-3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ */
+#ifndef __PLAT_DRV_AFPACKET_H
+#define __PLAT_DRV_AFPACKET_H
+
+#include <uk/arch/types.h>
+
+/**
+ * Host interface for packet sockets with memory-mapped rings. All functions
+ * return a negative error code on failure.
+ */
+
+/* Opens a packet socket that does not receive anything before it is bound */
+int afpacket_open(void);
+int afpacket_close(int fd);
+/* Reads index, hardware address (6 bytes), and MTU of a host interface */
+int afpacket_ifinfo_get(int fd, const char *ifname, int *ifindex,
+			__u8 *hwaddr, int *mtu);
+/* Sets a packet socket option (SOL_PACKET level) */
+int afpacket_sockopt_set(int fd, int optname, const void *optval,
+			 __u32 optlen);
+/* Binds to an interface, `protocol` 0 disables reception */
+int afpacket_bind(int fd, int ifindex, __u16 protocol);
+/* Maps the configured rings (receive ring first), NULL on failure */
+void *afpacket_ring_map(int fd, __sz len);
+int afpacket_ring_unmap(void *ring, __sz len);
+/* Makes the host send all frames that are marked in the transmit ring */
+int afpacket_tx_kick(int fd);
+
+#endif /* __PLAT_DRV_AFPACKET_H */
@@ -40,12 +40,18 @@
  */
 #define IFNAMSIZ        16
 
+struct k_iovec;
+
 int tap_open(__u32 flags);
 int tap_close(int fd);
 int tap_dev_configure(int fd, __u32 feature_flags, void *arg);
+int tap_dev_features_get(int fd, __u32 *features);
+int tap_dev_vnet_configure(int fd, int hdr_len, __u32 offloads);
 int tap_netif_configure(int fd, __u32 request, void *arg);
 int tap_netif_create(void);
 __ssz tap_read(int fd, void *buf, size_t count);
 __ssz tap_write(int fd, const void *buf, size_t count);
+__ssz tap_readv(int fd, const struct k_iovec *iov, int iovcnt);
+__ssz tap_writev(int fd, const struct k_iovec *iov, int iovcnt);
 
 #endif /* __PLAT_DRV_TAP_H */
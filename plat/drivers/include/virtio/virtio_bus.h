@@ -227,7 +227,7 @@ static inline __u64 virtio_feature_get(struct virtio_dev *vdev)
  * @param feature
  *	A bit map of the feature negotiated.
  */
-static inline void virtio_feature_set(struct virtio_dev *vdev, __u32 feature)
+static inline void virtio_feature_set(struct virtio_dev *vdev, __u64 feature)
 {
 	UK_ASSERT(vdev);
 
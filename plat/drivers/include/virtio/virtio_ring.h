@@ -152,12 +152,17 @@ struct vring {
  * NOTE: for VirtIO PCI, align is 4096.
  */
 
+/* The avail event index overlays the used ring element after the last one */
+typedef __virtio_le16 __attribute__((__may_alias__)) __vring_le16_alias;
+
 /**
  * We publish the used event index at the end of the available ring, and vice
  * versa. They are at the end for backwards compatibility.
  */
 #define vring_used_event(vr) ((vr)->avail->ring[(vr)->num])
-#define vring_avail_event(vr) (*(__virtio16 *)&(vr)->used->ring[(vr)->num])
+#define vring_avail_event(vr)						\
+	(*(__vring_le16_alias *)((__u8 *)(vr)->used->ring +		\
+				 (vr)->num * sizeof((vr)->used->ring[0])))
 
 static inline void vring_init(struct vring *vr, unsigned int num, uint8_t *p,
 			      unsigned long align)
@@ -183,10 +188,95 @@ static inline unsigned int vring_size(unsigned int num, unsigned long align)
 	return size;
 }
 
+/**
+ * Packed virtqueue layout (VIRTIO_F_RING_PACKED)
+ *
+ * The driver and the device share a single descriptor ring. Descriptors are
+ * made available and used in ring order, a wrap counter per side tells the
+ * current round of the ring apart from the previous one.
+ */
+
+/* Flag bit positions of the packed descriptors. */
+#define VRING_PACKED_DESC_F_AVAIL	7
+#define VRING_PACKED_DESC_F_USED	15
+
+/* Enable events */
+#define VRING_PACKED_EVENT_FLAG_ENABLE	0x0
+/* Disable events */
+#define VRING_PACKED_EVENT_FLAG_DISABLE	0x1
+/* Enable events for a specific descriptor (VIRTIO_F_EVENT_IDX) */
+#define VRING_PACKED_EVENT_FLAG_DESC	0x2
+
+/* Wrap counter bit shift in the event suppression off_wrap field */
+#define VRING_PACKED_EVENT_F_WRAP_CTR	15
+
+struct vring_packed_desc {
+	/* Buffer Address. */
+	__virtio_le64 addr;
+	/* Buffer Length. */
+	__virtio_le32 len;
+	/* Buffer ID. */
+	__virtio_le16 id;
+	/* The flags depending on descriptor type. */
+	__virtio_le16 flags;
+};
+
+struct vring_packed_desc_event {
+	/* Descriptor Ring Change Event Offset/Wrap Counter. */
+	__virtio_le16 off_wrap;
+	/* Descriptor Ring Change Event Flags. */
+	__virtio_le16 flags;
+};
+
+struct vring_packed {
+	unsigned int num;
+
+	struct vring_packed_desc *desc;
+	/* Written by the driver, read by the device */
+	struct vring_packed_desc_event *driver;
+	/* Written by the device, read by the driver */
+	struct vring_packed_desc_event *device;
+};
+
+/* The packed layout is a continuous chunk of memory which looks like this.
+ * The queue size does not need to be a power of 2.
+ *
+ * struct vring_packed {
+ *      // The descriptor ring (16 bytes each)
+ *      struct vring_packed_desc desc[num];
+ *
+ *      // Driver event suppression area
+ *      struct vring_packed_desc_event driver;
+ *
+ *      // Device event suppression area
+ *      struct vring_packed_desc_event device;
+ * };
+ */
+static inline void vring_packed_init(struct vring_packed *vr, unsigned int num,
+				     uint8_t *p)
+{
+	vr->num = num;
+	vr->desc = (struct vring_packed_desc *) p;
+	vr->driver = (struct vring_packed_desc_event *) (p +
+			num * sizeof(struct vring_packed_desc));
+	vr->device = vr->driver + 1;
+}
+
+static inline unsigned int vring_packed_size(unsigned int num)
+{
+	return num * sizeof(struct vring_packed_desc)
+		+ 2 * sizeof(struct vring_packed_desc_event);
+}
+
+/**
+ * Tells if an event is needed: The event index was passed while moving the
+ * index from `old_idx` to `new_idx`.
+ */
 static inline int vring_need_event(__u16 event_idx, __u16 new_idx,
 				   __u16 old_idx)
 {
-	return (new_idx - event_idx - 1) < (new_idx - old_idx);
+	return (__u16) (new_idx - event_idx - 1)
+		< (__u16) (new_idx - old_idx);
 }
 
 #ifdef __cplusplus
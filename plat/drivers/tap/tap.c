@@ -58,6 +58,11 @@
 
 #define ETH_PKT_PAYLOAD_LEN       1500
 
+/* Maximum number of segments of a transmitted netbuf chain */
+#define TAP_IOV_MAX               64
+/* Maximum length of a super-packet handed to the host */
+#define TAP_GSO_MAXLEN            __U16_MAX
+
 /**
  * TODO: Find a better way of forwarding the command line argument to the
  * driver. For now they are defined as macros from this driver.
@@ -115,8 +120,12 @@ struct tap_net_dev {
 	__u16 tid;
 	/* UK Netdevice identifier */
 	__u16 id;
-	/* File Descriptor for the tap device */
-	int tap_fd;
+	/* File descriptors of the tap device, one per queue */
+	int tap_fds[CONFIG_LIBUKNETDEV_MAXNBQUEUES];
+	/* Number of opened tap queues */
+	__u16 nb_fds;
+	/* Offloads that the host may hand over to us (UK_TUN_F_*) */
+	__u32 offloads;
 	/* Control socket descriptor */
 	int ctrl_sock;
 	/* Name of the character device */
@@ -125,6 +134,8 @@ struct tap_net_dev {
 	__u16  mtu;
 	/* RX promiscuous mode */
 	__u8 promisc : 1;
+	/* Frames are preceded by a struct uk_tun_vnet_hdr */
+	__u8 vnet_hdr : 1;
 	/* State of the net device */
 	__u8 state;
 };
@@ -136,6 +147,8 @@ struct tap_net_drv {
 	UK_TAILQ_HEAD(tdev_list, struct tap_net_dev) tap_dev_list;
 	/* Number of tap devices */
 	__u16 tap_dev_cnt;
+	/* Features of the host tap driver (UK_IFF_*) */
+	__u32 host_features;
 	/* A list of bridges associated with the bridge */
 	char **bridge_ifs;
 };
@@ -147,6 +160,7 @@ static struct tap_net_drv tap_drv = {0};
 static const char *drv_name = DRIVER_NAME;
 static int tap_dev_cnt;
 static char *bridgenames;
+static __u32 queues = 1;
 
 /**
  * Module Parameters.
@@ -159,6 +173,10 @@ UK_LIB_PARAM(tap_dev_cnt, __u32);
  * tap.bridgenames="br0 br1 ... brn"
  */
 UK_LIB_PARAM_STR(bridgenames);
+/**
+ * tap.queues=<max # of queues per tap device>
+ */
+UK_LIB_PARAM(queues, __u32);
 
 /**
  * Module functions
@@ -169,6 +187,12 @@ static int tap_netdev_xmit(struct uk_netdev *dev,
 static int tap_netdev_recv(struct uk_netdev *dev,
 			   struct uk_netdev_rx_queue *queue,
 			   struct uk_netbuf **pkt);
+static int tap_netdev_xmit_burst(struct uk_netdev *dev,
+				 struct uk_netdev_tx_queue *queue,
+				 struct uk_netbuf **pkts, __u16 *cnt);
+static int tap_netdev_recv_burst(struct uk_netdev *dev,
+				 struct uk_netdev_rx_queue *queue,
+				 struct uk_netbuf **pkts, __u16 *cnt);
 static struct uk_netdev_rx_queue *tap_netdev_rxq_setup(struct uk_netdev *dev,
 					__u16 queue_id, __u16 nb_desc,
 					struct uk_netdev_rxqueue_conf *conf);
@@ -190,7 +214,9 @@ static int tap_netdev_rxq_info_get(struct uk_netdev *dev, __u16 queue_id,
 				   struct uk_netdev_queue_info *qinfo);
 static int tap_netdev_txq_info_get(struct uk_netdev *dev, __u16 queue_id,
 				   struct uk_netdev_queue_info *qinfo);
-static int tap_device_create(struct tap_net_dev *tdev, __u32 feature_flags);
+static int tap_device_create(struct tap_net_dev *tdev, __u32 feature_flags,
+			     __u16 nb_fds);
+static void tap_device_close(struct tap_net_dev *tdev);
 static int tap_mac_generate(__u8 *addr, __u8 dev_id);
 static int tap_dev_br_add(struct tap_net_dev *tdev);
 static int tap_dev_index_get(struct tap_net_dev *tdev);
@@ -250,12 +276,184 @@ exit:
 	return rc;
 }
 
+/**
+ * Translates a segmentation offload type between uk_netbuf (UK_NETBUF_GSO_*)
+ * and vnet header (UK_TUN_VNET_HDR_GSO_*) representation.
+ * @param tdev
+ *	Reference to the tap device.
+ * @param gso_type
+ *	Type without ECN modifier.
+ * @param tx
+ *	If non-zero, `gso_type` is a UK_NETBUF_GSO_* type that is transmitted,
+ *	otherwise it is a received UK_TUN_VNET_HDR_GSO_* type.
+ * @return
+ *	>= 0, the translated type.
+ *	-ENOTSUP, the type is not supported.
+ */
+static int tap_gso_type(struct tap_net_dev *tdev, __u8 gso_type, int tx)
+{
+	if (tx) {
+		/* The host segments whatever we hand over */
+		switch (gso_type) {
+		case UK_NETBUF_GSO_TCPV4:
+			return UK_TUN_VNET_HDR_GSO_TCPV4;
+		case UK_NETBUF_GSO_TCPV6:
+			return UK_TUN_VNET_HDR_GSO_TCPV6;
+		default:
+			break;
+		}
+		return -ENOTSUP;
+	}
+
+	switch (gso_type) {
+	case UK_TUN_VNET_HDR_GSO_TCPV4:
+		if (tdev->offloads & UK_TUN_F_TSO4)
+			return UK_NETBUF_GSO_TCPV4;
+		break;
+	case UK_TUN_VNET_HDR_GSO_TCPV6:
+		if (tdev->offloads & UK_TUN_F_TSO6)
+			return UK_NETBUF_GSO_TCPV6;
+		break;
+	default:
+		break;
+	}
+	return -ENOTSUP;
+}
+
+/**
+ * Reads one frame into a receive buffer with a single system call. With a
+ * vnet header, the header is scattered to the stack and translated into the
+ * offload fields of the netbuf.
+ * @return
+ *	> 0, length of the received frame.
+ *	0, -EWOULDBLOCK, no frame available.
+ *	< 0, otherwise.
+ */
+static int tap_netdev_pkt_read(struct tap_net_dev *tdev, int fd,
+			       struct uk_netbuf *pkt)
+{
+	struct uk_tun_vnet_hdr vhdr;
+	struct k_iovec iov[2];
+	int rc;
+
+	if (!tdev->vnet_hdr) {
+		rc = tap_read(fd, pkt->data, pkt->len);
+		if (rc > 0)
+			pkt->len = rc;
+		return rc;
+	}
+
+	iov[0].iov_base = &vhdr;
+	iov[0].iov_len = sizeof(vhdr);
+	iov[1].iov_base = pkt->data;
+	iov[1].iov_len = pkt->len;
+	rc = tap_readv(fd, iov, ARRAY_SIZE(iov));
+	if (rc <= 0)
+		return rc;
+	if (unlikely(rc <= (int) sizeof(vhdr))) {
+		uk_pr_err(DRIVER_NAME": Received invalid packet size: %d\n",
+			  rc);
+		return -EINVAL;
+	}
+	pkt->len = rc - sizeof(vhdr);
+
+	pkt->flags = (vhdr.flags & UK_TUN_VNET_HDR_F_DATA_VALID)
+		     ? UK_NETBUF_F_DATA_VALID : 0x0;
+	if (vhdr.flags & UK_TUN_VNET_HDR_F_NEEDS_CSUM) {
+		pkt->flags |= UK_NETBUF_F_PARTIAL_CSUM;
+		pkt->csum_start = vhdr.csum_start;
+		pkt->csum_offset = vhdr.csum_offset;
+	}
+	pkt->gso_type = UK_NETBUF_GSO_NONE;
+	if ((vhdr.gso_type & ~UK_TUN_VNET_HDR_GSO_ECN)
+	    != UK_TUN_VNET_HDR_GSO_NONE) {
+		rc = tap_gso_type(tdev,
+				  vhdr.gso_type & ~UK_TUN_VNET_HDR_GSO_ECN, 0);
+		if (unlikely(rc < 0)) {
+			uk_pr_err(DRIVER_NAME": Received unknown segmentation offload: 0x%"__PRIx8"\n",
+				  vhdr.gso_type);
+			return -EINVAL;
+		}
+		pkt->gso_type = (__u8) rc;
+		if (vhdr.gso_type & UK_TUN_VNET_HDR_GSO_ECN)
+			pkt->gso_type |= UK_NETBUF_GSO_ECN;
+		pkt->gso_size = vhdr.gso_size;
+		pkt->hdr_len = vhdr.hdr_len;
+	}
+	return pkt->len;
+}
+
+/**
+ * Writes a netbuf chain as one frame with a single system call. With a vnet
+ * header, the offload requests of the netbuf are handed to the host.
+ * @return
+ *	> 0, number of bytes written.
+ *	-EAGAIN, the host queue is full.
+ *	< 0, otherwise. The packet was not sent.
+ */
+static int tap_netdev_pkt_write(struct tap_net_dev *tdev, int fd,
+				struct uk_netbuf *pkt)
+{
+	struct uk_tun_vnet_hdr vhdr = {0};
+	struct k_iovec iov[TAP_IOV_MAX];
+	struct uk_netbuf *seg;
+	int iovcnt = 0;
+	__u8 gso_type;
+	int rc;
+
+	if (tdev->vnet_hdr) {
+		if (pkt->flags & UK_NETBUF_F_PARTIAL_CSUM) {
+			vhdr.flags |= UK_TUN_VNET_HDR_F_NEEDS_CSUM;
+			vhdr.csum_start = pkt->csum_start;
+			vhdr.csum_offset = pkt->csum_offset;
+		}
+
+		/* NOTE: A super-packet must come with a partial checksum */
+		gso_type = pkt->gso_type & UK_NETBUF_GSO_TYPE_MASK;
+		if (gso_type != UK_NETBUF_GSO_NONE) {
+			rc = tap_gso_type(tdev, gso_type, 1);
+			if (unlikely(rc < 0
+				     || !(pkt->flags
+					  & UK_NETBUF_F_PARTIAL_CSUM))) {
+				uk_pr_err(DRIVER_NAME": Unsupported segmentation offload: 0x%"__PRIx8"\n",
+					  pkt->gso_type);
+				return -ENOTSUP;
+			}
+			vhdr.gso_type = (__u8) rc;
+			if (pkt->gso_type & UK_NETBUF_GSO_ECN)
+				vhdr.gso_type |= UK_TUN_VNET_HDR_GSO_ECN;
+			vhdr.gso_size = pkt->gso_size;
+			vhdr.hdr_len = pkt->hdr_len;
+		}
+
+		iov[iovcnt].iov_base = &vhdr;
+		iov[iovcnt].iov_len = sizeof(vhdr);
+		iovcnt++;
+	}
+
+	/* Chains are gathered by the host instead of being linearized */
+	UK_NETBUF_CHAIN_FOREACH(seg, pkt) {
+		if (!seg->len)
+			continue;
+		if (unlikely(iovcnt == TAP_IOV_MAX)) {
+			uk_pr_err(DRIVER_NAME": Too many segments in packet %p\n",
+				  pkt);
+			return -EMSGSIZE;
+		}
+		iov[iovcnt].iov_base = seg->data;
+		iov[iovcnt].iov_len = seg->len;
+		iovcnt++;
+	}
+
+	return tap_writev(fd, iov, iovcnt);
+}
+
 static int tap_netdev_recv(struct uk_netdev *dev,
 			   struct uk_netdev_rx_queue *queue,
 			   struct uk_netbuf **pkt)
 {
 	int rc = 0;
-	struct tap_net_dev *tdev __maybe_unused;
+	struct tap_net_dev *tdev;
 	struct uk_netbuf *_pkt = NULL;
 
 	UK_ASSERT(dev);
@@ -279,11 +477,9 @@ static int tap_netdev_recv(struct uk_netdev *dev,
 	}
 	uk_pr_debug(DRIVER_NAME": Receiving on interface %s(%d) %p(%d)\n",
 		    tdev->name, queue->fd, _pkt->data, _pkt->len);
-	rc = tap_read(queue->fd, _pkt->data, _pkt->len);
+	rc = tap_netdev_pkt_read(tdev, queue->fd, _pkt);
 	if (rc > 0) {
 		uk_pr_debug(DRIVER_NAME": Recv pkt size: %d\n", rc);
-		/* Setting the length of the packet */
-		_pkt->len = rc;
 		rc = UK_NETDEV_STATUS_SUCCESS | UK_NETDEV_STATUS_MORE;
 	} else if (rc == 0 || rc == -EWOULDBLOCK || rc == -EAGAIN) {
 		rc = 0;
@@ -311,14 +507,14 @@ static int tap_netdev_xmit(struct uk_netdev *dev,
 			   struct uk_netbuf *pkt)
 {
 	int rc = -EINVAL;
-	struct tap_net_dev *tdev __unused;
+	struct tap_net_dev *tdev;
 
 	UK_ASSERT(dev);
 	UK_ASSERT(queue && pkt);
 
 	tdev = to_tapnetdev(dev);
 
-	rc = tap_write(queue->fd, pkt->data, pkt->len);
+	rc = tap_netdev_pkt_write(tdev, queue->fd, pkt);
 	if (rc > 0) {
 		uk_pr_info(DRIVER_NAME": Send packet of size %d\n", rc);
 		uk_netbuf_free(pkt);
@@ -331,6 +527,96 @@ static int tap_netdev_xmit(struct uk_netdev *dev,
 	return rc;
 }
 
+static int tap_netdev_recv_burst(struct uk_netdev *dev,
+				 struct uk_netdev_rx_queue *queue,
+				 struct uk_netbuf **pkts, __u16 *cnt)
+{
+	int rc = 0;
+	int status = 0x0;
+	struct tap_net_dev *tdev;
+	__u16 alloced, rcvd = 0, i;
+
+	UK_ASSERT(dev);
+	UK_ASSERT(queue && pkts && cnt);
+
+	tdev = to_tapnetdev(dev);
+
+	if (!queue->alloc_rxpkts)
+		return -EINVAL;
+
+	/**
+	 * Allocate the receive buffers for the whole burst at once.
+	 */
+	alloced = queue->alloc_rxpkts(queue->alloc_rxpkts_argp, pkts, *cnt);
+	if (alloced == 0) {
+		uk_pr_err(DRIVER_NAME": Failed to allocate the memory\n");
+		*cnt = 0;
+		return UK_NETDEV_STATUS_UNDERRUN | UK_NETDEV_STATUS_MORE;
+	}
+	if (alloced < *cnt)
+		status |= UK_NETDEV_STATUS_UNDERRUN;
+
+	while (rcvd < alloced) {
+		rc = tap_netdev_pkt_read(tdev, queue->fd, pkts[rcvd]);
+		if (rc <= 0)
+			break;
+		uk_pr_debug(DRIVER_NAME": Recv pkt size: %d\n", rc);
+		rcvd++;
+	}
+
+	/* Release the buffers that did not receive a packet */
+	for (i = rcvd; i < alloced; i++)
+		uk_netbuf_free(pkts[i]);
+
+	if (rc < 0 && rc != -EWOULDBLOCK && rc != -EAGAIN) {
+		uk_pr_err(DRIVER_NAME": Failed(%d) to read the packet\n", rc);
+		if (rcvd == 0) {
+			*cnt = 0;
+			return rc;
+		}
+	}
+
+	*cnt = rcvd;
+	if (rcvd > 0)
+		status |= UK_NETDEV_STATUS_SUCCESS | UK_NETDEV_STATUS_MORE;
+	return status;
+}
+
+static int tap_netdev_xmit_burst(struct uk_netdev *dev,
+				 struct uk_netdev_tx_queue *queue,
+				 struct uk_netbuf **pkts, __u16 *cnt)
+{
+	int rc = 0;
+	struct tap_net_dev *tdev;
+	__u16 sent = 0;
+
+	UK_ASSERT(dev);
+	UK_ASSERT(queue && pkts && cnt);
+
+	tdev = to_tapnetdev(dev);
+
+	while (sent < *cnt) {
+		rc = tap_netdev_pkt_write(tdev, queue->fd, pkts[sent]);
+		if (rc <= 0)
+			break;
+		uk_netbuf_free(pkts[sent]);
+		sent++;
+	}
+
+	if (sent == 0 && rc < 0 && rc != -EWOULDBLOCK && rc != -EAGAIN) {
+		*cnt = 0;
+		return rc;
+	}
+
+	uk_pr_debug(DRIVER_NAME": Sent %"__PRIu16"/%"__PRIu16" packets\n",
+		    sent, *cnt);
+	*cnt = sent;
+	if (sent == 0)
+		return UK_NETDEV_STATUS_UNDERRUN;
+	return UK_NETDEV_STATUS_SUCCESS
+		| ((rc > 0) ? UK_NETDEV_STATUS_MORE : 0x0);
+}
+
 static int tap_netdev_txq_info_get(struct uk_netdev *dev __unused,
 				   __u16 queue_id __unused,
 				   struct uk_netdev_queue_info *qinfo)
@@ -442,7 +728,8 @@ static struct uk_netdev_rx_queue *tap_netdev_rxq_setup(struct uk_netdev *dev,
 	rxq->a = conf->a;
 	rxq->alloc_rxpkts = conf->alloc_rxpkts;
 	rxq->alloc_rxpkts_argp = conf->alloc_rxpkts_argp;
-	rxq->fd = tdev->tap_fd;
+	UK_ASSERT(queue_id < tdev->nb_fds);
+	rxq->fd = tdev->tap_fds[queue_id];
 	UK_TAILQ_INSERT_TAIL(&tdev->rxqs, rxq, next);
 	tdev->rxq_cnt++;
 exit:
@@ -474,7 +761,8 @@ static struct uk_netdev_tx_queue *tap_netdev_txq_setup(struct uk_netdev *dev,
 	}
 
 	txq->queue_id = queue_id;
-	txq->fd = tdev->tap_fd;
+	UK_ASSERT(queue_id < tdev->nb_fds);
+	txq->fd = tdev->tap_fds[queue_id];
 	txq->a = conf->a;
 	UK_TAILQ_INSERT_TAIL(&tdev->txqs, txq, next);
 	tdev->txq_cnt++;
@@ -510,15 +798,28 @@ static int tap_netdev_start(struct uk_netdev *n)
 	return 0;
 }
 
-static void tap_netdev_info_get(struct uk_netdev *dev __unused,
+static void tap_netdev_info_get(struct uk_netdev *dev,
 				struct uk_netdev_info *dev_info)
 {
-	UK_ASSERT(dev_info);
-	dev_info->max_rx_queues = 1;
-	dev_info->max_tx_queues = 1;
+	struct tap_net_dev *tdev;
+
+	UK_ASSERT(dev && dev_info);
+	tdev = to_tapnetdev(dev);
+
+	dev_info->max_rx_queues = tdev->max_qpairs;
+	dev_info->max_tx_queues = tdev->max_qpairs;
+	/* The vnet header is a separate I/O vector and needs no headroom */
 	dev_info->nb_encap_tx = 0;
 	dev_info->nb_encap_rx = 0;
 	dev_info->features = 0;
+	if (tap_drv.host_features & UK_IFF_VNET_HDR) {
+		dev_info->features |= UK_NETDEV_F_PARTIAL_CSUM
+				      | UK_NETDEV_F_TSO;
+#ifdef CONFIG_TAP_NET_GRO
+		dev_info->features |= UK_NETDEV_F_GRO;
+#endif /* CONFIG_TAP_NET_GRO */
+		dev_info->max_gso_len = TAP_GSO_MAXLEN;
+	}
 }
 
 static unsigned int tap_netdev_promisc_get(struct uk_netdev *n)
@@ -647,6 +948,8 @@ static int tap_netdev_configure(struct uk_netdev *n,
 	int rc = 0;
 	struct tap_net_dev *tdev = NULL;
 	__u32 feature_flag = 0;
+	__u32 offloads;
+	__u16 nb_fds;
 
 	UK_ASSERT(n && conf);
 	tdev = to_tapnetdev(n);
@@ -656,22 +959,47 @@ static int tap_netdev_configure(struct uk_netdev *n,
 		uk_pr_err(DRIVER_NAME": rx-queue:%d, tx-queue:%d not supported",
 			  conf->nb_rx_queues, conf->nb_tx_queues);
 		return -ENOTSUP;
-	} else if (conf->nb_rx_queues > 1 || conf->nb_tx_queues > 1)
-		/**
-		 * TODO:
-		 * We don't support multi-queues on the uknetdev. Might need to
-		 * revisit this when implementing multi-queue support on
-		 * uknetdev
-		 */
+	}
+
+	/**
+	 * Receive queue `i` and transmit queue `i` share the host queue (file
+	 * descriptor) `i`, so that the host can spread the load of one
+	 * interface over multiple queues.
+	 */
+	nb_fds = MAX(MAX(conf->nb_rx_queues, conf->nb_tx_queues), 1);
+	if (nb_fds > 1)
 		feature_flag |= UK_IFF_MULTI_QUEUE;
+	if (tap_drv.host_features & UK_IFF_VNET_HDR)
+		feature_flag |= UK_IFF_VNET_HDR;
 
 	/* Open the device and configure the tap interface */
-	rc = tap_device_create(tdev, feature_flag);
+	rc = tap_device_create(tdev, feature_flag, nb_fds);
 	if (rc < 0) {
 		uk_pr_err(DRIVER_NAME": Failed to configure the tap device\n");
 		goto exit;
 	}
 
+	/**
+	 * Checksum and segmentation offload
+	 * NOTE: Large receive segments require each receive buffer to be large
+	 *       enough for a segment of 64 KiB.
+	 */
+	if (feature_flag & UK_IFF_VNET_HDR) {
+		offloads = UK_TUN_F_CSUM;
+#ifdef CONFIG_TAP_NET_GRO
+		offloads |= UK_TUN_F_TSO4 | UK_TUN_F_TSO6 | UK_TUN_F_TSO_ECN;
+#endif /* CONFIG_TAP_NET_GRO */
+		rc = tap_dev_vnet_configure(tdev->tap_fds[0],
+					    sizeof(struct uk_tun_vnet_hdr),
+					    offloads);
+		if (rc < 0) {
+			uk_pr_err(DRIVER_NAME": Failed to negotiate offloads\n");
+			goto close_tap_dev;
+		}
+		tdev->vnet_hdr = 1;
+		tdev->offloads = offloads;
+	}
+
 	/* Create a control socket for the network interface */
 	rc = tapdev_ctrlsock_create(tdev);
 	if (rc != 0) {
@@ -708,39 +1036,61 @@ exit:
 close_ctrl_sock:
 	tap_close(tdev->ctrl_sock);
 close_tap_dev:
-	tap_close(tdev->tap_fd);
+	tap_device_close(tdev);
 	goto exit;
 }
 
-static int tap_device_create(struct tap_net_dev *tdev, __u32 feature_flags)
+static void tap_device_close(struct tap_net_dev *tdev)
+{
+	while (tdev->nb_fds > 0) {
+		tdev->nb_fds--;
+		tap_close(tdev->tap_fds[tdev->nb_fds]);
+		tdev->tap_fds[tdev->nb_fds] = -1;
+	}
+}
+
+static int tap_device_create(struct tap_net_dev *tdev, __u32 feature_flags,
+			     __u16 nb_fds)
 {
 	int rc = 0;
 	struct uk_ifreq ifreq = {0};
 
-	/* Open the tap device */
-	rc = tap_open(O_RDWR | O_NONBLOCK);
-	if (rc < 0) {
-		uk_pr_err(DRIVER_NAME": Failed(%d) to open the tap device\n",
-			  rc);
-		return rc;
-	}
+	UK_ASSERT(nb_fds > 0 && nb_fds <= CONFIG_LIBUKNETDEV_MAXNBQUEUES);
 
-	tdev->tap_fd = rc;
+	/**
+	 * Every open file becomes one queue of the same interface: the
+	 * interface is created by the first one, the following ones attach to
+	 * it by the name that the host returned in `ifreq`.
+	 */
+	tdev->nb_fds = 0;
+	while (tdev->nb_fds < nb_fds) {
+		/* Open the tap device */
+		rc = tap_open(O_RDWR | O_NONBLOCK);
+		if (rc < 0) {
+			uk_pr_err(DRIVER_NAME": Failed(%d) to open the tap device\n",
+				  rc);
+			goto close_tap;
+		}
+		tdev->tap_fds[tdev->nb_fds] = rc;
 
-	rc = tap_dev_configure(tdev->tap_fd, feature_flags, &ifreq);
-	if (rc < 0) {
-		uk_pr_err(DRIVER_NAME": Failed to setup the tap device\n");
-		goto close_tap;
+		rc = tap_dev_configure(tdev->tap_fds[tdev->nb_fds],
+				       feature_flags, &ifreq);
+		if (rc < 0) {
+			uk_pr_err(DRIVER_NAME": Failed to setup the tap device\n");
+			tap_close(tdev->tap_fds[tdev->nb_fds]);
+			goto close_tap;
+		}
+		tdev->nb_fds++;
 	}
 
 	snprintf(tdev->name, sizeof(tdev->name), "%s", ifreq.ifr_name);
-	uk_pr_info(DRIVER_NAME": Configured tap device %s\n", tdev->name);
+	uk_pr_info(DRIVER_NAME": Configured tap device %s with %"__PRIu16" queue(s)\n",
+		   tdev->name, tdev->nb_fds);
 
 exit:
 	return rc;
 close_tap:
-	tap_close(tdev->tap_fd);
-	tdev->tap_fd = -1;
+	tap_device_close(tdev);
 	goto exit;
 }
 
@@ -775,13 +1125,15 @@ static int tap_dev_init(int id)
 	}
 	tdev->ndev.rx_one = tap_netdev_recv;
 	tdev->ndev.tx_one = tap_netdev_xmit;
+	tdev->ndev.rx_burst = tap_netdev_recv_burst;
+	tdev->ndev.tx_burst = tap_netdev_xmit_burst;
 	tdev->ndev.ops = &tap_netdev_ops;
 	tdev->tid = id;
-	/**
-	 * TODO:
-	 * As an initial implementation we have limit on the number of queues.
-	 */
+	/* Multiple queues require support by the host */
 	tdev->max_qpairs = 1;
+	if (tap_drv.host_features & UK_IFF_MULTI_QUEUE)
+		tdev->max_qpairs = MIN(MAX(queues, 1U),
+				       (__u32) CONFIG_LIBUKNETDEV_MAXNBQUEUES);
 
 	/* Registering the tap device with libuknet*/
 	rc = uk_netdev_drv_register(&tdev->ndev, tap_drv.a, drv_name);
@@ -812,7 +1164,7 @@ free_tdev:
  */
 static int tap_drv_probe(void)
 {
-	int i;
+	int i, fd;
 	int rc = 0;
 	char *idx = NULL, *prev_idx;
 
@@ -825,6 +1177,20 @@ static int tap_drv_probe(void)
 		}
 	}
 
+	/* Query what the host tap driver can do for all devices */
+	if (tap_dev_cnt > 0) {
+		rc = tap_open(O_RDWR);
+		if (rc >= 0) {
+			fd = rc;
+			rc = tap_dev_features_get(fd, &tap_drv.host_features);
+			tap_close(fd);
+		}
+		if (rc < 0)
+			uk_pr_warn(DRIVER_NAME": Host features unknown, using a single queue without offloads\n");
+		uk_pr_debug(DRIVER_NAME": Host features: 0x%"__PRIx32"\n",
+			    tap_drv.host_features);
+	}
+
 	idx = bridgenames;
 	for (i = 0; i < tap_dev_cnt; i++) {
 		if (idx) {
@@ -101,12 +101,16 @@ static __u64 vm_get_features(struct virtio_dev *vdev)
 }
 
 static void vm_set_features(struct virtio_dev *vdev,
-					 __u64 features)
+					 __u64 features __unused)
 {
 	struct virtio_mmio_device *vm_dev = to_virtio_mmio_device(vdev);
 
-	/* Give virtio_ring a chance to accept features. */
-	virtqueue_feature_negotiate(features);
+	/**
+	 * Give virtio_ring a chance to accept the transport and ring features
+	 * offered by the device (e.g., VIRTIO_F_VERSION_1 on modern devices).
+	 */
+	vdev->features |= vm_get_features(vdev) & VIRTIO_TRANSPORT_F_MASK;
+	vdev->features = virtqueue_feature_negotiate(vdev->features);
 
 	/* Make sure there are no mixed devices */
 	if (vm_dev->version == 2 &&
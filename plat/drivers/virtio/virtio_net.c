@@ -50,6 +50,13 @@
 #define VIRTIO_PKT_BUFFER_LEN ((UK_ETH_PAYLOAD_MAXLEN) \
 			       + (UK_ETH_HDR_UNTAGGED_LEN) \
 			       + (VIRTIO_HDR_LEN))
+/**
+ * Largest super-packet we hand over for segmentation: A maximum sized IP
+ * packet plus Ethernet and virtio header.
+ */
+#define VIRTIO_GSO_MAXLEN     (__U16_MAX \
+			       + (UK_ETH_HDR_UNTAGGED_LEN) \
+			       + (VIRTIO_HDR_LEN))
 
 #define DRIVER_NAME           "virtio-net"
 
@@ -78,6 +85,11 @@ typedef enum {
  * below is placed at the beginning of the netbuf data. Use 4 bytes of pad to
  * both keep the VirtIO header and the data non-contiguous and to keep the
  * frame's payload 4 byte aligned.
+ * With mergeable buffers, the virtio_net_hdr_mrg_rxbuf struct is placed
+ * directly in front of the receive data instead: Only the first buffer of a
+ * packet carries a header, the following buffers are filled with packet data
+ * from their beginning, so the header area and data area have to be
+ * contiguous.
  */
 struct virtio_net_hdr_padded {
 	struct virtio_net_hdr vhdr;
@@ -100,6 +112,8 @@ struct uk_netdev_tx_queue {
 	uint16_t nb_desc;
 	/* The flag to interrupt on the transmit queue */
 	uint8_t intr_enabled;
+	/* The size of the virtio header on the ring */
+	uint16_t hdr_len;
 	/* Reference to the uk_netdev */
 	struct uk_netdev *ndev;
 	/* The scatter list and its associated fragements */
@@ -123,6 +137,10 @@ struct uk_netdev_rx_queue {
 	uint16_t nb_desc;
 	/* The flag to interrupt on the transmit queue */
 	uint8_t intr_enabled;
+	/* Packets may span multiple buffers (VIRTIO_NET_F_MRG_RXBUF) */
+	uint8_t mrg_rxbuf;
+	/* The size of the virtio header on the ring */
+	uint16_t hdr_len;
 	/* User-provided receive buffer allocation function */
 	uk_netdev_alloc_rxpkts alloc_rxpkts;
 	void *alloc_rxpkts_argp;
@@ -133,6 +151,18 @@ struct uk_netdev_rx_queue {
 	struct uk_sglist_seg sgsegs[NET_MAX_FRAGMENTS];
 };
 
+/**
+ * @internal structure to submit a command on the control virtqueue.
+ */
+struct virtio_net_ctrl_cmd {
+	struct virtio_net_ctrl_hdr hdr;
+	union {
+		struct virtio_net_ctrl_mq mq;
+		__u8 raw[8];
+	} data;
+	virtio_net_ctrl_ack ack;
+};
+
 struct virtio_net_device {
 	/* Virtio Device */
 	struct virtio_dev *vdev;
@@ -141,6 +171,15 @@ struct virtio_net_device {
 	struct uk_netdev netdev;
 	/* Count of the number of the virtqueues */
 	__u16 max_vqueue_pairs;
+	/* Number of configured virtqueue pairs */
+	__u16 nb_vqueue_pairs;
+	/* Control virtqueue (VIRTIO_NET_F_CTRL_VQ) */
+	struct virtqueue *ctrl_vq;
+	/* Command buffer of the control virtqueue */
+	struct virtio_net_ctrl_cmd *ctrl_cmd;
+	/* The scatter list for the control virtqueue */
+	struct uk_sglist ctrl_sg;
+	struct uk_sglist_seg ctrl_sgsegs[3];
 	/* List of the Rx/Tx queue */
 	__u16    rx_vqueue_cnt;
 	struct   uk_netdev_rx_queue *rxqs;
@@ -195,6 +234,12 @@ static int virtio_netdev_xmit(struct uk_netdev *dev,
 static int virtio_netdev_recv(struct uk_netdev *dev,
 			      struct uk_netdev_rx_queue *queue,
 			      struct uk_netbuf **pkt);
+static int virtio_netdev_xmit_burst(struct uk_netdev *dev,
+				    struct uk_netdev_tx_queue *queue,
+				    struct uk_netbuf **pkts, __u16 *cnt);
+static int virtio_netdev_recv_burst(struct uk_netdev *dev,
+				    struct uk_netdev_rx_queue *queue,
+				    struct uk_netbuf **pkts, __u16 *cnt);
 static const struct uk_hwaddr *virtio_net_mac_get(struct uk_netdev *n);
 static __u16 virtio_net_mtu_get(struct uk_netdev *n);
 static unsigned virtio_net_promisc_get(struct uk_netdev *n);
@@ -209,6 +254,9 @@ static int virtio_netdev_rxq_enqueue(struct uk_netdev_rx_queue *rxq,
 static int virtio_netdev_recv_done(struct virtqueue *vq, void *priv);
 static int virtio_netdev_rx_fillup(struct uk_netdev_rx_queue *rxq,
 				   __u16 num, int notify);
+static int virtio_netdev_ctrl_send(struct virtio_net_device *vndev,
+				   __u8 class, __u8 cmd,
+				   const void *data, __u16 len);
 
 /**
  * Static global constants
@@ -236,6 +284,68 @@ static int virtio_netdev_recv_done(struct virtqueue *vq, void *priv)
 	return 1;
 }
 
+/**
+ * Submits a command on the control virtqueue and waits for the device to
+ * acknowledge it. The device processes control commands synchronously, so we
+ * poll the control virtqueue instead of waiting for an interrupt.
+ */
+static int virtio_netdev_ctrl_send(struct virtio_net_device *vndev,
+				   __u8 class, __u8 cmd,
+				   const void *data, __u16 len)
+{
+	struct virtio_net_ctrl_cmd *ctrl;
+	void *cookie;
+	int rc;
+
+	UK_ASSERT(vndev);
+	UK_ASSERT(len <= sizeof(ctrl->data));
+
+	if (unlikely(!vndev->ctrl_vq))
+		return -ENOTSUP;
+
+	ctrl = vndev->ctrl_cmd;
+	ctrl->hdr.class = class;
+	ctrl->hdr.cmd = cmd;
+	if (len)
+		memcpy(&ctrl->data, data, len);
+	ctrl->ack = VIRTIO_NET_ERR;
+
+	/**
+	 * The header and the command data are read by the device, the
+	 * acknowledgment is written by the device.
+	 */
+	uk_sglist_reset(&vndev->ctrl_sg);
+	rc = uk_sglist_append(&vndev->ctrl_sg, &ctrl->hdr, sizeof(ctrl->hdr));
+	if (likely(rc == 0 && len))
+		rc = uk_sglist_append(&vndev->ctrl_sg, &ctrl->data, len);
+	if (likely(rc == 0))
+		rc = uk_sglist_append(&vndev->ctrl_sg, &ctrl->ack,
+				      sizeof(ctrl->ack));
+	if (unlikely(rc != 0)) {
+		uk_pr_err("Failed to append to the sg list\n");
+		return rc;
+	}
+
+	rc = virtqueue_buffer_enqueue(vndev->ctrl_vq, ctrl, &vndev->ctrl_sg,
+				      vndev->ctrl_sg.sg_nseg - 1, 1);
+	if (unlikely(rc < 0)) {
+		uk_pr_err("Failed to enqueue control command: %d\n", rc);
+		return rc;
+	}
+	virtqueue_host_notify(vndev->ctrl_vq);
+
+	while (virtqueue_buffer_dequeue(vndev->ctrl_vq, &cookie, NULL) < 0)
+		ukarch_spinwait();
+	UK_ASSERT(cookie == ctrl);
+
+	if (unlikely(ctrl->ack != VIRTIO_NET_OK)) {
+		uk_pr_err("Control command %"__PRIu8":%"__PRIu8" failed\n",
+			  class, cmd);
+		return -EIO;
+	}
+	return 0;
+}
+
 static void virtio_netdev_xmit_free(struct uk_netdev_tx_queue *txq)
 {
 	struct uk_netbuf *pkt = NULL;
@@ -275,16 +385,16 @@ static int virtio_netdev_rx_fillup(struct uk_netdev_rx_queue *rxq,
 	__u16 filled = 0;
 
 	/**
-	 * Fixed amount of memory is allocated to each received buffer. In
-	 * our case since we don't support jumbo frame or LRO yet we require
-	 * that the buffer feed to the ring descriptor is atleast
+	 * Fixed amount of memory is allocated to each received buffer. Unless
+	 * mergeable receive buffers are negotiated, we require that the
+	 * buffer feed to the ring descriptor is atleast
 	 * ethernet MTU + virtio net header.
 	 * Because we using 2 descriptor for a single netbuf, our effective
 	 * queue size is just the half.
 	 */
 	nb_desc = ALIGN_DOWN(nb_desc, 2);
 	while (filled < nb_desc) {
-		req = MIN(nb_desc / 2, RX_FILLUP_BATCHLEN);
+		req = MIN((nb_desc - filled) / 2, RX_FILLUP_BATCHLEN);
 		cnt = rxq->alloc_rxpkts(rxq->alloc_rxpkts_argp, netbuf, req);
 		for (i = 0; i < cnt; i++) {
 			uk_pr_debug("Enqueue netbuf %"PRIu16"/%"PRIu16" (%p) to virtqueue %p...\n",
@@ -327,31 +437,80 @@ out:
 	return status;
 }
 
-static int virtio_netdev_xmit(struct uk_netdev *dev,
-			      struct uk_netdev_tx_queue *queue,
-			      struct uk_netbuf *pkt)
+/**
+ * Translates a segmentation offload type between uk_netbuf (UK_NETBUF_GSO_*)
+ * and virtio (VIRTIO_NET_HDR_GSO_*) representation. The translation fails for
+ * types that were not negotiated with the device.
+ * @param vndev
+ *	Reference to the virtio net device.
+ * @param gso_type
+ *	Type without ECN modifier.
+ * @param tx
+ *	If non-zero, `gso_type` is a UK_NETBUF_GSO_* type that is transmitted,
+ *	otherwise it is a received VIRTIO_NET_HDR_GSO_* type.
+ * @return
+ *	>= 0, the translated type.
+ *	-ENOTSUP, the type is not supported.
+ */
+static int virtio_netdev_gso_type(struct virtio_net_device *vndev,
+				  __u8 gso_type, int tx)
+{
+	__u64 features = vndev->vdev->features;
+
+	if (tx) {
+		switch (gso_type) {
+		case UK_NETBUF_GSO_TCPV4:
+			if (VIRTIO_FEATURE_HAS(features,
+					       VIRTIO_NET_F_HOST_TSO4))
+				return VIRTIO_NET_HDR_GSO_TCPV4;
+			break;
+		case UK_NETBUF_GSO_TCPV6:
+			if (VIRTIO_FEATURE_HAS(features,
+					       VIRTIO_NET_F_HOST_TSO6))
+				return VIRTIO_NET_HDR_GSO_TCPV6;
+			break;
+		default:
+			break;
+		}
+		return -ENOTSUP;
+	}
+
+	switch (gso_type) {
+	case VIRTIO_NET_HDR_GSO_TCPV4:
+		if (VIRTIO_FEATURE_HAS(features, VIRTIO_NET_F_GUEST_TSO4))
+			return UK_NETBUF_GSO_TCPV4;
+		break;
+	case VIRTIO_NET_HDR_GSO_TCPV6:
+		if (VIRTIO_FEATURE_HAS(features, VIRTIO_NET_F_GUEST_TSO6))
+			return UK_NETBUF_GSO_TCPV6;
+		break;
+	default:
+		break;
+	}
+	return -ENOTSUP;
+}
+
+/**
+ * Prepends the virtio header to a netbuf and adds it to the transmit
+ * virtqueue without notifying the host.
+ * @return
+ *	>= 0 Number of descriptors still available in the virtqueue.
+ *	-ENOSPC, not enough descriptors available for this packet.
+ *	< 0, otherwise. The packet was not enqueued.
+ */
+static int virtio_netdev_xmit_enqueue(struct uk_netdev_tx_queue *queue,
+				      struct uk_netbuf *pkt)
 {
-	struct virtio_net_device *vndev __unused;
 	struct virtio_net_hdr *vhdr;
 	struct virtio_net_hdr_padded *padded_hdr;
 	int16_t header_sz = sizeof(*padded_hdr);
 	int rc = 0;
-	int status = 0x0;
 	size_t total_len = 0;
+	size_t max_len = VIRTIO_PKT_BUFFER_LEN;
 	__u8  *buf_start;
+	__u8 gso_type;
 	size_t buf_len;
 
-	UK_ASSERT(dev);
-	UK_ASSERT(pkt && queue);
-
-	vndev = to_virtionetdev(dev);
-	/**
-	 * We are reclaiming the free descriptors from buffers. The function is
-	 * not protected by means of locks. We need to be careful if there are
-	 * multiple context through which we free the tx descriptors.
-	 */
-	virtio_netdev_xmit_free(queue);
-
 	buf_start = pkt->data;
 	buf_len = pkt->len;
 	/**
@@ -360,8 +519,7 @@ static int virtio_netdev_xmit(struct uk_netdev *dev,
 	rc = uk_netbuf_header(pkt, header_sz);
 	if (unlikely(rc != 1)) {
 		uk_pr_err("Failed to prepend virtio header\n");
-		rc = -ENOSPC;
-		goto err_exit;
+		return -ENOSPC;
 	}
 	vhdr = pkt->data;
 
@@ -378,14 +536,39 @@ static int virtio_netdev_xmit(struct uk_netdev *dev,
 	 *       to `uk_sglist_append_netbuf()`. However, a netbuf
 	 *       chain can only once have set the PARTIAL_CSUM flag.
 	 */
-	memset(vhdr, 0, sizeof(*vhdr));
+	memset(vhdr, 0, queue->hdr_len);
 	if (pkt->flags & UK_NETBUF_F_PARTIAL_CSUM) {
 		vhdr->flags       |= VIRTIO_NET_HDR_F_NEEDS_CSUM;
 		/* `csum_start` is without header size */
 		vhdr->csum_start   = pkt->csum_start - header_sz;
 		vhdr->csum_offset  = pkt->csum_offset;
 	}
-	vhdr->gso_type = VIRTIO_NET_HDR_GSO_NONE;
+
+	/**
+	 * Segmentation offload
+	 * NOTE: A super-packet must come with a partial checksum
+	 */
+	gso_type = pkt->gso_type & UK_NETBUF_GSO_TYPE_MASK;
+	if (gso_type == UK_NETBUF_GSO_NONE) {
+		vhdr->gso_type = VIRTIO_NET_HDR_GSO_NONE;
+	} else {
+		rc = virtio_netdev_gso_type(to_virtionetdev(queue->ndev),
+					    gso_type, 1);
+		if (unlikely(rc < 0
+			     || !(pkt->flags & UK_NETBUF_F_PARTIAL_CSUM))) {
+			uk_pr_err("Unsupported segmentation offload: 0x%"__PRIx8"\n",
+				  pkt->gso_type);
+			rc = -ENOTSUP;
+			goto err_remove_vhdr;
+		}
+		vhdr->gso_type = (__u8) rc;
+		if (pkt->gso_type & UK_NETBUF_GSO_ECN)
+			vhdr->gso_type |= VIRTIO_NET_HDR_GSO_ECN;
+		vhdr->gso_size = pkt->gso_size;
+		/* `hdr_len` is without header size */
+		vhdr->hdr_len  = pkt->hdr_len;
+		max_len = VIRTIO_GSO_MAXLEN;
+	}
 
 	/**
 	 * Prepare the sglist and enqueue the buffer to the virtio-ring.
@@ -400,7 +583,7 @@ static int virtio_netdev_xmit(struct uk_netdev *dev,
 	 * 1 for the virtio header and the other for the actual network packet.
 	 */
 	/* Appending the data to the list. */
-	rc = uk_sglist_append(&queue->sg, vhdr, sizeof(*vhdr));
+	rc = uk_sglist_append(&queue->sg, vhdr, queue->hdr_len);
 	if (unlikely(rc != 0)) {
 		uk_pr_err("Failed to append to the sg list\n");
 		goto err_remove_vhdr;
@@ -419,9 +602,9 @@ static int virtio_netdev_xmit(struct uk_netdev *dev,
 	}
 
 	total_len = uk_sglist_length(&queue->sg);
-	if (unlikely(total_len > VIRTIO_PKT_BUFFER_LEN)) {
-		uk_pr_err("Packet size too big: %lu, max:%u\n",
-			  total_len, VIRTIO_PKT_BUFFER_LEN);
+	if (unlikely(total_len > max_len)) {
+		uk_pr_err("Packet size too big: %lu, max:%lu\n",
+			  total_len, max_len);
 		rc = -ENOTSUP;
 		goto err_remove_vhdr;
 	}
@@ -431,43 +614,105 @@ static int virtio_netdev_xmit(struct uk_netdev *dev,
 	 */
 	rc = virtqueue_buffer_enqueue(queue->vq, pkt, &queue->sg,
 				      queue->sg.sg_nseg, 0);
-	if (likely(rc >= 0)) {
-		status |= UK_NETDEV_STATUS_SUCCESS;
-		/**
-		 * Notify the host the new buffer.
-		 */
-		virtqueue_host_notify(queue->vq);
-		/**
-		 * When there is further space available in the ring
-		 * return UK_NETDEV_STATUS_MORE.
-		 */
-		status |= likely(rc > 0) ? UK_NETDEV_STATUS_MORE : 0x0;
-	} else if (rc == -ENOSPC) {
+	if (likely(rc >= 0))
+		return rc;
+
+	if (rc == -ENOSPC)
 		uk_pr_debug("No more descriptor available\n");
-		/**
-		 * Remove header before exiting because we could not send
-		 */
-		uk_netbuf_header(pkt, -header_sz);
-	} else {
+	else
 		uk_pr_err("Failed to enqueue descriptors into the ring: %d\n",
 			  rc);
-		goto err_remove_vhdr;
-	}
-	return status;
 
 err_remove_vhdr:
+	/**
+	 * Remove header before exiting because we could not send
+	 */
 	uk_netbuf_header(pkt, -header_sz);
-err_exit:
 	UK_ASSERT(rc < 0);
 	return rc;
 }
 
+static int virtio_netdev_xmit(struct uk_netdev *dev,
+			      struct uk_netdev_tx_queue *queue,
+			      struct uk_netbuf *pkt)
+{
+	int rc;
+
+	UK_ASSERT(dev);
+	UK_ASSERT(pkt && queue);
+
+	/**
+	 * We are reclaiming the free descriptors from buffers. The function is
+	 * not protected by means of locks. We need to be careful if there are
+	 * multiple context through which we free the tx descriptors.
+	 */
+	virtio_netdev_xmit_free(queue);
+
+	rc = virtio_netdev_xmit_enqueue(queue, pkt);
+	if (rc == -ENOSPC)
+		return 0x0;
+	if (unlikely(rc < 0))
+		return rc;
+
+	/**
+	 * Notify the host the new buffer.
+	 */
+	virtqueue_host_notify(queue->vq);
+
+	/**
+	 * When there is further space available in the ring
+	 * return UK_NETDEV_STATUS_MORE.
+	 */
+	return UK_NETDEV_STATUS_SUCCESS
+		| (likely(rc > 0) ? UK_NETDEV_STATUS_MORE : 0x0);
+}
+
+static int virtio_netdev_xmit_burst(struct uk_netdev *dev,
+				    struct uk_netdev_tx_queue *queue,
+				    struct uk_netbuf **pkts, __u16 *cnt)
+{
+	__u16 i;
+	int rc = 0;
+
+	UK_ASSERT(dev);
+	UK_ASSERT(queue && pkts && cnt);
+
+	/* Reclaim the descriptors once for the whole burst */
+	virtio_netdev_xmit_free(queue);
+
+	for (i = 0; i < *cnt; i++) {
+		rc = virtio_netdev_xmit_enqueue(queue, pkts[i]);
+		if (rc < 0)
+			break;
+		if (rc == 0) {
+			/* The ring is full after this packet */
+			i++;
+			break;
+		}
+	}
+
+	if (unlikely(i == 0)) {
+		*cnt = 0;
+		return (rc == -ENOSPC) ? 0x0 : rc;
+	}
+
+	/**
+	 * A single notification to the host for all the new buffers.
+	 */
+	virtqueue_host_notify(queue->vq);
+
+	*cnt = i;
+	return UK_NETDEV_STATUS_SUCCESS
+		| ((rc > 0) ? UK_NETDEV_STATUS_MORE : 0x0);
+}
+
 static int virtio_netdev_rxq_enqueue(struct uk_netdev_rx_queue *rxq,
 				     struct uk_netbuf *netbuf)
 {
 	int rc = 0;
-	struct virtio_net_hdr_padded *rxhdr;
-	int16_t header_sz = sizeof(*rxhdr);
+	struct virtio_net_hdr *rxhdr;
+	int16_t header_sz;
+	size_t hdr_len;
 	__u8 *buf_start;
 	size_t buf_len = 0;
 	struct uk_sglist *sg;
@@ -486,6 +731,9 @@ static int virtio_netdev_rxq_enqueue(struct uk_netdev_rx_queue *rxq,
 	/**
 	 * Retrieve the buffer header length.
 	 */
+	hdr_len = rxq->hdr_len;
+	header_sz = (rxq->mrg_rxbuf) ? hdr_len
+				     : sizeof(struct virtio_net_hdr_padded);
 	rc = uk_netbuf_header(netbuf, header_sz);
 	if (unlikely(rc != 1)) {
 		uk_pr_err("Failed to allocate space to prepend virtio header\n");
@@ -497,7 +745,7 @@ static int virtio_netdev_rxq_enqueue(struct uk_netdev_rx_queue *rxq,
 	uk_sglist_reset(sg);
 
 	/* Appending the header buffer to the sglist */
-	uk_sglist_append(sg, rxhdr, sizeof(struct virtio_net_hdr));
+	uk_sglist_append(sg, rxhdr, hdr_len);
 
 	/* Appending the data buffer to the sglist */
 	uk_sglist_append(sg, buf_start, buf_len);
@@ -506,6 +754,47 @@ static int virtio_netdev_rxq_enqueue(struct uk_netdev_rx_queue *rxq,
 	return rc;
 }
 
+/**
+ * Collects the remaining buffers of a packet that was spread over multiple
+ * receive buffers (VIRTIO_NET_F_MRG_RXBUF) and appends them to `head`.
+ * @return
+ *	>= 0, return value of the last virtqueue dequeue.
+ *	< 0, the packet is incomplete.
+ */
+static int virtio_netdev_rxq_dequeue_mrg(struct uk_netdev_rx_queue *rxq,
+					 struct uk_netbuf *head,
+					 __u16 num_buffers)
+{
+	struct uk_netbuf *buf;
+	__u32 len;
+	int ret = 0;
+
+	while (--num_buffers > 0) {
+		ret = virtqueue_buffer_dequeue(rxq->vq, (void **) &buf, &len);
+		if (unlikely(ret < 0)) {
+			uk_pr_err("Missing %"__PRIu16" buffer(s) of merged packet\n",
+				  num_buffers);
+			return -EINVAL;
+		}
+
+		/**
+		 * Following buffers do not carry a virtio header: The packet
+		 * data starts where the header area begins.
+		 */
+		if (unlikely(len > buf->len)) {
+			uk_pr_err("Received invalid buffer size: %"__PRIu32"\n",
+				  len);
+			uk_netbuf_free(buf);
+			return -EINVAL;
+		}
+		buf->len = len;
+		buf->flags = 0x0;
+		buf->gso_type = UK_NETBUF_GSO_NONE;
+		uk_netbuf_append(head, buf);
+	}
+	return ret;
+}
+
 static int virtio_netdev_rxq_dequeue(struct uk_netdev_rx_queue *rxq,
 				     struct uk_netbuf **netbuf)
 {
@@ -513,6 +802,8 @@ static int virtio_netdev_rxq_dequeue(struct uk_netdev_rx_queue *rxq,
 	int rc __maybe_unused = 0;
 	struct uk_netbuf *buf = NULL;
 	struct virtio_net_hdr *vhdr;
+	__u16 header_sz, hdr_len;
+	__u16 num_buffers = 1;
 	__u32 len;
 
 	UK_ASSERT(netbuf);
@@ -523,16 +814,31 @@ static int virtio_netdev_rxq_dequeue(struct uk_netdev_rx_queue *rxq,
 		*netbuf = NULL;
 		return rxq->nb_desc;
 	}
+
+	hdr_len = rxq->hdr_len;
+	header_sz = (rxq->mrg_rxbuf) ? hdr_len
+				     : sizeof(struct virtio_net_hdr_padded);
+
+	/**
+	 * The device can never write more than the buffer space we provided:
+	 * The virtio header (without padding) and the data area.
+	 * NOTE: Packets can be larger than VIRTIO_PKT_BUFFER_LEN when large
+	 *       receive segments (VIRTIO_NET_F_GUEST_TSO*) are negotiated.
+	 */
 	if (unlikely((len < VIRTIO_HDR_LEN + UK_ETH_HDR_UNTAGGED_LEN)
-		     || (len > VIRTIO_PKT_BUFFER_LEN))) {
+		     || (len > (__u32) buf->len - (header_sz - hdr_len)))) {
 		uk_pr_err("Received invalid packet size: %"__PRIu32"\n", len);
-		return -EINVAL;
+		rc = -EINVAL;
+		goto err_free;
 	}
 
 	/**
 	 * Copy virtio header flags to netbuf
 	 */
 	vhdr = (struct virtio_net_hdr *) buf->data;
+	if (rxq->mrg_rxbuf)
+		num_buffers = ((struct virtio_net_hdr_mrg_rxbuf *)
+			       vhdr)->num_buffers;
 	buf->flags  = ((vhdr->flags & VIRTIO_NET_HDR_F_DATA_VALID)
 		       ? UK_NETBUF_F_DATA_VALID   : 0x0);
 	if (vhdr->flags & VIRTIO_NET_HDR_F_NEEDS_CSUM) {
@@ -541,8 +847,25 @@ static int virtio_netdev_rxq_dequeue(struct uk_netdev_rx_queue *rxq,
 		/* NOTE: csum_start is without virtio header
 		 *       (uk_netbuf_header() will remove it again)
 		 */
-		buf->csum_start  = vhdr->csum_start
-			+ ((uint16_t)sizeof(struct virtio_net_hdr_padded));
+		buf->csum_start  = vhdr->csum_start + header_sz;
+	}
+	buf->gso_type = UK_NETBUF_GSO_NONE;
+	if ((vhdr->gso_type & ~VIRTIO_NET_HDR_GSO_ECN)
+	    != VIRTIO_NET_HDR_GSO_NONE) {
+		rc = virtio_netdev_gso_type(to_virtionetdev(rxq->ndev),
+					    vhdr->gso_type
+					    & ~VIRTIO_NET_HDR_GSO_ECN, 0);
+		if (unlikely(rc < 0)) {
+			uk_pr_err("Received unknown segmentation offload: 0x%"__PRIx8"\n",
+				  vhdr->gso_type);
+			rc = -EINVAL;
+			goto err_free;
+		}
+		buf->gso_type = (uint8_t) rc;
+		if (vhdr->gso_type & VIRTIO_NET_HDR_GSO_ECN)
+			buf->gso_type |= UK_NETBUF_GSO_ECN;
+		buf->gso_size = vhdr->gso_size;
+		buf->hdr_len  = vhdr->hdr_len;
 	}
 
 	/**
@@ -551,69 +874,108 @@ static int virtio_netdev_rxq_dequeue(struct uk_netdev_rx_queue *rxq,
 	 * alignment of the packet data. We compensate for this, by adding the
 	 *  padding to the length on dequeue.
 	 */
-	buf->len = len + VTNET_RX_HEADER_PAD;
-	rc = uk_netbuf_header(buf,
-			      -((int16_t)sizeof(struct virtio_net_hdr_padded)));
+	buf->len = len + (header_sz - hdr_len);
+	rc = uk_netbuf_header(buf, -((int16_t) header_sz));
 	UK_ASSERT(rc == 1);
+
+	if (num_buffers > 1) {
+		rc = virtio_netdev_rxq_dequeue_mrg(rxq, buf, num_buffers);
+		if (unlikely(rc < 0))
+			goto err_free;
+		ret = rc;
+	}
 	*netbuf = buf;
 
 	return ret;
+
+err_free:
+	uk_netbuf_free(buf);
+	return rc;
 }
 
-static int virtio_netdev_recv(struct uk_netdev *dev __unused,
-			      struct uk_netdev_rx_queue *queue,
-			      struct uk_netbuf **pkt)
+/**
+ * Dequeues up to `*cnt` packets from the receive virtqueue and re-programs
+ * the used descriptors with a single host notification.
+ * @return
+ *	>= 0, status flags UK_NETDEV_STATUS_SUCCESS and
+ *	      UK_NETDEV_STATUS_UNDERRUN; `*cnt` is updated to the number of
+ *	      received packets.
+ *	< 0, no packet was received.
+ */
+static int virtio_netdev_rxq_dequeue_burst(struct uk_netdev_rx_queue *rxq,
+					   struct uk_netbuf **pkts, __u16 *cnt)
 {
 	int status = 0x0;
 	int rc = 0;
+	__u16 used = rxq->nb_desc;
+	__u16 rcvd = 0;
+
+	while (rcvd < *cnt) {
+		rc = virtio_netdev_rxq_dequeue(rxq, &pkts[rcvd]);
+		if (unlikely(rc < 0)) {
+			uk_pr_err("Failed to dequeue the packet: %d\n", rc);
+			if (rcvd == 0) {
+				*cnt = 0;
+				return rc;
+			}
+			break;
+		}
+		if (!pkts[rcvd])
+			break;
+		used = rc;
+		rcvd++;
+	}
+
+	status |= (rcvd > 0) ? UK_NETDEV_STATUS_SUCCESS : 0x0;
+	status |= virtio_netdev_rx_fillup(rxq, (rxq->nb_desc - used), 1);
+	*cnt = rcvd;
+	return status;
+}
+
+static int virtio_netdev_recv_burst(struct uk_netdev *dev __unused,
+				    struct uk_netdev_rx_queue *queue,
+				    struct uk_netbuf **pkts, __u16 *cnt)
+{
+	int status = 0x0;
+	int rc = 0;
+	__u16 req;
 
 	UK_ASSERT(dev && queue);
-	UK_ASSERT(pkt);
+	UK_ASSERT(pkts && cnt);
 
 	/* Queue interrupts have to be off when calling receive */
 	UK_ASSERT(!(queue->intr_enabled & VTNET_INTR_EN));
 
-	rc = virtio_netdev_rxq_dequeue(queue, pkt);
-	if (unlikely(rc < 0)) {
-		uk_pr_err("Failed to dequeue the packet: %d\n", rc);
+	req = *cnt;
+	rc = virtio_netdev_rxq_dequeue_burst(queue, pkts, cnt);
+	if (unlikely(rc < 0))
 		goto err_exit;
-	}
-	status |= (*pkt) ? UK_NETDEV_STATUS_SUCCESS : 0x0;
-	status |= virtio_netdev_rx_fillup(queue, (queue->nb_desc - rc), 1);
+	status |= rc;
 
 	/* Enable interrupt only when user had previously enabled it */
 	if (queue->intr_enabled & VTNET_INTR_USR_EN_MASK) {
 		/* Need to enable the interrupt on the last packet */
 		rc = virtqueue_intr_enable(queue->vq);
-		if (rc == 1 && !(*pkt)) {
+		if (rc == 1 && *cnt == 0) {
 			/**
-			 * Packet arrive after reading the queue and before
+			 * Packets arrived after reading the queue and before
 			 * enabling the interrupt
 			 */
-			rc = virtio_netdev_rxq_dequeue(queue, pkt);
-			if (unlikely(rc < 0)) {
-				uk_pr_err("Failed to dequeue the packet: %d\n",
-					  rc);
+			*cnt = req;
+			rc = virtio_netdev_rxq_dequeue_burst(queue, pkts, cnt);
+			if (unlikely(rc < 0))
 				goto err_exit;
-			}
-			status |= UK_NETDEV_STATUS_SUCCESS;
-
-			/*
-			 * Since we received something, we need to fillup
-			 * and notify
-			 */
-			status |= virtio_netdev_rx_fillup(queue,
-							  (queue->nb_desc - rc),
-							  1);
+			status |= rc;
 
 			/* Need to enable the interrupt on the last packet */
 			rc = virtqueue_intr_enable(queue->vq);
-			status |= (rc == 1) ? UK_NETDEV_STATUS_MORE : 0x0;
-		} else if (*pkt) {
-			/* When we originally got a packet and there is more */
+			status |= (rc == 1 && *cnt > 0)
+				  ? UK_NETDEV_STATUS_MORE : 0x0;
+		} else if (*cnt > 0) {
+			/* When we originally got packets and there is more */
 			status |= (rc == 1) ? UK_NETDEV_STATUS_MORE : 0x0;
 		}
-	} else if (*pkt) {
+	} else if (*cnt > 0) {
 		/**
 		 * For polling case, we report always there are further
 		 * packets unless the queue is empty.
@@ -627,6 +989,21 @@ err_exit:
 	return rc;
 }
 
+static int virtio_netdev_recv(struct uk_netdev *dev,
+			      struct uk_netdev_rx_queue *queue,
+			      struct uk_netbuf **pkt)
+{
+	__u16 cnt = 1;
+	int rc;
+
+	UK_ASSERT(pkt);
+
+	rc = virtio_netdev_recv_burst(dev, queue, pkt, &cnt);
+	if (cnt == 0)
+		*pkt = NULL;
+	return rc;
+}
+
 static struct uk_netdev_rx_queue *virtio_netdev_rx_queue_setup(
 				struct uk_netdev *n, uint16_t queue_id,
 				uint16_t nb_desc,
@@ -641,7 +1018,7 @@ static struct uk_netdev_rx_queue *virtio_netdev_rx_queue_setup(
 	UK_ASSERT(conf->alloc_rxpkts);
 
 	vndev = to_virtionetdev(n);
-	if (queue_id >= vndev->max_vqueue_pairs) {
+	if (queue_id >= vndev->nb_vqueue_pairs) {
 		uk_pr_err("Invalid virtqueue identifier: %"__PRIu16"\n",
 			  queue_id);
 		rc = -EINVAL;
@@ -670,6 +1047,18 @@ err_exit:
 	goto exit;
 }
 
+/**
+ * The virtio header is extended by `num_buffers` with mergeable receive
+ * buffers and on modern (VIRTIO_F_VERSION_1) devices.
+ */
+static inline __u16 virtio_netdev_hdr_len(struct virtio_net_device *vndev)
+{
+	if (VIRTIO_FEATURE_HAS(vndev->vdev->features, VIRTIO_NET_F_MRG_RXBUF)
+	    || VIRTIO_FEATURE_HAS(vndev->vdev->features, VIRTIO_F_VERSION_1))
+		return sizeof(struct virtio_net_hdr_mrg_rxbuf);
+	return sizeof(struct virtio_net_hdr);
+}
+
 /**
  * This function setup the vring infrastructure.
  * @param vndev
@@ -693,13 +1082,22 @@ static int virtio_netdev_vqueue_setup(struct virtio_net_device *vndev,
 	uint16_t max_desc, hwvq_id;
 	struct virtqueue *vq;
 
+	/**
+	 * Each queue pair is bound to its own pair of virtqueues, so the
+	 * queue identifier selects the virtqueue.
+	 */
+	id = queue_id;
+	if (unlikely((queue_type == VNET_RX) ? vndev->rxqs[id].vq != NULL
+					     : vndev->txqs[id].vq != NULL)) {
+		uk_pr_err("Virtqueue %"__PRIu16" is already configured\n",
+			  queue_id);
+		return -EBUSY;
+	}
 	if (queue_type == VNET_RX) {
-		id = vndev->rx_vqueue_cnt;
 		callback = virtio_netdev_recv_done;
 		max_desc = vndev->rxqs[id].max_nb_desc;
 		hwvq_id = vndev->rxqs[id].hwvq_id;
 	} else {
-		id = vndev->tx_vqueue_cnt;
 		/* We don't support the callback from the txqueue yet */
 		callback = NULL;
 		max_desc = vndev->txqs[id].max_nb_desc;
@@ -734,12 +1132,17 @@ static int virtio_netdev_vqueue_setup(struct virtio_net_device *vndev,
 		vndev->rxqs[id].vq = vq;
 		vndev->rxqs[id].nb_desc = nr_desc;
 		vndev->rxqs[id].lqueue_id = queue_id;
+		vndev->rxqs[id].mrg_rxbuf =
+			VIRTIO_FEATURE_HAS(vndev->vdev->features,
+					   VIRTIO_NET_F_MRG_RXBUF);
+		vndev->rxqs[id].hdr_len = virtio_netdev_hdr_len(vndev);
 		vndev->rx_vqueue_cnt++;
 	} else {
 		vndev->txqs[id].vq = vq;
 		vndev->txqs[id].ndev = &vndev->netdev;
 		vndev->txqs[id].nb_desc = nr_desc;
 		vndev->txqs[id].lqueue_id = queue_id;
+		vndev->txqs[id].hdr_len = virtio_netdev_hdr_len(vndev);
 		vndev->tx_vqueue_cnt++;
 	}
 	return id;
@@ -756,7 +1159,7 @@ static struct uk_netdev_tx_queue *virtio_netdev_tx_queue_setup(
 
 	UK_ASSERT(n);
 	vndev = to_virtionetdev(n);
-	if (queue_id >= vndev->max_vqueue_pairs) {
+	if (queue_id >= vndev->nb_vqueue_pairs) {
 		uk_pr_err("Invalid virtqueue identifier: %"__PRIu16"\n",
 			  queue_id);
 		rc = -EINVAL;
@@ -790,7 +1193,7 @@ static int virtio_netdev_rxq_info_get(struct uk_netdev *dev,
 	UK_ASSERT(dev);
 	UK_ASSERT(qinfo);
 	vndev = to_virtionetdev(dev);
-	if (unlikely(queue_id >= vndev->max_vqueue_pairs)) {
+	if (unlikely(queue_id >= vndev->nb_vqueue_pairs)) {
 		uk_pr_err("Invalid virtqueue id: %"__PRIu16"\n", queue_id);
 		rc = -EINVAL;
 		goto exit;
@@ -817,7 +1220,7 @@ static int virtio_netdev_txq_info_get(struct uk_netdev *dev,
 	UK_ASSERT(qinfo);
 
 	vndev = to_virtionetdev(dev);
-	if (unlikely(queue_id >= vndev->max_vqueue_pairs)) {
+	if (unlikely(queue_id >= vndev->nb_vqueue_pairs)) {
 		uk_pr_err("Invalid queue_id %"__PRIu16"\n", queue_id);
 		rc = -EINVAL;
 		goto exit;
@@ -863,6 +1266,7 @@ static int virtio_netdev_feature_negotiate(struct uk_netdev *n)
 	__u64 host_features = 0;
 	__u64 drv_features  = 0;
 	int rc = 0;
+	int large_rx;
 	struct virtio_net_device *vndev;
 
 	UK_ASSERT(n);
@@ -922,6 +1326,72 @@ static int virtio_netdev_feature_negotiate(struct uk_netdev *n)
 		VIRTIO_FEATURE_SET(drv_features, VIRTIO_NET_F_GUEST_CSUM);
 	}
 
+	/**
+	 * TCP segmentation offload
+	 * NOTE: Segmentation offloading depends on partial checksumming.
+	 */
+	if (VIRTIO_FEATURE_HAS(drv_features, VIRTIO_NET_F_CSUM)) {
+		if (VIRTIO_FEATURE_HAS(host_features, VIRTIO_NET_F_HOST_TSO4))
+			VIRTIO_FEATURE_SET(drv_features,
+					   VIRTIO_NET_F_HOST_TSO4);
+		if (VIRTIO_FEATURE_HAS(host_features, VIRTIO_NET_F_HOST_TSO6))
+			VIRTIO_FEATURE_SET(drv_features,
+					   VIRTIO_NET_F_HOST_TSO6);
+		if (VIRTIO_FEATURE_HAS(host_features, VIRTIO_NET_F_HOST_ECN)
+		    && (VIRTIO_FEATURE_HAS(drv_features,
+					   VIRTIO_NET_F_HOST_TSO4)
+			|| VIRTIO_FEATURE_HAS(drv_features,
+					      VIRTIO_NET_F_HOST_TSO6)))
+			VIRTIO_FEATURE_SET(drv_features,
+					   VIRTIO_NET_F_HOST_ECN);
+	}
+
+	/**
+	 * Mergeable receive buffers
+	 * NOTE: Packets that do not fit into a single receive buffer are
+	 *       handed over as netbuf chains.
+	 */
+	if (VIRTIO_FEATURE_HAS(host_features, VIRTIO_NET_F_MRG_RXBUF))
+		VIRTIO_FEATURE_SET(drv_features, VIRTIO_NET_F_MRG_RXBUF);
+
+	/**
+	 * Large receive segments
+	 * NOTE: Without mergeable receive buffers, the device expects each
+	 *       receive buffer to be large enough for a segment of 64 KiB.
+	 */
+#ifdef CONFIG_VIRTIO_NET_GRO
+	large_rx = 1;
+#else
+	large_rx = VIRTIO_FEATURE_HAS(drv_features, VIRTIO_NET_F_MRG_RXBUF);
+#endif /* CONFIG_VIRTIO_NET_GRO */
+	if (large_rx
+	    && VIRTIO_FEATURE_HAS(drv_features, VIRTIO_NET_F_GUEST_CSUM)) {
+		if (VIRTIO_FEATURE_HAS(host_features, VIRTIO_NET_F_GUEST_TSO4))
+			VIRTIO_FEATURE_SET(drv_features,
+					   VIRTIO_NET_F_GUEST_TSO4);
+		if (VIRTIO_FEATURE_HAS(host_features, VIRTIO_NET_F_GUEST_TSO6))
+			VIRTIO_FEATURE_SET(drv_features,
+					   VIRTIO_NET_F_GUEST_TSO6);
+		if (VIRTIO_FEATURE_HAS(host_features, VIRTIO_NET_F_GUEST_ECN)
+		    && (VIRTIO_FEATURE_HAS(drv_features,
+					   VIRTIO_NET_F_GUEST_TSO4)
+			|| VIRTIO_FEATURE_HAS(drv_features,
+					      VIRTIO_NET_F_GUEST_TSO6)))
+			VIRTIO_FEATURE_SET(drv_features,
+					   VIRTIO_NET_F_GUEST_ECN);
+	}
+
+	/**
+	 * Control virtqueue and multiqueue
+	 * NOTE: VIRTIO_NET_F_MQ requires the control virtqueue for
+	 *       enabling the queue pairs (VIRTIO_NET_CTRL_MQ_VQ_PAIRS_SET).
+	 */
+	if (VIRTIO_FEATURE_HAS(host_features, VIRTIO_NET_F_CTRL_VQ)) {
+		VIRTIO_FEATURE_SET(drv_features, VIRTIO_NET_F_CTRL_VQ);
+		if (VIRTIO_FEATURE_HAS(host_features, VIRTIO_NET_F_MQ))
+			VIRTIO_FEATURE_SET(drv_features, VIRTIO_NET_F_MQ);
+	}
+
 	/**
 	 * Announce our enabled driver features back to the backend device
 	 */
@@ -942,7 +1412,7 @@ static int virtio_netdev_feature_negotiate(struct uk_netdev *n)
 
 	if (VIRTIO_FEATURE_HAS(drv_features, VIRTIO_NET_F_MTU)) {
 		virtio_config_get(vndev->vdev,
-				  __offsetof(struct virtio_net_config, mac),
+				  __offsetof(struct virtio_net_config, mtu),
 				  &vndev->mtu, sizeof(vndev->mtu), 1);
 		vndev->max_mtu = vndev->mtu;
 	} else {
@@ -955,6 +1425,28 @@ static int virtio_netdev_feature_negotiate(struct uk_netdev *n)
 		vndev->max_mtu = vndev->mtu = UK_ETH_PAYLOAD_MAXLEN;
 	}
 
+	if (VIRTIO_FEATURE_HAS(drv_features, VIRTIO_NET_F_MQ)) {
+		virtio_config_get(vndev->vdev,
+				  __offsetof(struct virtio_net_config,
+					     max_virtqueue_pairs),
+				  &vndev->max_vqueue_pairs,
+				  sizeof(vndev->max_vqueue_pairs),
+				  sizeof(vndev->max_vqueue_pairs));
+		if (unlikely(vndev->max_vqueue_pairs
+			     < VIRTIO_NET_CTRL_MQ_VQ_PAIRS_MIN
+			     || vndev->max_vqueue_pairs
+			     > VIRTIO_NET_CTRL_MQ_VQ_PAIRS_MAX)) {
+			uk_pr_err("%p: Invalid number of virtqueue pairs: %"__PRIu16"\n",
+				  n, vndev->max_vqueue_pairs);
+			rc = -EINVAL;
+			goto err_negotiate_feature;
+		}
+	} else {
+		vndev->max_vqueue_pairs = 1;
+	}
+	uk_pr_debug("%p: Device supports %"__PRIu16" queue pair(s)\n",
+		    n, vndev->max_vqueue_pairs);
+
 	return 0;
 
 err_negotiate_feature:
@@ -962,22 +1454,68 @@ err_negotiate_feature:
 	return rc;
 }
 
+static int virtio_netdev_ctrlq_setup(struct virtio_net_device *vndev,
+				     __u16 hwvq_id, __u16 nr_desc)
+{
+	struct virtqueue *vq;
+
+	vndev->ctrl_cmd = uk_malloc(a, sizeof(*vndev->ctrl_cmd));
+	if (unlikely(!vndev->ctrl_cmd))
+		return -ENOMEM;
+
+	vq = virtio_vqueue_setup(vndev->vdev, hwvq_id, nr_desc, NULL, a);
+	if (unlikely(PTRISERR(vq))) {
+		uk_pr_err("Failed to set up control virtqueue\n");
+		uk_free(a, vndev->ctrl_cmd);
+		vndev->ctrl_cmd = NULL;
+		return PTR2ERR(vq);
+	}
+	/* Command completion is polled */
+	virtqueue_intr_disable(vq);
+
+	uk_sglist_init(&vndev->ctrl_sg, ARRAY_SIZE(vndev->ctrl_sgsegs),
+		       &vndev->ctrl_sgsegs[0]);
+	vndev->ctrl_vq = vq;
+	return 0;
+}
+
 static int virtio_netdev_rxtx_alloc(struct virtio_net_device *vndev,
 				    const struct uk_netdev_conf *conf)
 {
 	int rc = 0;
 	int i = 0;
 	int vq_avail = 0;
-	int total_vqs = conf->nb_rx_queues + conf->nb_tx_queues;
-	__u16 qdesc_size[total_vqs];
+	int total_vqs;
+	int ctrl_vq_id = -1;
+	__u16 *qdesc_size = NULL;
 
-	if (conf->nb_rx_queues != 1 || conf->nb_tx_queues != 1) {
+	if (conf->nb_rx_queues != conf->nb_tx_queues
+	    || conf->nb_rx_queues == 0
+	    || conf->nb_rx_queues > vndev->max_vqueue_pairs) {
 		uk_pr_err("Queue combination not supported: %"__PRIu16"/%"__PRIu16" rx/tx\n",
 			  conf->nb_rx_queues, conf->nb_tx_queues);
 
 		return -ENOTSUP;
 	}
 
+	/**
+	 * The virtqueue are organized as:
+	 * Virtqueue-rx0
+	 * Virtqueue-tx0
+	 * Virtqueue-rx1
+	 * Virtqueue-tx1
+	 * ...
+	 * Virtqueue-ctrlq
+	 * The control virtqueue follows the maximum number of queue pairs
+	 * supported by the device, independent of how many pairs we use.
+	 */
+	if (VIRTIO_FEATURE_HAS(vndev->vdev->features, VIRTIO_NET_F_CTRL_VQ)) {
+		ctrl_vq_id = 2 * vndev->max_vqueue_pairs;
+		total_vqs = ctrl_vq_id + 1;
+	} else {
+		total_vqs = 2 * conf->nb_rx_queues;
+	}
+
 	/**
 	 * TODO:
 	 * The virtio device management data structure are allocated using the
@@ -985,9 +1523,10 @@ static int virtio_netdev_rxtx_alloc(struct virtio_net_device *vndev,
 	 * wiser to move it to the allocator of each individual queue. This
 	 * would better considering NUMA support.
 	 */
-	vndev->rxqs = uk_malloc(a, sizeof(*vndev->rxqs) * conf->nb_rx_queues);
-	vndev->txqs = uk_malloc(a, sizeof(*vndev->txqs) * conf->nb_tx_queues);
-	if (unlikely(!vndev->rxqs || !vndev->txqs)) {
+	vndev->rxqs = uk_calloc(a, conf->nb_rx_queues, sizeof(*vndev->rxqs));
+	vndev->txqs = uk_calloc(a, conf->nb_tx_queues, sizeof(*vndev->txqs));
+	qdesc_size = uk_calloc(a, total_vqs, sizeof(*qdesc_size));
+	if (unlikely(!vndev->rxqs || !vndev->txqs || !qdesc_size)) {
 		uk_pr_err("Failed to allocate memory for queue management\n");
 		rc = -ENOMEM;
 		goto err_free_txrx;
@@ -1001,16 +1540,7 @@ static int virtio_netdev_rxtx_alloc(struct virtio_net_device *vndev,
 		goto err_free_txrx;
 	}
 
-	/**
-	 * The virtqueue are organized as:
-	 * Virtqueue-rx0
-	 * Virtqueue-tx0
-	 * Virtqueue-rx1
-	 * Virtqueue-tx1
-	 * ...
-	 * Virtqueue-ctrlq
-	 */
-	for (i = 0; i < vndev->max_vqueue_pairs; i++) {
+	for (i = 0; i < conf->nb_rx_queues; i++) {
 		/**
 		 * Initialize the received queue with the information received
 		 * from the device.
@@ -1033,14 +1563,27 @@ static int virtio_netdev_rxtx_alloc(struct virtio_net_device *vndev,
 				sizeof(vndev->txqs[i].sgsegs[0])),
 			       &vndev->txqs[i].sgsegs[0]);
 	}
+
+	if (ctrl_vq_id >= 0) {
+		rc = virtio_netdev_ctrlq_setup(vndev, ctrl_vq_id,
+					       qdesc_size[ctrl_vq_id]);
+		if (unlikely(rc < 0))
+			goto err_free_txrx;
+	}
+	vndev->nb_vqueue_pairs = conf->nb_rx_queues;
+	uk_free(a, qdesc_size);
 exit:
 	return rc;
 
 err_free_txrx:
-	if (!vndev->rxqs)
+	if (qdesc_size)
+		uk_free(a, qdesc_size);
+	if (vndev->rxqs)
 		uk_free(a, vndev->rxqs);
-	if (!vndev->txqs)
+	if (vndev->txqs)
 		uk_free(a, vndev->txqs);
+	vndev->rxqs = NULL;
+	vndev->txqs = NULL;
 	goto exit;
 }
 
@@ -1114,34 +1657,53 @@ static void virtio_net_info_get(struct uk_netdev *dev,
 
 	dev_info->max_rx_queues = vndev->max_vqueue_pairs;
 	dev_info->max_tx_queues = vndev->max_vqueue_pairs;
+	dev_info->in_queue_pairs = 1;
 	dev_info->max_mtu = vndev->max_mtu;
 	dev_info->nb_encap_tx = sizeof(struct virtio_net_hdr_padded);
 	dev_info->nb_encap_rx = sizeof(struct virtio_net_hdr_padded);
 	dev_info->ioalign = sizeof(void *); /* word size alignment */
 	dev_info->features = UK_NETDEV_F_RXQ_INTR
 		| (VIRTIO_FEATURE_HAS(vndev->vdev->features, VIRTIO_NET_F_CSUM)
-		   ? UK_NETDEV_F_PARTIAL_CSUM : 0);
+		   ? UK_NETDEV_F_PARTIAL_CSUM : 0)
+		| ((VIRTIO_FEATURE_HAS(vndev->vdev->features,
+				       VIRTIO_NET_F_HOST_TSO4)
+		    || VIRTIO_FEATURE_HAS(vndev->vdev->features,
+					  VIRTIO_NET_F_HOST_TSO6))
+		   ? UK_NETDEV_F_TSO : 0)
+		| ((VIRTIO_FEATURE_HAS(vndev->vdev->features,
+				       VIRTIO_NET_F_GUEST_TSO4)
+		    || VIRTIO_FEATURE_HAS(vndev->vdev->features,
+					  VIRTIO_NET_F_GUEST_TSO6))
+		   ? UK_NETDEV_F_GRO : 0);
+	if (dev_info->features & UK_NETDEV_F_TSO)
+		dev_info->max_gso_len = VIRTIO_GSO_MAXLEN - VIRTIO_HDR_LEN;
 }
 
 static int virtio_net_start(struct uk_netdev *n)
 {
 	struct virtio_net_device *d;
+	struct virtio_net_ctrl_mq mq;
 	int i = 0;
+	int rc;
 
 	UK_ASSERT(n != NULL);
 	d = to_virtionetdev(n);
 
+	if (d->rx_vqueue_cnt != d->nb_vqueue_pairs
+	    || d->tx_vqueue_cnt != d->nb_vqueue_pairs) {
+		uk_pr_err(DRIVER_NAME": %"__PRIu16": Not all queues are configured\n",
+			  d->uid);
+		return -EINVAL;
+	}
+
 	/*
 	 * By default, interrupts are disabled and it is up to the user or
 	 * network stack to manually enable them with a call to
 	 * enable_tx|rx_intr()
 	 */
-	for (i = 0; i < d->rx_vqueue_cnt; i++) {
+	for (i = 0; i < d->nb_vqueue_pairs; i++) {
 		virtqueue_intr_disable(d->rxqs[i].vq);
 		d->rxqs[i].intr_enabled = 0;
-	}
-
-	for (i = 0; i < d->tx_vqueue_cnt; i++) {
 		virtqueue_intr_disable(d->txqs[i].vq);
 		d->txqs[i].intr_enabled = 0;
 	}
@@ -1150,9 +1712,26 @@ static int virtio_net_start(struct uk_netdev *n)
 	 * Set the DRIVER_OK status bit. At this point the device is "live".
 	 */
 	virtio_dev_drv_up(d->vdev);
-	uk_pr_info(DRIVER_NAME": %"__PRIu16" started\n", d->uid);
 
-	for (i = 0; i < d->rx_vqueue_cnt; i++)
+	/*
+	 * Without VIRTIO_NET_CTRL_MQ_VQ_PAIRS_SET, the device uses only
+	 * the first queue pair.
+	 */
+	if (VIRTIO_FEATURE_HAS(d->vdev->features, VIRTIO_NET_F_MQ)) {
+		mq.virtqueue_pairs = d->nb_vqueue_pairs;
+		rc = virtio_netdev_ctrl_send(d, VIRTIO_NET_CTRL_MQ,
+					     VIRTIO_NET_CTRL_MQ_VQ_PAIRS_SET,
+					     &mq, sizeof(mq));
+		if (unlikely(rc < 0)) {
+			uk_pr_err(DRIVER_NAME": %"__PRIu16": Failed to enable %"__PRIu16" queue pairs: %d\n",
+				  d->uid, d->nb_vqueue_pairs, rc);
+			return rc;
+		}
+	}
+	uk_pr_info(DRIVER_NAME": %"__PRIu16" started with %"__PRIu16" queue pair(s)\n",
+		   d->uid, d->nb_vqueue_pairs);
+
+	for (i = 0; i < d->nb_vqueue_pairs; i++)
 		virtqueue_host_notify(d->rxqs[i].vq);
 
 	return 0;
@@ -1190,6 +1769,8 @@ static int virtio_net_add_dev(struct virtio_dev *vdev)
 	/* register netdev */
 	vndev->netdev.rx_one = virtio_netdev_recv;
 	vndev->netdev.tx_one = virtio_netdev_xmit;
+	vndev->netdev.rx_burst = virtio_netdev_recv_burst;
+	vndev->netdev.tx_burst = virtio_netdev_xmit_burst;
 	vndev->netdev.ops = &virtio_netdev_ops;
 
 	rc = uk_netdev_drv_register(&vndev->netdev, a, drv_name);
@@ -1201,10 +1782,7 @@ static int virtio_net_add_dev(struct virtio_dev *vdev)
 	rc = 0;
 	vndev->promisc = 0;
 
-	/**
-	 * TODO:
-	 * Adding multiqueue support for the virtio net driver.
-	 */
+	/* Updated with VIRTIO_NET_F_MQ during feature negotiation */
 	vndev->max_vqueue_pairs = 1;
 	uk_pr_debug("virtio-net device registered with libuknet\n");
 
@@ -37,6 +37,7 @@
 #include <uk/print.h>
 #include <uk/plat/lcpu.h>
 #include <uk/plat/irq.h>
+#include <uk/arch/lcpu.h>
 #include <pci/pci_bus.h>
 #include <virtio/virtio_config.h>
 #include <virtio/virtio_bus.h>
@@ -46,8 +47,20 @@
 #define VENDOR_QUMRANET_VIRTIO           (0x1AF4)
 #define VIRTIO_PCI_MODERN_DEVICEID_START (0x1040)
 
+#define VIRTIO_PCI_MAX_BARS              6
+
 static struct uk_alloc *a;
 
+/**
+ * Per-virtqueue state of the modern transport.
+ */
+struct virtio_pci_vq {
+	/* Doorbell of the queue */
+	volatile __u16 *notify;
+	/* The virtqueue; NULL while the queue is released */
+	struct virtqueue *vq;
+};
+
 /**
  * The structure declares a pci device.
  */
@@ -60,6 +73,21 @@ struct virtio_pci_dev {
 	__u64 pci_isr_addr;
 	/* Pci device information */
 	struct pci_device *pdev;
+
+	/* Modern transport: mapped configuration structures */
+	volatile __u8 *common_cfg;
+	volatile __u8 *notify_base;
+	__u32 notify_len;
+	__u32 notify_off_multiplier;
+	volatile __u8 *isr;
+	volatile __u8 *device_cfg;
+	__u32 device_cfg_len;
+	/* Modern transport: per-virtqueue state */
+	__u16 num_vqs;
+	struct virtio_pci_vq *vqs;
+	/* Modern transport: MSI-X state, used if use_msix is set */
+	struct pci_msix msix;
+	int use_msix;
 };
 
 /**
@@ -96,6 +124,28 @@ static int virtio_pci_handle(void *arg);
 static int vpci_legacy_notify(struct virtio_dev *vdev, __u16 queue_id);
 static int virtio_pci_legacy_add_dev(struct pci_device *pci_dev,
 				     struct virtio_pci_dev *vpci_dev);
+static void vpci_modern_pci_dev_reset(struct virtio_dev *vdev);
+static int vpci_modern_pci_config_set(struct virtio_dev *vdev, __u16 offset,
+				      const void *buf, __u32 len);
+static int vpci_modern_pci_config_get(struct virtio_dev *vdev, __u16 offset,
+				      void *buf, __u32 len, __u8 type_len);
+static __u64 vpci_modern_pci_features_get(struct virtio_dev *vdev);
+static void vpci_modern_pci_features_set(struct virtio_dev *vdev,
+					 __u64 features);
+static int vpci_modern_pci_vq_find(struct virtio_dev *vdev, __u16 num_vq,
+				   __u16 *qdesc_size);
+static void vpci_modern_pci_status_set(struct virtio_dev *vdev, __u8 status);
+static __u8 vpci_modern_pci_status_get(struct virtio_dev *vdev);
+static struct virtqueue *vpci_modern_vq_setup(struct virtio_dev *vdev,
+					      __u16 queue_id,
+					      __u16 num_desc,
+					      virtqueue_callback_t callback,
+					      struct uk_alloc *a);
+static void vpci_modern_vq_release(struct virtio_dev *vdev,
+		struct virtqueue *vq, struct uk_alloc *a);
+static int vpci_modern_notify(struct virtio_dev *vdev, __u16 queue_id);
+static int virtio_pci_modern_add_dev(struct pci_device *pci_dev,
+				     struct virtio_pci_dev *vpci_dev);
 
 /**
  * Configuration operations legacy PCI device.
@@ -113,6 +163,62 @@ static struct virtio_config_ops vpci_legacy_ops = {
 	.vq_release   = vpci_legacy_vq_release,
 };
 
+/**
+ * Configuration operations modern (virtio 1.x) PCI device.
+ */
+static struct virtio_config_ops vpci_modern_ops = {
+	.device_reset = vpci_modern_pci_dev_reset,
+	.config_get   = vpci_modern_pci_config_get,
+	.config_set   = vpci_modern_pci_config_set,
+	.features_get = vpci_modern_pci_features_get,
+	.features_set = vpci_modern_pci_features_set,
+	.status_get   = vpci_modern_pci_status_get,
+	.status_set   = vpci_modern_pci_status_set,
+	.vqs_find     = vpci_modern_pci_vq_find,
+	.vq_setup     = vpci_modern_vq_setup,
+	.vq_release   = vpci_modern_vq_release,
+};
+
+/*
+ * Accessors for the memory-mapped structures of the modern transport. On
+ * x86, accesses to device memory are not reordered with other memory
+ * accesses, so a compiler barrier is sufficient.
+ */
+#if defined(__ARM_64__)
+#define vpci_rmb()	rmb()
+#define vpci_wmb()	wmb()
+#else
+#define vpci_rmb()	barrier()
+#define vpci_wmb()	barrier()
+#endif
+
+#define VPCI_MMIO_ACCESSORS(bits)					\
+	static inline __u##bits vpci_read##bits(volatile __u8 *base,	\
+						__u32 off)		\
+	{								\
+		__u##bits v = *(volatile __u##bits *)(base + off);	\
+									\
+		vpci_rmb();						\
+		return v;						\
+	}								\
+									\
+	static inline void vpci_write##bits(volatile __u8 *base,	\
+					    __u32 off, __u##bits v)	\
+	{								\
+		vpci_wmb();						\
+		*(volatile __u##bits *)(base + off) = v;		\
+	}
+
+VPCI_MMIO_ACCESSORS(8)
+VPCI_MMIO_ACCESSORS(16)
+VPCI_MMIO_ACCESSORS(32)
+
+static inline void vpci_write64(volatile __u8 *base, __u32 off, __u64 v)
+{
+	vpci_write32(base, off, (__u32) v);
+	vpci_write32(base, off + 4, (__u32)(v >> 32));
+}
+
 static int vpci_legacy_notify(struct virtio_dev *vdev, __u16 queue_id)
 {
 	struct virtio_pci_dev *vpdev;
@@ -135,7 +241,11 @@ static int virtio_pci_handle(void *arg)
 	UK_ASSERT(arg);
 
 	/* Reading the isr status is used to acknowledge the interrupt */
-	isr_status = virtio_cread8((void *)(unsigned long)d->pci_isr_addr, 0);
+	if (d->isr)
+		isr_status = vpci_read8(d->isr, 0);
+	else
+		isr_status = virtio_cread8((void *)(unsigned long)
+					   d->pci_isr_addr, 0);
 	/* We don't support configuration interrupt on the device */
 	if (isr_status & VIRTIO_PCI_ISR_CONFIG) {
 		uk_pr_warn("Unsupported config change interrupt received on virtio-pci device %p\n",
@@ -360,8 +470,15 @@ static void vpci_legacy_pci_features_set(struct virtio_dev *vdev,
 
 	UK_ASSERT(vdev);
 	vpdev = to_virtiopcidev(vdev);
-	/* Mask out features not supported by the virtqueue driver */
+	/**
+	 * Accept the ring features offered by the device and mask out
+	 * features not supported by the virtqueue driver
+	 */
+	features |= vpci_legacy_pci_features_get(vdev)
+		    & VIRTIO_TRANSPORT_F_MASK;
 	features = virtqueue_feature_negotiate(features);
+	/* Legacy devices support only 32 feature bits */
+	vdev->features = (__u32) features;
 	virtio_cwrite32((void *) (unsigned long)vpdev->pci_base_addr,
 			VIRTIO_PCI_GUEST_FEATURES, (__u32)features);
 }
@@ -391,6 +508,516 @@ static int virtio_pci_legacy_add_dev(struct pci_device *pci_dev,
 	return 0;
 }
 
+static int vpci_modern_notify(struct virtio_dev *vdev, __u16 queue_id)
+{
+	struct virtio_pci_dev *vpdev;
+
+	UK_ASSERT(vdev);
+	vpdev = to_virtiopcidev(vdev);
+	UK_ASSERT(queue_id < vpdev->num_vqs && vpdev->vqs[queue_id].notify);
+
+	vpci_wmb();
+	*vpdev->vqs[queue_id].notify = queue_id;
+	return 0;
+}
+
+/* MSI-X handler of a single virtqueue */
+static int vpci_modern_vq_handle(void *arg)
+{
+	struct virtio_pci_vq *pvq = (struct virtio_pci_vq *) arg;
+
+	UK_ASSERT(arg);
+
+	if (unlikely(!pvq->vq))
+		return 0;
+	return virtqueue_ring_interrupt(pvq->vq);
+}
+
+static __lcpuidx vpci_modern_vq_lcpu(__u16 queue_id __maybe_unused)
+{
+#ifdef CONFIG_VIRTIO_PCI_MSIX_SPREAD
+	return queue_id % ukplat_lcpu_count();
+#else /* !CONFIG_VIRTIO_PCI_MSIX_SPREAD */
+	return 0;
+#endif /* !CONFIG_VIRTIO_PCI_MSIX_SPREAD */
+}
+
+static struct virtqueue *vpci_modern_vq_setup(struct virtio_dev *vdev,
+					      __u16 queue_id,
+					      __u16 num_desc,
+					      virtqueue_callback_t callback,
+					      struct uk_alloc *a)
+{
+	struct virtio_pci_dev *vpdev = NULL;
+	struct virtio_pci_vq *pvq;
+	struct virtqueue *vq;
+	__u32 notify_off;
+	__u16 vector;
+	long flags;
+	int rc;
+
+	UK_ASSERT(vdev != NULL);
+
+	vpdev = to_virtiopcidev(vdev);
+	if (unlikely(queue_id >= vpdev->num_vqs)) {
+		uk_pr_err("Virtqueue %"__PRIu16" was not found\n", queue_id);
+		return ERR2PTR(-EINVAL);
+	}
+	pvq = &vpdev->vqs[queue_id];
+
+	vq = virtqueue_create(queue_id, num_desc, VIRTIO_PCI_VRING_ALIGN,
+			      callback, vpci_modern_notify, vdev, a);
+	if (PTRISERR(vq)) {
+		uk_pr_err("Failed to create the virtqueue: %d\n",
+			  PTR2ERR(vq));
+		return vq;
+	}
+
+	vpci_write16(vpdev->common_cfg, VIRTIO_PCI_COMMON_Q_SELECT, queue_id);
+	vpci_write16(vpdev->common_cfg, VIRTIO_PCI_COMMON_Q_SIZE, num_desc);
+	vpci_write64(vpdev->common_cfg, VIRTIO_PCI_COMMON_Q_DESCLO,
+		     virtqueue_physaddr(vq));
+	vpci_write64(vpdev->common_cfg, VIRTIO_PCI_COMMON_Q_AVAILLO,
+		     virtqueue_get_avail_addr(vq));
+	vpci_write64(vpdev->common_cfg, VIRTIO_PCI_COMMON_Q_USEDLO,
+		     virtqueue_get_used_addr(vq));
+
+	/* Doorbell of the queue */
+	notify_off = vpci_read16(vpdev->common_cfg, VIRTIO_PCI_COMMON_Q_NOFF)
+		     * vpdev->notify_off_multiplier;
+	if (unlikely(notify_off + sizeof(__u16) > vpdev->notify_len)) {
+		uk_pr_err("Notify offset of virtqueue %"__PRIu16
+			  " out of range\n", queue_id);
+		rc = -EINVAL;
+		goto err_destroy;
+	}
+	pvq->notify = (volatile __u16 *)(vpdev->notify_base + notify_off);
+
+	pvq->vq = vq;
+	if (vpdev->use_msix) {
+		/* The vector number equals the queue index. Its IRQ handler
+		 * was registered by vpci_modern_pci_vq_find() and looks up the
+		 * current virtqueue.
+		 */
+		pci_msix_vector_mask(&vpdev->msix, queue_id, 0);
+		vpci_write16(vpdev->common_cfg, VIRTIO_PCI_COMMON_Q_MSIX,
+			     queue_id);
+		vector = vpci_read16(vpdev->common_cfg,
+				     VIRTIO_PCI_COMMON_Q_MSIX);
+		if (unlikely(vector != queue_id)) {
+			uk_pr_err("Device rejected MSI-X vector for virtqueue %"__PRIu16"\n",
+				  queue_id);
+			pci_msix_vector_mask(&vpdev->msix, queue_id, 1);
+			rc = -EIO;
+			goto err_unset;
+		}
+	}
+
+	vpci_write16(vpdev->common_cfg, VIRTIO_PCI_COMMON_Q_ENABLE, 1);
+
+	flags = ukplat_lcpu_save_irqf();
+	UK_TAILQ_INSERT_TAIL(&vpdev->vdev.vqs, vq, next);
+	ukplat_lcpu_restore_irqf(flags);
+	return vq;
+
+err_unset:
+	pvq->vq = NULL;
+err_destroy:
+	virtqueue_destroy(vq, a);
+	return ERR2PTR(rc);
+}
+
+static void vpci_modern_vq_release(struct virtio_dev *vdev,
+		struct virtqueue *vq, struct uk_alloc *a)
+{
+	struct virtio_pci_dev *vpdev = NULL;
+	struct virtio_pci_vq *pvq;
+	long flags;
+
+	UK_ASSERT(vq != NULL);
+	UK_ASSERT(a != NULL);
+	vpdev = to_virtiopcidev(vdev);
+	UK_ASSERT(vq->queue_id < vpdev->num_vqs);
+	pvq = &vpdev->vqs[vq->queue_id];
+
+	/* A virtio 1.0 queue cannot be disabled individually, only by a
+	 * device reset. We detach its interrupt vector.
+	 */
+	vpci_write16(vpdev->common_cfg, VIRTIO_PCI_COMMON_Q_SELECT,
+		     vq->queue_id);
+	if (vpdev->use_msix) {
+		vpci_write16(vpdev->common_cfg, VIRTIO_PCI_COMMON_Q_MSIX,
+			     VIRTIO_MSI_NO_VECTOR);
+		pci_msix_vector_mask(&vpdev->msix, vq->queue_id, 1);
+	}
+
+	flags = ukplat_lcpu_save_irqf();
+	pvq->vq = NULL;
+	UK_TAILQ_REMOVE(&vpdev->vdev.vqs, vq, next);
+	ukplat_lcpu_restore_irqf(flags);
+
+	virtqueue_destroy(vq, a);
+}
+
+static int vpci_modern_pci_vq_find(struct virtio_dev *vdev, __u16 num_vqs,
+				   __u16 *qdesc_size)
+{
+	struct virtio_pci_dev *vpdev = NULL;
+	__u16 num_queues;
+	int vq_cnt = 0, i = 0, rc = 0;
+
+	UK_ASSERT(vdev);
+	vpdev = to_virtiopcidev(vdev);
+
+	/* The IRQ handlers registered below refer to the per-virtqueue state
+	 * and cannot be unregistered again
+	 */
+	if (unlikely(vpdev->vqs)) {
+		uk_pr_err("Virtqueues were already set up\n");
+		return -EBUSY;
+	}
+	vpdev->vqs = uk_calloc(a, num_vqs, sizeof(*vpdev->vqs));
+	if (unlikely(!vpdev->vqs))
+		return -ENOMEM;
+	vpdev->num_vqs = num_vqs;
+
+	/* Give every virtqueue its own MSI-X vector if the device has enough
+	 * of them and the platform can deliver MSIs. Configuration change
+	 * interrupts are not supported.
+	 */
+	vpdev->use_msix = (vpdev->msix.cap && vpdev->msix.nvec >= num_vqs);
+	for (i = 0; vpdev->use_msix && i < num_vqs; i++) {
+		rc = pci_msix_vector_setup(&vpdev->msix, i,
+					   vpci_modern_vq_lcpu(i),
+					   vpci_modern_vq_handle,
+					   &vpdev->vqs[i]);
+		if (unlikely(rc)) {
+			/* Vectors that were set up stay masked. Their
+			 * handlers do not find a virtqueue.
+			 */
+			uk_pr_debug("Failed to set up MSI-X vector %d: %d, using INTx\n",
+				    i, rc);
+			vpdev->use_msix = 0;
+		}
+		/* Vectors are unmasked when their virtqueue is set up */
+		pci_msix_vector_mask(&vpdev->msix, i, 1);
+	}
+
+	if (vpdev->use_msix) {
+		vpci_write16(vpdev->common_cfg, VIRTIO_PCI_COMMON_MSIX,
+			     VIRTIO_MSI_NO_VECTOR);
+		pci_msix_enable(&vpdev->msix);
+	} else {
+		/* Registering the interrupt for the queue */
+		rc = ukplat_irq_register(vpdev->pdev->irq, virtio_pci_handle,
+					 vpdev);
+		if (rc != 0) {
+			uk_pr_err("Failed to register the interrupt\n");
+			return rc;
+		}
+	}
+
+	num_queues = vpci_read16(vpdev->common_cfg, VIRTIO_PCI_COMMON_NUMQ);
+	for (i = 0; i < num_vqs; i++) {
+		if (unlikely(i >= num_queues)) {
+			qdesc_size[i] = 0;
+		} else {
+			vpci_write16(vpdev->common_cfg,
+				     VIRTIO_PCI_COMMON_Q_SELECT, i);
+			qdesc_size[i] = vpci_read16(vpdev->common_cfg,
+						    VIRTIO_PCI_COMMON_Q_SIZE);
+		}
+		if (unlikely(!qdesc_size[i])) {
+			uk_pr_err("Virtqueue %d not available\n", i);
+			continue;
+		}
+		vq_cnt++;
+	}
+	return vq_cnt;
+}
+
+static int vpci_modern_pci_config_set(struct virtio_dev *vdev, __u16 offset,
+				      const void *buf, __u32 len)
+{
+	struct virtio_pci_dev *vpdev = NULL;
+	__u32 i;
+
+	UK_ASSERT(vdev);
+	vpdev = to_virtiopcidev(vdev);
+
+	if (unlikely(!vpdev->device_cfg ||
+		     (__u32) offset + len > vpdev->device_cfg_len))
+		return -EINVAL;
+
+	for (i = 0; i < len; i++)
+		vpci_write8(vpdev->device_cfg, offset + i,
+			    ((const __u8 *) buf)[i]);
+	return 0;
+}
+
+static int vpci_modern_pci_config_get(struct virtio_dev *vdev, __u16 offset,
+				      void *buf, __u32 len, __u8 type_len)
+{
+	struct virtio_pci_dev *vpdev = NULL;
+	__u32 len_bytes, i;
+	__u8 gen;
+
+	UK_ASSERT(vdev);
+	vpdev = to_virtiopcidev(vdev);
+
+	if (type_len == len)
+		len_bytes = len;
+	else if (__builtin_umul_overflow(len, type_len, &len_bytes))
+		return -EFAULT;
+
+	if (unlikely(!vpdev->device_cfg ||
+		     (__u32) offset + len_bytes > vpdev->device_cfg_len))
+		return -EFAULT;
+
+	/* Retry until the device did not change the configuration while we
+	 * were reading it
+	 */
+	do {
+		gen = vpci_read8(vpdev->common_cfg,
+				 VIRTIO_PCI_COMMON_CFGGENERATION);
+		switch (type_len == len ? len : 0) {
+		case 1:
+			*(__u8 *) buf = vpci_read8(vpdev->device_cfg, offset);
+			break;
+		case 2:
+			*(__u16 *) buf = vpci_read16(vpdev->device_cfg,
+						     offset);
+			break;
+		case 4:
+			*(__u32 *) buf = vpci_read32(vpdev->device_cfg,
+						     offset);
+			break;
+		default:
+			for (i = 0; i < len_bytes; i++)
+				((__u8 *) buf)[i] =
+					vpci_read8(vpdev->device_cfg,
+						   offset + i);
+			break;
+		}
+	} while (gen != vpci_read8(vpdev->common_cfg,
+				   VIRTIO_PCI_COMMON_CFGGENERATION));
+
+	return 0;
+}
+
+static __u8 vpci_modern_pci_status_get(struct virtio_dev *vdev)
+{
+	struct virtio_pci_dev *vpdev = NULL;
+
+	UK_ASSERT(vdev);
+	vpdev = to_virtiopcidev(vdev);
+	return vpci_read8(vpdev->common_cfg, VIRTIO_PCI_COMMON_STATUS);
+}
+
+static void vpci_modern_pci_status_set(struct virtio_dev *vdev, __u8 status)
+{
+	struct virtio_pci_dev *vpdev = NULL;
+
+	/* Reset should be performed using the reset interface */
+	UK_ASSERT(vdev || status != VIRTIO_CONFIG_STATUS_RESET);
+
+	vpdev = to_virtiopcidev(vdev);
+	status |= vpci_modern_pci_status_get(vdev);
+	vpci_write8(vpdev->common_cfg, VIRTIO_PCI_COMMON_STATUS, status);
+}
+
+static void vpci_modern_pci_dev_reset(struct virtio_dev *vdev)
+{
+	struct virtio_pci_dev *vpdev = NULL;
+
+	UK_ASSERT(vdev);
+
+	vpdev = to_virtiopcidev(vdev);
+	vpci_write8(vpdev->common_cfg, VIRTIO_PCI_COMMON_STATUS,
+		    VIRTIO_CONFIG_STATUS_RESET);
+	/* The reset is complete when the device reads back 0 (4.1.4.3.2) */
+	while (vpci_read8(vpdev->common_cfg, VIRTIO_PCI_COMMON_STATUS)
+	       != VIRTIO_CONFIG_STATUS_RESET)
+		ukarch_spinwait();
+}
+
+static __u64 vpci_modern_pci_features_get(struct virtio_dev *vdev)
+{
+	struct virtio_pci_dev *vpdev = NULL;
+	__u64 features;
+
+	UK_ASSERT(vdev);
+
+	vpdev = to_virtiopcidev(vdev);
+	vpci_write32(vpdev->common_cfg, VIRTIO_PCI_COMMON_DFSELECT, 1);
+	features = vpci_read32(vpdev->common_cfg, VIRTIO_PCI_COMMON_DF);
+	features <<= 32;
+	vpci_write32(vpdev->common_cfg, VIRTIO_PCI_COMMON_DFSELECT, 0);
+	features |= vpci_read32(vpdev->common_cfg, VIRTIO_PCI_COMMON_DF);
+	return features;
+}
+
+static void vpci_modern_pci_features_set(struct virtio_dev *vdev,
+					 __u64 features)
+{
+	struct virtio_pci_dev *vpdev = NULL;
+
+	UK_ASSERT(vdev);
+	vpdev = to_virtiopcidev(vdev);
+	/**
+	 * Accept the ring features offered by the device and mask out
+	 * features not supported by the virtqueue driver
+	 */
+	features |= vpci_modern_pci_features_get(vdev)
+		    & VIRTIO_TRANSPORT_F_MASK;
+	features = virtqueue_feature_negotiate(features);
+	if (unlikely(!(features & (1ULL << VIRTIO_F_VERSION_1))))
+		uk_pr_warn("Modern virtio-pci device does not offer VIRTIO_F_VERSION_1\n");
+	vdev->features = features;
+
+	vpci_write32(vpdev->common_cfg, VIRTIO_PCI_COMMON_GFSELECT, 0);
+	vpci_write32(vpdev->common_cfg, VIRTIO_PCI_COMMON_GF,
+		     (__u32) features);
+	vpci_write32(vpdev->common_cfg, VIRTIO_PCI_COMMON_GFSELECT, 1);
+	vpci_write32(vpdev->common_cfg, VIRTIO_PCI_COMMON_GF,
+		     (__u32)(features >> 32));
+
+	/* The device confirms that it accepts the feature set by keeping
+	 * FEATURES_OK set (3.1.1)
+	 */
+	vpci_modern_pci_status_set(vdev, VIRTIO_CONFIG_STATUS_FEATURES_OK);
+	if (unlikely(!(vpci_modern_pci_status_get(vdev)
+		       & VIRTIO_CONFIG_STATUS_FEATURES_OK))) {
+		uk_pr_err("Device did not accept features %"__PRIx64"\n",
+			  features);
+		vpci_modern_pci_status_set(vdev, VIRTIO_CONFIG_STATUS_FAIL);
+	}
+}
+
+/**
+ * Maps the structure that a virtio vendor capability points to.
+ */
+static volatile __u8 *vpci_modern_map_cap(struct pci_device *pci_dev,
+					  __u8 cap, void **bars,
+					  __sz *bar_lens, __u32 *len)
+{
+	__u32 bar, offset, length;
+	int rc;
+
+	pci_conf_read(pci_dev, cap + VIRTIO_PCI_CAP_BAR, 1, &bar);
+	pci_conf_read(pci_dev, cap + VIRTIO_PCI_CAP_OFFSET, 4, &offset);
+	pci_conf_read(pci_dev, cap + VIRTIO_PCI_CAP_LENGTH, 4, &length);
+	if (bar >= VIRTIO_PCI_MAX_BARS)
+		return NULL;
+
+	if (!bars[bar]) {
+		rc = pci_bar_map(pci_dev, bar, &bars[bar], &bar_lens[bar]);
+		if (unlikely(rc)) {
+			bars[bar] = NULL;
+			return NULL;
+		}
+	}
+
+	if (unlikely((__sz) offset + length > bar_lens[bar]))
+		return NULL;
+	if (len)
+		*len = length;
+	return (volatile __u8 *) bars[bar] + offset;
+}
+
+static int virtio_pci_modern_add_dev(struct pci_device *pci_dev,
+				     struct virtio_pci_dev *vpci_dev)
+{
+	void *bars[VIRTIO_PCI_MAX_BARS] = { NULL };
+	__sz bar_lens[VIRTIO_PCI_MAX_BARS] = { 0 };
+	volatile __u8 *addr;
+	__u32 type, len, cmd;
+	__u8 cap;
+	int rc;
+
+	/* Use the first capability of each type that we can map (4.1.4.1) */
+	for (cap = pci_find_cap(pci_dev, PCI_CAP_ID_VNDR); cap;
+	     cap = pci_find_next_cap(pci_dev, cap, PCI_CAP_ID_VNDR)) {
+		pci_conf_read(pci_dev, cap + VIRTIO_PCI_CAP_CFG_TYPE, 1,
+			      &type);
+		switch (type) {
+		case VIRTIO_PCI_CAP_COMMON_CFG:
+			if (vpci_dev->common_cfg)
+				continue;
+			vpci_dev->common_cfg =
+				vpci_modern_map_cap(pci_dev, cap, bars,
+						    bar_lens, NULL);
+			break;
+		case VIRTIO_PCI_CAP_NOTIFY_CFG:
+			if (vpci_dev->notify_base)
+				continue;
+			addr = vpci_modern_map_cap(pci_dev, cap, bars,
+						   bar_lens, &len);
+			if (!addr)
+				continue;
+			pci_conf_read(pci_dev,
+				      cap + VIRTIO_PCI_NOTIFY_CAP_MULT, 4,
+				      &vpci_dev->notify_off_multiplier);
+			vpci_dev->notify_base = addr;
+			vpci_dev->notify_len = len;
+			break;
+		case VIRTIO_PCI_CAP_ISR_CFG:
+			if (vpci_dev->isr)
+				continue;
+			vpci_dev->isr = vpci_modern_map_cap(pci_dev, cap, bars,
+							    bar_lens, NULL);
+			break;
+		case VIRTIO_PCI_CAP_DEVICE_CFG:
+			if (vpci_dev->device_cfg)
+				continue;
+			vpci_dev->device_cfg =
+				vpci_modern_map_cap(pci_dev, cap, bars,
+						    bar_lens,
+						    &vpci_dev->device_cfg_len);
+			break;
+		default:
+			break;
+		}
+	}
+
+	if (!vpci_dev->common_cfg || !vpci_dev->notify_base ||
+	    !vpci_dev->isr) {
+		vpci_dev->common_cfg = NULL;
+		vpci_dev->notify_base = NULL;
+		vpci_dev->isr = NULL;
+		vpci_dev->device_cfg = NULL;
+		return -ENODEV;
+	}
+
+	/* The device accesses the virtqueues by DMA */
+	pci_conf_read(pci_dev, PCI_COMMAND, 2, &cmd);
+	pci_conf_write(pci_dev, PCI_COMMAND, 2, cmd | PCI_COMMAND_MASTER);
+
+	rc = pci_msix_init(pci_dev, &vpci_dev->msix);
+	if (rc) {
+		uk_pr_debug("virtio-pci device %04x: No MSI-X (%d), using INTx\n",
+			    pci_dev->id.device_id, rc);
+		vpci_dev->msix.cap = 0;
+	}
+
+	/* Setting the configuration operation */
+	vpci_dev->vdev.cops = &vpci_modern_ops;
+
+	/* Transitional devices carry the virtio device identifier in the
+	 * subsystem ID, modern-only devices in the PCI device ID
+	 */
+	if (pci_dev->id.device_id >= VIRTIO_PCI_MODERN_DEVICEID_START)
+		vpci_dev->vdev.id.virtio_device_id =
+			pci_dev->id.device_id - VIRTIO_PCI_MODERN_DEVICEID_START;
+	else
+		vpci_dev->vdev.id.virtio_device_id =
+			pci_dev->id.subsystem_device_id;
+
+	uk_pr_info("Added virtio-pci device %04x (modern, %s)\n",
+		   pci_dev->id.device_id,
+		   vpci_dev->msix.cap ? "MSI-X" : "INTx");
+	return 0;
+}
 
 static int virtio_pci_add_dev(struct pci_device *pci_dev)
 {
@@ -399,7 +1026,7 @@ static int virtio_pci_add_dev(struct pci_device *pci_dev)
 
 	UK_ASSERT(pci_dev != NULL);
 
-	vpci_dev = uk_malloc(a, sizeof(*vpci_dev));
+	vpci_dev = uk_calloc(a, 1, sizeof(*vpci_dev));
 	if (!vpci_dev) {
 		uk_pr_err("Failed to allocate virtio-pci device\n");
 		return -ENOMEM;
@@ -410,13 +1037,15 @@ static int virtio_pci_add_dev(struct pci_device *pci_dev)
 	vpci_dev->pci_base_addr = pci_dev->base;
 
 	/**
-	 * Probing for the legacy virtio device. We separate the legacy probing
-	 * with the possibility of supporting the modern PCI device in the
-	 * future.
+	 * Prefer the modern interface. Transitional devices offer both, so we
+	 * fall back to the legacy interface only if the modern capabilities
+	 * are missing or cannot be mapped.
 	 */
-	rc = virtio_pci_legacy_add_dev(pci_dev, vpci_dev);
+	rc = virtio_pci_modern_add_dev(pci_dev, vpci_dev);
+	if (rc == -ENODEV)
+		rc = virtio_pci_legacy_add_dev(pci_dev, vpci_dev);
 	if (rc != 0) {
-		uk_pr_err("Failed to probe (legacy) pci device: %d\n", rc);
+		uk_pr_err("Failed to probe pci device: %d\n", rc);
 		goto free_pci_dev;
 	}
 
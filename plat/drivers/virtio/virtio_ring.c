@@ -43,6 +43,7 @@
 #include <uk/plat/io.h>
 #include <virtio/virtio_ring.h>
 #include <virtio/virtqueue.h>
+#include <virtio/virtio_bus.h>
 #ifdef CONFIG_LIBUKVMEM
 #include <uk/arch/paging.h>
 #include <uk/plat/paging.h>
@@ -51,26 +52,57 @@
 #endif /* CONFIG_LIBUKVMEM */
 
 #define VIRTQUEUE_MAX_SIZE  32768
+/**
+ * Maximum number of segments of a buffer that is described with an
+ * indirect descriptor table (VIRTIO_F_INDIRECT_DESC). Buffers with more
+ * segments use the descriptors of the ring.
+ */
+#define VIRTQUEUE_INDIRECT_MAX  16
 #define to_virtqueue_vring(vq)			\
 	__containerof(vq, struct virtqueue_vring, vq)
 
 struct virtqueue_desc_info {
 	void *cookie;
 	__u16 desc_count;
+	/* Next free buffer id (packed ring only) */
+	__u16 next;
 };
 
 struct virtqueue_vring {
 	struct virtqueue vq;
 	/* Descriptor Ring */
 	struct vring vring;
+	/* Descriptor Ring with packed layout */
+	struct vring_packed vring_packed;
+	/* The ring uses the packed layout */
+	int packed;
+	/* Event index based suppression (VIRTIO_F_EVENT_IDX) */
+	int event_idx;
+	/* Number of avail index increments since the last notification */
+	__u16 num_added;
+	/**
+	 * Indirect descriptor tables (VIRTIO_F_INDIRECT_DESC), one per
+	 * head descriptor (split ring) or buffer id (packed ring)
+	 */
+	void *indirect;
+	/* Reference to the allocator of the indirect descriptor tables */
+	struct uk_alloc *a;
 	/* Reference to the vring */
 	void   *vring_mem;
 	/* Keep track of available descriptors */
 	__u16 desc_avail;
-	/* Index of the next available slot */
+	/**
+	 * Index of the next available slot (split ring), or
+	 * head of the list of free buffer ids (packed ring)
+	 */
 	__u16 head_free_desc;
 	/* Index of the last used descriptor by the host */
 	__u16 last_used_desc_idx;
+	/* Index of the next descriptor to make available (packed ring) */
+	__u16 next_avail_idx;
+	/* Wrap counters of the driver and device side (packed ring) */
+	__u8 avail_wrap_counter;
+	__u8 used_wrap_counter;
 	/* Cookie to identify driver buffer */
 	struct virtqueue_desc_info vq_info[];
 };
@@ -90,6 +122,39 @@ static inline int virtqueue_buffer_enqueue_segments(
 						    __u16 write_bufs);
 static void virtqueue_vring_init(struct virtqueue_vring *vrq, __u16 nr_desc,
 				 __u16 align);
+static void virtqueue_vring_packed_init(struct virtqueue_vring *vrq,
+					__u16 nr_desc);
+
+/**
+ * Packed ring helpers
+ */
+static inline int virtqueue_packed_desc_is_used(struct virtqueue_vring *vrq,
+						__u16 idx)
+{
+	__u16 flags;
+	int avail, used;
+
+	flags = UK_READ_ONCE(vrq->vring_packed.desc[idx].flags);
+	avail = !!(flags & (1 << VRING_PACKED_DESC_F_AVAIL));
+	used = !!(flags & (1 << VRING_PACKED_DESC_F_USED));
+
+	/**
+	 * The device marks a descriptor used by setting both flags to the
+	 * value of its wrap counter.
+	 */
+	return (avail == used) && (used == vrq->used_wrap_counter);
+}
+
+static inline __u16 virtqueue_packed_desc_flags(struct virtqueue_vring *vrq)
+{
+	/**
+	 * Making a descriptor available: The AVAIL flag matches the driver
+	 * wrap counter, the USED flag is the inverse.
+	 */
+	return vrq->avail_wrap_counter
+		? (1 << VRING_PACKED_DESC_F_AVAIL)
+		: (1 << VRING_PACKED_DESC_F_USED);
+}
 
 /**
  * Driver implementation
@@ -101,7 +166,20 @@ void virtqueue_intr_disable(struct virtqueue *vq)
 	UK_ASSERT(vq);
 
 	vrq = to_virtqueue_vring(vq);
+	if (vrq->packed) {
+		vrq->vring_packed.driver->flags =
+			VRING_PACKED_EVENT_FLAG_DISABLE;
+		return;
+	}
+
 	vrq->vring.avail->flags |= (VRING_AVAIL_F_NO_INTERRUPT);
+	/**
+	 * The device ignores the flag with VIRTIO_F_EVENT_IDX. Move the event
+	 * index behind the used index so that the next interrupt is due only
+	 * after a full wrap around.
+	 */
+	if (vrq->event_idx)
+		vring_used_event(&vrq->vring) = vrq->last_used_desc_idx - 1;
 }
 
 int virtqueue_intr_enable(struct virtqueue *vq)
@@ -112,32 +190,59 @@ int virtqueue_intr_enable(struct virtqueue *vq)
 	UK_ASSERT(vq);
 
 	vrq = to_virtqueue_vring(vq);
-	/* Check if there are no more packets enabled */
-	if (!virtqueue_hasdata(vq)) {
-		if (vrq->vring.avail->flags & VRING_AVAIL_F_NO_INTERRUPT) {
+	/**
+	 * There are more packet in the virtqueue to be processed while
+	 * the interrupt was disabled.
+	 */
+	if (virtqueue_hasdata(vq))
+		return 1;
+
+	if (vrq->packed) {
+		if (vrq->event_idx) {
+			/* Interrupt on the next used descriptor */
+			vrq->vring_packed.driver->off_wrap =
+				vrq->last_used_desc_idx
+				| (vrq->used_wrap_counter
+				   << VRING_PACKED_EVENT_F_WRAP_CTR);
+			wmb();
+			vrq->vring_packed.driver->flags =
+				VRING_PACKED_EVENT_FLAG_DESC;
+		} else if (vrq->vring_packed.driver->flags
+			   != VRING_PACKED_EVENT_FLAG_ENABLE) {
+			vrq->vring_packed.driver->flags =
+				VRING_PACKED_EVENT_FLAG_ENABLE;
+		} else {
+			return 0;
+		}
+	} else {
+		if (vrq->event_idx) {
+			/* Interrupt on the next used descriptor */
+			vring_used_event(&vrq->vring) =
+				vrq->last_used_desc_idx;
 			vrq->vring.avail->flags &=
 				(~VRING_AVAIL_F_NO_INTERRUPT);
-			/**
-			 * We enabled the interrupts. We ensure it using the
-			 * memory barrier and check if there are any further
-			 * data available in the queue. The check for data
-			 * after enabling the interrupt is to make sure we do
-			 * not miss any interrupt while transitioning to enable
-			 * interrupt. This is inline with the requirement from
-			 * virtio specification section 3.2.2
-			 */
-			mb();
-			/* Check if there are further descriptors */
-			if (virtqueue_hasdata(vq)) {
-				virtqueue_intr_disable(vq);
-				rc = 1;
-			}
+		} else if (vrq->vring.avail->flags
+			   & VRING_AVAIL_F_NO_INTERRUPT) {
+			vrq->vring.avail->flags &=
+				(~VRING_AVAIL_F_NO_INTERRUPT);
+		} else {
+			return 0;
 		}
-	} else {
-		/**
-		 * There are more packet in the virtqueue to be processed while
-		 * the interrupt was disabled.
-		 */
+	}
+
+	/**
+	 * We enabled the interrupts. We ensure it using the
+	 * memory barrier and check if there are any further
+	 * data available in the queue. The check for data
+	 * after enabling the interrupt is to make sure we do
+	 * not miss any interrupt while transitioning to enable
+	 * interrupt. This is inline with the requirement from
+	 * virtio specification section 3.2.2
+	 */
+	mb();
+	/* Check if there are further descriptors */
+	if (virtqueue_hasdata(vq)) {
+		virtqueue_intr_disable(vq);
 		rc = 1;
 	}
 	return rc;
@@ -157,6 +262,7 @@ static inline void virtqueue_ring_update_avail(struct virtqueue_vring *vrq,
 	 */
 	wmb();
 	vrq->vring.avail->idx++;
+	vrq->num_added++;
 }
 
 static inline void virtqueue_detach_desc(struct virtqueue_vring *vrq,
@@ -183,13 +289,53 @@ static inline void virtqueue_detach_desc(struct virtqueue_vring *vrq,
 	vrq->head_free_desc = head_idx;
 }
 
+static int virtqueue_packed_notify_enabled(struct virtqueue_vring *vrq)
+{
+	__u16 flags, off_wrap;
+	__u16 event_idx, new_idx, old_idx;
+
+	flags = UK_READ_ONCE(vrq->vring_packed.device->flags);
+	if (!vrq->event_idx || flags != VRING_PACKED_EVENT_FLAG_DESC) {
+		vrq->num_added = 0;
+		return (flags != VRING_PACKED_EVENT_FLAG_DISABLE);
+	}
+
+	off_wrap = UK_READ_ONCE(vrq->vring_packed.device->off_wrap);
+	event_idx = off_wrap & ~(1 << VRING_PACKED_EVENT_F_WRAP_CTR);
+	new_idx = vrq->next_avail_idx;
+	old_idx = new_idx - vrq->num_added;
+	vrq->num_added = 0;
+
+	/**
+	 * The event descriptor belongs to the previous round of the ring if
+	 * its wrap counter differs from ours.
+	 */
+	if ((off_wrap >> VRING_PACKED_EVENT_F_WRAP_CTR)
+	    != vrq->avail_wrap_counter)
+		event_idx -= vrq->vring_packed.num;
+	return vring_need_event(event_idx, new_idx, old_idx);
+}
+
 int virtqueue_notify_enabled(struct virtqueue *vq)
 {
 	struct virtqueue_vring *vrq;
+	__u16 new_idx, old_idx;
 
 	UK_ASSERT(vq);
 	vrq = to_virtqueue_vring(vq);
 
+	if (vrq->packed)
+		return virtqueue_packed_notify_enabled(vrq);
+
+	if (vrq->event_idx) {
+		new_idx = vrq->vring.avail->idx;
+		old_idx = new_idx - vrq->num_added;
+		vrq->num_added = 0;
+		/* Notify only if the device asked for one in this range */
+		return vring_need_event(vring_avail_event(&vrq->vring),
+					new_idx, old_idx);
+	}
+	vrq->num_added = 0;
 	return ((vrq->vring.used->flags & VRING_USED_F_NO_NOTIFY) == 0);
 }
 
@@ -226,6 +372,9 @@ int virtqueue_hasdata(struct virtqueue *vq)
 	UK_ASSERT(vq);
 
 	vring = to_virtqueue_vring(vq);
+	if (vring->packed)
+		return virtqueue_packed_desc_is_used(vring,
+						     vring->last_used_desc_idx);
 	return (vring->last_used_desc_idx != vring->vring.used->idx);
 }
 
@@ -234,9 +383,14 @@ __u64 virtqueue_feature_negotiate(__u64 feature_set)
 	__u64 feature = (1ULL << VIRTIO_TRANSPORT_F_START) - 1;
 
 	/**
-	 * Currently out vring driver does not support any ring feature. We will
-	 * add support to transport feature in the future.
+	 * Device specific features and the ring features that are
+	 * implemented by our vring driver.
+	 * NOTE: VIRTIO_F_VERSION_1 is decided by the transport.
 	 */
+	VIRTIO_FEATURE_SET(feature, VIRTIO_F_VERSION_1);
+	VIRTIO_FEATURE_SET(feature, VIRTIO_F_RING_PACKED);
+	VIRTIO_FEATURE_SET(feature, VIRTIO_F_EVENT_IDX);
+	VIRTIO_FEATURE_SET(feature, VIRTIO_F_INDIRECT_DESC);
 	feature &= feature_set;
 	return feature;
 }
@@ -273,6 +427,11 @@ __paddr_t virtqueue_get_avail_addr(struct virtqueue *vq)
 	UK_ASSERT(vq);
 
 	vrq = to_virtqueue_vring(vq);
+	/* Packed ring: Driver event suppression area */
+	if (vrq->packed)
+		return virtqueue_physaddr(vq) +
+			((char *)vrq->vring_packed.driver
+			 - (char *)vrq->vring_packed.desc);
 	return virtqueue_physaddr(vq) +
 		((char *)vrq->vring.avail - (char *)vrq->vring.desc);
 }
@@ -284,6 +443,11 @@ __paddr_t virtqueue_get_used_addr(struct virtqueue *vq)
 	UK_ASSERT(vq);
 
 	vrq = to_virtqueue_vring(vq);
+	/* Packed ring: Device event suppression area */
+	if (vrq->packed)
+		return virtqueue_physaddr(vq) +
+			((char *)vrq->vring_packed.device
+			 - (char *)vrq->vring_packed.desc);
 	return virtqueue_physaddr(vq) +
 		((char *)vrq->vring.used - (char *)vrq->vring.desc);
 }
@@ -295,7 +459,50 @@ unsigned int virtqueue_vring_get_num(struct virtqueue *vq)
 	UK_ASSERT(vq);
 
 	vrq = to_virtqueue_vring(vq);
-	return vrq->vring.num;
+	return (vrq->packed) ? vrq->vring_packed.num : vrq->vring.num;
+}
+
+static int virtqueue_packed_buffer_dequeue(struct virtqueue_vring *vrq,
+					   void **cookie, __u32 *len)
+{
+	struct vring_packed_desc *desc;
+	struct virtqueue_desc_info *vq_info;
+	__u16 id;
+
+	/* No new descriptor since last dequeue operation */
+	if (!virtqueue_packed_desc_is_used(vrq, vrq->last_used_desc_idx))
+		return -ENOMSG;
+	/**
+	 * We are reading the descriptor information updated by the host
+	 * after checking its flags.
+	 */
+	rmb();
+	desc = &vrq->vring_packed.desc[vrq->last_used_desc_idx];
+	id = desc->id;
+	UK_ASSERT(id < vrq->vring_packed.num);
+	if (len)
+		*len = desc->len;
+
+	vq_info = &vrq->vq_info[id];
+	*cookie = vq_info->cookie;
+	vq_info->cookie = NULL;
+
+	/**
+	 * The device writes a single used descriptor for a chain and skips
+	 * the remaining descriptors of the chain.
+	 */
+	vrq->desc_avail += vq_info->desc_count;
+	vrq->last_used_desc_idx += vq_info->desc_count;
+	if (vrq->last_used_desc_idx >= vrq->vring_packed.num) {
+		vrq->last_used_desc_idx -= vrq->vring_packed.num;
+		vrq->used_wrap_counter ^= 1;
+	}
+
+	/* Return the buffer id to the free list */
+	vq_info->desc_count = 0;
+	vq_info->next = vrq->head_free_desc;
+	vrq->head_free_desc = id;
+	return (vrq->vring_packed.num - vrq->desc_avail);
 }
 
 int virtqueue_buffer_dequeue(struct virtqueue *vq, void **cookie, __u32 *len)
@@ -308,6 +515,9 @@ int virtqueue_buffer_dequeue(struct virtqueue *vq, void **cookie, __u32 *len)
 	UK_ASSERT(cookie);
 	vrq = to_virtqueue_vring(vq);
 
+	if (vrq->packed)
+		return virtqueue_packed_buffer_dequeue(vrq, cookie, len);
+
 	/* No new descriptor since last dequeue operation */
 	if (!virtqueue_hasdata(vq))
 		return -ENOMSG;
@@ -327,6 +537,140 @@ int virtqueue_buffer_dequeue(struct virtqueue *vq, void **cookie, __u32 *len)
 	return (vrq->vring.num - vrq->desc_avail);
 }
 
+/**
+ * Fills the indirect descriptor table of `slot` with the segments of `sg`.
+ * @return
+ *	The guest physical address of the table.
+ */
+static __paddr_t virtqueue_indirect_fill(struct virtqueue_vring *vrq,
+					 __u16 slot, struct uk_sglist *sg,
+					 __u16 read_bufs, __u16 write_bufs)
+{
+	struct vring_packed_desc *pdesc;
+	struct vring_desc *desc;
+	struct uk_sglist_seg *segs;
+	__u16 total_desc, i;
+
+	total_desc = read_bufs + write_bufs;
+	UK_ASSERT(total_desc <= VIRTQUEUE_INDIRECT_MAX);
+
+	if (vrq->packed) {
+		pdesc = (struct vring_packed_desc *) vrq->indirect
+			+ slot * VIRTQUEUE_INDIRECT_MAX;
+		for (i = 0; i < total_desc; i++) {
+			segs = &sg->sg_segs[i];
+			pdesc[i].addr = segs->ss_paddr;
+			pdesc[i].len = segs->ss_len;
+			pdesc[i].id = 0;
+			pdesc[i].flags = (i >= read_bufs)
+					 ? VRING_DESC_F_WRITE : 0;
+		}
+		return ukplat_virt_to_phys(pdesc);
+	}
+
+	desc = (struct vring_desc *) vrq->indirect
+		+ slot * VIRTQUEUE_INDIRECT_MAX;
+	for (i = 0; i < total_desc; i++) {
+		segs = &sg->sg_segs[i];
+		desc[i].addr = segs->ss_paddr;
+		desc[i].len = segs->ss_len;
+		desc[i].flags = 0;
+		if (i >= read_bufs)
+			desc[i].flags |= VRING_DESC_F_WRITE;
+		if (i < total_desc - 1) {
+			desc[i].flags |= VRING_DESC_F_NEXT;
+			desc[i].next = i + 1;
+		}
+	}
+	return ukplat_virt_to_phys(desc);
+}
+
+static inline int virtqueue_use_indirect(struct virtqueue_vring *vrq,
+					 __u32 total_desc)
+{
+	return vrq->indirect && total_desc > 1
+		&& total_desc <= VIRTQUEUE_INDIRECT_MAX;
+}
+
+static int virtqueue_packed_buffer_enqueue(struct virtqueue_vring *vrq,
+					   void *cookie, struct uk_sglist *sg,
+					   __u16 read_bufs, __u16 write_bufs)
+{
+	struct vring_packed_desc *desc;
+	struct uk_sglist_seg *segs;
+	__u16 total_desc, i;
+	__u16 id, idx, head_idx;
+	__u16 head_flags = 0, flags;
+
+	total_desc = read_bufs + write_bufs;
+	id = vrq->head_free_desc;
+	UK_ASSERT(id < vrq->vring_packed.num);
+	vrq->head_free_desc = vrq->vq_info[id].next;
+	vrq->vq_info[id].cookie = cookie;
+	vrq->vq_info[id].desc_count = total_desc;
+
+	head_idx = idx = vrq->next_avail_idx;
+	if (virtqueue_use_indirect(vrq, total_desc)) {
+		/* A single ring descriptor refers to the table */
+		desc = &vrq->vring_packed.desc[idx];
+		desc->addr = virtqueue_indirect_fill(vrq, id, sg,
+						     read_bufs, write_bufs);
+		desc->len = total_desc * sizeof(struct vring_packed_desc);
+		desc->id = id;
+		head_flags = virtqueue_packed_desc_flags(vrq)
+			     | VRING_DESC_F_INDIRECT;
+		total_desc = 1;
+		vrq->vq_info[id].desc_count = total_desc;
+		if (++idx >= vrq->vring_packed.num) {
+			idx = 0;
+			vrq->avail_wrap_counter ^= 1;
+		}
+	} else {
+		for (i = 0; i < total_desc; i++) {
+			segs = &sg->sg_segs[i];
+			desc = &vrq->vring_packed.desc[idx];
+			desc->addr = segs->ss_paddr;
+			desc->len = segs->ss_len;
+			desc->id = id;
+
+			flags = virtqueue_packed_desc_flags(vrq);
+			if (i >= read_bufs)
+				flags |= VRING_DESC_F_WRITE;
+			if (i < total_desc - 1)
+				flags |= VRING_DESC_F_NEXT;
+
+			/**
+			 * The flags of the head descriptor are written last:
+			 * This makes the whole chain available to the device
+			 * at once.
+			 */
+			if (i == 0)
+				head_flags = flags;
+			else
+				desc->flags = flags;
+
+			if (++idx >= vrq->vring_packed.num) {
+				idx = 0;
+				vrq->avail_wrap_counter ^= 1;
+			}
+		}
+	}
+	vrq->next_avail_idx = idx;
+	vrq->desc_avail -= total_desc;
+	vrq->num_added += total_desc;
+
+	/**
+	 * Write barrier to make sure the descriptors are written before
+	 * the device sees the head descriptor as available.
+	 */
+	wmb();
+	vrq->vring_packed.desc[head_idx].flags = head_flags;
+
+	uk_pr_debug("Buffer id:%d, head:%d, total_desc:%d\n",
+		    id, head_idx, total_desc);
+	return vrq->desc_avail;
+}
+
 int virtqueue_buffer_enqueue(struct virtqueue *vq, void *cookie,
 			     struct uk_sglist *sg, __u16 read_bufs,
 			     __u16 write_bufs)
@@ -339,27 +683,47 @@ int virtqueue_buffer_enqueue(struct virtqueue *vq, void *cookie,
 
 	vrq = to_virtqueue_vring(vq);
 	total_desc = read_bufs + write_bufs;
-	if (unlikely(total_desc < 1 || total_desc > vrq->vring.num)) {
+	if (unlikely(total_desc < 1
+		     || total_desc > virtqueue_vring_get_num(vq))) {
 		uk_pr_err("%"__PRIu32" invalid number of descriptor\n",
 			  total_desc);
 		return -EINVAL;
-	} else if (vrq->desc_avail < total_desc) {
+	} else if (vrq->desc_avail
+		   < (virtqueue_use_indirect(vrq, total_desc)
+		      ? 1 : total_desc)) {
 		uk_pr_err("Available descriptor:%"__PRIu16", Requested descriptor:%"__PRIu32"\n",
 			  vrq->desc_avail, total_desc);
 		return -ENOSPC;
 	}
+	UK_ASSERT(cookie);
+	if (vrq->packed)
+		return virtqueue_packed_buffer_enqueue(vrq, cookie, sg,
+						       read_bufs, write_bufs);
+
 	/* Get the head of free descriptor */
 	head_idx = vrq->head_free_desc;
-	UK_ASSERT(cookie);
+
+	if (virtqueue_use_indirect(vrq, total_desc)) {
+		/* A single ring descriptor refers to the table */
+		vrq->vring.desc[head_idx].addr =
+			virtqueue_indirect_fill(vrq, head_idx, sg,
+						read_bufs, write_bufs);
+		vrq->vring.desc[head_idx].len =
+			total_desc * sizeof(struct vring_desc);
+		vrq->vring.desc[head_idx].flags = VRING_DESC_F_INDIRECT;
+		idx = vrq->vring.desc[head_idx].next;
+		total_desc = 1;
+	} else {
+		/**
+		 * We separate the descriptor management to enqueue
+		 * segment(s).
+		 */
+		idx = virtqueue_buffer_enqueue_segments(vrq, head_idx, sg,
+							read_bufs, write_bufs);
+	}
 	/* Additional information to reconstruct the data buffer */
 	vrq->vq_info[head_idx].cookie = cookie;
 	vrq->vq_info[head_idx].desc_count = total_desc;
-
-	/**
-	 * We separate the descriptor management to enqueue segment(s).
-	 */
-	idx = virtqueue_buffer_enqueue_segments(vrq, head_idx, sg,
-			read_bufs, write_bufs);
 	/* Metadata maintenance for the virtqueue */
 	vrq->head_free_desc = idx;
 	vrq->desc_avail -= total_desc;
@@ -390,6 +754,27 @@ static void virtqueue_vring_init(struct virtqueue_vring *vrq, __u16 nr_desc,
 	vrq->vring.desc[nr_desc - 1].next = VIRTQUEUE_MAX_SIZE;
 }
 
+static void virtqueue_vring_packed_init(struct virtqueue_vring *vrq,
+					__u16 nr_desc)
+{
+	int i = 0;
+
+	vring_packed_init(&vrq->vring_packed, nr_desc, vrq->vring_mem);
+
+	vrq->desc_avail = nr_desc;
+	vrq->next_avail_idx = 0;
+	vrq->last_used_desc_idx = 0;
+	/* Both wrap counters start with 1 */
+	vrq->avail_wrap_counter = 1;
+	vrq->used_wrap_counter = 1;
+
+	/* All buffer ids are free */
+	vrq->head_free_desc = 0;
+	for (i = 0; i < nr_desc - 1; i++)
+		vrq->vq_info[i].next = i + 1;
+	vrq->vq_info[nr_desc - 1].next = VIRTQUEUE_MAX_SIZE;
+}
+
 struct virtqueue *virtqueue_create(__u16 queue_id, __u16 nr_descs, __u16 align,
 				   virtqueue_callback_t callback,
 				   virtqueue_notify_host_t notify,
@@ -415,8 +800,15 @@ struct virtqueue *virtqueue_create(__u16 queue_id, __u16 nr_descs, __u16 align,
 	 * allocation.
 	 */
 	vrq->vring_mem = NULL;
-
-	ring_size = vring_size(nr_descs, align);
+	vrq->indirect = NULL;
+	vrq->a = a;
+
+	/* The ring layout is negotiated per device */
+	vrq->packed = VIRTIO_FEATURE_HAS(vdev->features, VIRTIO_F_RING_PACKED);
+	if (vrq->packed)
+		ring_size = vring_packed_size(nr_descs);
+	else
+		ring_size = vring_size(nr_descs, align);
 #ifdef CONFIG_LIBUKVMEM
 	struct uk_pagetable *pt = ukplat_pt_get_active();
 	__paddr_t paddr = __PADDR_ANY;
@@ -443,7 +835,28 @@ struct virtqueue *virtqueue_create(__u16 queue_id, __u16 nr_descs, __u16 align,
 	}
 #endif /* !CONFIG_LIBUKVMEM */
 	memset(vrq->vring_mem, 0, ring_size);
-	virtqueue_vring_init(vrq, nr_descs, align);
+	if (vrq->packed)
+		virtqueue_vring_packed_init(vrq, nr_descs);
+	else
+		virtqueue_vring_init(vrq, nr_descs, align);
+	vrq->event_idx = VIRTIO_FEATURE_HAS(vdev->features,
+					    VIRTIO_F_EVENT_IDX);
+	vrq->num_added = 0;
+
+	/**
+	 * Indirect descriptor tables. The tables are page aligned in total
+	 * and a single table never crosses a page boundary.
+	 */
+	if (VIRTIO_FEATURE_HAS(vdev->features, VIRTIO_F_INDIRECT_DESC)) {
+		UK_CTASSERT(__PAGE_SIZE % (VIRTQUEUE_INDIRECT_MAX
+					   * sizeof(struct vring_desc)) == 0);
+		vrq->indirect = uk_memalign(a, __PAGE_SIZE,
+					    (size_t) nr_descs
+					    * VIRTQUEUE_INDIRECT_MAX
+					    * sizeof(struct vring_desc));
+		if (unlikely(!vrq->indirect))
+			uk_pr_warn("Failed to allocate indirect descriptors, using ring descriptors only\n");
+	}
 
 	vq = &vrq->vq;
 	vq->queue_id = queue_id;
@@ -469,6 +882,8 @@ void virtqueue_destroy(struct virtqueue *vq, struct uk_alloc *a)
 
 	/* Free the ring */
 	uk_free(a, vrq->vring_mem);
+	if (vrq->indirect)
+		uk_free(vrq->a, vrq->indirect);
 
 	/* Free the virtqueue metadata */
 	uk_free(a, vrq);
@@ -88,4 +88,5 @@
 #define IDT_DESC_DPL_USER	GDT_DESC_DPL_USER
 
 #define IDT_DESC_OFFSET(n)	GDT_DESC_OFFSET(n)
-#define IDT_NUM_ENTRIES		48
+/* 32 exceptions, followed by the vectors of the PIC IRQs and the MSIs */
+#define IDT_NUM_ENTRIES		80
@@ -38,6 +38,10 @@
 #include <uk/print.h>
 #include <errno.h>
 #include <uk/bitops.h>
+#ifdef CONFIG_ARCH_X86_64
+#include <uk/plat/common/lcpu.h>
+#include <x86/apic.h>
+#endif /* CONFIG_ARCH_X86_64 */
 
 UK_EVENT(UKPLAT_EVENT_IRQ);
 
@@ -146,6 +150,91 @@ exit_ack:
 	intctrl_ack_irq(irq);
 }
 
+#ifdef CONFIG_ARCH_X86_64
+/* MSI address window of the local APICs. The destination APIC ID is encoded
+ * in bits 12-19 of the address, the vector in the low byte of the data.
+ */
+#define X86_MSI_ADDR_BASE		0xfee00000UL
+#define X86_MSI_ADDR_DEST_SHIFT		12
+#define X86_MSI_ADDR_DEST_MAX		0xff
+
+static unsigned long msi_irq_map[UK_BITS_TO_LONGS(X86_MSI_IRQS)];
+#ifndef CONFIG_HAVE_SMP
+static int msi_apic_ready;
+#endif /* !CONFIG_HAVE_SMP */
+
+int ukplat_irq_msi_alloc(unsigned long *irq)
+{
+	unsigned long flags;
+	unsigned long bit;
+	int rc = 0;
+
+	UK_ASSERT(irq);
+
+	flags = ukplat_lcpu_save_irqf();
+#ifndef CONFIG_HAVE_SMP
+	/* Without SMP support, nobody switched the local APIC to x2APIC
+	 * mode, which we need for delivering MSIs and for the EOI
+	 */
+	if (!msi_apic_ready) {
+		rc = apic_enable();
+		if (unlikely(rc))
+			goto out;
+		msi_apic_ready = 1;
+	}
+#endif /* !CONFIG_HAVE_SMP */
+
+	bit = uk_find_first_zero_bit(msi_irq_map, X86_MSI_IRQS);
+	if (unlikely(bit >= X86_MSI_IRQS)) {
+		rc = -ENOSPC;
+		goto out;
+	}
+	__uk_set_bit(bit, msi_irq_map);
+	*irq = X86_MSI_IRQ_BASE + bit;
+
+out:
+	ukplat_lcpu_restore_irqf(flags);
+	return rc;
+}
+
+int ukplat_irq_msi_compose(unsigned long irq, __lcpuidx lcpuidx,
+			   __u64 *addr, __u32 *data)
+{
+	__lcpuid apic_id;
+
+	UK_ASSERT(addr && data);
+
+	if (unlikely(irq < X86_MSI_IRQ_BASE || irq >= __MAX_IRQ))
+		return -EINVAL;
+	if (unlikely(lcpuidx >= ukplat_lcpu_count()))
+		return -EINVAL;
+
+	/* MSIs in xAPIC format can only address the first 256 APIC IDs */
+	apic_id = lcpu_get(lcpuidx)->id;
+	if (unlikely(apic_id > X86_MSI_ADDR_DEST_MAX))
+		return -ENOTSUP;
+
+	/* Fixed delivery mode, physical destination, edge triggered. The IDT
+	 * maps IRQ `n` to vector 32 + `n`.
+	 */
+	*addr = X86_MSI_ADDR_BASE | (apic_id << X86_MSI_ADDR_DEST_SHIFT);
+	*data = 32 + irq;
+	return 0;
+}
+#else /* !CONFIG_ARCH_X86_64 */
+int ukplat_irq_msi_alloc(unsigned long *irq __unused)
+{
+	return -ENOTSUP;
+}
+
+int ukplat_irq_msi_compose(unsigned long irq __unused,
+			   __lcpuidx lcpuidx __unused,
+			   __u64 *addr __unused, __u32 *data __unused)
+{
+	return -ENOTSUP;
+}
+#endif /* !CONFIG_ARCH_X86_64 */
+
 int ukplat_irq_init(struct uk_alloc *a __unused)
 {
 	UK_ASSERT(ukplat_lcpu_irqs_disabled());
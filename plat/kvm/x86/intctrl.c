@@ -24,6 +24,8 @@
 
 #include <stdint.h>
 #include <x86/cpu.h>
+#include <x86/irq.h>
+#include <x86/apic.h>
 #include <kvm/intctrl.h>
 
 #define PIC1             0x20    /* IO base address for master PIC */
@@ -88,6 +90,12 @@ void intctrl_init(void)
 
 void intctrl_ack_irq(unsigned int irq)
 {
+	/* MSIs bypass the PIC and are acknowledged at the local APIC */
+	if (irq >= X86_MSI_IRQ_BASE) {
+		apic_ack_interrupt();
+		return;
+	}
+
 	if (!IRQ_ON_MASTER(irq))
 		outb(PIC2_COMMAND, PIC_EOI);
 
@@ -98,6 +106,10 @@ void intctrl_mask_irq(unsigned int irq)
 {
 	__u16 port;
 
+	/* MSIs are masked at the device */
+	if (irq >= X86_MSI_IRQ_BASE)
+		return;
+
 	port = IRQ_PORT(irq);
 	outb(port, inb(port) | (1 << IRQ_OFFSET(irq)));
 }
@@ -106,6 +118,9 @@ void intctrl_clear_irq(unsigned int irq)
 {
 	__u16 port;
 
+	if (irq >= X86_MSI_IRQ_BASE)
+		return;
+
 	port = IRQ_PORT(irq);
 	outb(port, inb(port) & ~(1 << IRQ_OFFSET(irq)));
 }
@@ -31,6 +31,7 @@
 #include <uk/plat/lcpu.h>
 #include <uk/plat/config.h>
 #include <x86/desc.h>
+#include <x86/irq.h>
 #include <kvm-x86/traps.h>
 
 /*
@@ -142,6 +143,7 @@ DECLARE_TRAP_EC(double_fault,  "double fault",         NULL)
 DECLARE_TRAP_EC(virt_error,    "virtualization error", NULL)
 
 static struct seg_gate_desc64 cpu_idt[IDT_NUM_ENTRIES] __align(8);
+UK_CTASSERT(IDT_NUM_ENTRIES >= 32 + __MAX_IRQ);
 static struct desc_table_ptr64 idtptr;
 
 static inline void idt_fillgate(unsigned int num, void *fun, unsigned int ist)
@@ -232,6 +234,40 @@ void traps_table_init(void)
 	FILL_IRQ_GATE(14, 1);
 	FILL_IRQ_GATE(15, 1);
 
+	/* MSI vectors (X86_MSI_IRQ_BASE .. __MAX_IRQ - 1) */
+	FILL_IRQ_GATE(16, 1);
+	FILL_IRQ_GATE(17, 1);
+	FILL_IRQ_GATE(18, 1);
+	FILL_IRQ_GATE(19, 1);
+	FILL_IRQ_GATE(20, 1);
+	FILL_IRQ_GATE(21, 1);
+	FILL_IRQ_GATE(22, 1);
+	FILL_IRQ_GATE(23, 1);
+	FILL_IRQ_GATE(24, 1);
+	FILL_IRQ_GATE(25, 1);
+	FILL_IRQ_GATE(26, 1);
+	FILL_IRQ_GATE(27, 1);
+	FILL_IRQ_GATE(28, 1);
+	FILL_IRQ_GATE(29, 1);
+	FILL_IRQ_GATE(30, 1);
+	FILL_IRQ_GATE(31, 1);
+	FILL_IRQ_GATE(32, 1);
+	FILL_IRQ_GATE(33, 1);
+	FILL_IRQ_GATE(34, 1);
+	FILL_IRQ_GATE(35, 1);
+	FILL_IRQ_GATE(36, 1);
+	FILL_IRQ_GATE(37, 1);
+	FILL_IRQ_GATE(38, 1);
+	FILL_IRQ_GATE(39, 1);
+	FILL_IRQ_GATE(40, 1);
+	FILL_IRQ_GATE(41, 1);
+	FILL_IRQ_GATE(42, 1);
+	FILL_IRQ_GATE(43, 1);
+	FILL_IRQ_GATE(44, 1);
+	FILL_IRQ_GATE(45, 1);
+	FILL_IRQ_GATE(46, 1);
+	FILL_IRQ_GATE(47, 1);
+
 	idtptr.limit = sizeof(cpu_idt) - 1;
 	idtptr.base = (__u64) &cpu_idt;
 }
@@ -0,0 +1,117 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2023, Unikraft GmbH and The Unikraft Authors.
+ * Licensed under the BSD-3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <uk/print.h>
+#include <uk/arch/types.h>
+#include <linuxu/afpacket.h>
+#include <linuxu/tap.h>
+
+int afpacket_open(void)
+{
+	int rc;
+
+	/* Protocol 0: nothing is queued on the socket before it is bound */
+	rc = sys_socket(AF_PACKET, SOCK_RAW, 0);
+	if (rc < 0)
+		uk_pr_err("Failed(%d) to open a packet socket\n", rc);
+	return rc;
+}
+
+int afpacket_close(int fd)
+{
+	return sys_close(fd);
+}
+
+int afpacket_ifinfo_get(int fd, const char *ifname, int *ifindex,
+			__u8 *hwaddr, int *mtu)
+{
+	struct uk_ifreq ifr = {0};
+	int rc;
+
+	snprintf(ifr.ifr_name, IFNAMSIZ, "%s", ifname);
+	rc = sys_ioctl(fd, UK_SIOCGIFINDEX, &ifr);
+	if (rc < 0) {
+		uk_pr_err("Failed(%d) to find interface %s\n", rc, ifname);
+		return rc;
+	}
+	*ifindex = ifr.ifr_ifindex;
+
+	rc = sys_ioctl(fd, UK_SIOCGIFHWADDR, &ifr);
+	if (rc < 0) {
+		uk_pr_err("Failed(%d) to read the hardware address of %s\n",
+			  rc, ifname);
+		return rc;
+	}
+	memcpy(hwaddr, ifr.ifr_hwaddr.sa_data, 6);
+
+	rc = sys_ioctl(fd, UK_SIOCGIFMTU, &ifr);
+	if (rc < 0) {
+		uk_pr_err("Failed(%d) to read the MTU of %s\n", rc, ifname);
+		return rc;
+	}
+	*mtu = ifr.ifr_mtu;
+	return 0;
+}
+
+int afpacket_sockopt_set(int fd, int optname, const void *optval,
+			 __u32 optlen)
+{
+	int rc;
+
+	rc = sys_setsockopt(fd, UK_SOL_PACKET, optname, optval, optlen);
+	if (rc < 0)
+		uk_pr_err("Failed(%d) to set packet socket option %d\n",
+			  rc, optname);
+	return rc;
+}
+
+int afpacket_bind(int fd, int ifindex, __u16 protocol)
+{
+	struct uk_sockaddr_ll sll = {0};
+	int rc;
+
+	sll.sll_family = AF_PACKET;
+	sll.sll_protocol = UK_AFPACKET_HTONS(protocol);
+	sll.sll_ifindex = ifindex;
+	rc = sys_bind(fd, &sll, sizeof(sll));
+	if (rc < 0)
+		uk_pr_err("Failed(%d) to bind to interface %d\n", rc, ifindex);
+	return rc;
+}
+
+void *afpacket_ring_map(int fd, __sz len)
+{
+	void *ring;
+
+	ring = sys_mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if ((long) ring < 0 && (long) ring > -4096) {
+		uk_pr_err("Failed(%ld) to map the packet rings\n",
+			  (long) ring);
+		return NULL;
+	}
+	return ring;
+}
+
+int afpacket_ring_unmap(void *ring, __sz len)
+{
+	return sys_munmap(ring, len);
+}
+
+int afpacket_tx_kick(int fd)
+{
+	ssize_t rc;
+
+	rc = sys_sendto(fd, NULL, 0, UK_MSG_DONTWAIT, NULL, 0);
+	/* Linux errno -11 (EAGAIN) and -105 (ENOBUFS): retried next time */
+	if (rc == -11 || rc == -105)
+		return 0;
+	if (rc < 0)
+		uk_pr_err("Failed(%ld) to send the transmit ring\n", rc);
+	return (rc < 0) ? (int) rc : 0;
+}
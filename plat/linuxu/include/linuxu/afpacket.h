@@ -0,0 +1,137 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2023, Unikraft GmbH and The Unikraft Authors.
+ * Licensed under the BSD-3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ */
+#ifndef __PLAT_LINUXU_AFPACKET_H__
+#define __PLAT_LINUXU_AFPACKET_H__
+
+#include <uk/arch/types.h>
+#include <uk/essentials.h>
+#include <linuxu/syscall.h>
+#include <linuxu/ioctl.h>
+
+/**
+ * Using the Linux UAPI (linux/if_packet.h) as reference for the data
+ * structure definitions
+ */
+#ifndef AF_PACKET
+#define AF_PACKET		17
+#endif /* AF_PACKET */
+
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define UK_AFPACKET_HTONS(x)	((__u16) __builtin_bswap16(x))
+#else
+#define UK_AFPACKET_HTONS(x)	((__u16) (x))
+#endif
+
+#define UK_ETH_P_ALL		0x0003
+
+#define UK_MSG_DONTWAIT		0x40
+
+#define UK_SOL_PACKET		263
+#define UK_PACKET_ADD_MEMBERSHIP 1
+#define UK_PACKET_RX_RING	5
+#define UK_PACKET_VERSION	10
+#define UK_PACKET_TX_RING	13
+#define UK_PACKET_LOSS		14
+#define UK_PACKET_FANOUT	18
+#define UK_PACKET_QDISC_BYPASS	20
+
+#define UK_PACKET_MR_PROMISC	1
+
+#define UK_PACKET_FANOUT_HASH	0
+
+#define UK_TPACKET_V3		2
+
+/* sll_pkttype */
+#define UK_PACKET_OUTGOING	4
+
+/* Receive frame and block status */
+#define UK_TP_STATUS_KERNEL		0
+#define UK_TP_STATUS_USER		(1 << 0)
+#define UK_TP_STATUS_CSUMNOTREADY	(1 << 3)
+#define UK_TP_STATUS_CSUM_VALID		(1 << 7)
+/* Transmit frame status */
+#define UK_TP_STATUS_AVAILABLE		0
+#define UK_TP_STATUS_SEND_REQUEST	(1 << 0)
+#define UK_TP_STATUS_SENDING		(1 << 1)
+#define UK_TP_STATUS_WRONG_FORMAT	(1 << 2)
+
+#define UK_TPACKET_ALIGNMENT	16
+#define UK_TPACKET_ALIGN(x)	ALIGN_UP((x), UK_TPACKET_ALIGNMENT)
+
+struct uk_sockaddr_ll {
+	__u16 sll_family;
+	__u16 sll_protocol; /* network byte order */
+	int sll_ifindex;
+	__u16 sll_hatype;
+	__u8 sll_pkttype;
+	__u8 sll_halen;
+	__u8 sll_addr[8];
+};
+
+struct uk_packet_mreq {
+	int mr_ifindex;
+	__u16 mr_type;
+	__u16 mr_alen;
+	__u8 mr_address[8];
+};
+
+struct uk_tpacket_req3 {
+	unsigned int tp_block_size;
+	unsigned int tp_block_nr;
+	unsigned int tp_frame_size;
+	unsigned int tp_frame_nr;
+	unsigned int tp_retire_blk_tov; /* ms */
+	unsigned int tp_sizeof_priv;
+	unsigned int tp_feature_req_word;
+};
+
+struct uk_tpacket_bd_ts {
+	unsigned int ts_sec;
+	unsigned int ts_nsec;
+};
+
+struct uk_tpacket_hdr_v1 {
+	__u32 block_status;
+	__u32 num_pkts;
+	__u32 offset_to_first_pkt;
+	__u32 blk_len;
+	__u64 seq_num __align(8);
+	struct uk_tpacket_bd_ts ts_first_pkt;
+	struct uk_tpacket_bd_ts ts_last_pkt;
+};
+
+struct uk_tpacket_block_desc {
+	__u32 version;
+	__u32 offset_to_priv;
+	struct uk_tpacket_hdr_v1 bh1;
+};
+
+struct uk_tpacket3_hdr {
+	__u32 tp_next_offset;
+	__u32 tp_sec;
+	__u32 tp_nsec;
+	__u32 tp_snaplen;
+	__u32 tp_len;
+	__u32 tp_status;
+	__u16 tp_mac;
+	__u16 tp_net;
+	__u32 tp_rxhash;
+	__u32 tp_vlan_tci;
+	__u16 tp_vlan_tpid;
+	__u16 tp_padding0;
+	__u8 tp_padding[8];
+};
+
+/* The link-layer address follows the frame header in receive frames */
+#define UK_TPACKET3_SLL(hdr)						\
+	((struct uk_sockaddr_ll *) ((__u8 *) (hdr)			\
+		+ UK_TPACKET_ALIGN(sizeof(struct uk_tpacket3_hdr))))
+
+/* Offset of the frame data in transmit frames */
+#define UK_TPACKET3_TX_DATA_OFF						\
+	UK_TPACKET_ALIGN(sizeof(struct uk_tpacket3_hdr))
+
+#endif /* __PLAT_LINUXU_AFPACKET_H__ */
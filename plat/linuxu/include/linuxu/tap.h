@@ -34,6 +34,7 @@
 #define __PLAT_LINUXU_TAP_H__
 
 #include <uk/arch/types.h>
+#include <uk/essentials.h>
 #include <linuxu/syscall.h>
 #include <linuxu/ioctl.h>
 
@@ -117,6 +118,9 @@ struct uk_ifreq {
 #define ifr_newname uk_ifr_ifru.ifru_newname
 
 #define UK_TUNSETIFF     (0x400454ca)
+#define UK_TUNGETFEATURES (0x800454cf)
+#define UK_TUNSETOFFLOAD (0x400454d0)
+#define UK_TUNSETVNETHDRSZ (0x400454d8)
 #define UK_SIOCGIFNAME   (0x8910)
 #define UK_SIOCGIFFLAGS  (0x8913)
 #define UK_SIOCSIFFLAGS  (0x8914)
@@ -146,6 +150,32 @@ struct uk_ifreq {
 #define UK_IFF_UP	(0x1)
 #define UK_IFF_PROMISC	(0x100)
 
+/* TUNSETOFFLOAD flags: offloads the device may hand over to us */
+#define UK_TUN_F_CSUM    (0x01)
+#define UK_TUN_F_TSO4    (0x02)
+#define UK_TUN_F_TSO6    (0x04)
+#define UK_TUN_F_TSO_ECN (0x08)
+
+/**
+ * Header that precedes every frame with UK_IFF_VNET_HDR (virtio-net legacy
+ * header in host byte order)
+ */
+struct uk_tun_vnet_hdr {
+#define UK_TUN_VNET_HDR_F_NEEDS_CSUM	1
+#define UK_TUN_VNET_HDR_F_DATA_VALID	2
+	__u8 flags;
+#define UK_TUN_VNET_HDR_GSO_NONE	0
+#define UK_TUN_VNET_HDR_GSO_TCPV4	1
+#define UK_TUN_VNET_HDR_GSO_UDP		3
+#define UK_TUN_VNET_HDR_GSO_TCPV6	4
+#define UK_TUN_VNET_HDR_GSO_ECN		0x80
+	__u8 gso_type;
+	__u16 hdr_len;
+	__u16 gso_size;
+	__u16 csum_start;
+	__u16 csum_offset;
+} __packed;
+
 /* Adding the bridge interface */
 #define UK_SIOCBRADDIF (0x89a2)
 
@@ -60,6 +60,38 @@ int tap_dev_configure(int fd, __u32 feature_flags, void *arg)
 	return rc;
 }
 
+int tap_dev_features_get(int fd, __u32 *features)
+{
+	unsigned int host_features = 0;
+	int rc;
+
+	rc = sys_ioctl(fd, UK_TUNGETFEATURES, &host_features);
+	if (rc < 0) {
+		uk_pr_err("Failed(%d) to read the tap device features\n", rc);
+		return rc;
+	}
+	*features = host_features;
+	return 0;
+}
+
+int tap_dev_vnet_configure(int fd, int hdr_len, __u32 offloads)
+{
+	int rc;
+
+	rc = sys_ioctl(fd, UK_TUNSETVNETHDRSZ, &hdr_len);
+	if (rc < 0) {
+		uk_pr_err("Failed(%d) to set the vnet header size\n", rc);
+		return rc;
+	}
+
+	/* The offload flags are passed by value */
+	rc = sys_ioctl(fd, UK_TUNSETOFFLOAD, (void *)(unsigned long) offloads);
+	if (rc < 0)
+		uk_pr_err("Failed(%d) to set the offloads 0x%"__PRIx32"\n",
+			  rc, offloads);
+	return rc;
+}
+
 int tap_netif_configure(int fd, __u32 request, void *arg)
 {
 	int rc;
@@ -154,6 +186,39 @@ ssize_t tap_write(int fd, const void *buf, size_t count)
 	return (ssize_t)written;
 }
 
+ssize_t tap_readv(int fd, const struct k_iovec *iov, int iovcnt)
+{
+	ssize_t rc = -EINTR;
+
+	while (rc == -EINTR)
+		rc = sys_readv(fd, iov, iovcnt);
+
+	if (rc == -11)
+		/* Explicitly added since linux errno has -11 for EAGAIN */
+		rc = -EWOULDBLOCK;
+	else if (rc < 0)
+		uk_pr_err("Failed(%ld) to read from the tap device\n", rc);
+
+	return rc;
+}
+
+ssize_t tap_writev(int fd, const struct k_iovec *iov, int iovcnt)
+{
+	ssize_t rc = -EINTR;
+
+	/* The tap device takes a frame as a whole or not at all */
+	while (rc == -EINTR)
+		rc = sys_writev(fd, iov, iovcnt);
+
+	if (rc == -11)
+		/* Explicitly added since linux errno has -11 for EAGAIN */
+		rc = -EAGAIN;
+	else if (rc < 0)
+		uk_pr_err("Failed(%ld) to write to the tap device\n", rc);
+
+	return rc;
+}
+
 int tap_close(int fd)
 {
 	return sys_close(fd);
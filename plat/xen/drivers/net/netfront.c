@@ -117,39 +117,19 @@ static int network_tx_buf_gc(struct uk_netdev_tx_queue *txq)
 	return count;
 }
 
-static int netfront_xmit(struct uk_netdev *n,
+/* Fills a tx request for `pkt`; the caller pushes the requests afterwards */
+static void netfront_txq_enqueue(struct netfront_dev *nfdev,
 		struct uk_netdev_tx_queue *txq,
 		struct uk_netbuf *pkt)
 {
-	struct netfront_dev *nfdev;
-	unsigned long flags;
 	uint16_t id;
 	RING_IDX req_prod;
 	netif_tx_request_t *tx_req;
-	bool more_to_do;
-	int notify;
-	int status;
 
-	UK_ASSERT(n != NULL);
-	UK_ASSERT(txq != NULL);
-	UK_ASSERT(pkt != NULL);
 	UK_ASSERT(pkt->len < PAGE_SIZE);
 	UK_ASSERT(!pkt->next); /* TODO: Support for netbuf chains missing */
 	UK_ASSERT(((unsigned long) pkt->buf & ~PAGE_MASK) == 0);
 
-	nfdev = to_netfront_dev(n);
-
-	local_irq_save(flags);
-	if (unlikely(RING_FULL(&txq->ring))) {
-		/* try some cleanup */
-		network_tx_buf_gc(txq);
-		if (unlikely(RING_FULL(&txq->ring))) {
-			uk_pr_debug("tx queue is full\n");
-			local_irq_restore(flags);
-			return 0x0;
-		}
-	}
-
 	/* get request id */
 	id = get_id_from_freelist(txq->freelist);
 
@@ -182,28 +162,104 @@ static int netfront_xmit(struct uk_netdev *n,
 	tx_req->flags |= (pkt->flags & UK_NETBUF_F_DATA_VALID)
 			 ? NETTXF_data_validated : 0x0;
 	tx_req->id = id;
-	status = UK_NETDEV_STATUS_SUCCESS;
 
 	txq->ring.req_prod_pvt = req_prod + 1;
+}
+
+/* Pushes pending tx requests to the backend and collects responses */
+static int netfront_txq_push(struct uk_netdev_tx_queue *txq)
+{
+	bool more_to_do;
+	int notify;
+
 	wmb(); /* Ensure backend sees requests */
 
 	RING_PUSH_REQUESTS_AND_CHECK_NOTIFY(&txq->ring, notify);
 	if (notify)
 		notify_remote_via_evtchn(txq->evtchn);
 
-
 	/* some cleanup */
 	do {
 		network_tx_buf_gc(txq);
 		RING_FINAL_CHECK_FOR_RESPONSES(&txq->ring, more_to_do);
 	} while (more_to_do);
 
-	status |= (RING_FULL(&txq->ring)) ? 0x0 : UK_NETDEV_STATUS_MORE;
+	return (RING_FULL(&txq->ring)) ? 0x0 : UK_NETDEV_STATUS_MORE;
+}
+
+static int netfront_xmit(struct uk_netdev *n,
+		struct uk_netdev_tx_queue *txq,
+		struct uk_netbuf *pkt)
+{
+	struct netfront_dev *nfdev;
+	unsigned long flags;
+	int status;
+
+	UK_ASSERT(n != NULL);
+	UK_ASSERT(txq != NULL);
+	UK_ASSERT(pkt != NULL);
+
+	nfdev = to_netfront_dev(n);
+
+	local_irq_save(flags);
+	if (unlikely(RING_FULL(&txq->ring))) {
+		/* try some cleanup */
+		network_tx_buf_gc(txq);
+		if (unlikely(RING_FULL(&txq->ring))) {
+			uk_pr_debug("tx queue is full\n");
+			local_irq_restore(flags);
+			return 0x0;
+		}
+	}
+
+	netfront_txq_enqueue(nfdev, txq, pkt);
+	status = UK_NETDEV_STATUS_SUCCESS;
+	status |= netfront_txq_push(txq);
 	local_irq_restore(flags);
 
 	return status;
 }
 
+static int netfront_xmit_burst(struct uk_netdev *n,
+		struct uk_netdev_tx_queue *txq,
+		struct uk_netbuf **pkts,
+		uint16_t *cnt)
+{
+	struct netfront_dev *nfdev;
+	unsigned long flags;
+	uint16_t i;
+	int status;
+
+	UK_ASSERT(n != NULL);
+	UK_ASSERT(txq != NULL);
+	UK_ASSERT(pkts != NULL && cnt != NULL);
+
+	nfdev = to_netfront_dev(n);
+
+	local_irq_save(flags);
+	if (unlikely(RING_FULL(&txq->ring))) {
+		/* try some cleanup */
+		network_tx_buf_gc(txq);
+		if (unlikely(RING_FULL(&txq->ring))) {
+			uk_pr_debug("tx queue is full\n");
+			local_irq_restore(flags);
+			*cnt = 0;
+			return 0x0;
+		}
+	}
+
+	for (i = 0; i < *cnt && !RING_FULL(&txq->ring); i++)
+		netfront_txq_enqueue(nfdev, txq, pkts[i]);
+
+	/* Single push and notification for the whole burst */
+	status = UK_NETDEV_STATUS_SUCCESS;
+	status |= netfront_txq_push(txq);
+	local_irq_restore(flags);
+
+	*cnt = i;
+	return status;
+}
+
 static int netfront_rxq_enqueue(struct uk_netdev_rx_queue *rxq,
 		struct uk_netbuf *netbuf)
 {
@@ -211,7 +267,6 @@ static int netfront_rxq_enqueue(struct uk_netdev_rx_queue *rxq,
 	uint16_t id;
 	netif_rx_request_t *rx_req;
 	struct netfront_dev *nfdev;
-	int notify;
 
 	/* buffer must be page aligned */
 	UK_ASSERT(((unsigned long) netbuf->buf & ~PAGE_MASK) == 0);
@@ -246,13 +301,8 @@ static int netfront_rxq_enqueue(struct uk_netdev_rx_queue *rxq,
 	UK_ASSERT(rxq->gref[id] != GRANT_INVALID_REF);
 
 	rx_req->gref = rxq->gref[id];
-	wmb(); /* Ensure backend sees requests */
 	rxq->ring.req_prod_pvt = req_prod + 1;
 
-	RING_PUSH_REQUESTS_AND_CHECK_NOTIFY(&rxq->ring, notify);
-	if (notify)
-		notify_remote_via_evtchn(rxq->evtchn);
-
 	return 0;
 }
 
@@ -321,11 +371,15 @@ static int netfront_rx_fillup(struct uk_netdev_rx_queue *rxq, uint16_t nb_desc)
 {
 	struct uk_netbuf *netbuf[nb_desc];
 	int rc, status = 0;
-	uint16_t cnt;
+	uint16_t cnt, i = 0;
+	int notify;
+
+	if (nb_desc == 0)
+		return 0;
 
 	cnt = rxq->alloc_rxpkts(rxq->alloc_rxpkts_argp, netbuf, nb_desc);
 
-	for (uint16_t i = 0; i < cnt; i++) {
+	for (i = 0; i < cnt; i++) {
 		rc = netfront_rxq_enqueue(rxq, netbuf[i]);
 		if (unlikely(rc < 0)) {
 			uk_pr_err("Failed to add a buffer to rx queue %p: %d\n",
@@ -348,6 +402,13 @@ static int netfront_rx_fillup(struct uk_netdev_rx_queue *rxq, uint16_t nb_desc)
 		status |= UK_NETDEV_STATUS_UNDERRUN;
 
 out:
+	/* Push all new requests with a single notification */
+	if (i > 0) {
+		wmb(); /* Ensure backend sees requests */
+		RING_PUSH_REQUESTS_AND_CHECK_NOTIFY(&rxq->ring, notify);
+		if (notify)
+			notify_remote_via_evtchn(rxq->evtchn);
+	}
 	return status;
 }
 
@@ -425,6 +486,73 @@ static int netfront_recv(struct uk_netdev *n __unused,
 	return status;
 }
 
+static int netfront_recv_burst(struct uk_netdev *n __unused,
+		struct uk_netdev_rx_queue *rxq,
+		struct uk_netbuf **pkts,
+		uint16_t *cnt)
+{
+	int rc, status = 0;
+	uint16_t req, rcvd = 0;
+	int more;
+
+	UK_ASSERT(n != NULL);
+	UK_ASSERT(rxq != NULL);
+	UK_ASSERT(pkts != NULL && cnt != NULL);
+
+	/* Queue interrupts have to be off when calling receive */
+	UK_ASSERT(!(rxq->intr_enabled & NETFRONT_INTR_EN));
+
+	req = *cnt;
+	while (rcvd < req) {
+		rc = netfront_rxq_dequeue(rxq, &pkts[rcvd]);
+		UK_ASSERT(rc >= 0);
+		if (!rc)
+			break;
+		rcvd++;
+	}
+	/* Refill all consumed slots at once */
+	status |= netfront_rx_fillup(rxq, rcvd);
+
+	/* Enable interrupt only when user had previously enabled it */
+	if (rxq->intr_enabled & NETFRONT_INTR_USR_EN_MASK) {
+		/* Need to enable the interrupt on the last packet */
+		rc = netfront_rxq_intr_enable(rxq);
+		if (rc == 1 && rcvd == 0) {
+			/**
+			 * Packets arrived after reading the queue and before
+			 * enabling the interrupt
+			 */
+			while (rcvd < req) {
+				rc = netfront_rxq_dequeue(rxq, &pkts[rcvd]);
+				UK_ASSERT(rc >= 0);
+				if (!rc)
+					break;
+				rcvd++;
+			}
+			status |= netfront_rx_fillup(rxq, rcvd);
+
+			/* Need to enable the interrupt on the last packet */
+			rc = netfront_rxq_intr_enable(rxq);
+			status |= (rc == 1 && rcvd > 0)
+				  ? UK_NETDEV_STATUS_MORE : 0x0;
+		} else if (rcvd > 0) {
+			/* When we originally got packets and there is more */
+			status |= (rc == 1) ? UK_NETDEV_STATUS_MORE : 0x0;
+		}
+	} else if (rcvd > 0) {
+		/**
+		 * For polling case, we report always there are further
+		 * packets unless the queue is empty.
+		 */
+		RING_FINAL_CHECK_FOR_RESPONSES(&rxq->ring, more);
+		status |= (more) ? UK_NETDEV_STATUS_MORE : 0x0;
+	}
+
+	status |= (rcvd > 0) ? UK_NETDEV_STATUS_SUCCESS : 0x0;
+	*cnt = rcvd;
+	return status;
+}
+
 static struct uk_netdev_tx_queue *netfront_txq_setup(struct uk_netdev *n,
 		uint16_t queue_id,
 		uint16_t nb_desc __unused,
@@ -876,6 +1004,8 @@ static int netfront_add_dev(struct xenbus_device *xendev)
 	nfdev->max_queue_pairs = 1;
 	nfdev->netdev.tx_one = netfront_xmit;
 	nfdev->netdev.rx_one = netfront_recv;
+	nfdev->netdev.tx_burst = netfront_xmit_burst;
+	nfdev->netdev.rx_burst = netfront_recv_burst;
 	nfdev->netdev.ops = &netfront_ops;
 	rc = uk_netdev_drv_register(&nfdev->netdev, drv_allocator, DRIVER_NAME);
 	if (rc < 0) {